@@ -96,6 +96,9 @@ static inline pid_t __x64_clone_thread(void *stack, size_t stack_size, int (*fn)
 
 	int flags = CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD;
 	long ret;
+	/* pinned so neither can be handed rbp, which the child zeroes before the call */
+	register int (*entry)(void *) __asm__("r8") = fn;
+	register void *entry_arg __asm__("r9") = arg;
 
 	__asm__ volatile(
 		"mov $56, %%rax\n\t"         /* SYS_clone */
@@ -108,8 +111,8 @@ static inline pid_t __x64_clone_thread(void *stack, size_t stack_size, int (*fn)
 		"jnz 1f\n\t"                 /* Parent if non-zero */
 
 		/* Child path (rax == 0) */
-		"xor %%rbp, %%rbp\n\t"
 		"mov %5, %%rdi\n\t"          /* arg */
+		"xor %%rbp, %%rbp\n\t"
 		"call *%4\n\t"               /* fn(arg) */
 		"mov %%rax, %%rdi\n\t"
 		"mov $60, %%rax\n\t"         /* SYS_exit */
@@ -117,8 +120,8 @@ static inline pid_t __x64_clone_thread(void *stack, size_t stack_size, int (*fn)
 
 		"1:\n\t"                     /* Parent continues */
 		: "=a"(ret)
-		: "a"((long)56), "r"((long)flags), "r"(stack_top), "r"(fn), "r"(arg)
-		: "rcx", "r11", "rdx", "rsi", "rdi", "r8", "r9", "r10", "memory"
+		: "a"((long)56), "r"((long)flags), "r"(stack_top), "r"(entry), "r"(entry_arg)
+		: "rcx", "r11", "rdx", "rsi", "rdi", "r10", "memory"
 	);
 
 	return ret;
@@ -398,6 +398,15 @@ static inline void* __jacl_frame_address(int level) {
   #define JACL_WEAK
 #endif
 
+// keeps a big frame out of callers that never take the path needing it
+#if __has_attribute(noinline)
+  #define JACL_NOINLINE __attribute__((noinline, unused))
+#elif defined(_MSC_VER)
+  #define JACL_NOINLINE __declspec(noinline)
+#else
+  #define JACL_NOINLINE
+#endif
+
 /* ============================================================ */
 /* Vectorization Hints                                          */
 /* ============================================================ */
@@ -515,6 +524,11 @@ static inline void* __jacl_frame_address(int level) {
   #define JACL_HAS_PTHREADS 0
 #endif /* pthreads */
 
+// Stream and registry locking follows pthread availability
+#ifndef JACL_HAS_THREADS
+  #define JACL_HAS_THREADS JACL_HAS_PTHREADS
+#endif /* threads */
+
 // SIMD intrinsics
 #ifndef JACL_HAS_IMMINTRIN
   #if JACL_HAS_C99 && (defined(__SSE2__) || defined(__ARM_NEON) || defined(__wasm_simd128__))
@@ -74,16 +74,149 @@ typedef uint_least32_t __jacl_fmt_t;
 // ============= CHAR CONSTANTS =============
 static const char NANC[] = "NnAaNn", INFC[] = "IiNnFfIiNnIiTtYy", LD[] = "0123456789abcdef", UD[] = "0123456789ABCDEF", D100[] =
 	"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
-	"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+	"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899", LX256[] =
+	"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+	"404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+	"808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9fa0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+	"c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedfe0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", UX256[] =
+	"000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+	"404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+	"808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9FA0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+	"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDFE0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+// ============== OUTPUT SINK ===============
+/**
+ * NOTE: Output goes through a sink that takes whole spans (literal runs,
+ * digit buffers, padding blocks) rather than one fputc per character. A
+ * stream sink holds the FILE lock for the whole call and copies straight
+ * into its buffer; unbuffered descriptors collect into `stage` so one
+ * printf is one write(). A string sink copies what fits in `rem` and a sink
+ * with neither a stream nor a string only counts. `held` marks a stream whose
+ * lock the caller already took, so the sink leaves it alone.
+ */
+typedef struct {
+	FILE *stream;
+	char *out, *stage;
+	size_t rem, staged, cap;
+	int err, nl, held;
+} __jacl_sink_t;
+
+#define __jacl_sink_idle(sink) (!(sink)->stream && !(sink)->out)
+
+static inline void __jacl_sink_string(__jacl_sink_t *sink, char *out, size_t n) {
+	*sink = (__jacl_sink_t){ .out = n ? out : NULL, .rem = (out && n) ? n - 1 : 0 };
+}
+static inline int __jacl_sink_open(__jacl_sink_t *sink, FILE *f, char *stage, size_t cap, int held) {
+	*sink = (__jacl_sink_t){ .stream = f, .held = held };
+
+	if (!__jacl_stream_validate(f, 0)) return (sink->err = 1, -1);
+
+	__jacl_init_stdio();
+	if (!held) flockfile(f);
+	__jacl_switch_to_write(f);
+
+	if (!__JACL_HAS_MODE(f, __SWR)) { if (!held) funlockfile(f); __errno_set(EBADF); return (sink->err = 1, -1); }
+	if (f->_last_op == 1) __JACL_BUF_RESET(f);
+	if (f->_bufmode == _IONBF && !__JACL_HAS_MODE(f, __SMEM | __SCUSTOM)) { sink->stage = stage; sink->cap = cap; }
+
+	return 0;
+}
+static inline int __jacl_sink_drain(__jacl_sink_t *sink) {
+	size_t done = 0;
+
+	while (done < sink->staged && !sink->err) {
+		ssize_t w = write(sink->stream->_fd, sink->stage + done, sink->staged - done);
+
+		if (w > 0) done += (size_t)w;
+		else if (w < 0 && errno == EINTR) continue;
+		else { __JACL_SET_MODE(sink->stream, __SERR); sink->err = 1; }
+	}
+
+	sink->staged = 0;
+
+	return sink->err;
+}
+static inline void __jacl_sink_slow(__jacl_sink_t *sink, const char *s, size_t n) {
+	FILE *f = sink->stream;
+	size_t room;
+
+	if (sink->err) return;
+
+	if (sink->stage) {
+		while (n) {
+			if (sink->staged == sink->cap && __jacl_sink_drain(sink)) return;
+
+			room = sink->cap - sink->staged;
+			room = (n < room) ? n : room;
+
+			memcpy(sink->stage + sink->staged, s, room);
+			sink->staged += room; s += room; n -= room;
+		}
+
+		return;
+	}
+
+	while (n) {
+		if (f->_ptr >= f->_end && (__jacl_buffer_flush(f) == EOF || f->_ptr >= f->_end)) { sink->err = 1; return; }
+
+		room = (size_t)(f->_end - f->_ptr);
+		room = (n < room) ? n : room;
+
+		memcpy(f->_ptr, s, room);
+
+		if (f->_bufmode == _IOLBF && !sink->nl && memchr(s, '\n', room)) sink->nl = 1;
+
+		f->_ptr += room; s += room; n -= room;
+	}
+}
+static inline char *__jacl_sink_copy(char *d, const char *s, size_t n) {
+	if (n > 32) return (char *)memcpy(d, s, n) + n;
+
+	while (n--) *d++ = *s++;
+
+	return d;
+}
+static inline void __jacl_sink_put(__jacl_sink_t *sink, const char *s, size_t n) {
+	FILE *f = sink->stream;
+
+	if (!f) {
+		if (n > sink->rem) n = sink->rem;
+
+		sink->out = __jacl_sink_copy(sink->out, s, n);
+		sink->rem -= n;
+	} else if (!sink->stage && f->_bufmode != _IOLBF && (size_t)(f->_end - f->_ptr) >= n) {
+		f->_ptr = __jacl_sink_copy(f->_ptr, s, n);
+	} else __jacl_sink_slow(sink, s, n);
+}
+static inline void __jacl_sink_fill(__jacl_sink_t *sink, char ch, size_t n) {
+	char block[64];
+	size_t step = (n < sizeof(block)) ? n : sizeof(block);
+
+	memset(block, ch, step);
+
+	for (; n > step; n -= step) __jacl_sink_put(sink, block, step);
+
+	__jacl_sink_put(sink, block, n);
+}
+static inline int __jacl_sink_close(__jacl_sink_t *sink) {
+	FILE *f = sink->stream;
+
+	if (!f) { if (sink->out) *sink->out = '\0'; return 0; }
+
+	if (sink->stage) __jacl_sink_drain(sink);
+	else if (!sink->err && (f->_bufmode == _IONBF || sink->nl) && __jacl_buffer_flush(f) == EOF) sink->err = 1;
+
+	f->_last_op = 2;
+	if (!sink->held) funlockfile(f);
+
+	return sink->err ? -1 : 0;
+}
 
 // =========== WRITE PRIMITIVES ============
-#define __jacl_write_char(stream, out, rem, len, ch) do { \
-	if (stream) fputc((ch), stream); \
-	else if (out && *out && *rem > 0) { *(*out)++ = (ch); (*rem)--; }\
-	(len)++; \
-} while(0)
-#define __jacl_write_pad(stream, out, rem, len, ch, pad) do { int __i = (pad); while (__i-- > 0) __jacl_write_char(stream, out, rem, len, (ch)); } while(0)
-#define __jacl_write_sign(stream, out, rem, len, spec, neg) do { if (neg) __jacl_write_char(stream, out, rem, len, '-'); else if ((spec) & JACL_FMT_FLAG_plus) __jacl_write_char(stream, out, rem, len, '+'); else if JACL_FMT_HAS(FLAG, spec, spad) __jacl_write_char(stream, out, rem, len, ' '); } while(0)
+#define __jacl_write_span(sink, len, s, n) do { size_t __n = (n); __jacl_sink_put((sink), (s), __n); (len) += (int)__n; } while(0)
+#define __jacl_write_char(sink, len, ch) do { char __c = (char)(ch); __jacl_write_span(sink, len, &__c, 1); } while(0)
+#define __jacl_write_pad(sink, len, ch, pad) do { int __p = (pad); if (__p > 0) { __jacl_sink_fill((sink), (ch), (size_t)__p); (len) += __p; } } while(0)
+#define __jacl_write_sign(sink, len, spec, neg) do { if (neg) __jacl_write_char(sink, len, '-'); else if ((spec) & JACL_FMT_FLAG_plus) __jacl_write_char(sink, len, '+'); else if JACL_FMT_HAS(FLAG, spec, spad) __jacl_write_char(sink, len, ' '); } while(0)
 
 // ============ READ PRIMITIVES ============
 #define __jacl_isspace(c) ((c)==' ' || (c)=='\t' || (c)=='\n' || (c)=='\r' || (c)=='\f' || (c)=='\v')
@@ -104,6 +237,248 @@ static const char NANC[] = "NnAaNn", INFC[] = "IiNnFfIiNnIiTtYy", LD[] = "012345
 	} \
 } while(0)
 
+// =========== DECIMAL SCANNING ============
+/**
+ * NOTE: Digit runs in memory are taken eight at a time: one load, one test
+ * that all eight bytes are '0'-'9' and three multiplies to fold them into a
+ * number. Loads never cross into a page the run doesn't reach, the same rule
+ * string.h follows, and the tail goes a byte at a time.
+ */
+#ifdef __JACL_SWAR
+	typedef uint64_t __jacl_u64u_t __attribute__((__may_alias__, __aligned__(1)));
+#endif
+
+static inline uint64_t __jacl_load_eight(const char *p) {
+#ifdef __JACL_SWAR
+	uint64_t v = *(const __jacl_u64u_t *)(const void *)p;
+
+	#if JACL_HAS_BE
+		v = __builtin_bswap64(v);
+	#endif
+
+	return v;
+#else
+	uint64_t v = 0;
+
+	for (int i = 7; i >= 0; i--) v = (v << 8) | (unsigned char)p[i];
+
+	return v;
+#endif
+}
+static inline int __jacl_eight_digits(uint64_t v) {
+	return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+static inline uint32_t __jacl_parse_eight(uint64_t v) {
+	v -= 0x3030303030303030ULL;
+	v = (v * 10) + (v >> 8);
+	v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+
+	return (uint32_t)v;
+}
+static inline const char *__jacl_scan_digits(const char *p, uint64_t *w) {
+	uint64_t v;
+
+	while (__JACL_PAGE_SAFE(p, 8) && __jacl_eight_digits(v = __jacl_load_eight(p))) { *w = *w * 100000000u + __jacl_parse_eight(v); p += 8; }
+	while ((unsigned)(*p - '0') < 10) *w = *w * 10 + (uint64_t)(*p++ - '0');
+
+	return p;
+}
+
+/**
+ * Read a decimal floating constant (sign, digits with at most one point,
+ * optional exponent) at s into d. Returns the end, or s when there are no
+ * digits. Hex, inf and nan are left to the callers.
+ */
+static inline const char *__jacl_scan_decimal(const char *s, __jacl_decimal_t *d) {
+	const char *p = s, *digits, *end;
+	uint64_t w = 0;
+	int32_t frac = 0, exp = 0, n;
+
+	d->neg = (*p == '-');
+	d->trunc = d->sticky = 0;
+
+	if (*p == '-' || *p == '+') p++;
+
+	digits = p;
+	p = __jacl_scan_digits(p, &w);
+	n = (int32_t)(p - digits);
+
+	if (*p == '.') {
+		const char *dot = ++p;
+
+		p = __jacl_scan_digits(p, &w);
+		frac = (int32_t)(p - dot);
+		n += frac;
+	}
+
+	if (!n) return s;
+
+	end = p;
+
+	if (*p == 'e' || *p == 'E') {
+		const char *e = p + 1;
+		int eneg = (*e == '-');
+
+		if (*e == '-' || *e == '+') e++;
+		if ((unsigned)(*e - '0') < 10) {
+			for (; (unsigned)(*e - '0') < 10; e++) if (exp < 100000) exp = exp * 10 + (*e - '0');
+
+			p = e;
+
+			if (eneg) exp = -exp;
+		}
+	}
+
+	d->text = digits;
+	d->len = (size_t)(end - digits);
+	d->q = exp - frac;
+
+	// w wrapped: start over from the first significant digit and keep 19
+	if (n > 19) {
+		const char *c = digits;
+		int32_t kept = 0, left = 0;
+
+		for (; c < end && (*c == '0' || *c == '.'); c++);
+
+		if (end - c > 19) {
+			for (w = 0; c < end; c++) {
+				if (*c == '.') continue;
+				if (kept < 19) { w = w * 10 + (uint64_t)(*c - '0'); kept++; }
+				else { left++; d->trunc |= *c != '0'; }
+			}
+
+			d->q = exp - frac + left;
+		}
+	}
+
+	d->w = w;
+
+	return p;
+}
+
+// ============= INTEGER TEXT ==============
+/**
+ * NOTE: The integer <-> text primitives under printf, scanf and strto*.
+ * Writing goes backwards from the end of the caller's buffer. Decimal
+ * splits off eight digits with one 64-bit divide and then works in 32 bits,
+ * two digits at a time out of D100; hex writes a byte at a time out of
+ * LX256 / UX256. Reading in place takes eight decimal or hex digits per load
+ * when the run allows it and falls back to a byte at a time, with the
+ * overflow cutoff worked out once rather than divided out per digit.
+ */
+static inline char *__jacl_utoa_dec(char *end, uintmax_t v) {
+	char *p = end;
+	uint32_t w, d;
+
+	while (v >= 100000000u) {
+		w = (uint32_t)(v % 100000000u);
+		v /= 100000000u;
+
+		for (int i = 0; i < 4; i++, w /= 100) { d = (w % 100) * 2; p -= 2; p[0] = D100[d]; p[1] = D100[d + 1]; }
+	}
+
+	for (w = (uint32_t)v; w >= 100; w /= 100) { d = (w % 100) * 2; p -= 2; p[0] = D100[d]; p[1] = D100[d + 1]; }
+
+	if (w >= 10) { p -= 2; p[0] = D100[w * 2]; p[1] = D100[w * 2 + 1]; }
+	else *--p = (char)('0' + w);
+
+	return p;
+}
+static inline char *__jacl_utoa_hex(char *end, uintmax_t v, int upper) {
+	const char *pair = upper ? UX256 : LX256;
+	char *p = end;
+
+	for (; v >= 0x100; v >>= 8) { p -= 2; p[0] = pair[(v & 0xFF) * 2]; p[1] = pair[(v & 0xFF) * 2 + 1]; }
+
+	if (v >= 0x10) { p -= 2; p[0] = pair[v * 2]; p[1] = pair[v * 2 + 1]; }
+	else *--p = (upper ? UD : LD)[v];
+
+	return p;
+}
+static inline char *__jacl_utoa(char *end, uintmax_t v, int base, int upper) {
+	char *p = end;
+
+	if (base == 10) return __jacl_utoa_dec(end, v);
+	if (base == 16) return __jacl_utoa_hex(end, v, upper);
+
+	do { *--p = (upper ? UD : LD)[v % (unsigned)base]; v /= (unsigned)base; } while (v);
+
+	return p;
+}
+
+static inline int __jacl_eight_hex(uint64_t v, uint64_t *nib) {
+	uint64_t x = v | 0x2020202020202020ULL, hi = 0x8080808080808080ULL;
+	uint64_t dig = (v + 0x5050505050505050ULL) & ~(v + 0x4646464646464646ULL) & hi;
+	uint64_t alpha = (x + 0x1F1F1F1F1F1F1F1FULL) & ~(x + 0x1919191919191919ULL) & hi;
+
+	if ((v & hi) || (dig | alpha) != hi) return 0;
+
+	*nib = (x & 0x0F0F0F0F0F0F0F0FULL) + (alpha >> 7) * 9;
+
+	return 1;
+}
+static inline uint32_t __jacl_parse_eight_hex(uint64_t n) {
+	// first character in the low byte: fold neighbours, high nibble first
+	n = ((n << 4) + (n >> 8)) & 0x00FF00FF00FF00FFULL;
+	n = ((n << 8) + (n >> 16)) & 0x0000FFFF0000FFFFULL;
+
+	return (uint32_t)((n << 16) + (n >> 32));
+}
+
+/**
+ * At most `max` digits of `base` at s into *val. Returns the end of the
+ * digits. On overflow *val sticks at UINTMAX_MAX, errno gets ERANGE and the
+ * rest of the digits are still consumed.
+ */
+static inline const char *__jacl_scan_uint(const char *s, int base, size_t max, uintmax_t *val) {
+	const uintmax_t cutoff = UINTMAX_MAX / (unsigned)base;
+	const unsigned cutlim = (unsigned)(UINTMAX_MAX % (unsigned)base);
+	const char *p = s;
+	uintmax_t v = *val;
+	uint64_t w, n;
+	int over = 0;
+
+	#if UINTMAX_MAX == UINT64_MAX
+		if (base == 10) {
+			while (max >= 8 && __JACL_PAGE_SAFE(p, 8) && __jacl_eight_digits(w = __jacl_load_eight(p))) {
+				uint32_t chunk = __jacl_parse_eight(w);
+
+				if (v > 184467440737u || (v == 184467440737u && chunk > 9551615u)) over = 1;
+				else v = v * 100000000u + chunk;
+
+				p += 8;
+				max -= 8;
+			}
+		} else if (base == 16) {
+			while (max >= 8 && __JACL_PAGE_SAFE(p, 8) && __jacl_eight_hex(__jacl_load_eight(p), &n)) {
+				if (v >> 32) over = 1;
+				else v = (v << 32) | __jacl_parse_eight_hex(n);
+
+				p += 8;
+				max -= 8;
+			}
+		}
+	#endif
+
+	for (; max; p++, max--) {
+		unsigned c = (unsigned char)*p, d = c - '0';
+
+		if (d > 9) {
+			c |= 0x20;
+			d = (c >= 'a' && c <= 'z') ? c - 'a' + 10 : 36;
+		}
+		if (d >= (unsigned)base) break;
+		if (v > cutoff || (v == cutoff && d > cutlim)) over = 1;
+		else v = v * (unsigned)base + d;
+	}
+
+	if (over) { __errno_set(ERANGE); v = UINTMAX_MAX; }
+
+	*val = v;
+
+	return p;
+}
+
 // ============= SPEC FUNCTIONS =============
 #define CASE(ch, N) case ch: (*fmt)++; return JACL_FMT_VAL(LENGTH, N)
 static inline int __jacl_spec_length(const char **restrict fmt) {
@@ -233,87 +608,73 @@ static inline void __jacl_set_unsigned(__jacl_fmt_t spec, va_list ap, uintmax_t
 #undef CASE
 
 // ============ OUTPUT FUNCTIONS ============
-static inline int __jacl_output_str(FILE * stream, char **out, size_t *rem, __jacl_fmt_t spec, const char *str, int prec, int width) {
-	int len = 0, slen = 0, pad = 0, pos = 0;
-	const char *s = str;
+static inline int __jacl_output_str(__jacl_sink_t *sink, __jacl_fmt_t spec, const char *str, int prec, int width) {
+	int len = 0, slen = 0, pad = 0;
 
 	if (prec < 0) prec = INT_MAX;
-	while (s[slen] && slen < prec) slen++;
+	while (str[slen] && slen < prec) slen++;
 
 	pad = (width > slen) ? width - slen : 0;
 
-	if (!JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
-	while (pos < slen) __jacl_write_char(stream, out, rem, len, str[pos++]);
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (__jacl_sink_idle(sink)) return slen + pad;
+	if (!JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
+	__jacl_write_span(sink, len, str, (size_t)slen);
+	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
 
 	return len;
 }
-#define CASE(base, mask, shift) case JACL_FMT_VAL(BASE,base): while (val) { buf[pos++] = digits[val & mask]; val >>= shift; } break;
-static inline int __jacl_output_int(FILE * stream, char **out, size_t *rem, const __jacl_fmt_t spec, uintmax_t val, int prec, int width) {
-	int pos = 0, num, neg = (JACL_FMT_HAS(FLAG, spec, sign) && (intmax_t)val < 0), pad, len = 0, sign = JACL_FMT_HAS(FLAG, spec, sign) && (neg || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), prefix = 0;
-	const char *digits = JACL_FMT_HAS(FLAG, spec, upper) ? UD : LD;
-	char buf[64] = {0};
+#define CASE(N, base) case JACL_FMT_VAL(BASE,N): pos = (int)(__jacl_utoa(buf + 64, val, base, upper) - buf); break;
+static inline int __jacl_output_int(__jacl_sink_t *sink, const __jacl_fmt_t spec, uintmax_t val, int prec, int width) {
+	int pos = 64, num, zeros, neg = (JACL_FMT_HAS(FLAG, spec, sign) && (intmax_t)val < 0), pad, len = 0, sign = JACL_FMT_HAS(FLAG, spec, sign) && (neg || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), prefix = 0;
+	int upper = JACL_FMT_HAS(FLAG, spec, upper) != 0;
+	char buf[64], pre[2] = { '0' };
 
 	if (neg) val = (uintmax_t)(-(intmax_t)val);
 	if (JACL_FMT_HAS(FLAG, spec, pref) && val) {
 		if (JACL_FMT_CHK(BASE, spec, hex) || JACL_FMT_CHK(BASE, spec, bin)) prefix = 2;
 		else if (JACL_FMT_CHK(BASE, spec, oct)) prefix = 1;
 	}
-	if (!(prec == 0 && val == 0)) {
-		if (val == 0) buf[pos++] = '0';
-		else switch (JACL_FMT_GET(BASE, spec)) {
-		CASE(hex, 0xF, 4); CASE(oct, 0x7, 3); CASE(bin, 0x1, 1);
-		default:
-			while (val >= 100) {
-				int digits = val % 100;
-				buf[pos++] = D100[digits * 2 + 1];
-				buf[pos++] = D100[digits * 2];
-				val /= 100;
-			}
-			if (val >= 10) {
-				buf[pos++] = D100[val * 2 + 1];
-				buf[pos++] = D100[val * 2];
-			} else buf[pos++] = '0' + val;
-		}
+	if (!(prec == 0 && val == 0)) switch (JACL_FMT_GET(BASE, spec)) {
+	CASE(hex, 16); CASE(oct, 8); CASE(bin, 2);
+	default: pos = (int)(__jacl_utoa_dec(buf + 64, val) - buf);
 	}
-	while (pos < prec && pos < 64) buf[pos++] = '0';
 
-	pad = (width > pos + sign + prefix) ? width - pos - sign - prefix : 0;
+	num = 64 - pos;
+	zeros = (prec > num) ? prec - num : 0;
+	pad = (width > num + zeros + sign + prefix) ? width - num - zeros - sign - prefix : 0;
 
-	if (!stream && (!out || !*out)) return pos + sign + prefix + pad;
-	if (!JACL_FMT_HAS(FLAG, spec, left) && !(JACL_FMT_HAS(FLAG, spec, zpad) && (prec < 0))) __jacl_write_pad(stream, out, rem, len, ' ', pad);
-	if (sign) __jacl_write_sign(stream, out, rem, len, spec, neg);
-	if (prefix) { __jacl_write_char(stream, out, rem, len, '0'); if (prefix == 2) __jacl_write_char(stream, out, rem, len, JACL_FMT_HAS(FLAG, spec, upper) ? (JACL_FMT_CHK(BASE, spec, hex) ? 'X' : 'B') : (JACL_FMT_CHK(BASE, spec, hex) ? 'x' : 'b')); }
-	if (!JACL_FMT_HAS(FLAG, spec, left) && (JACL_FMT_HAS(FLAG, spec, zpad) && (prec < 0))) __jacl_write_pad(stream, out, rem, len, '0', pad);
-	while (pos--) __jacl_write_char(stream, out, rem, len, buf[pos]);
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (__jacl_sink_idle(sink)) return num + zeros + sign + prefix + pad;
+	if (prefix == 2) pre[1] = JACL_FMT_HAS(FLAG, spec, upper) ? (JACL_FMT_CHK(BASE, spec, hex) ? 'X' : 'B') : (JACL_FMT_CHK(BASE, spec, hex) ? 'x' : 'b');
+	if (!JACL_FMT_HAS(FLAG, spec, left) && !(JACL_FMT_HAS(FLAG, spec, zpad) && (prec < 0))) __jacl_write_pad(sink, len, ' ', pad);
+	if (sign) __jacl_write_sign(sink, len, spec, neg);
+	if (prefix) __jacl_write_span(sink, len, pre, (size_t)prefix);
+	if (!JACL_FMT_HAS(FLAG, spec, left) && (JACL_FMT_HAS(FLAG, spec, zpad) && (prec < 0))) __jacl_write_pad(sink, len, '0', pad);
+	__jacl_write_pad(sink, len, '0', zeros);
+	__jacl_write_span(sink, len, buf + pos, (size_t)num);
+	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
 
 	return len;
 }
 #undef CASE
-static inline int __jacl_output_special(FILE * stream, char **out, size_t *rem, const __jacl_fmt_t spec, int val, int neg, int width) {
+static inline int __jacl_output_special(__jacl_sink_t *sink, const __jacl_fmt_t spec, int val, int neg, int width) {
 	int sign = (neg || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), count = sign + 3, pad = 0, len = 0;
 
 	pad = (width > count) ? width - count : 0;
 
-	if (!stream && (!out || !*out)) return count + pad;
-	if (!JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
-	if (sign) __jacl_write_sign(stream, out, rem, len, spec, neg);
-	if (val == JACL_VAL_NAN) len += __jacl_output_str(stream, out, rem, spec, JACL_FMT_HAS(FLAG, spec, upper) ? "NAN" : "nan", 3, 0);
-	if (val == JACL_VAL_INF) len += __jacl_output_str(stream, out, rem, spec, JACL_FMT_HAS(FLAG, spec, upper) ? "INF" : "inf", 3, 0);
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (__jacl_sink_idle(sink)) return count + pad;
+	if (!JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
+	if (sign) __jacl_write_sign(sink, len, spec, neg);
+	if (val == JACL_VAL_NAN) __jacl_write_span(sink, len, JACL_FMT_HAS(FLAG, spec, upper) ? "NAN" : "nan", 3);
+	if (val == JACL_VAL_INF) __jacl_write_span(sink, len, JACL_FMT_HAS(FLAG, spec, upper) ? "INF" : "inf", 3);
+	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
 
 	return len;
 }
-static inline int __jacl_output_float(FILE * stream, char **out, size_t *rem, const __jacl_fmt_t spec, long double val, int prec, int width) {
-	if (prec < 0) prec = 6;
-
-	__jacl_fdigits_t dec = __jacl_fdigits(val, prec, 0, JACL_FMT_CHK(LENGTH, spec, L));
-
-	int i, len = 0, sign = (dec.sign || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), ipart = (dec.exp >= 0) ? (dec.exp + 1) : 0, digits = dec.end - dec.start;
-	int whole = (ipart < digits) ? ipart : digits, lead = (dec.exp < 0) ? -(dec.exp + 1) : 0, post = (i = digits - whole) < (prec - lead) ? i : (prec - lead), trail, pad, total;
+static inline int __jacl_emit_float(__jacl_sink_t *sink, const __jacl_fmt_t spec, const __jacl_fdigits_t *dec, int prec, int width) {
+	int i, len = 0, sign = (dec->sign || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), ipart = (dec->exp >= 0) ? (dec->exp + 1) : 0, digits = dec->end - dec->start;
+	int whole = (ipart < digits) ? ipart : digits, lead = (dec->exp < 0) ? -(dec->exp + 1) : 0, post = (i = digits - whole) < (prec - lead) ? i : (prec - lead), trail, pad, total;
 
-	if (dec.digits[0] > '9') return __jacl_output_special(stream, out, rem, spec, (val != val) ? JACL_VAL_NAN : JACL_VAL_INF, dec.sign, width);
+	if (lead > prec) lead = prec;
 	if (post < 0) post = 0;
 
 	trail = prec - lead - post;
@@ -321,108 +682,131 @@ static inline int __jacl_output_float(FILE * stream, char **out, size_t *rem, co
 	total = sign + (ipart ? ipart : 1) + (prec > 0 || JACL_FMT_HAS(FLAG, spec, pref)) + lead + post + trail;
 	pad = (width > total) ? width - total : 0;
 
-	if (!stream && (!out || !*out)) return total + pad;
-	if (!JACL_FMT_HAS(FLAG, spec, left) && !JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
-	if (sign) __jacl_write_sign(stream, out, rem, len, spec, dec.sign);
-	if (!JACL_FMT_HAS(FLAG, spec, left) && JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, '0', pad);
-	if (!ipart) __jacl_write_char(stream, out, rem, len, '0');
-	else { for (i = 0; i < whole; i++) __jacl_write_char(stream, out, rem, len, dec.digits[dec.start + i]); for (i = whole; i < ipart; i++) __jacl_write_char(stream, out, rem, len, '0'); }
-	if (prec > 0 || JACL_FMT_HAS(FLAG, spec, pref)) __jacl_write_char(stream, out, rem, len, '.');
-	for (i = 0; i < lead; i++) __jacl_write_char(stream, out, rem, len, '0');
-	for (i = 0; i < post; i++) __jacl_write_char(stream, out, rem, len, dec.digits[dec.start + whole + i]);
-	for (i = 0; i < trail; i++) __jacl_write_char(stream, out, rem, len, '0');
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (__jacl_sink_idle(sink)) return total + pad;
+	if (!JACL_FMT_HAS(FLAG, spec, left) && !JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(sink, len, ' ', pad);
+	if (sign) __jacl_write_sign(sink, len, spec, dec->sign);
+	if (!JACL_FMT_HAS(FLAG, spec, left) && JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(sink, len, '0', pad);
+	if (!ipart) __jacl_write_char(sink, len, '0');
+	else { __jacl_write_span(sink, len, dec->digits + dec->start, (size_t)whole); __jacl_write_pad(sink, len, '0', ipart - whole); }
+	if (prec > 0 || JACL_FMT_HAS(FLAG, spec, pref)) __jacl_write_char(sink, len, '.');
+	__jacl_write_pad(sink, len, '0', lead);
+	__jacl_write_span(sink, len, dec->digits + dec->start + whole, (size_t)post);
+	__jacl_write_pad(sink, len, '0', trail);
+	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
 
 	return len;
 }
-static inline int __jacl_output_exp(FILE * stream, char **out, size_t *rem, const __jacl_fmt_t spec, long double val, int prec, int width) {
-	if (prec < 0) prec = 6;
-
+static inline int __jacl_emit_exp(__jacl_sink_t *sink, const __jacl_fmt_t spec, const __jacl_fdigits_t *dec, int prec, int width) {
 	__jacl_fmt_t blank = {0};
-	__jacl_fdigits_t dec = __jacl_fdigits(val, 0, prec + 1, JACL_FMT_CHK(LENGTH, spec, L));
-	int i, len = 0, sign = (dec.sign || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), expval = (dec.exp < 0) ? -dec.exp : dec.exp, expdig = (expval < 10) ? 2 : (expval < 100) ? 2 : 3;
-	int total = sign + 1 + (prec > 0 || JACL_FMT_HAS(FLAG, spec, pref)) + prec + 2 + expdig, pad = (width > total) ? width - total : 0, remain;
+	int len = 0, sign = (dec->sign || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), expval = (dec->exp < 0) ? -dec->exp : dec->exp, expdig = (expval < 10) ? 2 : (expval < 100) ? 2 : 3;
+	int total = sign + 1 + (prec > 0 || JACL_FMT_HAS(FLAG, spec, pref)) + prec + 2 + expdig, pad = (width > total) ? width - total : 0, frac = dec->end - dec->start - 1;
+	char mark[2] = { JACL_FMT_HAS(FLAG, spec, upper) ? 'E' : 'e', dec->exp < 0 ? '-' : '+' };
+
+	if (__jacl_sink_idle(sink)) return total + pad;
+	if (!JACL_FMT_HAS(FLAG, spec, left) && !JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(sink, len, ' ', pad);
+	if (sign) __jacl_write_sign(sink, len, spec, dec->sign);
+	if (!JACL_FMT_HAS(FLAG, spec, left) && JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(sink, len, '0', pad);
 
-	if (dec.digits[0] > '9') return __jacl_output_special(stream, out, rem, spec, (val != val) ? JACL_VAL_NAN : JACL_VAL_INF, dec.sign, width);
-	if (!stream && (!out || !*out)) return total + pad;
-	if (!JACL_FMT_HAS(FLAG, spec, left) && !JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
-	if (sign) __jacl_write_sign(stream, out, rem, len, spec, dec.sign);
-	if (!JACL_FMT_HAS(FLAG, spec, left) && JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, '0', pad);
+	__jacl_write_char(sink, len, dec->digits[dec->start]);
 
-	__jacl_write_char(stream, out, rem, len, dec.digits[dec.start]);
+	if (frac > prec) frac = prec;
+	if (frac < 0) frac = 0;
+	if (prec > 0 || JACL_FMT_HAS(FLAG, spec, pref)) __jacl_write_char(sink, len, '.');
 
-	if (prec > 0 || JACL_FMT_HAS(FLAG, spec, pref)) __jacl_write_char(stream, out, rem, len, '.');
-	for (i = dec.start + 1, remain = prec; i < dec.end && remain > 0; i++, remain--) __jacl_write_char(stream, out, rem, len, dec.digits[i]);
-	while (remain-- > 0) __jacl_write_char(stream, out, rem, len, '0');
+	__jacl_write_span(sink, len, dec->digits + dec->start + 1, (size_t)frac);
+	__jacl_write_pad(sink, len, '0', prec - frac);
+	__jacl_write_span(sink, len, mark, 2);
 
-	__jacl_write_char(stream, out, rem, len, JACL_FMT_HAS(FLAG, spec, upper) ? 'E' : 'e');
-	__jacl_write_char(stream, out, rem, len, dec.exp < 0 ? '-' : '+');
-	len += __jacl_output_int(stream, out, rem, blank, expval, 2, 0);
+	len += __jacl_output_int(sink, blank, expval, 2, 0);
 
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
 
 	return len;
 }
-static inline int __jacl_output_gen(FILE * stream, char **out, size_t *rem, const __jacl_fmt_t spec, long double val, int prec, int width) {
-	char buf[256], *ptr = buf;
-	size_t size = sizeof(buf);
-	long double check = __jacl_signclr_LDBL(val);
-	int i, ex, ep, dp, total, neg = __jacl_signget_LDBL(val), sign = (neg || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad)), len = 0, pad = 0, exp;
-	__jacl_fmt_t blank = {0};
+/**
+ * NOTE: %g picks its style from the exponent after rounding to P digits, so
+ * the digits are produced once and handed to the %e or %f emitter with the
+ * precision that shows exactly what is left after the trailing zeros go.
+ */
+static inline int __jacl_emit_gen(__jacl_sink_t *sink, const __jacl_fmt_t spec, __jacl_fdigits_t *dec, int prec, int width) {
+	int x = dec->exp, digits;
+
+	if (!JACL_FMT_HAS(FLAG, spec, pref)) while (dec->end - dec->start > 1 && dec->digits[dec->end - 1] == '0') dec->end--;
+
+	digits = dec->end - dec->start;
+
+	if (x < -4 || x >= prec) return __jacl_emit_exp(sink, spec, dec, JACL_FMT_HAS(FLAG, spec, pref) ? prec - 1 : digits - 1, width);
+
+	return __jacl_emit_float(sink, spec, dec, JACL_FMT_HAS(FLAG, spec, pref) ? prec - 1 - x : (digits - 1 - x > 0 ? digits - 1 - x : 0), width);
+}
+static inline int __jacl_output_float(__jacl_sink_t *sink, const __jacl_fmt_t spec, long double val, int prec, int width) {
+	if (prec < 0) prec = 6;
+
+	__jacl_fdigits_t dec = __jacl_fdigits(val, prec, 0, JACL_FMT_CHK(LENGTH, spec, L));
+
+	if (dec.digits[0] > '9') return __jacl_output_special(sink, spec, dec.digits[0] == 'n' ? JACL_VAL_NAN : JACL_VAL_INF, dec.sign, width);
+
+	return __jacl_emit_float(sink, spec, &dec, prec, width);
+}
+static inline int __jacl_output_exp(__jacl_sink_t *sink, const __jacl_fmt_t spec, long double val, int prec, int width) {
+	if (prec < 0) prec = 6;
+
+	__jacl_fdigits_t dec = __jacl_fdigits(val, 0, prec + 1, JACL_FMT_CHK(LENGTH, spec, L));
 
-	blank |= JACL_FMT_HAS(FLAG, spec, upper);
+	if (dec.digits[0] > '9') return __jacl_output_special(sink, spec, dec.digits[0] == 'n' ? JACL_VAL_NAN : JACL_VAL_INF, dec.sign, width);
 
+	return __jacl_emit_exp(sink, spec, &dec, prec, width);
+}
+static inline int __jacl_output_gen(__jacl_sink_t *sink, const __jacl_fmt_t spec, long double val, int prec, int width) {
 	if (prec < 0) prec = 6;
 	if (prec == 0) prec = 1;
-	if (prec > LDBL_DIG) prec = LDBL_DIG;
-	if (isnan(val)) return __jacl_output_special(stream, out, rem, spec, JACL_VAL_NAN, neg, width);
-	if (isinf(val)) return __jacl_output_special(stream, out, rem, spec, JACL_VAL_INF, neg, width);
 
-	// Calculate exponent
-	for (exp = 0; check >= 10.0; check *= 0.1, exp++);
-	for (; check < 1.0 && check > 0.0; check *= 10.0, exp--);
+	__jacl_fdigits_t dec = __jacl_fdigits(val, 0, prec, JACL_FMT_CHK(LENGTH, spec, L));
 
-	// Format using exp or float, with absolute value
-	val = __jacl_signclr_LDBL(val);
-	total = (exp < -4 || exp >= prec)
-	      ? __jacl_output_exp(NULL, &ptr, &size, blank, val, prec - 1, 0)
-	      : __jacl_output_float(NULL, &ptr, &size, blank, val, (prec - exp - 1 > 0) ? prec - exp - 1 : 0, 0);
+	if (dec.digits[0] > '9') return __jacl_output_special(sink, spec, dec.digits[0] == 'n' ? JACL_VAL_NAN : JACL_VAL_INF, dec.sign, width);
 
-	// Find exponent and decimal point
-	for (ep = 0; ep < total && buf[ep] != 'e' && buf[ep] != 'E'; ep++);
-	for (dp = 0; dp < ep && buf[dp] != '.'; dp++);
+	return __jacl_emit_gen(sink, spec, &dec, prec, width);
+}
+/**
+ * NOTE: %r (an extension) prints the shortest digits that read back to the
+ * same double, or float with `h`, laid out like %g with an exponent once it
+ * passes 16 digits or drops below 1e-4. A positive precision makes it plain
+ * %g. There is no shortest engine for a wider long double, so %Lr prints
+ * LDBL_DIG significant digits instead.
+ */
+static inline int __jacl_output_short(__jacl_sink_t *sink, const __jacl_fmt_t spec, long double val, int prec, int width) {
+	if (prec > 0 || (JACL_FMT_CHK(LENGTH, spec, L) && LDBL_MANT_DIG != DBL_MANT_DIG)) return __jacl_output_gen(sink, spec, val, prec > 0 ? prec : LDBL_DIG, width);
 
-	// Strip trailing zeros only if there's a decimal point
-	if (dp < (ex = ep)) {
-		while (ex > dp + 1 && buf[ex - 1] == '0') ex--;
-		if (ex > 0 && !JACL_FMT_HAS(FLAG, spec, pref) && buf[ex - 1] == '.') ex--;
-	}
+	__jacl_fdigits_t dec;
+	__jacl_ryu_t r;
+	int n = 0;
 
-	// Copy exponent forward if present
-	while (ep < total) buf[ex++] = buf[ep++];
+	dec.start = 0;
+	dec.sign = __jacl_signget_LDBL(val);
 
-	// Calculate padding
-	if (width > sign + ex) pad = width - sign - ex;
-	if (!stream && (!out || !*out)) return sign + pad + ex;
+	if (isnan(val)) return __jacl_output_special(sink, spec, JACL_VAL_NAN, dec.sign, width);
+	if (isinf(val)) return __jacl_output_special(sink, spec, JACL_VAL_INF, dec.sign, width);
 
-	// Output with padding
-	if (!JACL_FMT_HAS(FLAG, spec, left) && !JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
-	if (sign) __jacl_write_sign(stream, out, rem, len, spec, neg);
-	if (!JACL_FMT_HAS(FLAG, spec, left) && JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, '0', pad);
-	for (i = 0; i < ex; i++) __jacl_write_char(stream, out, rem, len, buf[i]);
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (val == 0.0L) r = (__jacl_ryu_t){ 0, 0 };
+	else r = JACL_FMT_CHK(LENGTH, spec, h) ? __jacl_ryu_FLT((float)__jacl_signclr_LDBL(val)) : __jacl_ryu_DBL((double)__jacl_signclr_LDBL(val));
 
-	return len;
+	do dec.digits[n++] = '0' + r.digits % 10; while (r.digits /= 10);
+	for (int i = 0; i < n / 2; i++) { char t = dec.digits[i]; dec.digits[i] = dec.digits[n - 1 - i]; dec.digits[n - 1 - i] = t; }
+
+	dec.end = (uint16_t)n;
+	dec.exp = (int16_t)(r.exp + n - 1);
+
+	return __jacl_emit_gen(sink, spec, &dec, 16, width);
 }
-static inline int __jacl_output_alt(FILE * stream, char **out, size_t *rem, const __jacl_fmt_t spec, long double val, int prec, int width) {
-	char hex[LDBL_MANT_DIG / 4 + 2] = {0};
+static inline int __jacl_output_alt(__jacl_sink_t *sink, const __jacl_fmt_t spec, long double val, int prec, int width) {
+	char hex[LDBL_MANT_DIG / 4 + 2] = {0}, text[LDBL_MANT_DIG / 4 + 12], *t = text;
 	int exp, neg = __jacl_signget_LDBL(val), len = 0, leading = 0, num_digits = 0, max_digits = LDBL_MANT_DIG / 4, limit, exponent_absolute, total, padding, i;
 	int sign = (neg || JACL_FMT_HAS(FLAG, spec, plus) || JACL_FMT_HAS(FLAG, spec, spad));
-	const char *digits_ptr;
+	const char *digits_ptr = JACL_FMT_HAS(FLAG, spec, upper) ? UD : LD;
 	long double mantissa = val;
 
-	if (isnan(val)) return __jacl_output_special(stream, out, rem, spec, JACL_VAL_NAN, neg, width);
-	if (isinf(val)) return __jacl_output_special(stream, out, rem, spec, JACL_VAL_INF, neg, width);
+	if (isnan(val)) return __jacl_output_special(sink, spec, JACL_VAL_NAN, neg, width);
+	if (isinf(val)) return __jacl_output_special(sink, spec, JACL_VAL_INF, neg, width);
 
 	// Extract mantissa and exponent
 	if (val != 0.0L) {
@@ -460,77 +844,75 @@ static inline int __jacl_output_alt(FILE * stream, char **out, size_t *rem, cons
 	padding = (width > total) ? width - total : 0;
 
 	// Output with sign, prefix, and padding
-	if (!stream && (!out || !*out)) return total + padding;
-	if (!JACL_FMT_HAS(FLAG, spec, left) && !JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, ' ', padding);
-	if (sign) __jacl_write_sign(stream, out, rem, len, spec, neg);
+	if (__jacl_sink_idle(sink)) return total + padding;
+	if (!JACL_FMT_HAS(FLAG, spec, left) && !JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(sink, len, ' ', padding);
+	if (sign) __jacl_write_sign(sink, len, spec, neg);
 
-	__jacl_write_char(stream, out, rem, len, '0');
-	__jacl_write_char(stream, out, rem, len, JACL_FMT_HAS(FLAG, spec, upper) ? 'X' : 'x');
+	__jacl_write_span(sink, len, JACL_FMT_HAS(FLAG, spec, upper) ? "0X" : "0x", 2);
 
-	if (!JACL_FMT_HAS(FLAG, spec, left) && JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(stream, out, rem, len, '0', padding);
+	if (!JACL_FMT_HAS(FLAG, spec, left) && JACL_FMT_HAS(FLAG, spec, zpad)) __jacl_write_pad(sink, len, '0', padding);
 
-	// Output mantissa
-	__jacl_write_char(stream, out, rem, len, '0' + leading);
+	// Mantissa, decimal point and fractional digits (or just decimal point if # flag)
+	*t++ = '0' + leading;
 
-	// Output decimal point and fractional digits (or just decimal point if # flag)
 	if (num_digits || JACL_FMT_HAS(FLAG, spec, pref)) {
-		digits_ptr = JACL_FMT_HAS(FLAG, spec, upper) ? UD : LD;
-
-		__jacl_write_char(stream, out, rem, len, '.');
+		*t++ = '.';
 
-		for (i = 0; i < num_digits; i++) __jacl_write_char(stream, out, rem, len, digits_ptr[hex[i]]);
+		for (i = 0; i < num_digits; i++) *t++ = digits_ptr[(int)hex[i]];
 	}
 
-	// Output exponent
-	__jacl_write_char(stream, out, rem, len, JACL_FMT_HAS(FLAG, spec, upper) ? 'P' : 'p');
-	__jacl_write_char(stream, out, rem, len, (exp < 0) ? '-' : '+');
+	// Exponent
+	*t++ = JACL_FMT_HAS(FLAG, spec, upper) ? 'P' : 'p';
+	*t++ = (exp < 0) ? '-' : '+';
 
-	if (exponent_absolute >= 100) __jacl_write_char(stream, out, rem, len, '0' + exponent_absolute / 100);
-	if (exponent_absolute >= 10) __jacl_write_char(stream, out, rem, len, '0' + (exponent_absolute / 10) % 10);
+	if (exponent_absolute >= 100) *t++ = '0' + exponent_absolute / 100;
+	if (exponent_absolute >= 10) *t++ = '0' + (exponent_absolute / 10) % 10;
 
-	__jacl_write_char(stream, out, rem, len, '0' + exponent_absolute % 10);
+	*t++ = '0' + exponent_absolute % 10;
 
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', padding);
+	__jacl_write_span(sink, len, text, (size_t)(t - text));
+
+	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', padding);
 
 	return len;
 }
 
 // ============ PRINTF FUNCTIONS ============
-static inline int __jacl_printf_ptr(FILE * stream, char **out, size_t *rem, __jacl_fmt_t spec, va_list ap, int prec, int width) {
+static inline int __jacl_printf_ptr(__jacl_sink_t *sink, __jacl_fmt_t spec, va_list ap, int prec, int width) {
 	void *p = va_arg(ap, void*);
 	union { void *p; uintmax_t u; } u;
 
 	return (u.p = p)
-	     ? __jacl_output_int(stream, out, rem, JACL_FMT_SET(BASE, spec, hex) | JACL_FMT_FLAG_pref, u.u, -1, width)
-	     : __jacl_output_str(stream, out, rem, spec, "0x0", 3, width);
+	     ? __jacl_output_int(sink, JACL_FMT_SET(BASE, spec, hex) | JACL_FMT_FLAG_pref, u.u, -1, width)
+	     : __jacl_output_str(sink, spec, "0x0", 3, width);
 }
-static inline int __jacl_printf_char(FILE * stream, char **out, size_t *rem, __jacl_fmt_t spec, va_list ap, int prec, int width) {
+static inline int __jacl_printf_char(__jacl_sink_t *sink, __jacl_fmt_t spec, va_list ap, int prec, int width) {
 	int ch = va_arg(ap, int), pad = (width > 1) ? width - 1 : 0, len = 0;
 
-	if (!JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (!JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
 
-	__jacl_write_char(stream, out, rem, len, (char)ch);
+	__jacl_write_char(sink, len, ch);
 
-	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(stream, out, rem, len, ' ', pad);
+	if (JACL_FMT_HAS(FLAG, spec, left)) __jacl_write_pad(sink, len, ' ', pad);
 
 	return len;
 }
-static inline int __jacl_printf_str(FILE * stream, char **out, size_t *rem, __jacl_fmt_t spec, va_list ap, int prec, int width) {
+static inline int __jacl_printf_str(__jacl_sink_t *sink, __jacl_fmt_t spec, va_list ap, int prec, int width) {
 	const char *str = va_arg(ap, const char*);
 
 	if (!str) str = "(null)";
 
-	return __jacl_output_str(stream, out, rem, spec, str, prec, width);
+	return __jacl_output_str(sink, spec, str, prec, width);
 }
 #define __jacl_printf_base(name) \
-static inline int __jacl_printf_##name(FILE * stream, char **out, size_t *rem, __jacl_fmt_t spec, va_list ap, int prec, int width) { \
+static inline int __jacl_printf_##name(__jacl_sink_t *sink, __jacl_fmt_t spec, va_list ap, int prec, int width) { \
 	uintmax_t val = JACL_FMT_HAS(FLAG, spec, sign) ? __jacl_get_signed(spec, ap) : __jacl_get_unsigned(spec, ap); \
-	return __jacl_output_int(stream, out, rem, JACL_FMT_SET(BASE, spec, name), val, prec, width); \
+	return __jacl_output_int(sink, JACL_FMT_SET(BASE, spec, name), val, prec, width); \
 }
 #define __jacl_printf_style(name) \
-static inline int __jacl_printf_##name(FILE * stream, char **out, size_t *rem, __jacl_fmt_t spec, va_list ap, int prec, int width) { \
+static inline int __jacl_printf_##name(__jacl_sink_t *sink, __jacl_fmt_t spec, va_list ap, int prec, int width) { \
 	long double val = __jacl_get_float(spec, ap); \
-	return __jacl_output_##name(stream, out, rem, spec, val, prec, width); \
+	return __jacl_output_##name(sink, spec, val, prec, width); \
 }
 __jacl_printf_base(dec)
 __jacl_printf_base(oct)
@@ -538,6 +920,7 @@ __jacl_printf_base(hex)
 __jacl_printf_style(float)
 __jacl_printf_style(exp)
 __jacl_printf_style(gen)
+__jacl_printf_style(short)
 #if JACL_HAS_C99
 __jacl_printf_style(alt)
 #endif
@@ -545,18 +928,22 @@ __jacl_printf_style(alt)
 __jacl_printf_base(bin)
 #endif
 
-#define CASE(ch,type) case ch: len += __jacl_printf_##type(stream, &ptr, &rem, spec, ap, prec, width); break
-static inline int __jacl_printf(FILE *stream, char * restrict out, size_t n, const char *fmt, va_list ap) {
-	if (!fmt) return -1;
-
-	char *ptr = out;
-	size_t rem = (out && n > 0) ? n - 1 : 0;
+#define CASE(ch,type) case ch: len += __jacl_printf_##type(sink, spec, ap, prec, width); break
+static inline int __jacl_printf_run(__jacl_sink_t *sink, const char *fmt, va_list ap) {
 	int len = 0, width, prec;
 	char type;
 
 	while (*fmt) {
-		if (*fmt != '%') { __jacl_write_char(stream, &ptr, &rem, len, *fmt); fmt++; continue; }
-		if (*(++fmt) == '%') { __jacl_write_char(stream, &ptr, &rem, len, '%'); fmt++; continue; }
+		if (*fmt != '%') {
+			const char *run = fmt;
+
+			while (*++fmt && *fmt != '%');
+
+			__jacl_write_span(sink, len, run, (size_t)(fmt - run));
+
+			continue;
+		}
+		if (*(++fmt) == '%') { __jacl_write_char(sink, len, '%'); fmt++; continue; }
 
 		__jacl_fmt_t spec = __jacl_spec_printf(ap, &fmt, &prec, &width, &type);
 
@@ -566,24 +953,52 @@ static inline int __jacl_printf(FILE *stream, char * restrict out, size_t n, con
 		#if JACL_HAS_C23
 		CASE('b', bin); CASE('B', bin);
 		#endif
-		CASE('p', ptr); CASE('f', float); CASE('F', float); CASE('e', exp); CASE('E', exp); CASE('g', gen); CASE('G', gen);
+		CASE('p', ptr); CASE('f', float); CASE('F', float); CASE('e', exp); CASE('E', exp); CASE('g', gen); CASE('G', gen); CASE('r', short); CASE('R', short);
 		#if JACL_HAS_C99
 		CASE('a', alt); CASE('A', alt);
 		#endif
 		default:
-			__jacl_write_char(stream, &ptr, &rem, len, '%');
-			__jacl_write_char(stream, &ptr, &rem, len, type);
+			__jacl_write_char(sink, len, '%');
+			__jacl_write_char(sink, len, type);
 
 			break;
 		}
 
 		fmt++;
 	}
-	if (out && n > 0) *ptr = '\0';
 
-	return len;
+	return __jacl_sink_close(sink) ? -1 : len;
 }
 #undef CASE
+// only a descriptor written straight through stages its output, so only it gets the buffer
+static JACL_NOINLINE int __jacl_printf_staged(FILE *stream, int held, const char *fmt, va_list ap) {
+	char stage[BUFSIZ];
+	__jacl_sink_t sink;
+
+	if (__jacl_sink_open(&sink, stream, stage, sizeof(stage), held)) return -1;
+
+	return __jacl_printf_run(&sink, fmt, ap);
+}
+// held is set when the caller already holds the stream's lock
+static inline int __jacl_printf_stream(FILE *stream, int held, const char *fmt, va_list ap) {
+	if (stream && stream->_bufmode == _IONBF && !__JACL_HAS_MODE(stream, __SMEM | __SCUSTOM)) return __jacl_printf_staged(stream, held, fmt, ap);
+
+	__jacl_sink_t sink;
+
+	if (__jacl_sink_open(&sink, stream, NULL, 0, held)) return -1;
+
+	return __jacl_printf_run(&sink, fmt, ap);
+}
+static inline int __jacl_printf(FILE *stream, char * restrict out, size_t n, const char *fmt, va_list ap) {
+	if (!fmt) return -1;
+	if (stream) return __jacl_printf_stream(stream, 0, fmt, ap);
+
+	__jacl_sink_t sink;
+
+	__jacl_sink_string(&sink, out, n);
+
+	return __jacl_printf_run(&sink, fmt, ap);
+}
 
 // ============ INPUT FUNCTIONS =============
 static inline int __jacl_input_str(FILE *stream, const char **in, size_t *read, __jacl_fmt_t spec, int width, char *buf) {
@@ -666,7 +1081,7 @@ static inline int __jacl_input_scan(FILE *stream, const char **in, size_t *read,
 	} \
 	break
 static inline int __jacl_input_int(FILE *stream, const char **in, size_t *read, __jacl_fmt_t spec, int width, uintmax_t *rtn) {
-	int neg = 0, pos_val = 0, *pos = &pos_val, digits = 0, ch, base = JACL_FMT_GET(BASE, spec);
+	int neg = 0, pos_val = 0, *pos = &pos_val, digits = 0, zero = 0, ch, base = JACL_FMT_GET(BASE, spec);
 	uintmax_t val = 0;
 
 	__jacl_read_next(ch, stream, in, read);
@@ -679,23 +1094,31 @@ static inline int __jacl_input_int(FILE *stream, const char **in, size_t *read,
 			__jacl_read_next(ch, stream, in, pos);
 
 			if (ch == 'x' || ch == 'X') { base = 16; __jacl_read_next(ch, stream, in, pos); }
-			else base = 8;
+			else { base = 8; zero = 1; }
 		} else base = 10;
 	} else if (base == 16 && ch == '0') {
 		__jacl_read_next(ch, stream, in, pos);
 
 		if (ch == 'x' || ch == 'X') { __jacl_read_next(ch, stream, in, pos); }
-		else { __jacl_read_back(ch, stream, in, pos); ch = '0'; }
+		else { if (ch != EOF) __jacl_read_back(ch, stream, in, pos); ch = '0'; }
 	}
 
-	__jacl_read_digits(ch, stream, in, pos, width, digits, width, base, val, errno);
+	if (in && *in) {
+		// a string is scanned in place; ch has already been taken from it
+		const char *s = *in - (ch != EOF), *e = __jacl_scan_uint(s, base, (size_t)(width - pos_val), &val);
+
+		if ((digits = (int)(e - s))) { pos_val += digits - (ch != EOF); *in = e; }
+	} else {
+		__jacl_read_digits(ch, stream, in, pos, width, digits, width, base, val, errno);
 
-	if (digits > 0 && ch != EOF) __jacl_read_back(ch, stream, in, pos);
+		if (digits > 0 && ch != EOF) __jacl_read_back(ch, stream, in, pos);
+	}
 	switch (JACL_FMT_GET(LENGTH, spec)) {
 	CASE(hh, SCHAR, UCHAR); CASE(h, SHRT, USHRT); CASE(l, LONG, ULONG); CASE(ll, LLONG, ULLONG); CASE(j, INTMAX, UINTMAX); CASE(t, PTRDIFF, SIZE); CASE(z, SSIZE, SIZE);
 	default: CASE(0, INT, UINT);
 	}
-	if (base == 8 && val == 0) digits = 1;
+	// the leading 0 of an octal number counts on its own
+	if (zero && !digits) { if (ch != EOF) __jacl_read_back(ch, stream, in, pos); digits = 1; }
 	if (digits > 0) { *read += pos_val; *rtn = val; return 1; }
 
 	return 0;
@@ -779,31 +1202,19 @@ static inline int __jacl_input_special(FILE *stream, const char **in, size_t *re
 }
 #define CASE(N, PRE) case JACL_FMT_VAL(LENGTH,N): \
 	limit = PRE##_MANT_DIG; \
-	emax = (is_hex) ? PRE##_MAX_EXP : PRE##_MAX_10_EXP; \
-	emin = (is_hex) ? PRE##_MIN_EXP : PRE##_MIN_10_EXP; \
+	emax = PRE##_MAX_EXP; \
+	emin = PRE##_MIN_EXP; \
 	break;
-static inline int __jacl_input_float(FILE *stream, const char **in, size_t *read, __jacl_fmt_t spec, int width, long double *rtn) {
-	int ch, pos_val = 0, *pos = &pos_val, mdig = 0, edig = 0, mneg = 0, eneg = 0, err = 0, sign = 0, base = 10, is_hex = 0;
+static inline int __jacl_input_hexfloat(FILE *stream, const char **in, int *pos, __jacl_fmt_t spec, int width, int ch, int mneg, long double *rtn) {
+	int edig = 0, eneg = 0, err = 0;
 	intmax_t epart = 0, exp = 0, emax, emin, limit;
 	uintmax_t digits = 0, ipart = 0, idig = 0, fpart = 0, trash = 0, slop = 0;
 
-	__jacl_read_next(ch, stream, in, pos);
-
-	// Parse prefix
 	switch (JACL_FMT_GET(LENGTH, spec)) { CASE(0, FLT); CASE(l, DBL); CASE(L, LDBL); }
-	if (ch == '+' || ch == '-') { sign = ch; mneg = (ch == '-'); __jacl_read_next(ch, stream, in, pos); }
-
-	#if JACL_HAS_C99
-		if (ch == '0') {
-			__jacl_read_next(ch, stream, in, pos);
-
-			if (ch == 'x' || ch == 'X') { is_hex = 1; base = 16; __jacl_read_next(ch, stream, in, pos); }
-		}
-	#endif
 
 	// Parse integer
-	if (width) __jacl_read_digits(ch, stream, in, pos, width, digits, limit, base, ipart, err);
-	if (digits == limit) __jacl_read_digits(ch, stream, in, pos, width, exp, INT_MAX, base, trash, err);
+	if (width) __jacl_read_digits(ch, stream, in, pos, width, digits, limit, 16, ipart, err);
+	if (digits == limit) __jacl_read_digits(ch, stream, in, pos, width, exp, INT_MAX, 16, trash, err);
 
 	idig = digits;
 
@@ -812,12 +1223,12 @@ static inline int __jacl_input_float(FILE *stream, const char **in, size_t *read
 		__jacl_read_next(ch, stream, in, pos);
 
 		if (ipart == 0) { __jacl_read_digits(ch, stream, in, pos, width, exp, INT_MAX, 1, trash, err); exp = -exp; }
-		if (digits < limit) __jacl_read_digits(ch, stream, in, pos, width, digits, limit, base, fpart, err);
-		if (digits == limit) { __jacl_read_digits(ch, stream, in, pos, width, slop, INT_MAX, base, trash, err); }
+		if (digits < limit) __jacl_read_digits(ch, stream, in, pos, width, digits, limit, 16, fpart, err);
+		if (digits == limit) { __jacl_read_digits(ch, stream, in, pos, width, slop, INT_MAX, 16, trash, err); }
 	}
 
 	// Parse exponent
-	if (is_hex ? (ch == 'p' || ch == 'P') : (ch == 'e' || ch == 'E')) {
+	if (ch == 'p' || ch == 'P') {
 		__jacl_read_next(ch, stream, in, pos);
 
 		if (ch == '+' || ch == '-') { eneg = (ch == '-'); __jacl_read_next(ch, stream, in, pos); }
@@ -826,19 +1237,126 @@ static inline int __jacl_input_float(FILE *stream, const char **in, size_t *read
 	}
 
 	// Build result
-	if (exp) epart += is_hex ? exp * 4 : exp;
+	if (exp) epart += exp * 4;
 	if (epart > emax) { __errno_set(ERANGE); *rtn = INFINITY; }
 	else if (epart < emin) { __errno_set(ERANGE); *rtn = 0.0L; }
-	else *rtn = (ipart + (long double)fpart / powl(base, digits - idig)) * powl(base == 16 ? 2.0L : 10.0L, epart);
+	else *rtn = (ipart + (long double)fpart / powl(16, digits - idig)) * powl(2.0L, epart);
 	if (mneg) *rtn = __jacl_signset_LDBL(*rtn);
 	if (ch != EOF) __jacl_read_back(ch, stream, in, pos);
 
+	return 1;
+}
+#undef CASE
+
+/**
+ * NOTE: Decimal input is copied into a buffer a character at a time, since a
+ * stream can't be scanned in place, then handed to the same
+ * __jacl_scan_decimal() / __jacl_decimal_*() pair strtod uses. Digits past
+ * JACL_FEXACT_DIGITS only move the exponent and mark the result inexact.
+ */
+static inline int __jacl_input_float(FILE *stream, const char **in, size_t *read, __jacl_fmt_t spec, int width, long double *rtn) {
+	char text[JACL_FEXACT_DIGITS + 1];
+	int ch, pos_val = 0, *pos = &pos_val, mneg = 0, sign = 0, n = 0, dot = 0, digits = 0, sticky = 0, eneg = 0;
+	int32_t extra = 0, exp = 0;
+	__jacl_decimal_t dec;
+
+	__jacl_read_next(ch, stream, in, pos);
+
+	// Parse prefix
+	if (ch == '+' || ch == '-') { sign = ch; mneg = (ch == '-'); __jacl_read_next(ch, stream, in, pos); }
+
+	#if JACL_HAS_C99
+		if (ch == '0' && pos_val < width) {
+			__jacl_read_next(ch, stream, in, pos);
+
+			if (ch == 'x' || ch == 'X') {
+				__jacl_read_next(ch, stream, in, pos);
+
+				if (!__jacl_input_hexfloat(stream, in, pos, spec, width, ch, mneg, rtn)) return 0;
+
+				*read += pos_val;
+
+				return 1;
+			}
+
+			text[n++] = '0';
+			digits++;
+		}
+	#endif
+
+	// Parse mantissa
+	while (ch != EOF) {
+		if (ch == '.' && !dot) dot = 1;
+		else if (ch >= '0' && ch <= '9') digits++;
+		else break;
+
+		if (n < JACL_FEXACT_DIGITS) text[n++] = (char)ch;
+		else if (ch != '.') { extra += !dot; sticky |= (ch != '0'); }
+		if (pos_val >= width) { ch = EOF; break; }
+
+		__jacl_read_next(ch, stream, in, pos);
+	}
+
+	if (!digits) {
+		if (ch != EOF) __jacl_read_back(ch, stream, in, pos);
+		if (dot) __jacl_read_back('.', stream, in, pos);
+		if (sign) __jacl_read_back(sign, stream, in, pos);
+
+		return 0;
+	}
+
+	// Parse exponent
+	if ((ch == 'e' || ch == 'E') && pos_val < width) {
+		int e = ch, edig = 0;
+
+		__jacl_read_next(ch, stream, in, pos);
+
+		if ((ch == '+' || ch == '-') && pos_val < width) { sign = ch; eneg = (ch == '-'); __jacl_read_next(ch, stream, in, pos); }
+		else sign = 0;
+
+		while (ch >= '0' && ch <= '9') {
+			if (exp < 100000) exp = exp * 10 + (ch - '0');
+
+			edig++;
+
+			if (pos_val >= width) { ch = EOF; break; }
+
+			__jacl_read_next(ch, stream, in, pos);
+		}
+
+		// a bare 'e' is not part of the number
+		if (!edig) {
+			if (ch != EOF) __jacl_read_back(ch, stream, in, pos);
+			if (sign) __jacl_read_back(sign, stream, in, pos);
+
+			ch = e;
+		} else if (eneg) exp = -exp;
+	}
+
+	if (ch != EOF) __jacl_read_back(ch, stream, in, pos);
+
+	// Build result
+	text[n] = '\0';
+	__jacl_scan_decimal(text, &dec);
+
+	dec.neg = (uint8_t)mneg;
+	dec.q += exp + extra;
+
+	if (sticky) dec.trunc = dec.sticky = 1;
+
+	switch (JACL_FMT_GET(LENGTH, spec)) {
+	case JACL_FMT_VAL(LENGTH, l): *rtn = __jacl_decimal_DBL(&dec); break;
+	case JACL_FMT_VAL(LENGTH, L): *rtn = __jacl_decimal_LDBL(&dec); break;
+	default: *rtn = __jacl_decimal_FLT(&dec); break;
+	}
+
+	if (isinf(*rtn) || (*rtn == 0 && dec.w)) __errno_set(ERANGE);
+
 	// Set outcome
 	*read += pos_val;
 
 	return 1;
 }
-#undef CASE
 
 // ============ SCANF FUNCTIONS =============
 static inline int __jacl_scanf_scan(FILE *stream, const char **in, size_t *read, __jacl_fmt_t spec, int width, va_list ap, const char **fmt) {
@@ -712,7 +712,7 @@ static char* js_stringify_number(jsio_t* v) {
 
 	if (!buf) return (__errno_set(ENOMEM), NULL);
 
-	snprintf(buf, 32, "%.17g", v->value.num);
+	snprintf(buf, 32, "%r", v->value.num);
 
 	return buf;
 }
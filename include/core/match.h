@@ -24,7 +24,9 @@ extern "C" {
 
 static inline uint32_t __jacl_match_atom(match_parser_t *p);
 static inline const char *matchfind(match_ctx_t *c, uint32_t n_idx, const char *pos);
-static inline const char *matchgate(const matcher_t *m, const char *s, const char *end, int ic);
+typedef struct { const char *q, *from; } __jacl_gate_t;
+
+static inline const char *matchgate(const matcher_t *m, const char *s, const char *end, int ic, __jacl_gate_t *g);
 
 static inline int __jacl_match_is_word(uint32_t cp) { return iswalnum((wint_t)cp) || cp == '_'; }
 static inline uint32_t __jacl_match_node(match_parser_t *p, match_tok_t type) {
@@ -49,6 +51,7 @@ static inline uint32_t __jacl_match_rep(match_parser_t *p, uint32_t body_idx, in
 }
 static inline void __jacl_match_free_arena(matcher_t *m) {
 	if (m->arena) free(m->arena);
+	if (m->prog) free(m->prog);
 	for (int i = 0; i < m->nr; i++) if (m->cname[i]) free(m->cname[i]);
 	for (int i = 0; i < 32; i++) if (m->nsub_names[i]) free(m->nsub_names[i]);
 	memset(m, 0, sizeof(*m));
@@ -149,7 +152,7 @@ static inline int __jacl_parse_posix_class(match_parser_t *p, uint8_t cid, uint8
 }
 static inline uint32_t __jacl_paren_look(match_parser_t *p, int is_lb, int is_neg) {
 	JACL_PARSE_FLAG(p, (is_lb ? MCOMP_LOOKBACK : MCOMP_LOOKFWD));
-	JACL_NODE_FLAGS(n, MTOK_LOOK); p->p += (p->m->arena[n].cap_id = is_lb) ? 2 : 1; p->m->arena[n].neg = is_neg ? 1 : 0; p->m->arena[n].a = __jacl_match_expr(p);
+	JACL_NODE_FLAGS(n, MTOK_LOOK); p->p += (p->m->arena[n].cap_id = is_lb) ? 2 : 1; p->m->arena[n].neg = is_neg ? 1 : 0; uint32_t body = __jacl_match_expr(p); p->m->arena[n].a = body;
 	JACL_PARSE_PAREN(p); return n;
 }
 static inline uint32_t __jacl_paren_call(match_parser_t *p, int is_named) {
@@ -191,7 +194,7 @@ static inline uint32_t __jacl_paren_named_cap(match_parser_t *p, int cap) {
 	JACL_PARSE_FLAG(p, MCOMP_NAMEREF); p->p++; JACL_PARSE_NAME(name, '>'); if (*p->p == '>') p->p++;
 	if (cap < 32) p->m->nsub_names[cap] = strdup(name);
 	JACL_NODE_FLAGS(n, MTOK_CAP); if (cap < 32) p->m->groups[cap] = n;
-	p->m->arena[n].cap_id = cap; p->m->arena[n].a = __jacl_match_expr(p); JACL_PARSE_PAREN(p); return n;
+	p->m->arena[n].cap_id = cap; uint32_t body = __jacl_match_expr(p); p->m->arena[n].a = body; JACL_PARSE_PAREN(p); return n;
 }
 static inline uint32_t __jacl_paren_atomic(match_parser_t *p) {
 	JACL_PARSE_FLAG(p, MCOMP_ATOMIC); p->p++; uint32_t inner = __jacl_match_expr(p); if (!inner) return 0;
@@ -219,7 +222,7 @@ static inline uint32_t __jacl_paren_flags(match_parser_t *p) {
 static inline uint32_t __jacl_paren_capture(match_parser_t *p, int cap) {
 	JACL_PARSE_FLAG(p, MCOMP_CAPTURE);
 	JACL_NODE_FLAGS(n, MTOK_CAP); if (cap < 32) p->m->groups[cap] = n;
-	p->m->arena[n].cap_id = cap; p->m->arena[n].a = __jacl_match_expr(p); JACL_PARSE_PAREN(p); return n;
+	p->m->arena[n].cap_id = cap; uint32_t body = __jacl_match_expr(p); p->m->arena[n].a = body; JACL_PARSE_PAREN(p); return n;
 }
 
 static inline uint32_t __jacl_atom_paren(match_parser_t *p) {
@@ -384,20 +387,28 @@ static inline const char *__jacl_prim_ANY(match_ctx_t *c, uint32_t n_idx, const
 	while (b >= 0x80 && next < c->end && JACL_UTF8_CONT(next)) next++;
 	return matchfind(c, n->b, next);
 }
+static inline int __jacl_match_at(const match_ctx_t *c, match_tok_t t, const char *pos) {
+	if (t == MTOK_BOL) return !(c->ef & MEXEC_NOTBOL) && (pos == c->s || (c->nl && pos > c->s && *(pos-1) == '\n'));
+	if (t == MTOK_EOL) return !(c->ef & MEXEC_NOTEOL) && (pos == c->end || (c->nl && pos < c->end && *pos == '\n'));
+	int neg = (t == MTOK_NWB), prev = 0, curr = 0;
+	if (pos == c->s || pos == c->end) return !neg;
+	if (pos > c->s) { const char *pp = pos - 1; while (pp > c->s && JACL_UTF8_CONT(pp)) pp--; if (__jacl_match_is_word(__jacl_match_utf8_next(&pp, pos))) prev = 1; }
+	if (pos < c->end) { const char *cp = pos; if (__jacl_match_is_word(__jacl_match_utf8_next(&cp, c->end))) curr = 1; }
+	return neg ? (prev == curr) : (prev != curr);
+}
 static inline const char *__jacl_prim_BOL(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) {
-	(void)n_idx; (void)extra;
-	if (c->ef & MEXEC_NOTBOL) return 0;
-	return (pos == c->s || (c->nl && pos > c->s && *(pos-1) == '\n')) ? matchfind(c, c->m->arena[n_idx].b, pos) : 0;
+	(void)extra;
+	return __jacl_match_at(c, MTOK_BOL, pos) ? matchfind(c, c->m->arena[n_idx].b, pos) : 0;
 }
 static inline const char *__jacl_prim_EOL(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) {
-	(void)n_idx; (void)extra;
-	if (c->ef & MEXEC_NOTEOL) return 0;
-	return (pos == c->end || (c->nl && pos < c->end && *pos == '\n')) ? matchfind(c, c->m->arena[n_idx].b, pos) : 0;
+	(void)extra;
+	return __jacl_match_at(c, MTOK_EOL, pos) ? matchfind(c, c->m->arena[n_idx].b, pos) : 0;
 }
 static inline const char *__jacl_prim_CAP(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) {
 	match_node_t *n = &c->m->arena[n_idx];
 	int idx = n->cap_id * 2;
 	if (idx + 1 >= MATCH_MAX_GROUPS * 2) { c->error = M_EINTERNAL; return 0; }
+	if ((uint32_t)idx >= c->ncap) { const char *r = matchfind(c, n->a, pos); return (r && c->error == M_SUCCESS) ? matchfind(c, n->b, r) : 0; }
 	matchoff_t sv_so = c->caps[idx], sv_eo = c->caps[idx+1];
 	c->caps[idx] = pos - c->s;
 	const char *r = matchfind(c, n->a, pos);
@@ -426,11 +437,12 @@ static inline const char *__jacl_prim_ALT(match_ctx_t *c, uint32_t n_idx, const
 	(void)extra;
 	match_node_t *n = &c->m->arena[n_idx];
 	matchoff_t sc[MATCH_MAX_GROUPS * 2];
-	memcpy(sc, c->caps, sizeof(sc));
+	size_t sz = c->ncap * sizeof(matchoff_t);
+	memcpy(sc, c->caps, sz);
 	const char *r = matchfind(c, n->a, pos);
 	if (r) return r;
 	if (c->error == M_EDEPTH) return 0;
-	memcpy(c->caps, sc, sizeof(sc));
+	memcpy(c->caps, sc, sz);
 	return matchfind(c, n->b, pos);
 }
 static inline const char *__jacl_prim_REP(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) {
@@ -438,15 +450,17 @@ static inline const char *__jacl_prim_REP(match_ctx_t *c, uint32_t n_idx, const
 	match_node_t *n = &c->m->arena[n_idx];
 	const char **path = c->rep_ws->path;
 	matchoff_t (*cpath)[MATCH_MAX_GROUPS * 2] = c->rep_ws->cpath;
-	int k = 0; path[0] = pos; memcpy(cpath[0], c->caps, sizeof(cpath[0]));
+	// only the groups someone reads are kept per step; a boolean test keeps none
+	size_t sz = c->ncap * sizeof(matchoff_t);
+	int k = 0; path[0] = pos; memcpy(cpath[0], c->caps, sz);
 	while (k < MATCH_MAX_BACKTRACK - 1 && (n->max == 255 || k < n->max)) {
-		memcpy(cpath[k+1], c->caps, sizeof(cpath[0]));
+		memcpy(cpath[k+1], c->caps, sz);
 		const char *next = matchfind(c, n->a, path[k]);
 		if (JACL_UNLIKELY(!next || next == path[k])) break;
-		path[++k] = next; memcpy(cpath[k], c->caps, sizeof(cpath[0]));
+		path[++k] = next; memcpy(cpath[k], c->caps, sz);
 	}
 	for (int i = n->lazy ? n->min : k, lim = n->lazy ? k : n->min, step = n->lazy ? 1 : -1; n->lazy ? i <= lim : i >= lim; i += step) {
-		memcpy(c->caps, cpath[i], sizeof(cpath[0]));
+		memcpy(c->caps, cpath[i], sz);
 		const char *r = n->b ? matchfind(c, n->b, path[i]) : path[i];
 		if (r) return r;
 		if (c->error == M_EDEPTH) return 0;
@@ -455,17 +469,18 @@ static inline const char *__jacl_prim_REP(match_ctx_t *c, uint32_t n_idx, const
 }
 static inline const char *__jacl_prim_LOOK(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) {
 	match_node_t *n = &c->m->arena[n_idx];
-	matchoff_t scap[MATCH_MAX_GROUPS * 2]; memcpy(scap, c->caps, sizeof(scap));
+	size_t sz = c->ncap * sizeof(matchoff_t);
+	matchoff_t scap[MATCH_MAX_GROUPS * 2]; memcpy(scap, c->caps, sz);
 	int is_lb = extra & 1, is_neg = (extra >> 1) & 1, found = 0;
 	if (is_lb) {
 		for (const char *cp = pos; cp >= c->s; cp--) {
-			memcpy(c->caps, scap, sizeof(c->caps)); match_ctx_t sub = *c; sub.caps = c->caps;
+			memcpy(c->caps, scap, sz); match_ctx_t sub = *c; sub.caps = c->caps;
 			if (matchfind(&sub, n->a, cp) == pos) { found = 1; break; }
 			if (cp == c->s) break;
 			while (cp > c->s && JACL_UTF8_CONT(cp)) cp--;
 		}
 	} else { match_ctx_t sub = *c; sub.caps = scap; found = (matchfind(&sub, n->a, pos) != 0); }
-	memcpy(c->caps, scap, sizeof(scap));
+	memcpy(c->caps, scap, sz);
 	if ((is_neg ? !found : found)) return matchfind(c, n->b, pos);
 	return 0;
 }
@@ -500,13 +515,7 @@ static inline const char *__jacl_prim_COND(match_ctx_t *c, uint32_t n_idx, const
 	return pos;
 }
 static inline const char *__jacl_prim_WB(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) {
-	match_node_t *n = &c->m->arena[n_idx];
-	int neg = (int)extra, prev = 0, curr = 0;
-	if (pos == c->s || pos == c->end) return neg ? 0 : matchfind(c, n->b, pos);
-	if (pos > c->s) { const char *pp = pos - 1; while (pp > c->s && JACL_UTF8_CONT(pp)) pp--; if (__jacl_match_is_word(__jacl_match_utf8_next((const char**)&pp, pos))) prev = 1; }
-	if (pos < c->end) { const char *cp = pos; if (__jacl_match_is_word(__jacl_match_utf8_next(&cp, c->end))) curr = 1; }
-	if (neg ? (prev == curr) : (prev != curr)) return matchfind(c, n->b, pos);
-	return 0;
+	return __jacl_match_at(c, extra ? MTOK_NWB : MTOK_WB, pos) ? matchfind(c, c->m->arena[n_idx].b, pos) : 0;
 }
 static inline const char *__jacl_prim_NWB(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) { return __jacl_prim_WB(c, n_idx, pos, 1); }
 static inline const char *__jacl_prim_FLAGS(match_ctx_t *c, uint32_t n_idx, const char *pos, uint32_t extra) {
@@ -535,28 +544,576 @@ static inline const char *matchfind(match_ctx_t *c, uint32_t n_idx, const char *
 	c->depth--;
 	return 0;
 }
-static inline const char *matchgate(const matcher_t *m, const char *s, const char *end, int ic) {
-	if (!m->nlit) return s;
-	if (m->nlit == 1) {
-		uint8_t lit = ic && m->lit[0] >= 'A' && m->lit[0] <= 'Z' ? m->lit[0] + 32 : m->lit[0];
-		for (const char *p = s; p < end; p++) {
-			uint8_t c = *p;
-			if (ic && c >= 'A' && c <= 'Z') c += 32;
-			if (c == lit) return p;
+/* ===================================================================== */
+/* Literal Extraction & Prefilter                                        */
+/* ===================================================================== */
+
+/**
+ * NOTE: matchcomp walks the arena once to find literals the subject must
+ * contain. `pre` is a set of up to MATCH_MAX_LITS strings one of which every
+ * match starts with: alternations union their sets, sequences concatenate
+ * while the parts are exact, optional and repeated atoms widen the set, and
+ * anchors, \b and lookaround are zero width so they don't break the chain.
+ * Suffix sets are built the same way from the other end, and where two parts
+ * of a sequence meet, the suffixes of the left one joined to the prefixes of
+ * the right one give strings from the middle of the match. The longest of
+ * those becomes `req`, kept only when it beats `pre`; `lead` bounds how far
+ * into the match it can start (-1 unbounded) and `nl` says whether a newline
+ * can come before it, so a hit lets the scan skip to q - lead or to the start
+ * of q's line. Sets that outgrow MATCH_MAX_LITS are trimmed to shorter
+ * strings rather than dropped. Case folding is ASCII only, the same as
+ * __jacl_match_fold.
+ */
+
+typedef struct {
+	uint8_t n, inf, ic;
+	uint8_t len[MATCH_MAX_LITS], exact[MATCH_MAX_LITS];
+	char s[MATCH_MAX_LITS][MATCH_MAX_LITLEN];
+} __jacl_lit_seq_t;
+
+typedef struct {
+	__jacl_lit_seq_t pre, suf, req;
+	int32_t max, lead;
+	uint8_t nl, lead_nl;
+} __jacl_lit_info_t;
+
+typedef struct { const matcher_t *m; uint32_t *spine, top; } __jacl_lit_ctx_t;
+
+static inline void __jacl_lit_inf(__jacl_lit_seq_t *q) { q->n = 0; q->inf = 1; q->ic = 0; }
+static inline void __jacl_lit_empty(__jacl_lit_seq_t *q) { q->n = 1; q->inf = 0; q->ic = 0; q->len[0] = 0; q->exact[0] = 1; }
+static inline void __jacl_lit_loose(__jacl_lit_seq_t *q) { for (int i = 0; i < q->n; i++) q->exact[i] = 0; }
+static inline int __jacl_lit_exact(const __jacl_lit_seq_t *q) { for (int i = 0; i < q->n; i++) if (q->exact[i]) return 1; return 0; }
+static inline int32_t __jacl_lit_add(int32_t a, int32_t b) { return (a < 0 || b < 0 || a + (int64_t)b > (1 << 24)) ? -1 : a + b; }
+static inline int __jacl_lit_score(const __jacl_lit_seq_t *q) {
+	int least = MATCH_MAX_LITLEN;
+	if (q->inf || !q->n) return 0;
+	for (int i = 0; i < q->n; i++) if (q->len[i] < least) least = q->len[i];
+	return least ? least * 16 - q->n : 0;
+}
+// rev keeps the tail of an overlong string rather than its head, for suffix sets
+static inline int __jacl_lit_push(__jacl_lit_seq_t *q, const char *s, size_t len, int exact, int rev) {
+	if (len > MATCH_MAX_LITLEN) { if (rev) s += len - MATCH_MAX_LITLEN; len = MATCH_MAX_LITLEN; exact = 0; }
+	for (int i = 0; i < q->n; i++) if (q->len[i] == len && !memcmp(q->s[i], s, len)) { q->exact[i] &= exact; return 1; }
+	if (q->n >= MATCH_MAX_LITS) return 0;
+	memcpy(q->s[q->n], s, len); q->len[q->n] = (uint8_t)len; q->exact[q->n++] = (uint8_t)exact;
+	return 1;
+}
+// cut a byte off the longest strings, merging any that become equal; 0 once that would leave nothing to search for
+static inline int __jacl_lit_shrink(__jacl_lit_seq_t *q, int rev) {
+	__jacl_lit_seq_t r = { 0, 0, q->ic, { 0 }, { 0 }, { { 0 } } };
+	uint8_t most = 0;
+	for (int i = 0; i < q->n; i++) if (q->len[i] > most) most = q->len[i];
+	if (most <= 1) return 0;
+	for (int i = 0; i < q->n; i++) {
+		int cut = q->len[i] == most;
+		__jacl_lit_push(&r, q->s[i] + (cut && rev), q->len[i] - (size_t)cut, cut ? 0 : q->exact[i], rev);
+	}
+	*q = r;
+	return 1;
+}
+static inline void __jacl_lit_union(__jacl_lit_seq_t *a, const __jacl_lit_seq_t *b, int rev) {
+	if (a->inf || b->inf) { __jacl_lit_inf(a); return; }
+	a->ic |= b->ic;
+	for (int i = 0; i < b->n; i++) while (!__jacl_lit_push(a, b->s[i], b->len[i], b->exact[i], rev)) if (!__jacl_lit_shrink(a, rev)) { __jacl_lit_inf(a); return; }
+}
+// extend the exact strings of a with every string of b: appended for prefix sets, prepended (rev) for suffix sets
+static inline void __jacl_lit_cross(__jacl_lit_seq_t *a, const __jacl_lit_seq_t *b, int rev) {
+	__jacl_lit_seq_t r = { 0, 0, (uint8_t)(a->ic | b->ic), { 0 }, { 0 }, { { 0 } } };
+	char buf[2 * MATCH_MAX_LITLEN];
+	if (a->inf) return;
+	if (b->inf) { __jacl_lit_loose(a); return; }
+	for (int i = 0; i < a->n; i++) {
+		if (!a->exact[i]) { if (!__jacl_lit_push(&r, a->s[i], a->len[i], 0, rev)) { __jacl_lit_loose(a); return; } continue; }
+		for (int j = 0; j < b->n; j++) {
+			const __jacl_lit_seq_t *x = rev ? b : a, *y = rev ? a : b;
+			int xi = rev ? j : i, yi = rev ? i : j;
+			memcpy(buf, x->s[xi], x->len[xi]); memcpy(buf + x->len[xi], y->s[yi], y->len[yi]);
+			if (!__jacl_lit_push(&r, buf, a->len[i] + (size_t)b->len[j], b->exact[j], rev)) { __jacl_lit_loose(a); return; }
 		}
-		return NULL;
-	}
-	for (const char *p = s; p + m->nlit <= end; p++) {
-		int ok = 1;
-		for (int i = 0; i < m->nlit; i++) {
-			uint8_t a = ic && m->lit[i] >= 'A' && m->lit[i] <= 'Z' ? m->lit[i] + 32 : m->lit[i];
-			uint8_t b = ic && p[i] >= 'A' && p[i] <= 'Z' ? p[i] + 32 : p[i];
-			if (a != b) { ok = 0; break; }
+	}
+	*a = r;
+}
+static inline void __jacl_lit_take(__jacl_lit_info_t *o, const __jacl_lit_seq_t *q, int32_t lead, uint8_t nl) {
+	if (__jacl_lit_score(q) > __jacl_lit_score(&o->req)) { o->req = *q; o->lead = lead; o->lead_nl = nl; }
+}
+static inline void __jacl_lit_cat(__jacl_lit_info_t *o, const __jacl_lit_info_t *t) {
+	__jacl_lit_seq_t join = { 0, 0, (uint8_t)(o->suf.ic | t->pre.ic), { 0 }, { 0 }, { { 0 } } }, suf = t->suf;
+	char buf[2 * MATCH_MAX_LITLEN];
+	if (o->suf.inf || t->pre.inf) __jacl_lit_inf(&join);
+	for (int i = 0; i < o->suf.n && !join.inf; i++) for (int j = 0; j < t->pre.n && !join.inf; j++) {
+		memcpy(buf, o->suf.s[i], o->suf.len[i]); memcpy(buf + o->suf.len[i], t->pre.s[j], t->pre.len[j]);
+		while (!__jacl_lit_push(&join, buf, o->suf.len[i] + (size_t)t->pre.len[j], 0, 0)) if (!__jacl_lit_shrink(&join, 0)) { __jacl_lit_inf(&join); break; }
+	}
+	__jacl_lit_take(o, &t->req, __jacl_lit_add(o->max, t->lead), o->nl || t->lead_nl);
+	__jacl_lit_take(o, &join, o->max, o->nl);
+	__jacl_lit_cross(&o->pre, &t->pre, 0);
+	__jacl_lit_cross(&suf, &o->suf, 1);
+	o->suf = suf;
+	o->max = __jacl_lit_add(o->max, t->max); o->nl |= t->nl;
+	__jacl_lit_take(o, &o->pre, 0, 0);
+}
+// under ICASE the fold goes through towlower, which maps U+0130 to 'i' in Turkish locales and U+212A to 'k'
+static inline int __jacl_lit_wide(uint32_t cp, int ic) {
+	return ic && (cp >= 0x80 || (cp | 0x20) == 'i' || (cp | 0x20) == 'k');
+}
+static inline void __jacl_lit_node(__jacl_lit_ctx_t *x, uint32_t n_idx, __jacl_lit_info_t *o) {
+	const matcher_t *m = x->m;
+	const match_node_t *n = &m->arena[n_idx];
+	uint8_t ic = !!((n->eflags | m->eflags) & MEXEC_ICASE);
+	__jacl_lit_info_t t;
+	o->max = 0; o->lead = -1; o->nl = 0; o->lead_nl = 1;
+	__jacl_lit_empty(&o->pre); __jacl_lit_empty(&o->suf); __jacl_lit_inf(&o->req);
+	if (!n_idx) return;
+	switch (n->type) {
+		case MTOK_END: case MTOK_BOL: case MTOK_EOL: case MTOK_WB: case MTOK_NWB: case MTOK_LOOK: return;
+		case MTOK_CHAR: {
+			uint32_t cp = n->val; char buf[4]; size_t len;
+			o->nl = cp == '\n';
+			if (__jacl_lit_wide(cp, ic)) { o->max = -1; __jacl_lit_inf(&o->pre); __jacl_lit_inf(&o->suf); return; }
+			if (cp < 0x80) { buf[0] = (char)cp; len = 1; }
+			else if (cp < 0x800) { buf[0] = (char)(0xC0 | cp >> 6); buf[1] = (char)(0x80 | (cp & 0x3F)); len = 2; }
+			else if (cp < 0x10000) { buf[0] = (char)(0xE0 | cp >> 12); buf[1] = (char)(0x80 | (cp >> 6 & 0x3F)); buf[2] = (char)(0x80 | (cp & 0x3F)); len = 3; }
+			else { buf[0] = (char)(0xF0 | cp >> 18); buf[1] = (char)(0x80 | (cp >> 12 & 0x3F)); buf[2] = (char)(0x80 | (cp >> 6 & 0x3F)); buf[3] = (char)(0x80 | (cp & 0x3F)); len = 4; }
+			o->max = (int32_t)len; o->pre.n = 0; o->pre.ic = ic;
+			__jacl_lit_push(&o->pre, buf, len, 1, 0);
+			break;
+		}
+		case MTOK_CLASS: {
+			int ascii = 1; uint32_t count = 0;
+			for (int i = 0; i < m->nr; i++) if (m->rcid[i] == n->val) { if (m->cname[i] || m->rneg[i] || m->rhi[i] >= 0x80) ascii = 0; else { count += m->rhi[i] - m->rlo[i] + 1; for (uint32_t c = m->rlo[i]; c <= m->rhi[i] && ascii; c++) ascii = !__jacl_lit_wide(c, ic); } }
+			o->nl = __jacl_match_in_class(m, '\n', (uint8_t)n->val, 0);
+			o->max = ascii ? 1 : -1;
+			if (!ascii || !count || count > MATCH_MAX_LITS) { __jacl_lit_inf(&o->pre); __jacl_lit_inf(&o->suf); return; }
+			o->pre.n = 0; o->pre.ic = ic;
+			for (int i = 0; i < m->nr; i++) if (m->rcid[i] == n->val) for (uint32_t c = m->rlo[i]; c <= m->rhi[i]; c++) { char ch = (char)c; __jacl_lit_push(&o->pre, &ch, 1, 1, 0); }
+			break;
+		}
+		case MTOK_ANY: o->max = -1; o->nl = !!(n->eflags & MEXEC_DOTALL); __jacl_lit_inf(&o->pre); __jacl_lit_inf(&o->suf); return;
+		case MTOK_CAP: case MTOK_ATOMIC: __jacl_lit_node(x, n->a, o); return;
+		case MTOK_SEQ: {
+			uint32_t *sp = x->spine + x->top, k = 0;
+			while (n_idx && m->arena[n_idx].type == MTOK_SEQ) { sp[k++] = m->arena[n_idx].b; n_idx = m->arena[n_idx].a; }
+			x->top += k;
+			__jacl_lit_node(x, n_idx, o);
+			while (k--) { __jacl_lit_node(x, sp[k], &t); __jacl_lit_cat(o, &t); }
+			x->top = (uint32_t)(sp - x->spine);
+			return;
+		}
+		case MTOK_ALT:
+			__jacl_lit_node(x, n->a, o); __jacl_lit_node(x, n->b, &t);
+			__jacl_lit_union(&o->pre, &t.pre, 0); __jacl_lit_union(&o->suf, &t.suf, 1); __jacl_lit_union(&o->req, &t.req, 0);
+			o->lead = (o->lead < 0 || t.lead < 0) ? -1 : (o->lead > t.lead ? o->lead : t.lead); o->lead_nl |= t.lead_nl;
+			o->max = (o->max < 0 || t.max < 0) ? -1 : (o->max > t.max ? o->max : t.max); o->nl |= t.nl;
+			__jacl_lit_take(o, &o->pre, 0, 0);
+			return;
+		case MTOK_REP:
+			__jacl_lit_node(x, n->a, &t);
+			o->nl = t.nl;
+			o->max = t.max == 0 ? 0 : n->max == 255 ? -1 : (t.max < 0 || (int64_t)t.max * n->max > (1 << 24)) ? -1 : t.max * n->max;
+			o->pre = t.pre; o->suf = t.suf;
+			if (n->min == 0) {
+				__jacl_lit_seq_t e;
+				if (n->max != 1) { __jacl_lit_loose(&o->pre); __jacl_lit_loose(&o->suf); }
+				__jacl_lit_empty(&e); __jacl_lit_union(&o->pre, &e, 0); __jacl_lit_union(&o->suf, &e, 1);
+				return;
+			}
+			for (int i = 1; i < n->min && (__jacl_lit_exact(&o->pre) || __jacl_lit_exact(&o->suf)); i++) {
+				__jacl_lit_seq_t suf = t.suf;
+				__jacl_lit_cross(&o->pre, &t.pre, 0); __jacl_lit_cross(&suf, &o->suf, 1); o->suf = suf;
+			}
+			if (n->max != n->min) { __jacl_lit_loose(&o->pre); __jacl_lit_loose(&o->suf); }
+			o->req = t.req; o->lead = t.lead; o->lead_nl = t.lead_nl;
+			__jacl_lit_take(o, &o->pre, 0, 0);
+			return;
+		default: o->max = -1; o->nl = 1; __jacl_lit_inf(&o->pre); __jacl_lit_inf(&o->suf); return;
+	}
+	o->suf = o->req = o->pre; o->lead = 0; o->lead_nl = 0;
+}
+static inline void __jacl_lit_store(match_lits_t *l, const __jacl_lit_seq_t *q, int32_t lead, uint8_t nl) {
+	l->n = q->n; l->ic = q->ic; l->lead = lead; l->nl = nl;
+	for (int i = 0; i < q->n; i++) {
+		l->len[i] = q->len[i]; memcpy(l->lit[i], q->s[i], q->len[i]);
+		for (int k = 0; k < q->len[i]; k++) l->wide |= __jacl_lit_wide((unsigned char)q->s[i][k], 1);
+	}
+}
+static inline void __jacl_lit_compile(matcher_t *m) {
+	__jacl_lit_ctx_t x = { m, malloc((m->count + 1) * sizeof(uint32_t)), 0 };
+	__jacl_lit_info_t o;
+	memset(&m->pre, 0, sizeof(m->pre)); memset(&m->req, 0, sizeof(m->req));
+	if (!x.spine) return;
+	__jacl_lit_node(&x, m->root, &o);
+	free(x.spine);
+	int ps = __jacl_lit_score(&o.pre), rs = __jacl_lit_score(&o.req);
+	if (ps) __jacl_lit_store(&m->pre, &o.pre, 0, 0);
+	if (rs > ps) __jacl_lit_store(&m->req, &o.req, o.lead, o.lead_nl);
+	// matchfind lets a case-blind atom fold the rest of its sequence too
+	for (uint32_t i = 1; i < m->count && !m->prog; i++) if (m->arena[i].eflags & MEXEC_ICASE) { m->pre.ic = m->req.ic = 1; break; }
+}
+
+// first place in s..end where any of the literals starts
+static inline const char *__jacl_match_scan(const match_lits_t *l, const char *s, const char *end, int ic) {
+	const unsigned char *h = (const unsigned char *)s;
+	size_t hl = (size_t)(end - s), i = 0, most = 0;
+	ic |= l->ic;
+	if (l->n == 1) return (const char *)__jacl_mem_search(h, hl, (const unsigned char *)l->lit[0], l->len[0], ic);
+	for (int k = 0; k < l->n; k++) if (l->len[k] > most) most = l->len[k];
+#ifdef __JACL_VSIZE
+	__jacl_vec_t vf[MATCH_MAX_LITS], vfu[MATCH_MAX_LITS], ve[MATCH_MAX_LITS], veu[MATCH_MAX_LITS];
+	for (int k = 0; k < l->n; k++) {
+		unsigned char f = __JACL_FOLD((unsigned char)l->lit[k][0], ic), e = __JACL_FOLD((unsigned char)l->lit[k][l->len[k] - 1], ic);
+		vf[k] = __jacl_vsplat(f); vfu[k] = __jacl_vsplat((ic && (unsigned)(f - 'a') < 26u) ? f - 32 : f);
+		ve[k] = __jacl_vsplat(e); veu[k] = __jacl_vsplat((ic && (unsigned)(e - 'a') < 26u) ? e - 32 : e);
+	}
+	for (; i + most - 1 + __JACL_VSIZE <= hl; i += __JACL_VSIZE) {
+		__jacl_vec_t a = __jacl_vload(h + i);
+		unsigned hit = 0;
+		for (int k = 0; k < l->n; k++) {
+			__jacl_vec_t b = __jacl_vload(h + i + l->len[k] - 1);
+			hit |= (__jacl_veq(a, vf[k]) | __jacl_veq(a, vfu[k])) & (__jacl_veq(b, ve[k]) | __jacl_veq(b, veu[k]));
 		}
-		if (ok) return p;
+		for (; hit; hit &= hit - 1) {
+			size_t j = i + __jacl_mem_ctz(hit);
+			for (int k = 0; k < l->n; k++) if (__jacl_mem_same(h + j, (const unsigned char *)l->lit[k], l->len[k], ic)) return (const char *)h + j;
+		}
+	}
+#endif
+	uint8_t first[256] = { 0 };
+	for (int k = 0; k < l->n; k++) {
+		unsigned char f = (unsigned char)l->lit[k][0], lo = __JACL_FOLD(f, ic);
+		first[f] = first[lo] = 1;
+		if (ic && (unsigned)(lo - 'a') < 26u) first[lo - 32] = 1;
+	}
+	for (; i < hl; i++) {
+		if (!first[h[i]]) continue;
+		for (int k = 0; k < l->n; k++) if (l->len[k] <= hl - i && __jacl_mem_same(h + i, (const unsigned char *)l->lit[k], l->len[k], ic)) return (const char *)h + i;
 	}
 	return NULL;
 }
+// earliest place at or after s a match could start, or NULL when none can; g caches the last req hit
+static inline const char *matchgate(const matcher_t *m, const char *s, const char *end, int ic, __jacl_gate_t *g) {
+	// a fold the set wasn't built for (REG_ICASE arrives after matchcomp) could reach past ASCII
+	int pre = m->pre.n && !(ic && !m->pre.ic && m->pre.wide), req = m->req.n && !(ic && !m->req.ic && m->req.wide);
+	for (;;) {
+		if (s > end) return NULL;
+		if (req) {
+			if (!g->q || g->q < s) {
+				if (!(g->q = __jacl_match_scan(&m->req, s, end, ic))) return NULL;
+				g->from = (m->req.lead >= 0 && g->q - s > m->req.lead) ? g->q - m->req.lead : s;
+				if (!m->req.nl) for (const char *p = g->q; p > g->from; p--) if (p[-1] == '\n') { g->from = p; break; }
+			}
+			if (g->from > s) s = g->from;
+		}
+		if (!pre) return s;
+		const char *p = __jacl_match_scan(&m->pre, s, end, ic);
+		if (!p || !req || g->q >= p) return p;
+		s = p;
+	}
+}
+
+/* ===================================================================== */
+/* Pike VM - Linear Time Execution                                       */
+/* ===================================================================== */
+
+/**
+ * NOTE: Patterns without backreferences, lookaround, atomic groups,
+ * conditionals or recursion are regular, so matchcomp also flattens their
+ * arena into a small program (CHAR / CLASS / ANY consume one code point,
+ * SPLIT / JMP / SAVE / ASSERT don't) and matchexec runs that instead of
+ * matchfind. Every live thread steps over the subject together, one code
+ * point at a time, and a pc is admitted to a step at most once, so the cost
+ * is O(subject * program) whatever the pattern: no exponential blow-up, no
+ * M_EDEPTH. Threads are kept in priority order (SPLIT's x before y, greedy
+ * loops prefer the body) and a match cuts every lower priority thread, which
+ * gives the same leftmost-first answer and captures a backtracker exploring
+ * in that order would. Counted repeats are unrolled and a loop closes with a
+ * SPLIT back to its body rather than a JMP to a head of its own. A closure
+ * holds each state it is still inside at gen + 1, so running into one again
+ * means the pass just made through a loop that can match nothing did match
+ * nothing: a greedy loop then leaves through its exit at that pass's
+ * priority, and a counted copy after an empty one goes straight to the exit,
+ * as a backtracker stops repeating an empty iteration. Anything over
+ * MATCH_MAX_PROG instructions stays on the backtracker.
+ */
+
+typedef struct { const matcher_t *m; match_inst_t *prog; uint32_t n, cap; } __jacl_vm_build_t;
+typedef struct { uint32_t n; uint32_t *pc; matchoff_t *caps; } __jacl_vm_list_t;
+typedef struct { match_ctx_t *c; const match_inst_t *prog; uint32_t *mark, gen, ok; size_t ns; matchoff_t *work; uint32_t loop; } __jacl_vm_t;
+
+/* a handful of offsets at most, not worth a trip through memcpy */
+static inline void __jacl_vm_copy(matchoff_t *dst, const matchoff_t *src, size_t n) { for (size_t i = 0; i < n; i++) dst[i] = src[i]; }
+
+static inline uint32_t __jacl_vm_emit(__jacl_vm_build_t *b, match_op_t op, uint8_t flag, uint32_t val) {
+	if (b->n >= b->cap) {
+		if (b->cap >= MATCH_MAX_PROG) return UINT32_MAX;
+		uint32_t cap = b->cap ? b->cap * 2 : 32;
+		if (cap > MATCH_MAX_PROG) cap = MATCH_MAX_PROG;
+		match_inst_t *tmp = realloc(b->prog, cap * sizeof(match_inst_t));
+		if (!tmp) return UINT32_MAX;
+		b->prog = tmp; b->cap = cap;
+	}
+	b->prog[b->n] = (match_inst_t){ (uint8_t)op, flag, val, 0, 0 };
+	return b->n++;
+}
+// whether the chain at n_idx can match without consuming anything
+static inline int __jacl_vm_nullable(const matcher_t *m, uint32_t n_idx) {
+	for (; n_idx; n_idx = m->arena[n_idx].b) {
+		const match_node_t *n = &m->arena[n_idx];
+		switch (n->type) {
+			case MTOK_CHAR: case MTOK_CLASS: case MTOK_ANY: return 0;
+			case MTOK_ALT: return __jacl_vm_nullable(m, n->a) || __jacl_vm_nullable(m, n->b);
+			case MTOK_CAP: case MTOK_SEQ: if (!__jacl_vm_nullable(m, n->a)) return 0; break;
+			case MTOK_REP: if (n->min && !__jacl_vm_nullable(m, n->a)) return 0; break;
+			default: break;
+		}
+	}
+	return 1;
+}
+static inline int __jacl_vm_gen(__jacl_vm_build_t *b, uint32_t n_idx) {
+	if (!n_idx) return 1;
+	const match_node_t *n = &b->m->arena[n_idx];
+	uint32_t at, jmp;
+	switch (n->type) {
+		case MTOK_END: break;
+		case MTOK_CHAR: if (__jacl_vm_emit(b, MVM_CHAR, !!(n->eflags & MEXEC_ICASE), n->val) == UINT32_MAX) return 0; break;
+		case MTOK_CLASS: if (__jacl_vm_emit(b, MVM_CLASS, 0, n->val) == UINT32_MAX) return 0; break;
+		case MTOK_ANY: if (__jacl_vm_emit(b, MVM_ANY, !!(n->eflags & MEXEC_DOTALL), 0) == UINT32_MAX) return 0; break;
+		case MTOK_BOL: case MTOK_EOL: case MTOK_WB: case MTOK_NWB: if (__jacl_vm_emit(b, MVM_ASSERT, 0, n->type) == UINT32_MAX) return 0; break;
+		case MTOK_CAP:
+			if (n->cap_id >= MATCH_MAX_GROUPS) return 0;
+			if (__jacl_vm_emit(b, MVM_SAVE, 0, n->cap_id * 2u) == UINT32_MAX || !__jacl_vm_gen(b, n->a) || __jacl_vm_emit(b, MVM_SAVE, 0, n->cap_id * 2u + 1) == UINT32_MAX) return 0;
+			break;
+		case MTOK_SEQ: if (!__jacl_vm_gen(b, n->a)) return 0; break;
+		case MTOK_ALT:
+			if ((at = __jacl_vm_emit(b, MVM_SPLIT, 0, 0)) == UINT32_MAX) return 0;
+			b->prog[at].x = b->n;
+			if (!__jacl_vm_gen(b, n->a) || (jmp = __jacl_vm_emit(b, MVM_JMP, 0, 0)) == UINT32_MAX) return 0;
+			b->prog[at].y = b->n;
+			if (!__jacl_vm_gen(b, n->b)) return 0;
+			b->prog[jmp].x = b->n;
+			return 1;
+		case MTOK_REP: {
+			if (n->max != 255 && n->max < n->min) return 0;
+			int empty = __jacl_vm_nullable(b->m, n->a);
+			for (int i = n->max == 255 && n->min; i < n->min; i++) if (!__jacl_vm_gen(b, n->a)) return 0;
+			if (n->max == 255) {
+				// x{n,} is x{n-1}x+ and x* is (x+)?: the loop closes on a SPLIT, flagged when x can match nothing
+				if (!n->min && (at = __jacl_vm_emit(b, MVM_SPLIT, 0, 0)) == UINT32_MAX) return 0;
+				uint32_t top = b->n;
+				if (!__jacl_vm_gen(b, n->a) || (jmp = __jacl_vm_emit(b, MVM_SPLIT, empty ? 1 + n->lazy : 0, 0)) == UINT32_MAX) return 0;
+				b->prog[jmp].x = n->lazy ? b->n : top; b->prog[jmp].y = n->lazy ? top : b->n;
+				if (!n->min) { b->prog[at].x = b->prog[jmp].x; b->prog[at].y = b->prog[jmp].y; }
+				break;
+			}
+			// each optional copy after the first names the one before it, when x can match nothing
+			uint32_t first = b->n, prev = 0;
+			for (int i = n->min; i < n->max; i++, prev = at) if ((at = __jacl_vm_emit(b, MVM_SPLIT, 0, empty ? prev : 0)) == UINT32_MAX || !__jacl_vm_gen(b, n->a)) return 0;
+			for (uint32_t i = first; i < b->n; i++) if (b->prog[i].op == MVM_SPLIT && !b->prog[i].x && !b->prog[i].y) { b->prog[i].x = n->lazy ? b->n : i + 1; b->prog[i].y = n->lazy ? i + 1 : b->n; }
+			break;
+		}
+		default: return 0;
+	}
+	return __jacl_vm_gen(b, n->b);
+}
+static inline void __jacl_vm_compile(matcher_t *m) {
+	__jacl_vm_build_t b = { m, NULL, 0, 0 };
+	uint32_t n_idx = m->root;
+	if (MATCH_MAX_PROG > 0 && __jacl_vm_emit(&b, MVM_SAVE, 0, 0) != UINT32_MAX && __jacl_vm_gen(&b, m->root) && __jacl_vm_emit(&b, MVM_SAVE, 0, 1) != UINT32_MAX && __jacl_vm_emit(&b, MVM_MATCH, 0, 0) != UINT32_MAX) {
+		m->prog = b.prog; m->nprog = b.n;
+		while (n_idx && (m->arena[n_idx].type == MTOK_SEQ || m->arena[n_idx].type == MTOK_CAP)) n_idx = m->arena[n_idx].a;
+		m->anchored = n_idx && m->arena[n_idx].type == MTOK_BOL;
+		for (uint32_t i = 0; i < b.n; i++) if (b.prog[i].op == MVM_ASSERT) m->asserts = 1;
+		for (uint32_t i = 0; i < b.n; i++) if (b.prog[i].op == MVM_SPLIT && (b.prog[i].flag || b.prog[i].val)) m->nullrep = 1;
+	} else if (b.prog) free(b.prog);
+}
+// the assertions that hold at pos, one bit per match_tok_t, for v->ok
+static inline uint32_t __jacl_vm_holds(const match_ctx_t *c, const char *pos) {
+	uint32_t wb = (uint32_t)__jacl_match_at(c, MTOK_WB, pos);
+	return (uint32_t)__jacl_match_at(c, MTOK_BOL, pos) << MTOK_BOL | (uint32_t)__jacl_match_at(c, MTOK_EOL, pos) << MTOK_EOL | wb << MTOK_WB | (wb ^ 1u) << MTOK_NWB;
+}
+static inline void __jacl_vm_add(__jacl_vm_t *v, __jacl_vm_list_t *l, uint32_t pc, matchoff_t off) {
+	if (v->mark[pc] == v->gen) return;
+	// still inside pc's own closure: the loop just gone round matched nothing, so a greedy one leaves through its exit
+	if (v->mark[pc] == v->gen + 1) { if (v->prog[v->loop].flag == 1 && v->prog[v->loop].y != pc) __jacl_vm_add(v, l, v->prog[v->loop].y, off); return; }
+	v->mark[pc] = v->gen + 1;
+	const match_inst_t *in = &v->prog[pc];
+	switch (in->op) {
+		case MVM_JMP: __jacl_vm_add(v, l, in->x, off); break;
+		case MVM_SPLIT: {
+			// the copy before this one matched nothing: a counted repeat stops there too
+			if (in->val && v->mark[in->val] == v->gen + 1) { __jacl_vm_add(v, l, in->x > in->y ? in->x : in->y, off); break; }
+			uint32_t loop = v->loop;
+			if (in->flag == 1) v->loop = pc;
+			__jacl_vm_add(v, l, in->x, off);
+			v->loop = in->flag == 2 ? pc : loop;
+			__jacl_vm_add(v, l, in->y, off);
+			v->loop = loop;
+			break;
+		}
+		case MVM_ASSERT: if (v->ok >> in->val & 1u) __jacl_vm_add(v, l, pc + 1, off); break;
+		case MVM_SAVE:
+			if (in->val < v->ns) { matchoff_t old = v->work[in->val]; v->work[in->val] = off; __jacl_vm_add(v, l, pc + 1, off); v->work[in->val] = old; }
+			else __jacl_vm_add(v, l, pc + 1, off);
+			break;
+		default:
+			l->pc[l->n] = pc;
+			__jacl_vm_copy(l->caps + (size_t)l->n * v->ns, v->work, v->ns);
+			l->n++;
+	}
+	v->mark[pc] = v->gen;
+}
+static inline int __jacl_vm_step(const match_ctx_t *c, const match_inst_t *in, uint32_t cp, uint8_t b) {
+	switch (in->op) {
+		case MVM_CHAR: return __jacl_match_fold(cp, in->val, c->ic || in->flag);
+		case MVM_CLASS: return __jacl_match_in_class(c->m, cp, (uint8_t)in->val, c->ic);
+		case MVM_ANY: return in->flag || b != '\n';
+		default: return 0;
+	}
+}
+static inline match_err_t __jacl_vm_exec(match_ctx_t *c, const char *start, match_find_t *pm, size_t nm) {
+	const matcher_t *m = c->m;
+	size_t np = m->nprog, ng = (pm && nm) ? m->m_nsub + 1 : 0;
+	if (ng > nm) ng = nm;
+	if (ng > MATCH_MAX_GROUPS) ng = MATCH_MAX_GROUPS;
+	size_t ns = ng * 2, words = ((2 * np + 2) * ns * sizeof(matchoff_t) + 3 * np * sizeof(uint32_t)) / sizeof(matchoff_t) + 1;
+	matchoff_t local[1024], *mem = words <= 1024 ? local : malloc(words * sizeof(matchoff_t));
+	if (!mem) return M_ESPACE;
+	__jacl_vm_list_t lists[2] = { { 0, NULL, mem }, { 0, NULL, mem + np * ns } }, *cl = &lists[0], *nl = &lists[1], *tmp;
+	matchoff_t *best = mem + 2 * np * ns;
+	__jacl_vm_t v = { c, m->prog, NULL, 1, 0, ns, best + ns, 0 };
+	lists[0].pc = (uint32_t *)(v.work + ns); lists[1].pc = lists[0].pc + np; v.mark = lists[1].pc + np;
+	memset(v.mark, 0, np * sizeof(uint32_t));
+	int matched = 0, gate = m->pre.n || m->req.n, fixed = m->anchored && !c->nl;
+	__jacl_gate_t g = { NULL, NULL };
+	const char *pos = start;
+	for (;;) {
+		if (!cl->n && (matched || (fixed && pos != c->s))) break;
+		if (!matched && !(fixed && pos != c->s)) {
+			if (!cl->n && gate && !(pos = matchgate(m, pos, c->end, c->ic, &g))) break;
+			for (size_t i = 0; i < ns; i++) v.work[i] = -1;
+			if (m->asserts) v.ok = __jacl_vm_holds(c, pos);
+			__jacl_vm_add(&v, cl, 0, pos - c->s);
+		}
+		const char *next = pos + 1;
+		uint32_t cp = 0; uint8_t b = 0;
+		if (pos < c->end) {
+			b = (uint8_t)*pos; cp = b;
+			if (b >= 0x80) { while (next < c->end && JACL_UTF8_CONT(next)) next++; const char *q = pos; cp = __jacl_match_utf8_next(&q, next); }
+		}
+		v.gen++; nl->n = 0;
+		if (m->asserts && pos < c->end) v.ok = __jacl_vm_holds(c, next);
+		for (uint32_t i = 0; i < cl->n; i++) {
+			const match_inst_t *in = &m->prog[cl->pc[i]];
+			if (in->op == MVM_MATCH) {
+				matched = 1;
+				if (!ns) goto done;
+				__jacl_vm_copy(best, cl->caps + (size_t)i * ns, ns);
+				break;
+			}
+			if (pos < c->end && __jacl_vm_step(c, in, cp, b)) {
+				__jacl_vm_copy(v.work, cl->caps + (size_t)i * ns, ns);
+				__jacl_vm_add(&v, nl, cl->pc[i] + 1, next - c->s);
+			}
+		}
+		if (pos >= c->end) break;
+		tmp = cl; cl = nl; nl = tmp; pos = next;
+	}
+done:
+	if (matched && ns) {
+		for (size_t i = 0; i < ng; i++) { pm[i].rm_so = best[i*2]; pm[i].rm_eo = best[i*2+1]; }
+		for (size_t i = ng; i < nm; i++) { pm[i].rm_so = -1; pm[i].rm_eo = -1; }
+	}
+	if (mem != local) free(mem);
+	return matched ? M_SUCCESS : M_NOMATCH;
+}
+
+/**
+ * NOTE: When captures are wanted and the program times the subject fits in
+ * MATCH_MAX_BITS, matchexec runs the program depth first instead, in the
+ * order the backtracker would try it, with one bit per (pc, position) marking
+ * the states already entered. Nothing a state can reach depends on how it was
+ * reached, so one that failed once fails again and is never entered twice:
+ * the search stays linear, and the bitmap plus a stack of pending branches is
+ * all the memory it takes. Captures live in a single array that SAVE undoes
+ * on the way back, where the Pike VM copies them into every thread at every
+ * step. A loop whose body can match nothing breaks that premise: an empty
+ * pass must leave through the exit where a state entered from elsewhere
+ * would not, and one bit can't tell the two apart, so such programs
+ * (nullrep) stay on the Pike VM.
+ */
+
+typedef struct { uint32_t pc; int32_t slot; matchoff_t off; } __jacl_bits_job_t;
+
+static inline int __jacl_vm_push(__jacl_bits_job_t **jobs, size_t *n, size_t *cap, __jacl_bits_job_t *local, __jacl_bits_job_t j) {
+	if (*n == *cap) {
+		__jacl_bits_job_t *tmp = malloc(*cap * 2 * sizeof(*tmp));
+		if (!tmp) return -1;
+		memcpy(tmp, *jobs, *n * sizeof(*tmp));
+		if (*jobs != local) free(*jobs);
+		*jobs = tmp; *cap *= 2;
+	}
+	(*jobs)[(*n)++] = j;
+	return 0;
+}
+static inline match_err_t __jacl_vm_bits(match_ctx_t *c, match_find_t *pm, size_t nm) {
+	const matcher_t *m = c->m;
+	size_t len = (size_t)(c->end - c->s) + 1, ng = m->m_nsub + 1, nj = 0, cap = 256;
+	if (!pm) nm = 0;
+	if (ng > nm) ng = nm;
+	if (ng > MATCH_MAX_GROUPS) ng = MATCH_MAX_GROUPS;
+	uint32_t seen[MATCH_MAX_BITS / 32 + 1], ns = (uint32_t)ng * 2;
+	matchoff_t caps[MATCH_MAX_GROUPS * 2];
+	__jacl_bits_job_t local[256], *jobs = local;
+	memset(seen, 0, ((size_t)m->nprog * len + 31) / 32 * sizeof(uint32_t));
+	match_err_t err = M_NOMATCH;
+	int fixed = m->anchored && !c->nl;
+	__jacl_gate_t g = { NULL, NULL };
+	for (const char *start = fixed ? c->s : matchgate(m, c->s, c->end, c->ic, &g), *next; start && start <= c->end && err == M_NOMATCH; start = fixed ? NULL : matchgate(m, next, c->end, c->ic, &g)) {
+		// like the VM, a match only starts on a code point
+		for (next = start + 1; next < c->end && JACL_UTF8_CONT(next); next++) {}
+		for (uint32_t i = 0; i < ns; i++) caps[i] = -1;
+		nj = 0;
+		if (__jacl_vm_push(&jobs, &nj, &cap, local, (__jacl_bits_job_t){ 0, -1, start - c->s })) { err = M_ESPACE; break; }
+		while (nj && err == M_NOMATCH) {
+			__jacl_bits_job_t j = jobs[--nj];
+			if (j.slot >= 0) { caps[j.slot] = j.off; continue; }
+			uint32_t pc = j.pc;
+			const char *pos = c->s + j.off;
+			for (;;) {
+				size_t bit = (size_t)pc * len + (size_t)(pos - c->s);
+				if (seen[bit / 32] >> (bit % 32) & 1u) break;
+				seen[bit / 32] |= 1u << (bit % 32);
+				const match_inst_t *in = &m->prog[pc];
+				if (in->op == MVM_JMP) { pc = in->x; continue; }
+				if (in->op == MVM_SPLIT) {
+					if (__jacl_vm_push(&jobs, &nj, &cap, local, (__jacl_bits_job_t){ in->y, -1, pos - c->s })) { err = M_ESPACE; break; }
+					pc = in->x; continue;
+				}
+				if (in->op == MVM_ASSERT) { if (!__jacl_match_at(c, (match_tok_t)in->val, pos)) break; pc++; continue; }
+				if (in->op == MVM_SAVE) {
+					if (in->val < ns) {
+						if (__jacl_vm_push(&jobs, &nj, &cap, local, (__jacl_bits_job_t){ 0, (int32_t)in->val, caps[in->val] })) { err = M_ESPACE; break; }
+						caps[in->val] = pos - c->s;
+					}
+					pc++; continue;
+				}
+				if (in->op == MVM_MATCH) { err = M_SUCCESS; break; }
+				if (pos >= c->end) break;
+				const char *next = pos + 1;
+				uint8_t b = (uint8_t)*pos;
+				uint32_t cp = b;
+				if (b >= 0x80) { while (next < c->end && JACL_UTF8_CONT(next)) next++; const char *q = pos; cp = __jacl_match_utf8_next(&q, next); }
+				if (!__jacl_vm_step(c, in, cp, b)) break;
+				pc++; pos = next;
+			}
+		}
+	}
+	if (jobs != local) free(jobs);
+	if (err == M_SUCCESS) {
+		for (size_t i = 0; i < ng; i++) { pm[i].rm_so = caps[i*2]; pm[i].rm_eo = caps[i*2+1]; }
+		for (size_t i = ng; i < nm; i++) { pm[i].rm_so = -1; pm[i].rm_eo = -1; }
+	}
+	return err;
+}
 match_err_t matchcomp(matcher_t *restrict m, const char *pat, mcomp_flag_t fl) {
 	memset(m, 0, sizeof(*m));
 	m->cflags = fl;
@@ -565,39 +1122,580 @@ match_err_t matchcomp(matcher_t *restrict m, const char *pat, mcomp_flag_t fl) {
 	m->root = __jacl_match_expr(&p);
 	if (p.err) { __jacl_match_free_arena(m); return p.err; }
 	m->m_nsub = p.cap; m->eflags = p.eflags;
-	if (m->root && m->arena[m->root].type == MTOK_ALT) { m->nlit = 0; }
-	else {
-		m->nlit = 0;
-		const char *pp = pat;
-		if (*pp == '^') pp++;
-		while (*pp && *pp != '.' && *pp != '[' && *pp != '(' && *pp != '|' && *pp != ')' && *pp != '*' && *pp != '+' && *pp != '?' && *pp != '{' && *pp != '\\' && *pp != '$') { m->lit[m->nlit++] = *pp++; if (m->nlit >= 31) break; }
-		if (m->nlit > 0) { char next = *pp; if (next == '*' || next == '?' || next == '+' || next == '{') m->nlit = 0; }
-	}
+	for (uint32_t i = 1; i < m->count; i++) if (m->arena[i].type == MTOK_BACKREF || m->arena[i].type == MTOK_COND) m->refs = 1;
+	__jacl_vm_compile(m);
+	__jacl_lit_compile(m);
 	return M_SUCCESS;
 }
-match_err_t matchexec(const matcher_t *restrict m, const char *s, const char *end, match_find_t *pm, size_t nm, mexec_flag_t fl) {
+static inline match_err_t __jacl_match_backtrack(const matcher_t *m, const char *s, const char *end, match_find_t *pm, size_t nm, mexec_flag_t fl) {
 	matchoff_t local_caps[MATCH_MAX_GROUPS * 2];
 	__jacl_rep_ws_t rep_buffer;
-	match_ctx_t c = { m, s, end, local_caps, (m->eflags | fl) & MEXEC_ICASE, (m->eflags | fl) & MEXEC_NEWLINE, fl, 0, M_SUCCESS, &rep_buffer };
+	match_ctx_t c = { m, s, end, local_caps, (m->eflags | fl) & MEXEC_ICASE, (m->eflags | fl) & MEXEC_NEWLINE, fl, 0, M_SUCCESS, &rep_buffer, 0 };
+	// track the groups the caller asked for, or all of them when backreferences read them back
+	size_t ng = m->refs ? m->m_nsub + 1 : (pm && nm > 1) ? nm : 0;
+	if (ng > m->m_nsub + 1) ng = m->m_nsub + 1;
+	if (ng > MATCH_MAX_GROUPS) ng = MATCH_MAX_GROUPS;
+	c.ncap = (uint32_t)ng * 2;
 	int anchored = (m->root && m->arena[m->root].type == MTOK_BOL);
-	const char *start = (anchored || (m->eflags & MEXEC_ICASE)) ? s : matchgate(m, s, end, c.ic);
+	__jacl_gate_t g = { NULL, NULL };
+	const char *start = anchored ? s : matchgate(m, s, end, c.ic, &g);
 	if (JACL_UNLIKELY(!start)) { return M_NOMATCH; }
-	for (; start <= end; start++) {
-		for(int i=0; i<MATCH_MAX_GROUPS * 2; i++) c.caps[i] = -1;
+	for (; start && start <= end; start = matchgate(m, start + 1, end, c.ic, &g)) {
+		for (uint32_t i = 0; i < c.ncap; i++) c.caps[i] = -1;
 		if (JACL_UNLIKELY(c.depth > MATCH_MAX_DEPTH)) { c.error = M_EDEPTH; break; }
 		const char *r = matchfind(&c, m->root, start);
 		if (c.error == M_EDEPTH) break;
 		if (JACL_UNLIKELY(!r)) { if (anchored) break; continue; }
 		if (pm && nm > 0) {
 			pm[0].rm_so = start - s; pm[0].rm_eo = r - s;
-			for (size_t i = 1; i < nm; i++) { pm[i].rm_so = c.caps[i*2]; pm[i].rm_eo = c.caps[i*2+1]; }
+			for (size_t i = 1; i < nm; i++) { pm[i].rm_so = i < ng ? c.caps[i*2] : -1; pm[i].rm_eo = i < ng ? c.caps[i*2+1] : -1; }
 		}
 		return M_SUCCESS;
 	}
 	return c.error != M_SUCCESS ? c.error : M_NOMATCH;
 }
+match_err_t matchexec(const matcher_t *restrict m, const char *s, const char *end, match_find_t *pm, size_t nm, mexec_flag_t fl) {
+	if ((m->eflags | fl) & MEXEC_NOSUB) { pm = NULL; nm = 0; }
+	if (!m->prog) return __jacl_match_backtrack(m, s, end, pm, nm, fl);
+	match_ctx_t c = { m, s, end, NULL, (m->eflags | fl) & MEXEC_ICASE, (m->eflags | fl) & MEXEC_NEWLINE, fl, 0, M_SUCCESS, NULL, 0 };
+	if (!m->nullrep && (size_t)m->nprog * (size_t)(end - s + 1) <= MATCH_MAX_BITS) return __jacl_vm_bits(&c, pm, nm);
+	return __jacl_vm_exec(&c, s, pm, nm);
+}
 void matchfree(matcher_t *restrict m) { __jacl_match_free_arena(m); }
 
+/* ===================================================================== */
+/* Pattern Sets                                                          */
+/* ===================================================================== */
+
+/**
+ * NOTE: A matchset answers "which of these patterns occur in the subject" in
+ * one pass. matchsetcomp copies every member's Pike VM program into a single
+ * instruction array, rebasing jumps, turning MATCH into "member k matched" and
+ * baking each member's ICASE and NEWLINE into its instructions, so all of
+ * them can be walked together. matchsetexec runs that program as a lazily
+ * built DFA: a state is the set of pcs alive after some code point plus the
+ * class of that code point (start, newline, word or other, which is all ^, $
+ * and \b look at), and its moves on ASCII bytes are cached in the state. No
+ * thread is ever cut the way leftmost-first does, so every member that can
+ * match is seen, and every member restarts at every position as an unanchored
+ * search would. What the member entry points do on each byte is worked out
+ * once, so building a state only walks the threads already in it. The cache
+ * holds at most MATCH_MAX_DFA states and is flushed when full, which costs
+ * time, never answers. Members the VM can't run
+ * (backreferences, lookaround) are searched one by one with matchexec. The
+ * cache lives in the set, so one set must not be searched from two threads at
+ * once.
+ */
+
+enum { __JACL_DFA_EDGE, __JACL_DFA_NL, __JACL_DFA_WORD, __JACL_DFA_OTHER };
+#define __JACL_DFA_HIT 0x80000000u
+
+typedef struct {
+	uint32_t pcs, npcs, hash;
+	uint8_t prev;
+	uint32_t mat[4], nmat[4];
+	uint32_t next[128];
+} __jacl_dstate_t;
+
+struct __jacl_dfa {
+	__jacl_dstate_t *st;
+	uint32_t nst, capst;
+	uint32_t *pool, npool, cappool, maxpool;
+	uint32_t *table, mask;
+	uint32_t *mark, gen, *stack, *list, *ids;
+	uint32_t *lpool, nlpool, caplpool, lead[4][129];
+	uint32_t flushes;
+	uint8_t asserts;
+	mexec_flag_t ef;
+	uint8_t cls[128];
+};
+
+static inline uint8_t __jacl_set_class(uint32_t cp) { return cp == '\n' ? __JACL_DFA_NL : __jacl_match_is_word(cp) ? __JACL_DFA_WORD : __JACL_DFA_OTHER; }
+static inline int __jacl_set_cmp(const void *a, const void *b) { uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b; return (x > y) - (x < y); }
+
+// __jacl_match_at for a position known only by the classes either side of it; EDGE is the start before and the end after
+static inline int __jacl_set_at(mexec_flag_t ef, match_tok_t t, int nl, uint8_t prev, uint8_t cur) {
+	if (t == MTOK_BOL) return !(ef & MEXEC_NOTBOL) && (prev == __JACL_DFA_EDGE || (nl && prev == __JACL_DFA_NL));
+	if (t == MTOK_EOL) return !(ef & MEXEC_NOTEOL) && (cur == __JACL_DFA_EDGE || (nl && cur == __JACL_DFA_NL));
+	int neg = (t == MTOK_NWB);
+	if (prev == __JACL_DFA_EDGE || cur == __JACL_DFA_EDGE) return !neg;
+	return neg ? ((prev == __JACL_DFA_WORD) == (cur == __JACL_DFA_WORD)) : ((prev == __JACL_DFA_WORD) != (cur == __JACL_DFA_WORD));
+}
+static inline void __jacl_set_flush(__jacl_dfa_t *d) {
+	d->nst = 0; d->npool = 0; d->flushes++;
+	memset(d->table, 0, (d->mask + 1) * sizeof(uint32_t));
+}
+// room for `states` more states and `words` more pool words; 0 once the MATCH_MAX_DFA budget is spent
+static inline int __jacl_set_room(__jacl_dfa_t *d, uint32_t states, uint32_t words) {
+	if (d->nst + states > d->capst) {
+		if (d->nst + states > MATCH_MAX_DFA) return 0;
+		uint32_t cap = d->capst ? d->capst * 2 : 64;
+		if (cap > MATCH_MAX_DFA) cap = MATCH_MAX_DFA;
+		__jacl_dstate_t *tmp = realloc(d->st, cap * sizeof(__jacl_dstate_t));
+		if (!tmp) return 0;
+		d->st = tmp; d->capst = cap;
+	}
+	if (d->npool + words > d->cappool) {
+		if (d->npool + words > d->maxpool) return 0;
+		uint32_t cap = d->cappool ? d->cappool : 64;
+		while (cap < d->npool + words) cap *= 2;
+		if (cap > d->maxpool) cap = d->maxpool;
+		uint32_t *tmp = realloc(d->pool, cap * sizeof(uint32_t));
+		if (!tmp) return 0;
+		d->pool = tmp; d->cappool = cap;
+	}
+	return 1;
+}
+static inline uint32_t __jacl_set_intern(__jacl_dfa_t *d, const uint32_t *pcs, uint32_t n, uint8_t prev) {
+	uint32_t h = 2166136261u ^ prev, slot;
+	for (uint32_t i = 0; i < n; i++) h = (h ^ pcs[i]) * 16777619u;
+	for (slot = h & d->mask; d->table[slot]; slot = (slot + 1) & d->mask) {
+		const __jacl_dstate_t *st = &d->st[d->table[slot] - 1];
+		if (st->hash == h && st->prev == prev && st->npcs == n && (!n || !memcmp(d->pool + st->pcs, pcs, n * sizeof(uint32_t)))) return d->table[slot] - 1;
+	}
+	if (!__jacl_set_room(d, 1, n)) return UINT32_MAX;
+	__jacl_dstate_t *st = &d->st[d->nst];
+	st->pcs = d->npool; st->npcs = n; st->hash = h; st->prev = prev;
+	for (int i = 0; i < 4; i++) { st->mat[i] = 0; st->nmat[i] = UINT32_MAX; }
+	memset(st->next, 0, sizeof(st->next));
+	if (n) memcpy(d->pool + d->npool, pcs, n * sizeof(uint32_t));
+	d->npool += n;
+	d->table[slot] = d->nst + 1;
+	return d->nst++;
+}
+static inline uint32_t __jacl_set_state(__jacl_dfa_t *d, const uint32_t *pcs, uint32_t n, uint8_t prev) {
+	uint32_t at = __jacl_set_intern(d, pcs, n, prev);
+	if (at == UINT32_MAX) { __jacl_set_flush(d); at = __jacl_set_intern(d, pcs, n, prev); }
+	return at;
+}
+// close the seeds over the zero-width moves at one position and step what is left over cp: the next pcs end up in d->stack, the members that matched in d->ids
+static inline void __jacl_set_walk(matchset_t *s, const uint32_t *a, uint32_t na, const uint32_t *b, uint32_t nb, uint8_t prev, uint32_t cp, uint8_t cur, uint32_t *nn, uint32_t *ni) {
+	__jacl_dfa_t *d = s->dfa;
+	uint32_t sp = 0, nl = 0, k = 0;
+	d->gen++;
+	for (uint32_t i = 0; i < na + nb; i++) {
+		uint32_t pc = i < na ? a[i] : b[i - na];
+		if (d->mark[pc] != d->gen) { d->mark[pc] = d->gen; d->stack[sp++] = pc; }
+	}
+	while (sp) {
+		uint32_t pc = d->stack[--sp], to[2], nt = 0;
+		const match_inst_t *in = &s->prog[pc];
+		switch (in->op) {
+			case MVM_JMP: to[nt++] = in->x; break;
+			case MVM_SPLIT: to[nt++] = in->x; to[nt++] = in->y; break;
+			case MVM_SAVE: to[nt++] = pc + 1; break;
+			case MVM_ASSERT: if (__jacl_set_at(d->ef, (match_tok_t)in->val, in->flag || (d->ef & MEXEC_NEWLINE), prev, cur)) to[nt++] = pc + 1; break;
+			case MVM_MATCH: d->ids[k++] = in->val; break;
+			default: d->list[nl++] = pc;
+		}
+		for (uint32_t j = 0; j < nt; j++) if (d->mark[to[j]] != d->gen) { d->mark[to[j]] = d->gen; d->stack[sp++] = to[j]; }
+	}
+	*ni = k; *nn = 0;
+	if (cur == __JACL_DFA_EDGE) return;
+	d->gen++;
+	for (uint32_t i = 0; i < nl; i++) {
+		const match_inst_t *in = &s->prog[d->list[i]];
+		int ic = in->flag || (d->ef & MEXEC_ICASE);
+		int ok = in->op == MVM_CHAR ? __jacl_match_fold(cp, in->val, ic)
+			: in->op == MVM_CLASS ? __jacl_match_in_class(&s->pats[in->x], cp, (uint8_t)in->val, ic)
+			: in->flag || cp != '\n';
+		if (ok && d->mark[d->list[i] + 1] != d->gen) { d->mark[d->list[i] + 1] = d->gen; d->stack[(*nn)++] = d->list[i] + 1; }
+	}
+}
+// what the member entry points alone do at an ASCII byte (128: the end), kept as { nn, ni, pcs..., ids... } so new states don't walk every member again
+static inline uint32_t __jacl_set_lead(matchset_t *s, uint8_t prev, uint32_t key, uint8_t cur) {
+	__jacl_dfa_t *d = s->dfa;
+	uint32_t nn, ni, at = d->lead[prev][key];
+	if (at != UINT32_MAX) return at;
+	__jacl_set_walk(s, s->starts, s->nvm, NULL, 0, prev, key, cur, &nn, &ni);
+	if (d->nlpool + 2 + nn + ni > d->caplpool) {
+		uint32_t cap = d->caplpool ? d->caplpool : 64;
+		while (cap < d->nlpool + 2 + nn + ni) cap *= 2;
+		uint32_t *tmp = realloc(d->lpool, cap * sizeof(uint32_t));
+		if (!tmp) return UINT32_MAX;
+		d->lpool = tmp; d->caplpool = cap;
+	}
+	at = d->nlpool;
+	d->lpool[at] = nn; d->lpool[at + 1] = ni;
+	if (nn) memcpy(d->lpool + at + 2, d->stack, nn * sizeof(uint32_t));
+	if (ni) memcpy(d->lpool + at + 2 + nn, d->ids, ni * sizeof(uint32_t));
+	d->nlpool += 2 + nn + ni;
+	return d->lead[prev][key] = at;
+}
+// follow state `at` across one code point of class cur (EDGE: the end of the subject); the members that matched on the way are left in d->ids
+static inline uint32_t __jacl_set_move(matchset_t *s, uint32_t at, uint32_t cp, uint8_t cur, uint32_t *nids) {
+	__jacl_dfa_t *d = s->dfa;
+	uint8_t prev = d->st[at].prev;
+	uint32_t nn, ni, lead = (cp < 0x80 || cur == __JACL_DFA_EDGE) ? __jacl_set_lead(s, prev, cur == __JACL_DFA_EDGE ? 128 : cp, cur) : UINT32_MAX;
+	const __jacl_dstate_t *st = &d->st[at];
+	if (lead == UINT32_MAX) __jacl_set_walk(s, d->pool + st->pcs, st->npcs, s->starts, s->nvm, prev, cp, cur, &nn, &ni);
+	else {
+		const uint32_t *l = d->lpool + lead;
+		__jacl_set_walk(s, d->pool + st->pcs, st->npcs, NULL, 0, prev, cp, cur, &nn, &ni);
+		for (uint32_t i = 0; i < l[0]; i++) if (d->mark[l[2 + i]] != d->gen) { d->mark[l[2 + i]] = d->gen; d->stack[nn++] = l[2 + i]; }
+		for (uint32_t i = 0; i < l[1]; i++) d->ids[ni++] = l[2 + l[0] + i];
+	}
+	if (st->nmat[cur] == UINT32_MAX && __jacl_set_room(d, 0, ni)) {
+		__jacl_dstate_t *w = &d->st[at];
+		if (ni) memcpy(d->pool + d->npool, d->ids, ni * sizeof(uint32_t));
+		w->mat[cur] = d->npool; w->nmat[cur] = ni; d->npool += ni;
+	}
+	*nids = ni;
+	if (cur == __JACL_DFA_EDGE) return at;
+	if (nn > 1) qsort(d->stack, nn, sizeof(uint32_t), __jacl_set_cmp);
+	return __jacl_set_state(d, d->stack, nn, d->asserts ? cur : __JACL_DFA_OTHER);
+}
+static inline void __jacl_set_free_dfa(__jacl_dfa_t *d) {
+	if (!d) return;
+	free(d->st); free(d->pool); free(d->table); free(d->mark); free(d->stack); free(d->list); free(d->ids); free(d->lpool); free(d);
+}
+match_err_t matchsetadd(matchset_t *restrict s, const char *pat, mcomp_flag_t cf, mexec_flag_t ef) {
+	if (!s || !pat) return M_BADPAT;
+	if (s->n >= s->cap) {
+		uint32_t cap = s->cap ? s->cap * 2 : 8;
+		matcher_t *tmp = realloc(s->pats, cap * sizeof(matcher_t));
+		if (!tmp) return M_ESPACE;
+		s->pats = tmp; s->cap = cap;
+	}
+	match_err_t err = matchcomp(&s->pats[s->n], pat, cf);
+	if (err != M_SUCCESS) return err;
+	s->pats[s->n++].eflags |= ef;
+	s->ready = 0;
+	return M_SUCCESS;
+}
+match_err_t matchsetcomp(matchset_t *restrict s) {
+	uint32_t total = 0, nvm = 0, at = 0;
+	free(s->prog); free(s->starts); free(s->slow); free(s->found); free(s->hit); __jacl_set_free_dfa(s->dfa);
+	s->prog = NULL; s->starts = s->slow = s->found = NULL; s->hit = NULL; s->dfa = NULL; s->nprog = s->nvm = s->nslow = 0; s->ready = 0;
+	for (uint32_t k = 0; k < s->n; k++) if (s->pats[k].prog) { total += s->pats[k].nprog; nvm++; }
+	s->hit = calloc(s->n + 1, 1);
+	s->found = malloc((s->n + 1) * sizeof(uint32_t));
+	s->slow = malloc((s->n - nvm + 1) * sizeof(uint32_t));
+	s->prog = malloc((total + 1) * sizeof(match_inst_t));
+	s->starts = malloc((nvm + 1) * sizeof(uint32_t));
+	__jacl_dfa_t *d = s->dfa = calloc(1, sizeof(__jacl_dfa_t));
+	if (!s->hit || !s->found || !s->slow || !s->prog || !s->starts || !d) return M_ESPACE;
+	for (uint32_t k = 0; k < s->n; k++) {
+		const matcher_t *m = &s->pats[k];
+		if (!m->prog) { s->slow[s->nslow++] = k; continue; }
+		uint8_t ic = !!(m->eflags & MEXEC_ICASE), nl = !!(m->eflags & MEXEC_NEWLINE);
+		s->starts[s->nvm++] = at;
+		for (uint32_t i = 0; i < m->nprog; i++) {
+			match_inst_t in = m->prog[i];
+			switch (in.op) {
+				case MVM_JMP: in.x += at; break;
+				case MVM_SPLIT: in.x += at; in.y += at; break;
+				case MVM_MATCH: in.val = k; break;
+				case MVM_CHAR: in.flag |= ic; break;
+				case MVM_CLASS: in.flag = ic; in.x = k; break;
+				case MVM_ASSERT: in.flag = nl; d->asserts = 1; break;
+				default: break;
+			}
+			s->prog[at + i] = in;
+		}
+		at += m->nprog;
+	}
+	s->nprog = total;
+	d->maxpool = (uint32_t)MATCH_MAX_DFA * 32u + 4u * (total + nvm);
+	for (d->mask = 1; d->mask < 2u * MATCH_MAX_DFA; d->mask <<= 1) {}
+	d->table = calloc(d->mask--, sizeof(uint32_t));
+	d->mark = calloc(total + 1, sizeof(uint32_t));
+	d->stack = malloc((total + 1) * sizeof(uint32_t));
+	d->list = malloc((total + 1) * sizeof(uint32_t));
+	d->ids = malloc((2 * nvm + 1) * sizeof(uint32_t));
+	memset(d->lead, 0xFF, sizeof(d->lead));
+	if (!d->table || !d->mark || !d->stack || !d->list || !d->ids) return M_ESPACE;
+	for (uint32_t b = 0; b < 128; b++) d->cls[b] = __jacl_set_class(b);
+	s->ready = 1;
+	return M_SUCCESS;
+}
+match_err_t matchsetexec(matchset_t *restrict s, const char *str, const char *end, uint32_t *ids, size_t *nids, mexec_flag_t fl) {
+	size_t cap = nids ? *nids : 0;
+	uint32_t left, n, found = 0;
+	match_err_t err;
+	if (!s->ready && (err = matchsetcomp(s)) != M_SUCCESS) return err;
+	left = s->nvm;
+	if (left) {
+		__jacl_dfa_t *d = s->dfa;
+		mexec_flag_t ef = fl & (MEXEC_NOTBOL | MEXEC_NOTEOL | MEXEC_NEWLINE | MEXEC_ICASE);
+		if (d->ef != ef) { __jacl_set_flush(d); d->ef = ef; d->nlpool = 0; memset(d->lead, 0xFF, sizeof(d->lead)); }
+		uint32_t at = __jacl_set_state(d, NULL, 0, d->asserts ? __JACL_DFA_EDGE : __JACL_DFA_OTHER);
+		const char *p = str;
+		for (;;) {
+			const uint32_t *hit = d->ids;
+			int last = p >= end;
+			n = 0;
+			if (last) {
+				const __jacl_dstate_t *st = &d->st[at];
+				if (st->nmat[__JACL_DFA_EDGE] != UINT32_MAX) { hit = d->pool + st->mat[__JACL_DFA_EDGE]; n = st->nmat[__JACL_DFA_EDGE]; }
+				else __jacl_set_move(s, at, 0, __JACL_DFA_EDGE, &n);
+			} else if ((uint8_t)*p < 0x80) {
+				uint8_t b = (uint8_t)*p++, cls = d->cls[b];
+				uint32_t t = d->st[at].next[b];
+				if (t) {
+					if (t & __JACL_DFA_HIT) { hit = d->pool + d->st[at].mat[cls]; n = d->st[at].nmat[cls]; }
+					at = (t & ~__JACL_DFA_HIT) - 1;
+				} else {
+					uint32_t flushes = d->flushes, from = at;
+					at = __jacl_set_move(s, from, b, cls, &n);
+					if (d->flushes == flushes && d->st[from].nmat[cls] != UINT32_MAX) d->st[from].next[b] = (at + 1) | (n ? __JACL_DFA_HIT : 0);
+				}
+			} else {
+				uint32_t cp = __jacl_match_utf8_next(&p, end);
+				at = __jacl_set_move(s, at, cp, __jacl_set_class(cp), &n);
+			}
+			for (uint32_t i = 0; i < n; i++) if (!s->hit[hit[i]]) { s->hit[hit[i]] = 1; s->found[found++] = hit[i]; left--; }
+			if (!left || last) break;
+		}
+	}
+	for (uint32_t i = 0; i < s->nslow; i++) {
+		const matcher_t *m = &s->pats[s->slow[i]];
+		if (matchexec(m, str, end, NULL, 0, m->eflags | fl) == M_SUCCESS) s->found[found++] = s->slow[i];
+	}
+	if (found > 1) qsort(s->found, found, sizeof(uint32_t), __jacl_set_cmp);
+	for (uint32_t i = 0; i < found; i++) { if (i < cap) ids[i] = s->found[i]; s->hit[s->found[i]] = 0; }
+	if (nids) *nids = found;
+	return found ? M_SUCCESS : M_NOMATCH;
+}
+void matchsetfree(matchset_t *restrict s) {
+	if (!s) return;
+	for (uint32_t k = 0; k < s->n; k++) matchfree(&s->pats[k]);
+	free(s->pats); free(s->prog); free(s->starts); free(s->slow); free(s->found); free(s->hit); __jacl_set_free_dfa(s->dfa);
+	memset(s, 0, sizeof(*s));
+}
+
+/* ===================================================================== */
+/* Streaming                                                             */
+/* ===================================================================== */
+
+/**
+ * NOTE: A matchstream runs a pattern's Pike VM program over a subject that
+ * arrives in chunks (socket reads, fread buffers) and reports matches as
+ * offsets from the start of the stream. The answers are the leftmost-first
+ * ones matchexec would give for the whole stream at once, found one after
+ * another; after an empty match the search resumes one character later.
+ * Between chunks a thread is kept after it steps over a code point but before
+ * its closure runs, because ^, $ and \b at the edge of a chunk depend on what
+ * comes next. A match is only reported once no higher priority thread can
+ * still end later, so the VM may have read past its end; those bytes, and a
+ * UTF-8 sequence cut by the edge of a chunk, are copied to ms->hold and run
+ * again, and nothing else of a chunk is kept once the call returns. When a
+ * match is found part way through a chunk, *used says how much of it was
+ * taken and the caller feeds the rest again. While no thread is alive the
+ * literal sets skip ahead inside the chunk as matchgate does, trusting only
+ * what the chunk shows: a literal may still be cut by its end. Patterns
+ * without a program (backreferences, lookaround) can't be streamed and
+ * matchstreaminit turns them away with M_BADPAT.
+ */
+
+struct __jacl_stream {
+	match_ctx_t c;
+	__jacl_vm_t v;
+	__jacl_vm_list_t run, step;
+	matchoff_t *mem, *best, keep;
+	size_t ng, most, rmost;
+	uint8_t prev, bprev, closed, matched, nostart, fixed, pre, req;
+};
+
+static inline uint32_t __jacl_stream_holds(const match_ctx_t *c, uint8_t prev, uint8_t cur) {
+	uint32_t wb = (uint32_t)__jacl_set_at(c->ef, MTOK_WB, c->nl, prev, cur);
+	return (uint32_t)__jacl_set_at(c->ef, MTOK_BOL, c->nl, prev, cur) << MTOK_BOL | (uint32_t)__jacl_set_at(c->ef, MTOK_EOL, c->nl, prev, cur) << MTOK_EOL | wb << MTOK_WB | (wb ^ 1u) << MTOK_NWB;
+}
+static inline int __jacl_stream_hold(matchstream_t *ms, const char *p, size_t n) {
+	if (!n) return 0;
+	if (ms->nhold + n > ms->cap) {
+		size_t cap = ms->cap ? ms->cap : 64;
+		while (cap < ms->nhold + n) cap *= 2;
+		char *tmp = realloc(ms->hold, cap);
+		if (!tmp) return -1;
+		ms->hold = tmp; ms->cap = cap;
+	}
+	memcpy(ms->hold + ms->nhold, p, n);
+	ms->nhold += n;
+	return 0;
+}
+// the last place in p..end a literal of up to most + 1 bytes could start without running past end
+static inline const char *__jacl_stream_lim(const char *p, const char *end, size_t most) {
+	const char *q = (size_t)(end - p) > most ? end - most : p;
+	while (q > p && JACL_UTF8_CONT(q)) q--;
+	return q;
+}
+// matchgate for a chunk: the earliest place at or after p a match could start, *rq caching the last req hit
+static inline const char *__jacl_stream_skip(const __jacl_stream_t *t, const matcher_t *m, const char *p, const char *end, const char **rq) {
+	const char *s = p;
+	if (t->req) {
+		// a req literal past the end of the chunk still bounds how far back its match can start
+		const char *lim = __jacl_stream_lim(p, end, t->rmost), *r;
+		if (!*rq || *rq < p) *rq = __jacl_match_scan(&m->req, p, end, t->c.ic);
+		r = (*rq && *rq < lim) ? *rq : lim;
+		if (m->req.lead >= 0 && r - s > m->req.lead) s = r - m->req.lead;
+		if (!m->req.nl) for (const char *z = r; z > s; z--) if (z[-1] == '\n') { s = z; break; }
+		while (s > p && JACL_UTF8_CONT(s)) s--;
+	}
+	if (t->pre) {
+		const char *lim = __jacl_stream_lim(s, end, t->most), *q = __jacl_match_scan(&m->pre, s, end, t->c.ic);
+		s = (q && q < lim) ? q : lim;
+	}
+	return s;
+}
+// closure of the stepped threads at ms->off, cur being the class of what follows; a match cuts the threads after it
+static inline void __jacl_stream_close(matchstream_t *ms, uint8_t cur) {
+	__jacl_stream_t *t = ms->vm;
+	__jacl_vm_t *v = &t->v;
+	size_t ns = v->ns;
+	if (++v->gen == UINT32_MAX) { memset(v->mark, 0, ms->m->nprog * sizeof(uint32_t)); v->gen = 1; }
+	t->run.n = 0;
+	if (ms->m->asserts) v->ok = __jacl_stream_holds(&t->c, t->prev, cur);
+	for (uint32_t i = 0; i < t->step.n; i++) {
+		__jacl_vm_copy(v->work, t->step.caps + (size_t)i * ns, ns);
+		__jacl_vm_add(v, &t->run, t->step.pc[i], ms->off);
+	}
+	if (!t->matched && !t->nostart && !(t->fixed && ms->off)) {
+		for (size_t i = 0; i < ns; i++) v->work[i] = -1;
+		__jacl_vm_add(v, &t->run, 0, ms->off);
+	}
+	t->nostart = 0; t->closed = 1;
+	for (uint32_t i = 0; i < t->run.n; i++) {
+		if (ms->m->prog[t->run.pc[i]].op != MVM_MATCH) continue;
+		if (!t->matched) t->keep = ms->off;
+		t->matched = 1; t->bprev = t->prev;
+		__jacl_vm_copy(t->best, t->run.caps + (size_t)i * ns, ns);
+		t->run.n = i;
+		break;
+	}
+}
+static inline void __jacl_stream_step(matchstream_t *ms, uint32_t cp, uint8_t b, size_t len, uint8_t cls) {
+	__jacl_stream_t *t = ms->vm;
+	size_t ns = t->v.ns;
+	t->step.n = 0;
+	for (uint32_t i = 0; i < t->run.n; i++) {
+		if (!__jacl_vm_step(&t->c, &ms->m->prog[t->run.pc[i]], cp, b)) continue;
+		t->step.pc[t->step.n] = t->run.pc[i] + 1;
+		__jacl_vm_copy(t->step.caps + (size_t)t->step.n * ns, t->run.caps + (size_t)i * ns, ns);
+		t->step.n++;
+	}
+	ms->off += (matchoff_t)len; t->prev = cls; t->closed = 0;
+}
+// run ms->hold then buf (which starts at ms->fed) through the VM; eof closes the stream after them
+static inline match_err_t __jacl_stream_run(matchstream_t *ms, const char *buf, size_t len, int eof, size_t *used, match_find_t *pm, size_t nm) {
+	__jacl_stream_t *t = ms->vm;
+	size_t moved = 0;
+	if (!t) return M_BADPAT;
+	// a sequence cut at the end of the held bytes goes on in buf
+	if (ms->off < ms->fed) {
+		while (moved < len && JACL_UTF8_CONT(buf + moved)) moved++;
+		if (__jacl_stream_hold(ms, buf, moved)) return M_ESPACE;
+		ms->fed += (matchoff_t)moved; buf += moved; len -= moved;
+	}
+	matchoff_t base = ms->fed, hoff = base - (matchoff_t)ms->nhold;
+	const char *rq = NULL;
+	for (;;) {
+		int held = ms->off < base;
+		const char *r = held ? ms->hold : buf;
+		size_t rn = held ? ms->nhold : len, i = (size_t)(ms->off - (held ? hoff : base));
+		if (!held && i >= rn) break;
+		if (!held && !t->closed && !t->step.n && !t->matched && !t->nostart) {
+			if (t->fixed && ms->off) { ms->off = base + (matchoff_t)len; break; }
+			if (t->pre || t->req) {
+				const char *p = buf + i, *q = __jacl_stream_skip(t, ms->m, p, buf + len, &rq);
+				if (q > p) {
+					const char *z = q - 1;
+					while (z > p && JACL_UTF8_CONT(z)) z--;
+					t->prev = __jacl_set_class(__jacl_match_utf8_next(&z, q));
+					ms->off += q - p;
+					continue;
+				}
+			}
+		}
+		uint8_t b = (uint8_t)r[i];
+		uint32_t cp = b;
+		size_t n = 1;
+		if (b >= 0x80) {
+			while (i + n < rn && JACL_UTF8_CONT(r + i + n)) n++;
+			if (i + n == rn && !eof && (!held || !len)) break;
+			const char *q = r + i;
+			cp = __jacl_match_utf8_next(&q, r + i + n);
+		}
+		uint8_t cls = __jacl_set_class(cp);
+		if (!t->closed) {
+			__jacl_stream_close(ms, cls);
+			if (t->matched && !t->run.n) goto found;
+		}
+		__jacl_stream_step(ms, cp, b, n, cls);
+		if (t->matched && !t->step.n) goto found;
+		// with nothing to look ahead for, a match is settled as soon as it is reached
+		if (t->step.n && !ms->m->asserts) {
+			__jacl_stream_close(ms, __JACL_DFA_OTHER);
+			if (t->matched && !t->run.n) goto found;
+		}
+	}
+	if (eof) {
+		if (!t->closed) __jacl_stream_close(ms, __JACL_DFA_EDGE);
+		if (t->matched) goto found;
+		ms->off = ms->fed = base + (matchoff_t)len; ms->nhold = 0;
+		*used = moved + len;
+		return M_NOMATCH;
+	}
+	// keep what the VM hasn't taken yet and whatever followed a match still being extended
+	matchoff_t from = t->matched ? t->keep : ms->off;
+	if (from < base) { size_t k = (size_t)(from - hoff); memmove(ms->hold, ms->hold + k, ms->nhold - k); ms->nhold -= k; }
+	else ms->nhold = 0;
+	size_t skip = from > base ? (size_t)(from - base) : 0;
+	if (__jacl_stream_hold(ms, buf + skip, len - skip)) return M_ESPACE;
+	ms->fed = base + (matchoff_t)len;
+	*used = moved + len;
+	return M_NOMATCH;
+found:;
+	matchoff_t so = t->best[0], eo = t->best[1];
+	size_t ng = nm < t->ng ? nm : t->ng;
+	for (size_t i = 0; pm && i < nm; i++) { pm[i].rm_so = i < ng ? t->best[i*2] : -1; pm[i].rm_eo = i < ng ? t->best[i*2+1] : -1; }
+	// resume at the end of the match; bytes after it the caller no longer holds stay in ms->hold
+	if (eo >= base) { ms->nhold = 0; ms->fed = eo; *used = moved + (size_t)(eo - base); }
+	else { size_t k = (size_t)(eo - hoff); ms->nhold = (size_t)(base - eo); memmove(ms->hold, ms->hold + k, ms->nhold); ms->fed = base; *used = moved; }
+	ms->off = eo; t->prev = t->bprev; t->nostart = so == eo;
+	t->matched = t->closed = 0; t->run.n = t->step.n = 0;
+	return M_SUCCESS;
+}
+match_err_t matchstreaminit(matchstream_t *restrict ms, const matcher_t *m, size_t nm, mexec_flag_t fl) {
+	memset(ms, 0, sizeof(*ms));
+	if (!m || !m->prog) return M_BADPAT;
+	size_t np = m->nprog, ng = m->m_nsub + 1;
+	if (ng > nm) ng = nm ? nm : 1;
+	if (ng > MATCH_MAX_GROUPS) ng = MATCH_MAX_GROUPS;
+	size_t ns = ng * 2, words = ((2 * np + 2) * ns * sizeof(matchoff_t) + 3 * np * sizeof(uint32_t)) / sizeof(matchoff_t) + 1;
+	__jacl_stream_t *t = calloc(1, sizeof(*t));
+	matchoff_t *mem = malloc(words * sizeof(matchoff_t));
+	if (!t || !mem) { free(t); free(mem); return M_ESPACE; }
+	t->c = (match_ctx_t){ m, NULL, NULL, NULL, (m->eflags | fl) & MEXEC_ICASE, (m->eflags | fl) & MEXEC_NEWLINE, fl, 0, M_SUCCESS, NULL, 0 };
+	t->mem = mem; t->ng = ng;
+	t->run.caps = mem; t->step.caps = mem + np * ns; t->best = mem + 2 * np * ns;
+	t->v = (__jacl_vm_t){ &t->c, m->prog, NULL, 0, 0, ns, t->best + ns, 0 };
+	t->run.pc = (uint32_t *)(t->v.work + ns); t->step.pc = t->run.pc + np; t->v.mark = t->step.pc + np;
+	memset(t->v.mark, 0, np * sizeof(uint32_t));
+	t->prev = __JACL_DFA_EDGE;
+	t->fixed = m->anchored && !t->c.nl;
+	t->pre = m->pre.n && !(t->c.ic && !m->pre.ic && m->pre.wide);
+	t->req = m->req.n && !(t->c.ic && !m->req.ic && m->req.wide);
+	for (int k = 0; k < m->pre.n; k++) if ((size_t)m->pre.len[k] > t->most + 1) t->most = (size_t)m->pre.len[k] - 1;
+	for (int k = 0; k < m->req.n; k++) if ((size_t)m->req.len[k] > t->rmost + 1) t->rmost = (size_t)m->req.len[k] - 1;
+	ms->m = m; ms->ef = fl; ms->vm = t;
+	return M_SUCCESS;
+}
+match_err_t matchstreamfeed(matchstream_t *restrict ms, const char *buf, size_t len, size_t *used, match_find_t *pm, size_t nm) {
+	size_t u;
+	return __jacl_stream_run(ms, buf ? buf : "", buf ? len : 0, 0, used ? used : &u, pm, nm);
+}
+match_err_t matchstreamend(matchstream_t *restrict ms, match_find_t *pm, size_t nm) {
+	size_t u;
+	return __jacl_stream_run(ms, "", 0, 1, &u, pm, nm);
+}
+void matchstreamfree(matchstream_t *restrict ms) {
+	if (!ms) return;
+	if (ms->vm) free(ms->vm->mem);
+	free(ms->vm); free(ms->hold);
+	memset(ms, 0, sizeof(*ms));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <errno.h>
+#include <stdio.h>
+#include <malloc.h>
 
 #if JACL_OS_WINDOWS
   #include <windows.h>
@@ -54,13 +56,61 @@ extern "C" {
 #endif
 
 #ifndef JACL_RECYCLING
-#define JACL_RECYCLING 12
+#define JACL_RECYCLING 32
+#endif
+
+#ifndef JACL_CACHE_MAX
+#define JACL_CACHE_MAX 1024u
+#endif
+
+#ifndef JACL_OWNERS
+#define JACL_OWNERS 256
+#endif
+
+#ifndef JACL_HDR_CACHE
+#define JACL_HDR_CACHE 4u
 #endif
 
 #ifndef JACL_COALESCING
 #define JACL_COALESCING 1024u
 #endif
 
+#ifndef JACL_PAGEMAP_SHIFT
+#define JACL_PAGEMAP_SHIFT 16u
+#endif
+
+#ifndef JACL_HDR_HUGE
+#define JACL_HDR_HUGE 8u
+#endif
+
+#ifndef JACL_HDR_ZERO
+#define JACL_HDR_ZERO 16u
+#endif
+
+#ifndef JACL_HUGE_MIN
+#define JACL_HUGE_MIN JACL_HEAP_SEG
+#endif
+
+#ifndef JACL_PURGE_DECAY
+#define JACL_PURGE_DECAY 1000u
+#endif
+
+#ifndef JACL_UNMAP_DECAY
+#define JACL_UNMAP_DECAY 10000u
+#endif
+
+#ifndef JACL_DECAY_TICKS
+#define JACL_DECAY_TICKS 256u
+#endif
+
+#ifndef JACL_MALLOC_STATS
+#define JACL_MALLOC_STATS 0
+#endif
+
+#if !defined(JACL_PURGE_ADVICE) && defined(MADV_DONTNEED)
+#define JACL_PURGE_ADVICE MADV_DONTNEED
+#endif
+
 #if JACL_CONCURENCY > 32
 #undef JACL_CONCURENCY
 #define JACL_CONCURENCY 32
@@ -72,6 +122,7 @@ extern "C" {
 	#define memory_order_relaxed 0
 	#define memory_order_acquire 0
 	#define memory_order_release 0
+	#define memory_order_acq_rel 0
 	#define memory_order_seq_cst 0
 
 	#define atomic_load(ptr) (*(ptr))
@@ -80,13 +131,17 @@ extern "C" {
 	#define atomic_store_explicit(ptr, val, order) (*(ptr) = (val))
 	#define atomic_fetch_add(ptr, val) ((*(ptr))++)
 	#define atomic_fetch_add_explicit(ptr, val, order) ((*(ptr)) += (val), (*(ptr)) - (val))
+	#define atomic_fetch_sub_explicit(ptr, val, order) ((*(ptr)) -= (val), (*(ptr)) + (val))
 	#define atomic_fetch_and(ptr, val) ((*(ptr)) &= (val))
 	#define atomic_fetch_and_explicit(ptr, val, order) ((*(ptr)) &= (val))
 	#define atomic_fetch_or(ptr, val) ((*(ptr)) |= (val))
 	#define atomic_fetch_or_explicit(ptr, val, order) ((*(ptr)) |= (val))
+	#define atomic_exchange_explicit(ptr, val, order) __jacl_memswap((ptr), (val))
 	#define atomic_compare_exchange_strong(ptr, expected, desired) \
 		((*(ptr) == *(expected)) ? (*(ptr) = (desired), 1) : (*(expected) = *(ptr), 0))
 
+	static inline uintptr_t __jacl_memswap(uintptr_t* ptr, uintptr_t val) { uintptr_t old = *ptr; *ptr = val; return old; }
+
 	#warning "WARNING: Before C11 your memory is single-threaded mode only"
 #endif
 
@@ -97,8 +152,8 @@ typedef struct {
 
 typedef struct __jacl_memseg {
 	uint8_t *base;
-	size_t size, bins[JACL_CONCURENCY];
-	uint_least32_t bitmap;
+	size_t size, bins[JACL_CONCURENCY], used, zero;
+	uint_least32_t bitmap, idle, purged;
 	struct __jacl_memseg *next;
 } __jacl_memseg_t;
 
@@ -112,36 +167,152 @@ static _Alignas(16) uint8_t __jacl_static_heap[JACL_HEAP_INIT];
 // Segment tracking
 static __jacl_memseg_t __jacl_memseg_init;
 static __jacl_memseg_t* __jacl_memseg_head = NULL;
-static size_t __jacl_heap_current = JACL_HEAP_INIT;
+static _Atomic size_t __jacl_heap_current = JACL_HEAP_INIT;
 static size_t __jacl_heap_max = JACL_HEAP_MAX;
 static _Atomic uint32_t __jacl_once = 0;
 static __jacl_memlock_t __jacl_locks[JACL_CONCURENCY];
 static __jacl_memlock_t __jacl_growth;
 
-// TLS state
-_Atomic uint32_t __jacl_tls_cursor = 0;
-thread_local uint32_t __jacl_tls_off = 0;
-thread_local uint32_t __jacl_tls_end = 0;
+/**
+ * NOTE: A segment whose last block comes back is stamped idle. Every
+ * JACL_DECAY_TICKS slow frees the heap is swept: idle segments older than
+ * JACL_PURGE_DECAY ms are folded back into one free block and their pages
+ * handed back with JACL_PURGE_ADVICE, and ones older than JACL_UNMAP_DECAY ms
+ * are unmapped. Segment lists are walked without the growth lock, so walkers
+ * register in one of two epoch slots and an unmap waits out the old slot.
+ */
+#define __JACL_IDLE_PENDING  0xFFFFFFFFu
+
+#if JACL_OS_WINDOWS || (JACL_HAS_POSIX && !JACL_ARCH_WASM)
+#define __JACL_CAN_UNMAP 1
+#else
+#define __JACL_CAN_UNMAP 0
+#endif
+
+static _Atomic uint32_t __jacl_walk_epoch = 0;
+static _Atomic uint32_t __jacl_walkers[2];
+static _Atomic uint32_t __jacl_decay_ticks = 0;
+static _Atomic uint32_t __jacl_decay_pending = 0;
 
-/* Recycling */
-thread_local _Alignas(64) struct {
-	void* slots[JACL_RECYCLING];
-	int count;
-} __jacl_recycling[4];
+// threads only get TLS of their own where the OS layer can build it, and the
+// slabs and caches below are only safe while each thread has its own copy
+#if !JACL_HAS_PTHREADS || defined(__jacl_os_tls_init)
+#define __JACL_CAN_CACHE 1
+#else
+#define __JACL_CAN_CACHE 0
+#endif
+
+/**
+ * NOTE: The first quarter of the static heap is cut into JACL_TLS_CHUNK slabs,
+ * each serving a single small size class to a single thread. The owner pops
+ * and pushes its own free list without atomics; other threads push onto the
+ * slab's remote list. `live` counts blocks handed out, with __JACL_SLAB_ORPHAN
+ * set once the owner has exited, so whoever drops it to zero (owner, exit or
+ * the last foreign free) is the one who returns the slab to the pool.
+ */
+#define __JACL_SLAB_CLASSES  (JACL_SMALL_MAX / 8 + 8)
+#define __JACL_SLAB_ORPHAN   0x80000000u
+
+typedef struct __jacl_memslab {
+	_Atomic uintptr_t remote;
+	_Atomic uint32_t live;
+	uint32_t size, top;
+	void *free, *owner;
+	struct __jacl_memslab *next;
+} __jacl_memslab_t;
+
+// atomic so a value peeked before taking __jacl_growth is never reused after it
+static _Atomic uint32_t __jacl_slab_cursor = 0;
+static _Atomic uintptr_t __jacl_slab_pool = 0;
+thread_local __jacl_memslab_t* __jacl_slabs[__JACL_SLAB_CLASSES];
+thread_local uint64_t __jacl_slab_dry;
+
+/**
+ * NOTE: Blocks up to JACL_CACHE_MAX (header included) are recycled through a
+ * per-thread cache with one free list per size class, refilled from and
+ * flushed to the shared bins in batches of JACL_RECYCLING / 2. Each thread
+ * takes an owner record and stamps it into the header of what it allocates.
+ * Freeing someone else's block pushes it on the owner's lock-free remote
+ * list, which the owner drains on its next miss. A record whose thread has
+ * gone is drained by whoever pushes to it next, so nothing gets stranded.
+ */
+#define __JACL_CLASSES       57
+#define __JACL_HDR_OWNER(f)  ((uint32_t)((f) >> 8))
+
+typedef struct {
+	void* head[__JACL_CLASSES];
+	uint16_t count[__JACL_CLASSES];
+	uint32_t owner;
+} __jacl_memcache_t;
+
+typedef struct {
+	_Alignas(64) _Atomic uintptr_t remote;
+	_Atomic uint32_t live;
+} __jacl_memowner_t;
+
+thread_local __jacl_memcache_t __jacl_memcache;
+static __jacl_memowner_t __jacl_owners[JACL_OWNERS];
+
+/**
+ * NOTE: With JACL_MALLOC_STATS set every thread bumps plain counters of its
+ * own on the paths below, so counting costs no atomics or shared lines. A
+ * thread links its record on its first malloc or free and folds it into
+ * __jacl_memstat_gone on exit; readers sum the list under __jacl_growth.
+ * Left at 0 the counters compile away. Huge mappings are counted regardless,
+ * mallinfo2() needs them either way.
+ */
+enum {
+	__JACL_MS_MALLOC, __JACL_MS_FREE, __JACL_MS_CACHE_HIT, __JACL_MS_CACHE_MISS,
+	__JACL_MS_CACHE_FLUSH, __JACL_MS_ARENA_HIT, __JACL_MS_BIN_HIT, __JACL_MS_BIN_MISS,
+	__JACL_MS_GROW, __JACL_MS_HUGE, __JACL_MS_REMOTE_FREE, __JACL_MS_COALESCE,
+	__JACL_MS_LOCK_WAIT, __JACL_MS_COUNT
+};
+
+static const char* const __jacl_memstat_names[__JACL_MS_COUNT] = {
+	"malloc", "free", "cache_hits", "cache_misses",
+	"cache_flushes", "arena_hits", "bin_hits", "bin_misses",
+	"segments_grown", "huge_maps", "remote_frees", "coalesces",
+	"lock_waits"
+};
+
+typedef struct __jacl_memstats {
+	size_t n[__JACL_MS_COUNT];
+	struct __jacl_memstats *next;
+	int linked;
+} __jacl_memstats_t;
+
+static _Atomic size_t __jacl_huge_count = 0;
+static _Atomic size_t __jacl_huge_bytes = 0;
+
+#if JACL_MALLOC_STATS
+thread_local __jacl_memstats_t __jacl_memstat;
+static __jacl_memstats_t* __jacl_memstat_list = NULL;
+static __jacl_memstats_t __jacl_memstat_gone;
+
+#define __JACL_MEMSTAT(c)  (__jacl_memstat.n[__JACL_MS_##c]++)
+#else
+#define __JACL_MEMSTAT(c)  ((void)0)
+#endif
 
 /* Internal Functions */
+static inline void __jacl_memyield(void) {
+	#if JACL_OS_WINDOWS
+		YieldProcessor();
+	#elif JACL_OS_DARWIN
+		pthread_yield_np();
+	#else
+		sched_yield();
+	#endif
+}
+
 void __jacl_memlock_acquire(__jacl_memlock_t* l) {
 	uint32_t ticket = atomic_fetch_add_explicit(&l->next, 1, memory_order_relaxed);
 
-	while (atomic_load_explicit(&l->owner, memory_order_acquire) != ticket) {
-		#if JACL_OS_WINDOWS
-			YieldProcessor();
-		#elif JACL_OS_DARWIN
-			pthread_yield_np();
-		#else
-			sched_yield();
-		#endif
-	}
+	if (atomic_load_explicit(&l->owner, memory_order_acquire) == ticket) return;
+
+	__JACL_MEMSTAT(LOCK_WAIT);
+
+	while (atomic_load_explicit(&l->owner, memory_order_acquire) != ticket) __jacl_memyield();
 }
 
 void __jacl_memlock_release(__jacl_memlock_t* l) {
@@ -154,9 +325,10 @@ void __jacl_memlock_blank(__jacl_memlock_t* l) {
 }
 
 void __jacl_memlock_block(void) {
-	for (int i = JACL_CONCURENCY; i--;) __jacl_memlock_acquire(&__jacl_locks[i]);
-
+	// growth first, a heap sweep holds it while it takes segment locks
 	__jacl_memlock_acquire(&__jacl_growth);
+
+	for (int i = JACL_CONCURENCY; i--;) __jacl_memlock_acquire(&__jacl_locks[i]);
 }
 
 void __jacl_memlock_clear(void) {
@@ -166,14 +338,69 @@ void __jacl_memlock_clear(void) {
 }
 
 void __jacl_memlock_reset(void) {
-	__jacl_tls_off = JACL_HEAP_INIT / 4;
-	__jacl_tls_end = JACL_HEAP_INIT / 4;  // Force refill or skip TLS
 	__jacl_memseg_head = &__jacl_memseg_init;
 	__jacl_once = 1;
 
+	// only the forking thread survives, everyone else's remote list is now up for grabs
+	for (uint32_t i = 0; i < JACL_OWNERS; i++) if (i + 1 != __jacl_memcache.owner) __jacl_owners[i].live = 0;
+
+	__jacl_walkers[0] = 0;
+	__jacl_walkers[1] = 0;
+
 	__jacl_memlock_clear();
 }
 
+#if JACL_MALLOC_STATS
+static inline void __jacl_memstat_link(void) {
+	__jacl_memlock_acquire(&__jacl_growth);
+
+	__jacl_memstat.next = __jacl_memstat_list;
+	__jacl_memstat.linked = 1;
+	__jacl_memstat_list = &__jacl_memstat;
+
+	__jacl_memlock_release(&__jacl_growth);
+}
+
+static inline void __jacl_memstat_unlink(void) {
+	if (!__jacl_memstat.linked) return;
+
+	__jacl_memlock_acquire(&__jacl_growth);
+
+	__jacl_memstats_t** link = &__jacl_memstat_list;
+
+	while (*link != &__jacl_memstat) link = &(*link)->next;
+
+	*link = __jacl_memstat.next;
+
+	for (int i = 0; i < __JACL_MS_COUNT; i++) __jacl_memstat_gone.n[i] += __jacl_memstat.n[i];
+
+	__jacl_memlock_release(&__jacl_growth);
+
+	memset(&__jacl_memstat, 0, sizeof(__jacl_memstat));
+}
+
+#define __JACL_MEMSTAT_OP(c) do { \
+	if (JACL_UNLIKELY(!__jacl_memstat.linked)) __jacl_memstat_link(); \
+	__JACL_MEMSTAT(c); \
+} while (0)
+#else
+#define __JACL_MEMSTAT_OP(c)  ((void)0)
+#endif
+
+// every thread's counters summed, zero when they are compiled out
+static inline void __jacl_memstat_sum(size_t* n) {
+	memset(n, 0, __JACL_MS_COUNT * sizeof(size_t));
+
+	#if JACL_MALLOC_STATS
+		__jacl_memlock_acquire(&__jacl_growth);
+
+		for (int i = 0; i < __JACL_MS_COUNT; i++) n[i] = __jacl_memstat_gone.n[i];
+		for (__jacl_memstats_t* t = __jacl_memstat_list; t; t = t->next) for (int i = 0; i < __JACL_MS_COUNT; i++) n[i] += t->n[i];
+
+		__jacl_memlock_release(&__jacl_growth);
+	#endif
+}
+
 #define __jacl_membin_safety(seg, off, where) do { \
 	if ((off) >= (seg)->size || (off) + sizeof(__jacl_memhdr_t) > (seg)->size) { \
 		return 0; \
@@ -271,6 +498,114 @@ static inline void __jacl_membin_remove(__jacl_memseg_t* seg, size_t off) {
 	}
 }
 
+/**
+ * NOTE: The page map answers "which segment owns this pointer" for free in
+ * constant time. Segments start on a JACL_PAGEMAP_SHIFT granule (64K is the
+ * Windows allocation granularity and the wasm page) so no two ever share an
+ * entry. Reads are two acquire loads and never lock; writers hold the growth
+ * lock. If a leaf cannot be mapped or two segments collide we mark the map
+ * lost and misses fall back to walking the segment list.
+ */
+#if JACL_64BIT
+	#define __JACL_PMAP_BITS 48
+	#define __JACL_PMAP_ROOT 14
+#else
+	#define __JACL_PMAP_BITS 32
+	#define __JACL_PMAP_ROOT 4
+#endif
+
+#define __JACL_PMAP_LEAF (__JACL_PMAP_BITS - JACL_PAGEMAP_SHIFT - __JACL_PMAP_ROOT)
+#define __JACL_PMAP_GRAN ((size_t)1 << JACL_PAGEMAP_SHIFT)
+
+static _Atomic uintptr_t __jacl_pagemap[(size_t)1 << __JACL_PMAP_ROOT];
+static _Atomic uint32_t __jacl_pagemap_lost = 0;
+
+static inline void* __jacl_grow_map(size_t size) {
+	#if JACL_OS_WINDOWS
+		return VirtualAlloc(NULL, size, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+	#elif JACL_ARCH_WASM
+		size_t pages = (size + 65535) / 65536;
+		int old = __builtin_wasm_memory_grow(0, pages);
+
+		return (old < 0) ? NULL : (void*)(old * 65536);
+	#elif JACL_HAS_POSIX
+		void* p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+		return (p == MAP_FAILED) ? NULL : p;
+	#else
+		return NULL;
+	#endif
+}
+
+static inline int __jacl_grow_unmap(void* p, size_t size) {
+	#if JACL_OS_WINDOWS
+		(void)size;
+
+		return VirtualFree(p, 0, MEM_RELEASE) != 0;
+	#elif JACL_HAS_POSIX && !JACL_ARCH_WASM
+		return munmap(p, size) == 0;
+	#else
+		(void)p; (void)size;
+
+		return 0;
+	#endif
+}
+
+// returns whether the pages are sure to read back as zero
+static inline int __jacl_grow_purge(void* p, size_t size) {
+	#if JACL_OS_WINDOWS
+		VirtualAlloc(p, size, MEM_RESET, PAGE_READWRITE);
+
+		return 0;
+	#elif defined(JACL_PURGE_ADVICE) && !JACL_ARCH_WASM
+		// MADV_FREE is refused by older kernels, fall back to the eager kind
+		if (!madvise(p, size, JACL_PURGE_ADVICE)) return JACL_PURGE_ADVICE == MADV_DONTNEED;
+
+		return JACL_PURGE_ADVICE != MADV_DONTNEED && !madvise(p, size, MADV_DONTNEED);
+	#else
+		(void)p; (void)size;
+
+		return 0;
+	#endif
+}
+
+static inline _Atomic uintptr_t* __jacl_pagemap_leaf(uintptr_t g, int make) {
+	uintptr_t r = g >> __JACL_PMAP_LEAF;
+
+	if (r >> __JACL_PMAP_ROOT) return NULL;
+
+	uintptr_t leaf = atomic_load_explicit(&__jacl_pagemap[r], memory_order_acquire);
+
+	if (!leaf && make && (leaf = (uintptr_t)__jacl_grow_map(sizeof(uintptr_t) << __JACL_PMAP_LEAF))) {
+		atomic_store_explicit(&__jacl_pagemap[r], leaf, memory_order_release);
+	}
+
+	return (_Atomic uintptr_t*)leaf;
+}
+
+// caller holds __jacl_growth, a NULL seg clears the range
+static inline void __jacl_pagemap_set(const void* base, size_t size, __jacl_memseg_t* seg) {
+	uintptr_t g = (uintptr_t)base >> JACL_PAGEMAP_SHIFT;
+	uintptr_t e = ((uintptr_t)base + size - 1) >> JACL_PAGEMAP_SHIFT;
+
+	for (; g <= e; g++) {
+		_Atomic uintptr_t* leaf = __jacl_pagemap_leaf(g, seg != NULL);
+		_Atomic uintptr_t* slot = leaf ? &leaf[g & (((uintptr_t)1 << __JACL_PMAP_LEAF) - 1)] : NULL;
+
+		if (seg && (!slot || atomic_load_explicit(slot, memory_order_relaxed))) atomic_store_explicit(&__jacl_pagemap_lost, 1, memory_order_relaxed);
+		if (slot) atomic_store_explicit(slot, (uintptr_t)seg, memory_order_release);
+	}
+}
+
+static inline __jacl_memseg_t* __jacl_pagemap_get(const void* p) {
+	uintptr_t g = (uintptr_t)p >> JACL_PAGEMAP_SHIFT;
+	_Atomic uintptr_t* leaf = __jacl_pagemap_leaf(g, 0);
+
+	if (!leaf) return NULL;
+
+	return (__jacl_memseg_t*)atomic_load_explicit(&leaf[g & (((uintptr_t)1 << __JACL_PMAP_LEAF) - 1)], memory_order_acquire);
+}
+
 static inline void __jacl_membin_init(void) {
 	static int canary = 0;
 	canary++;
@@ -283,13 +618,6 @@ static inline void __jacl_membin_init(void) {
 
 	if (!atomic_compare_exchange_strong(&__jacl_once, &expect, 1)) return;
 
-	/* Init Recycling */
-	for (int i = 0; i < 4; i++) {
-		__jacl_recycling[i].count = 0;
-
-		for (int j = 0; j < JACL_RECYCLING; j++) __jacl_recycling[i].slots[j] = NULL;
-	}
-
 	__jacl_memseg_init.base = __jacl_static_heap;
 	__jacl_memseg_init.size = JACL_HEAP_INIT;
 	__jacl_memseg_init.next = NULL;
@@ -297,9 +625,11 @@ static inline void __jacl_membin_init(void) {
 	memset(__jacl_memseg_init.bins, 0, sizeof(__jacl_memseg_init.bins));
 
 	__jacl_memseg_init.bitmap = 0;
+	__jacl_memseg_init.zero = JACL_HEAP_INIT;
 	__jacl_memseg_head = &__jacl_memseg_init;
 
-	atomic_store_explicit(&__jacl_tls_cursor, 0, memory_order_relaxed);
+	atomic_store_explicit(&__jacl_slab_cursor, 0, memory_order_relaxed);
+	atomic_store_explicit(&__jacl_slab_pool, 0, memory_order_relaxed);
 
 	size_t base = JACL_ALIGN_UP(JACL_HEAP_INIT/4, JACL_ALIGNMENT);
 
@@ -311,37 +641,153 @@ static inline void __jacl_membin_init(void) {
 		h->flags = 0;
 
 		__jacl_membin_push(&__jacl_memseg_init, base);
+
+		__jacl_memseg_init.zero = base;
+	}
+
+	__jacl_memlock_acquire(&__jacl_growth);
+	__jacl_pagemap_set(__jacl_static_heap, JACL_HEAP_INIT, &__jacl_memseg_init);
+	__jacl_memlock_release(&__jacl_growth);
+}
+
+static inline uint32_t __jacl_walk_enter(void) {
+	for (;;) {
+		uint32_t e = atomic_load(&__jacl_walk_epoch) & 1;
+
+		atomic_fetch_add(&__jacl_walkers[e], 1);
+
+		if ((atomic_load(&__jacl_walk_epoch) & 1) == e) return e;
+
+		atomic_fetch_sub_explicit(&__jacl_walkers[e], 1, memory_order_release);
 	}
 }
 
+static inline void __jacl_walk_leave(uint32_t e) {
+	atomic_fetch_sub_explicit(&__jacl_walkers[e], 1, memory_order_release);
+}
+
+// caller holds __jacl_growth, everyone who could still see an unlinked segment is gone on return
+static inline void __jacl_walk_sync(void) {
+	uint32_t e = atomic_fetch_add(&__jacl_walk_epoch, 1) & 1;
+
+	while (atomic_load(&__jacl_walkers[e])) __jacl_memyield();
+}
+
 static inline __jacl_memseg_t* __jacl_memseg_find(void* ptr) {
 	if (!ptr) return NULL;
 
-	__jacl_memseg_t* seg = __jacl_memseg_head;
+	// a segment being unmapped leaves the page map before decay waits out the walkers, so look it up as one
+	uint32_t e = __jacl_walk_enter();
+	__jacl_memseg_t* seg = __jacl_pagemap_get(ptr);
 
-	while (seg) {
-		if (ptr >= (void*)seg->base && ptr < (void*)(seg->base + seg->size)) return seg;
+	if (!seg || ptr < (void*)seg->base || ptr >= (void*)(seg->base + seg->size)) {
+		seg = NULL;
 
-		seg = seg->next;
+		if (atomic_load_explicit(&__jacl_pagemap_lost, memory_order_relaxed)) {
+			for (seg = __jacl_memseg_head; seg; seg = seg->next) if (ptr >= (void*)seg->base && ptr < (void*)(seg->base + seg->size)) break;
+		}
 	}
 
-	return NULL;
+	__jacl_walk_leave(e);
+
+	return seg;
+}
+
+// shared bins are guarded per segment, striped over __jacl_locks
+static inline __jacl_memlock_t* __jacl_memseg_lock(__jacl_memseg_t* seg) {
+	return &__jacl_locks[((uintptr_t)seg >> JACL_PAGEMAP_SHIFT ^ (uintptr_t)seg >> 6) % JACL_CONCURENCY];
 }
 
-static inline int __jacl_tls_refill(void) {
-	uint32_t cur = atomic_fetch_add_explicit(&__jacl_tls_cursor, JACL_TLS_CHUNK, memory_order_relaxed);
-	uint32_t limit = JACL_HEAP_INIT / 4;
+static inline __jacl_memslab_t* __jacl_slab_claim(size_t need) {
+	// unlocked peek so an exhausted arena costs nothing
+	if (!atomic_load_explicit(&__jacl_slab_pool, memory_order_relaxed)
+		&& atomic_load_explicit(&__jacl_slab_cursor, memory_order_relaxed) + JACL_TLS_CHUNK > JACL_HEAP_INIT / 4
+	) return NULL;
+
+	__jacl_memslab_t* s = NULL;
+	uint32_t cursor;
 
-	if (cur >= limit) return 0;
+	__jacl_memlock_acquire(&__jacl_growth);
 
-	uint32_t available = (cur + JACL_TLS_CHUNK > limit) ? (limit - cur) : JACL_TLS_CHUNK;
+	if ((s = (__jacl_memslab_t*)atomic_load_explicit(&__jacl_slab_pool, memory_order_relaxed))) {
+		atomic_store_explicit(&__jacl_slab_pool, (uintptr_t)s->next, memory_order_relaxed);
+	} else if ((cursor = atomic_load_explicit(&__jacl_slab_cursor, memory_order_relaxed)) + JACL_TLS_CHUNK <= JACL_HEAP_INIT / 4) {
+		s = (__jacl_memslab_t*)(__jacl_static_heap + cursor);
+		atomic_store_explicit(&__jacl_slab_cursor, cursor + JACL_TLS_CHUNK, memory_order_relaxed);
+	}
 
-	if (available < 64) return 0;
+	__jacl_memlock_release(&__jacl_growth);
 
-	__jacl_tls_off = JACL_ALIGN_UP(cur, JACL_ALIGNMENT);
-	__jacl_tls_end = cur + available;
+	if (!s) return NULL;
 
-	return 1;
+	atomic_store_explicit(&s->remote, 0, memory_order_relaxed);
+	atomic_store_explicit(&s->live, 0, memory_order_relaxed);
+
+	s->size = (uint32_t)need;
+	s->top = JACL_ALIGN_UP(sizeof(__jacl_memslab_t), JACL_ALIGNMENT);
+	s->free = NULL;
+	s->owner = (void*)__jacl_slabs;
+
+	return s;
+}
+
+static inline void __jacl_slab_release(__jacl_memslab_t* s) {
+	__jacl_memlock_acquire(&__jacl_growth);
+
+	s->next = (__jacl_memslab_t*)atomic_load_explicit(&__jacl_slab_pool, memory_order_relaxed);
+	atomic_store_explicit(&__jacl_slab_pool, (uintptr_t)s, memory_order_relaxed);
+
+	__jacl_memlock_release(&__jacl_growth);
+}
+
+static inline void* __jacl_slab_take(__jacl_memslab_t* s) {
+	void* b = s->free;
+
+	if (!b && atomic_load_explicit(&s->remote, memory_order_relaxed)) b = (void*)atomic_exchange_explicit(&s->remote, 0, memory_order_acquire);
+
+	if (b) s->free = *(void**)b;
+	else if (s->top + s->size <= JACL_TLS_CHUNK) {
+		b = (uint8_t*)s + s->top;
+		s->top += s->size;
+	} else return NULL;
+
+	atomic_fetch_add_explicit(&s->live, 1, memory_order_relaxed);
+
+	return b;
+}
+
+// the header of a live arena block, or NULL when p is not one
+static inline __jacl_memhdr_t* __jacl_slab_block(void* p, __jacl_memslab_t** slab) {
+	size_t off = (size_t)((uint8_t*)p - __jacl_static_heap);
+
+	if ((uint8_t*)p < __jacl_static_heap || off >= JACL_HEAP_INIT / 4) return NULL;
+
+	__jacl_memslab_t* s = (__jacl_memslab_t*)(__jacl_static_heap + off / JACL_TLS_CHUNK * JACL_TLS_CHUNK);
+	size_t at = (size_t)((uint8_t*)p - (uint8_t*)s), first = JACL_ALIGN_UP(sizeof(__jacl_memslab_t), JACL_ALIGNMENT);
+	__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
+
+	if (!s->size || at < first + sizeof(__jacl_memhdr_t) || at >= s->top) return NULL;
+	if ((at - first - sizeof(__jacl_memhdr_t)) % s->size) return NULL;
+	if (h->flags != (JACL_HDR_ALLOC | JACL_HDR_ARENA)) return NULL;
+
+	*slab = s;
+
+	return h;
+}
+
+static inline void __jacl_slab_exit(void) {
+	for (uint32_t c = 0; c < __JACL_SLAB_CLASSES; c++) {
+		for (__jacl_memslab_t *s = __jacl_slabs[c], *next; s; s = next) {
+			next = s->next;
+			s->owner = NULL;
+
+			if (!(atomic_fetch_or_explicit(&s->live, __JACL_SLAB_ORPHAN, memory_order_acq_rel) & ~__JACL_SLAB_ORPHAN)) __jacl_slab_release(s);
+		}
+
+		__jacl_slabs[c] = NULL;
+	}
+
+	__jacl_slab_dry = 0;
 }
 
 static inline size_t __jacl_round_size(size_t sz) {
@@ -364,6 +810,9 @@ static inline void __jacl_segment_init(__jacl_memseg_t* seg) {
 
 static inline void __jacl_segment_link(__jacl_memseg_t* seg) {
 	__jacl_memlock_acquire(&__jacl_growth);
+	__jacl_pagemap_set(seg, seg->size + sizeof(__jacl_memseg_t), seg);
+
+	atomic_fetch_add_explicit(&__jacl_heap_current, seg->size + sizeof(__jacl_memseg_t), memory_order_relaxed);
 
 	__jacl_memseg_t* tail = __jacl_memseg_head;
 
@@ -381,27 +830,34 @@ static inline __jacl_memseg_t* __jacl_segment(__jacl_memseg_t* seg, size_t seg_s
 	seg->size = seg_size - sizeof(__jacl_memseg_t);
 	seg->next = NULL;
 	seg->bitmap = 0;
+	seg->used = 0;
+	seg->idle = 0;
+	seg->purged = 0;
 
 	memset(seg->bins, 0, sizeof(seg->bins));
 	__jacl_segment_init(seg);
-	__jacl_segment_link(seg);
 
-	__jacl_heap_current += seg_size;
+	// straight from the OS, nothing but the first header has been written
+	seg->zero = sizeof(__jacl_memhdr_t);
 
 	return seg;
 }
 
 static inline int __jacl_grow_check(void) {
-	return (__jacl_heap_max != JACL_HEAP_INIT && __jacl_heap_current < __jacl_heap_max);
+	return (__jacl_heap_max != JACL_HEAP_INIT && atomic_load_explicit(&__jacl_heap_current, memory_order_relaxed) < __jacl_heap_max);
 }
 
 static inline size_t __jacl_grow_size(size_t need) {
-	size_t seg_size = (need > JACL_HEAP_SEG)
-		? JACL_ALIGN_UP(need, 4096)
+	// the segment and first block headers ride along in the same mapping
+	size_t want = need + sizeof(__jacl_memseg_t) + sizeof(__jacl_memhdr_t);
+	size_t seg_size = (want > JACL_HEAP_SEG)
+		? JACL_ALIGN_UP(want, (size_t)4096)
 		: JACL_HEAP_SEG;
 
-	if (__jacl_heap_current + seg_size > __jacl_heap_max) {
-		seg_size = __jacl_heap_max - __jacl_heap_current;
+	size_t current = atomic_load_explicit(&__jacl_heap_current, memory_order_relaxed);
+
+	if (current + seg_size > __jacl_heap_max) {
+		seg_size = __jacl_heap_max - current;
 
 		if (seg_size < need) return 0;
 	}
@@ -410,19 +866,20 @@ static inline size_t __jacl_grow_size(size_t need) {
 }
 
 static inline void* __jacl_grow_acquire(size_t seg_size) {
-	#if JACL_OS_WINDOWS
-		return VirtualAlloc(NULL, seg_size, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
-	#elif JACL_ARCH_WASM
-		size_t pages = (seg_size + 65535) / 65536;
-		int old = __builtin_wasm_memory_grow(0, pages);
+	#if JACL_HAS_POSIX && !JACL_OS_WINDOWS && !JACL_ARCH_WASM
+		// over-map by one granule and trim so the segment starts on the page map grid
+		uint8_t* p = (uint8_t*)__jacl_grow_map(seg_size + __JACL_PMAP_GRAN);
 
-		return (old < 0) ? NULL : (void*)(old * 65536);
-	#elif JACL_HAS_POSIX
-		void* p = mmap(NULL, seg_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if (!p) return NULL;
 
-		return (p == MAP_FAILED) ? NULL : p;
+		size_t head = (size_t)(-(uintptr_t)p & (__JACL_PMAP_GRAN - 1));
+
+		if (head) munmap(p, head);
+		if (__JACL_PMAP_GRAN - head) munmap(p + head + seg_size, __JACL_PMAP_GRAN - head);
+
+		return p + head;
 	#else
-		return NULL;
+		return __jacl_grow_map(seg_size);
 	#endif
 }
 
@@ -445,94 +902,357 @@ static inline size_t __jacl_alloc_need(size_t n) {
 	return __jacl_round_size(n + sizeof(__jacl_memhdr_t));
 }
 
-static inline void* __jacl_alloc_recycle(size_t n) {
-	if (n < 16 || n > 48) return NULL;
+static inline int __jacl_memcache_class(size_t size) {
+	if (size <= 128) return (int)(size >> 3);
+	if (size <= 512) return (int)(8 + (size >> 4));
+
+	return (int)(24 + (size >> 5));
+}
+
+static inline __jacl_memowner_t* __jacl_memcache_owner(void) {
+	if (!__JACL_CAN_CACHE) return NULL;
+
+	if (!__jacl_memcache.owner) {
+		for (uint32_t i = 0; i < JACL_OWNERS; i++) {
+			uint32_t expect = 0;
+
+			if (!atomic_load_explicit(&__jacl_owners[i].live, memory_order_relaxed) && atomic_compare_exchange_strong(&__jacl_owners[i].live, &expect, 1)) {
+				__jacl_memcache.owner = i + 1;
+
+				break;
+			}
+		}
+	}
+
+	return __jacl_memcache.owner ? &__jacl_owners[__jacl_memcache.owner - 1] : NULL;
+}
+
+static inline void __jacl_memcache_push(void* p) {
+	__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
+	int c = __jacl_memcache_class(h->size);
+
+	h->flags = JACL_HDR_ALLOC | JACL_HDR_CACHE | ((size_t)__jacl_memcache.owner << 8);
+	*(void**)p = __jacl_memcache.head[c];
+	__jacl_memcache.head[c] = p;
+	__jacl_memcache.count[c]++;
+}
+
+static inline void* __jacl_memcache_pop(int c) {
+	void* p = __jacl_memcache.head[c];
+
+	if (!p) return NULL;
+
+	__jacl_memcache.head[c] = *(void**)p;
+	__jacl_memcache.count[c]--;
+	((__jacl_memhdr_t*)p - 1)->flags = JACL_HDR_ALLOC | ((size_t)__jacl_memcache.owner << 8);
+
+	return p;
+}
+
+static inline void* __jacl_alloc_recycle(size_t need) {
+	if (need > JACL_CACHE_MAX) return NULL;
 
-	// Round up to the nearest 8-byte alignment before calculating bin
-	size_t aligned = (n + 7) & ~7u;
-	int rbin = (aligned >> 3) - 2;
+	int c = __jacl_memcache_class(need);
+	void* p = __jacl_memcache_pop(c);
 
-	if (rbin >= 0 && rbin < 4 && __jacl_recycling[rbin].count > 0) {
-		void* p = __jacl_recycling[rbin].slots[--__jacl_recycling[rbin].count];
+	if (p) return (__JACL_MEMSTAT(CACHE_HIT), p);
+	if (!__jacl_memcache.owner) return NULL;
 
-		((__jacl_memhdr_t*)p - 1)->flags = JACL_HDR_ALLOC;
+	// a miss is the moment to take back what other threads have freed for us
+	uintptr_t r = atomic_exchange_explicit(&__jacl_owners[__jacl_memcache.owner - 1].remote, 0, memory_order_acquire);
 
-		return p;
+	while (r) {
+		void* q = (void*)r;
+
+		r = *(uintptr_t*)q;
+		__jacl_memcache_push(q);
 	}
 
-	return NULL;
+	if ((p = __jacl_memcache_pop(c))) __JACL_MEMSTAT(CACHE_HIT);
+	else __JACL_MEMSTAT(CACHE_MISS);
+
+	return p;
 }
 
 static inline void* __jacl_alloc_arena(size_t n, size_t need) {
-	if (JACL_UNLIKELY(n > JACL_SMALL_MAX)) return NULL;
+	if (JACL_UNLIKELY(!__JACL_CAN_CACHE || n > JACL_SMALL_MAX)) return NULL;
+
+	int c = (int)(need >> 3);
+	__jacl_memslab_t **list = &__jacl_slabs[c], **link = list, *s = *list;
+	__jacl_memhdr_t* h = NULL;
+
+	// a class that came up empty stays skipped until one of its blocks is freed here
+	if (c < 64 && (__jacl_slab_dry >> c & 1)) return NULL;
+
+	for (; s; link = &s->next, s = s->next) if ((h = __jacl_slab_take(s))) break;
 
-	int can_alloc = 0;
+	if (s && link != list) {
+		*link = s->next;
+		s->next = *list;
+		*list = s;
+	} else if (!s) {
+		if (!(s = __jacl_slab_claim(need))) {
+			if (c < 64) __jacl_slab_dry |= (uint64_t)1 << c;
 
-	if (__jacl_tls_off + need <= __jacl_tls_end || __jacl_tls_refill()) can_alloc = 1;
-	if (__jacl_tls_off + need > (JACL_HEAP_INIT / 4)) can_alloc = 0;
-	if (!can_alloc) return NULL;
+			return NULL;
+		}
+
+		s->next = *list;
+		*list = s;
+		h = __jacl_slab_take(s);
+	}
 
-	__jacl_memhdr_t* h = (__jacl_memhdr_t*)(__jacl_static_heap + __jacl_tls_off);
 	h->size = need;
 	h->prev_size = 0;
 	h->flags = JACL_HDR_ALLOC | JACL_HDR_ARENA;
-	__jacl_tls_off += need;
+
+	__JACL_MEMSTAT(ARENA_HIT);
 
 	return (void*)(h + 1);
 }
 
-static inline void* __jacl_alloc_bins(__jacl_memseg_t* seg, size_t need) {
-	while (seg) {
-		size_t off = __jacl_membin_pop(seg, need);
+/**
+ * NOTE: A segment's `zero` is the offset past which it has never held more
+ * than the header and bin link of the free block starting there. A block
+ * carved at or past it gets its link cleared and JACL_HDR_ZERO set, which
+ * tells calloc() to skip the memset, and `zero` moves past its end. Fresh
+ * segments start out that way, a purge sets it again when the pages are
+ * sure to come back zeroed, and huge mappings are always flagged.
+ */
 
-		if (!off) { seg = seg->next; continue; }
+// caller holds the segment lock
+static inline void* __jacl_alloc_carve(__jacl_memseg_t* seg, size_t need) {
+	size_t off = __jacl_membin_pop(seg, need);
 
-		__jacl_memhdr_t* h = (__jacl_memhdr_t*)(seg->base + off);
+	if (!off) return NULL;
 
-		if (h->size < need) {
-			__jacl_membin_push(seg, off);
+	__jacl_memhdr_t* h = (__jacl_memhdr_t*)(seg->base + off);
 
-			seg = seg->next;
+	if (h->size < need) {
+		__jacl_membin_push(seg, off);
 
-			continue;
-		}
+		return NULL;
+	}
 
-		if (h->size >= need + sizeof(__jacl_memhdr_t) + 8) {
-			size_t rem_off = off + need;
-			__jacl_memhdr_t* rem = (__jacl_memhdr_t*)(seg->base + rem_off);
+	int zero = off >= seg->zero;
 
-			rem->size = h->size - need;
-			rem->prev_size = need;
-			rem->flags = 0;
-			h->size = need;
+	if (h->size >= need + sizeof(__jacl_memhdr_t) + 8) {
+		size_t rem_off = off + need;
+		__jacl_memhdr_t* rem = (__jacl_memhdr_t*)(seg->base + rem_off);
 
-			__jacl_membin_push(seg, rem_off);
-		}
+		rem->size = h->size - need;
+		rem->prev_size = need;
+		rem->flags = 0;
+		h->size = need;
 
-		size_t next_off = off + h->size;
+		// whoever followed the whole block now follows the remainder
+		if (rem_off + rem->size < seg->size) ((__jacl_memhdr_t*)(seg->base + rem_off + rem->size))->prev_size = rem->size;
+
+		__jacl_membin_push(seg, rem_off);
+	}
 
-		if (next_off < seg->size) ((__jacl_memhdr_t*)(seg->base + next_off))->prev_size = h->size;
+	size_t next_off = off + h->size;
 
-		h->flags = JACL_HDR_ALLOC;
+	if (next_off < seg->size) ((__jacl_memhdr_t*)(seg->base + next_off))->prev_size = h->size;
 
-		return (void*)(h + 1);
+	h->flags = JACL_HDR_ALLOC | ((size_t)__jacl_memcache.owner << 8);
+	seg->used += h->size;
+	seg->idle = 0;
+	seg->purged = 0;
+
+	if (off + h->size > seg->zero) seg->zero = off + h->size;
+
+	// the bin link is all that was ever written past the header
+	if (zero) {
+		h->flags |= JACL_HDR_ZERO;
+		*(size_t*)(h + 1) = 0;
 	}
 
-	return NULL;
+	return (void*)(h + 1);
 }
 
-static inline int __jacl_free_arena(void* p) {
-	__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
+// carve one block for the caller and up to batch - 1 more into the thread cache
+static inline void* __jacl_alloc_bins(__jacl_memseg_t* seg, size_t need, int batch) {
+	uint32_t e = __jacl_walk_enter();
+	void* p = NULL;
 
-	if (h->flags & JACL_HDR_ARENA) {
-		if (h->flags & JACL_HDR_ALLOC) h->flags = 0;
+	for (; seg && !p; seg = seg->next) {
+		if (!(seg->bitmap & ((~0u) << __jacl_membin_get(need)))) continue;
 
-		return 1;
+		__jacl_memlock_t* lock = __jacl_memseg_lock(seg);
+
+		__jacl_memlock_acquire(lock);
+
+		p = __jacl_alloc_carve(seg, need);
+
+		for (void* q; p && --batch > 0 && (q = __jacl_alloc_carve(seg, need));) __jacl_memcache_push(q);
+
+		__jacl_memlock_release(lock);
 	}
 
+	__jacl_walk_leave(e);
+
+	if (p) __JACL_MEMSTAT(BIN_HIT);
+	else __JACL_MEMSTAT(BIN_MISS);
+
+	return p;
+}
+
+// carve from a new segment before anyone else can see it, then publish it
+static inline void* __jacl_alloc_fresh(size_t need, int batch) {
+	__jacl_memseg_t* seg = __jacl_grow_heap(need);
+
+	if (!seg) return NULL;
+
+	void* p = __jacl_alloc_carve(seg, need);
+
+	for (void* q; p && --batch > 0 && (q = __jacl_alloc_carve(seg, need));) __jacl_memcache_push(q);
+
+	__jacl_segment_link(seg);
+	__JACL_MEMSTAT(GROW);
+
+	return p;
+}
+
+/**
+ * NOTE: Requests over JACL_HUGE_MIN skip the segments. Each gets a mapping of
+ * its own with the header at its first byte, so the block starts 24 bytes
+ * into a page and the header says JACL_HDR_HUGE. The page map never hears of
+ * it and free hands the mapping straight back. On Linux a growing realloc
+ * moves the pages with mremap instead of copying them.
+ */
+#define __JACL_HUGE_PAGE  4096u
+
+static inline size_t __jacl_huge_span(size_t need) {
+	return (need + __JACL_HUGE_PAGE - 1) & ~(size_t)(__JACL_HUGE_PAGE - 1);
+}
+
+// count the mapping against JACL_HEAP_MAX up front so racing threads can't overshoot
+static inline int __jacl_huge_charge(size_t span) {
+	if (atomic_fetch_add_explicit(&__jacl_heap_current, span, memory_order_relaxed) + span <= __jacl_heap_max) return 1;
+
+	atomic_fetch_sub_explicit(&__jacl_heap_current, span, memory_order_relaxed);
+
 	return 0;
 }
 
+static inline void* __jacl_alloc_huge(size_t need) {
+	if (!__JACL_CAN_UNMAP || need <= JACL_HUGE_MIN || !__jacl_grow_check()) return NULL;
+
+	size_t span = __jacl_huge_span(need);
+
+	if (span < need || !__jacl_huge_charge(span)) return NULL;
+
+	__jacl_memhdr_t* h = (__jacl_memhdr_t*)__jacl_grow_map(span);
+
+	if (!h) {
+		atomic_fetch_sub_explicit(&__jacl_heap_current, span, memory_order_relaxed);
+
+		return NULL;
+	}
+
+	h->size = span;
+	h->prev_size = 0;
+	h->flags = JACL_HDR_ALLOC | JACL_HDR_HUGE | JACL_HDR_ZERO;
+
+	atomic_fetch_add_explicit(&__jacl_huge_count, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&__jacl_huge_bytes, span, memory_order_relaxed);
+	__JACL_MEMSTAT(HUGE);
+
+	return (void*)(h + 1);
+}
+
+// the header of a block with a mapping of its own, or NULL when p is not one
+static inline __jacl_memhdr_t* __jacl_huge_block(void* p) {
+	__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
+
+	if (((uintptr_t)h & (__JACL_HUGE_PAGE - 1)) || (h->flags & ~(size_t)JACL_HDR_ZERO) != (JACL_HDR_ALLOC | JACL_HDR_HUGE)) return NULL;
+
+	return h;
+}
+
+static inline int __jacl_free_huge(void* p) {
+	__jacl_memhdr_t* h = __jacl_huge_block(p);
+
+	if (!h) return 0;
+
+	size_t span = h->size;
+
+	h->flags = 0;
+
+	atomic_fetch_sub_explicit(&__jacl_huge_count, 1, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&__jacl_huge_bytes, span, memory_order_relaxed);
+
+	if (__jacl_grow_unmap(h, span)) atomic_fetch_sub_explicit(&__jacl_heap_current, span, memory_order_relaxed);
+
+	return 1;
+}
+
+#if JACL_OS_LINUX
+// grow a huge block in place or let the kernel move its pages, NULL leaves it untouched
+static inline void* __jacl_realloc_huge(__jacl_memhdr_t* h, size_t need) {
+	size_t span = __jacl_huge_span(need), old = h->size;
+
+	if (span <= old || !__jacl_huge_charge(span - old)) return NULL;
+
+	void* m = mremap(h, old, span, MREMAP_MAYMOVE);
+
+	if (m == MAP_FAILED) {
+		atomic_fetch_sub_explicit(&__jacl_heap_current, span - old, memory_order_relaxed);
+
+		return NULL;
+	}
+
+	atomic_fetch_add_explicit(&__jacl_huge_bytes, span - old, memory_order_relaxed);
+
+	h = (__jacl_memhdr_t*)m;
+	h->size = span;
+
+	return (void*)(h + 1);
+}
+#endif
+
+static inline int __jacl_free_arena(void* p) {
+	if ((uint8_t*)p < __jacl_static_heap || (uint8_t*)p >= __jacl_static_heap + JACL_HEAP_INIT / 4) return 0;
+
+	__jacl_memslab_t* s;
+	__jacl_memhdr_t* h = __jacl_slab_block(p, &s);
+
+	// not a block start, so an aligned_alloc() pointer or a stale one
+	if (!h && !(h = __jacl_slab_block(*(void**)((uint8_t*)p - sizeof(void*)), &s))) return 1;
+
+	h->flags = JACL_HDR_ARENA;
+
+	if (s->owner == (void*)__jacl_slabs) {
+		*(void**)h = s->free;
+		s->free = h;
+
+		if (s->size >> 3 < 64) __jacl_slab_dry &= ~((uint64_t)1 << (s->size >> 3));
+	} else if (!(atomic_load_explicit(&s->live, memory_order_relaxed) & __JACL_SLAB_ORPHAN)) {
+		uintptr_t head = atomic_load_explicit(&s->remote, memory_order_relaxed);
+
+		__JACL_MEMSTAT(REMOTE_FREE);
+
+		do *(uintptr_t*)h = head;
+		while (!atomic_compare_exchange_strong(&s->remote, &head, (uintptr_t)h));
+	}
+
+	uint32_t was = atomic_fetch_sub_explicit(&s->live, 1, memory_order_acq_rel);
+
+	if (was == (__JACL_SLAB_ORPHAN | 1)) __jacl_slab_release(s);
+	else if (was == 1 && s->owner == (void*)__jacl_slabs && __jacl_slabs[s->size >> 3] != s) {
+		// an idle slab that is not the one we allocate from goes back for anyone to use
+		__jacl_memslab_t** link = &__jacl_slabs[s->size >> 3];
+
+		while (*link != s) link = &(*link)->next;
+
+		*link = s->next;
+		__jacl_slab_release(s);
+	}
+
+	return 1;
+}
+
 static inline void* __jacl_free_aligned(void* p, __jacl_memhdr_t** h, __jacl_memseg_t** seg) {
 	void** stored = (void**)((uint8_t*)p - sizeof(void*));
 	void* orig = *stored;
@@ -542,24 +1262,69 @@ static inline void* __jacl_free_aligned(void* p, __jacl_memhdr_t** h, __jacl_mem
 	*h = (__jacl_memhdr_t*)orig - 1;
 	*seg = __jacl_memseg_find((void*)*h);
 
-	if (!*seg) return NULL;
+	// over-allocated from a mapping of its own
+	if (!*seg) return (__jacl_free_huge(orig), NULL);
 
 	return (void*)(*h + 1);
 }
 
-static inline int __jacl_free_recycle(void* p, size_t size) {
-	if (size < 16 || size > 48) return 0;
+static inline void __jacl_free_shared(__jacl_memseg_t* seg, __jacl_memhdr_t* h);
+
+static inline void __jacl_free_remote(__jacl_memowner_t* o) {
+	uintptr_t r = atomic_exchange_explicit(&o->remote, 0, memory_order_acquire);
+
+	while (r) {
+		__jacl_memhdr_t* h = (__jacl_memhdr_t*)r - 1;
+
+		r = *(uintptr_t*)(h + 1);
+		__jacl_free_shared(__jacl_memseg_find(h), h);
+	}
+}
+
+static inline void __jacl_free_flush(int c, int keep) {
+	while (__jacl_memcache.count[c] > keep) {
+		void* p = __jacl_memcache.head[c];
+		__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
+
+		__jacl_memcache.head[c] = *(void**)p;
+		__jacl_memcache.count[c]--;
+		__jacl_free_shared(__jacl_memseg_find(h), h);
+	}
+}
+
+static inline int __jacl_free_recycle(void* p, __jacl_memhdr_t* h) {
+	if (h->size > JACL_CACHE_MAX) return 0;
+
+	uint32_t owner = __JACL_HDR_OWNER(h->flags);
+
+	if (owner && owner <= JACL_OWNERS && owner != __jacl_memcache.owner) {
+		__jacl_memowner_t* o = &__jacl_owners[owner - 1];
+		uintptr_t head = atomic_load_explicit(&o->remote, memory_order_relaxed);
+
+		h->flags |= JACL_HDR_CACHE;
+		__JACL_MEMSTAT(REMOTE_FREE);
 
-	int rbin = (size >> 3) - 2;
+		do *(uintptr_t*)p = head;
+		while (!atomic_compare_exchange_strong(&o->remote, &head, (uintptr_t)p));
 
-	if (rbin >= 0 && rbin < 4 && __jacl_recycling[rbin].count < JACL_RECYCLING) {
-		((__jacl_memhdr_t*)p - 1)->flags = 0;
-		__jacl_recycling[rbin].slots[__jacl_recycling[rbin].count++] = p;
+		// the owner may have exited while we pushed
+		if (!atomic_load_explicit(&o->live, memory_order_acquire)) __jacl_free_remote(o);
 
 		return 1;
 	}
 
-	return 0;
+	if (!__jacl_memcache_owner()) return 0;
+
+	int c = __jacl_memcache_class(h->size);
+
+	__jacl_memcache_push(p);
+
+	if (__jacl_memcache.count[c] > JACL_RECYCLING) {
+		__JACL_MEMSTAT(CACHE_FLUSH);
+		__jacl_free_flush(c, JACL_RECYCLING / 2);
+	}
+
+	return 1;
 }
 
 static inline void __jacl_free_coalesce(__jacl_memseg_t* seg, size_t off) {
@@ -573,6 +1338,7 @@ static inline void __jacl_free_coalesce(__jacl_memseg_t* seg, size_t off) {
 
 			if (!(next->flags & JACL_HDR_ALLOC)) {
 				__jacl_membin_remove(seg, next_off);
+				__JACL_MEMSTAT(COALESCE);
 
 				h->size += next->size;
 
@@ -592,6 +1358,7 @@ static inline void __jacl_free_coalesce(__jacl_memseg_t* seg, size_t off) {
 				&& !(prev->flags & JACL_HDR_ALLOC)
 			) {
 				__jacl_membin_remove(seg, prev_off);
+				__JACL_MEMSTAT(COALESCE);
 
 				prev->size += h->size;
 
@@ -607,38 +1374,256 @@ static inline void __jacl_free_coalesce(__jacl_memseg_t* seg, size_t off) {
 	__jacl_membin_push(seg, off);
 }
 
-/* Public API */
-void* malloc(size_t n) {
-	size_t need = __jacl_alloc_need(n);
+static inline uint32_t __jacl_decay_now(void) {
+	#if JACL_OS_WINDOWS
+		return (uint32_t)GetTickCount();
+	#elif JACL_HAS_POSIX
+		struct timespec ts;
 
-	if (JACL_UNLIKELY(!need)) return NULL;
+		if (clock_gettime(CLOCK_MONOTONIC, &ts)) return 0;
+
+		return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+	#else
+		return 0;
+	#endif
+}
+
+// caller holds the segment lock; leaves one free block and hands the rest of the pages back
+static inline void __jacl_segment_purge(__jacl_memseg_t* seg) {
+	memset(seg->bins, 0, sizeof(seg->bins));
+	seg->bitmap = 0;
+
+	__jacl_segment_init(seg);
+
+	uint8_t* from = (uint8_t*)JACL_ALIGN_UP((uintptr_t)(seg->base + 2 * sizeof(__jacl_memhdr_t) + sizeof(size_t)), (uintptr_t)4096);
+	uint8_t* to = (uint8_t*)((uintptr_t)(seg->base + seg->size) & ~(uintptr_t)4095);
+
+	int zero = to > from && __jacl_grow_purge(from, (size_t)(to - from));
+
+	// a tail past the last whole page keeps whatever it held
+	seg->zero = (zero && to == seg->base + seg->size) ? (size_t)(from - seg->base) : seg->size;
+	seg->purged = 1;
+}
+
+/**
+ * Sweep the idle segments. With force set everything idle goes now, keeping
+ * up to `keep` bytes mapped (purged) for reuse. Returns whether any memory was
+ * handed back to the OS.
+ */
+static inline int __jacl_heap_decay(int force, size_t keep) {
+	__jacl_memseg_t *dead[32], **link;
+	uint32_t now = __jacl_decay_now() | 1, pending;
+	int ndead, released = 0;
+	size_t kept;
+
+	__jacl_memlock_acquire(&__jacl_growth);
+
+	// a full batch may have stopped short of the end, so sweep again until one doesn't
+	do {
+		ndead = 0; kept = 0; pending = 0;
+
+		atomic_store_explicit(&__jacl_decay_pending, 0, memory_order_relaxed);
+
+		for (link = &__jacl_memseg_init.next; *link;) {
+			__jacl_memseg_t* seg = *link;
+			__jacl_memlock_t* lock = __jacl_memseg_lock(seg);
+			int unmap = 0;
+
+			__jacl_memlock_acquire(lock);
+
+			if (!seg->used && seg->idle) {
+				if (seg->idle == __JACL_IDLE_PENDING) seg->idle = now;
+
+				uint32_t age = now - seg->idle;
+
+				unmap = __JACL_CAN_UNMAP && ndead < 32 && (force ? (kept += seg->size) > keep : age >= JACL_UNMAP_DECAY);
+
+				if (unmap) {
+					// nothing left to carve, so anyone still holding the pointer walks on by
+					memset(seg->bins, 0, sizeof(seg->bins));
+					seg->bitmap = 0;
+					seg->idle = 0;
+					dead[ndead++] = seg;
+				} else {
+					if (!seg->purged && (force || age >= JACL_PURGE_DECAY)) {
+						__jacl_segment_purge(seg);
+
+						released = 1;
+					}
+
+					if (__JACL_CAN_UNMAP || !seg->purged) pending = 1;
+				}
+			}
+
+			__jacl_memlock_release(lock);
+
+			if (unmap) *link = seg->next;
+			else link = &seg->next;
+		}
+
+		if (ndead) {
+			// out of the page map first, so the sync below waits out every lookup that could still reach them
+			for (int i = 0; i < ndead; i++) __jacl_pagemap_set(dead[i], dead[i]->size + sizeof(__jacl_memseg_t), NULL);
+
+			__jacl_walk_sync();
+
+			for (int i = 0; i < ndead; i++) {
+				size_t span = dead[i]->size + sizeof(__jacl_memseg_t);
+
+				if (__jacl_grow_unmap(dead[i], span)) atomic_fetch_sub_explicit(&__jacl_heap_current, span, memory_order_relaxed);
+			}
+
+			released = 1;
+		}
+	} while (ndead == 32);
+
+	if (pending) atomic_store_explicit(&__jacl_decay_pending, 1, memory_order_relaxed);
+
+	__jacl_memlock_release(&__jacl_growth);
+
+	return released;
+}
+
+static inline void __jacl_free_shared(__jacl_memseg_t* seg, __jacl_memhdr_t* h) {
+	if (!seg) return;
+
+	__jacl_memlock_t* lock = __jacl_memseg_lock(seg);
+
+	__jacl_memlock_acquire(lock);
+
+	// neighbours coalesce on this flag, so it only drops under the lock
+	h->flags = 0;
+	seg->used -= h->size;
+
+	__jacl_free_coalesce(seg, (size_t)((uint8_t*)h - seg->base));
+
+	int idle = !seg->used && seg != &__jacl_memseg_init;
+
+	if (idle) seg->idle = __JACL_IDLE_PENDING;
+
+	__jacl_memlock_release(lock);
+
+	if (idle) atomic_store_explicit(&__jacl_decay_pending, 1, memory_order_relaxed);
+
+	if (atomic_load_explicit(&__jacl_decay_pending, memory_order_relaxed)
+		&& !(atomic_fetch_add_explicit(&__jacl_decay_ticks, 1, memory_order_relaxed) % JACL_DECAY_TICKS)
+	) __jacl_heap_decay(0, 0);
+}
+
+// called on the way out of a thread so its slabs, cache and owner record go back to the pool
+void __jacl_memcache_exit(void) {
+	__jacl_slab_exit();
+
+	uint32_t owner = __jacl_memcache.owner;
+
+	if (owner) {
+		for (int c = 0; c < __JACL_CLASSES; c++) __jacl_free_flush(c, 0);
+
+		__jacl_memcache.owner = 0;
+
+		atomic_store_explicit(&__jacl_owners[owner - 1].live, 0, memory_order_release);
+		__jacl_free_remote(&__jacl_owners[owner - 1]);
+	}
+
+	// last, so the flushes above still land in this thread's counters
+	#if JACL_MALLOC_STATS
+		__jacl_memstat_unlink();
+	#endif
+}
+
+/**
+ * NOTE: A census of the heap for mallinfo2() and friends. Each segment is
+ * walked block by block under its own lock, inside a walker epoch so nobody
+ * unmaps it underneath us, and the arena slabs are read without locking. The
+ * numbers are exact when the heap is quiet and close enough when it is not.
+ * The arena and segment bytes add up to in_use + free + cached.
+ */
+typedef struct {
+	size_t arena, in_use, free, free_blocks, largest_free, cached, cached_blocks;
+	size_t segments, idle, slabs, huge_blocks, huge_bytes;
+} __jacl_memsnap_t;
+
+static inline void __jacl_heap_census(__jacl_memsnap_t* m) {
+	memset(m, 0, sizeof(*m));
 
 	__jacl_membin_init();
 
-	void* p;
+	size_t top = atomic_load_explicit(&__jacl_slab_cursor, memory_order_acquire);
+	size_t first = JACL_ALIGN_UP(JACL_HEAP_INIT / 4, JACL_ALIGNMENT);
 
-	if ((p = __jacl_alloc_recycle(n))) return p;
-	if ((p = __jacl_alloc_arena(n, need))) return p;
+	// the whole arena counts, slabs nobody has claimed yet are free space
+	m->arena = first;
+	m->free = first;
 
-	assert(__jacl_tls_off <= JACL_HEAP_INIT / 4);
-	assert(__jacl_tls_end <= JACL_HEAP_INIT / 4);
-	assert(__jacl_tls_off <= __jacl_tls_end);
+	for (size_t off = 0; off + JACL_TLS_CHUNK <= top; off += JACL_TLS_CHUNK) {
+		__jacl_memslab_t* s = (__jacl_memslab_t*)(__jacl_static_heap + off);
+		size_t used = (size_t)(atomic_load_explicit(&s->live, memory_order_relaxed) & ~__JACL_SLAB_ORPHAN) * s->size;
 
-	int bin = __jacl_membin_get(need);
-	__jacl_memseg_t* seg = __jacl_memseg_head;
+		m->slabs++;
+		m->in_use += used;
+		m->free -= used;
+	}
 
-	__jacl_memlock_acquire(&__jacl_locks[bin]);
+	uint32_t e = __jacl_walk_enter();
 
-	p = __jacl_alloc_bins(__jacl_memseg_head, need);
+	for (__jacl_memseg_t* seg = __jacl_memseg_head; seg; seg = seg->next) {
+		__jacl_memlock_t* lock = __jacl_memseg_lock(seg);
+		size_t off = seg == &__jacl_memseg_init ? first : sizeof(__jacl_memhdr_t);
 
-	if (!p) {
-		seg = __jacl_grow_heap(need);
-		p = __jacl_alloc_bins(seg, need);
+		__jacl_memlock_acquire(lock);
+
+		m->arena += seg->size - off;
+
+		if (seg != &__jacl_memseg_init) {
+			m->segments++;
+
+			if (!seg->used && seg->idle) m->idle += seg->size;
+		}
+
+		for (__jacl_memhdr_t* h; off < seg->size; off += h->size) {
+			h = (__jacl_memhdr_t*)(seg->base + off);
+
+			if (!h->size) break;
+
+			if (!(h->flags & JACL_HDR_ALLOC)) {
+				m->free += h->size;
+				m->free_blocks++;
+
+				if (h->size > m->largest_free) m->largest_free = h->size;
+			} else if (h->flags & JACL_HDR_CACHE) {
+				m->cached += h->size;
+				m->cached_blocks++;
+			} else m->in_use += h->size;
+		}
+
+		__jacl_memlock_release(lock);
 	}
 
-	__jacl_memlock_release(&__jacl_locks[bin]);
+	__jacl_walk_leave(e);
+
+	m->huge_blocks = atomic_load_explicit(&__jacl_huge_count, memory_order_relaxed);
+	m->huge_bytes = atomic_load_explicit(&__jacl_huge_bytes, memory_order_relaxed);
+}
 
-	if (p) return p;
+/* Public API */
+void* malloc(size_t n) {
+	size_t need = __jacl_alloc_need(n);
+
+	if (JACL_UNLIKELY(!need)) return NULL;
+
+	__jacl_membin_init();
+	__JACL_MEMSTAT_OP(MALLOC);
+
+	void* p;
+
+	if ((p = __jacl_alloc_recycle(need))) return p;
+	if ((p = __jacl_alloc_arena(n, need))) return p;
+	if ((p = __jacl_alloc_huge(need))) return p;
+
+	int batch = (need <= JACL_CACHE_MAX && __jacl_memcache_owner()) ? JACL_RECYCLING / 2 : 1;
+
+	if ((p = __jacl_alloc_bins(__jacl_memseg_head, need, batch))) return p;
+	if ((p = __jacl_alloc_fresh(need, batch))) return p;
 
 	return (__errno_set(ENOMEM), NULL);
 }
@@ -646,12 +1631,16 @@ void* malloc(size_t n) {
 void free(void* p) {
 	if (JACL_UNLIKELY(!p)) return;
 
+	__JACL_MEMSTAT_OP(FREE);
+
 	if (__jacl_free_arena(p)) return;
 
 	__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
 	__jacl_memseg_t* seg = __jacl_memseg_find((void*)h);
 
 	if (!seg) {
+		if (__jacl_free_huge(p)) return;
+
 		void* resolved = __jacl_free_aligned(p, &h, &seg);
 
 		if (!resolved) return;
@@ -659,20 +1648,108 @@ void free(void* p) {
 		p = resolved;
 	}
 
-	if (JACL_UNLIKELY(!(h->flags & JACL_HDR_ALLOC))) return;
+	if (JACL_UNLIKELY((h->flags & (JACL_HDR_ALLOC | JACL_HDR_CACHE)) != JACL_HDR_ALLOC)) return;
+	if (__jacl_free_recycle(p, h)) return;
 
-	size_t size = h->size - sizeof(__jacl_memhdr_t);
+	__jacl_free_shared(seg, h);
+}
+
+int malloc_trim(size_t pad) {
+	__jacl_membin_init();
 
-	if (__jacl_free_recycle(p, size)) return;
+	for (int c = 0; c < __JACL_CLASSES; c++) __jacl_free_flush(c, 0);
 
-	h->flags = 0;
+	if (__jacl_memcache.owner) __jacl_free_remote(&__jacl_owners[__jacl_memcache.owner - 1]);
+
+	return __jacl_heap_decay(1, pad);
+}
+
+struct mallinfo2 mallinfo2(void) {
+	__jacl_memsnap_t m;
+	struct mallinfo2 mi;
+
+	__jacl_heap_census(&m);
+
+	mi.arena = m.arena;
+	mi.ordblks = m.free_blocks;
+	mi.smblks = m.cached_blocks;
+	mi.hblks = m.huge_blocks;
+	mi.hblkhd = m.huge_bytes;
+	mi.usmblks = 0;
+	mi.fsmblks = m.cached;
+	mi.uordblks = m.in_use;
+	mi.fordblks = m.free;
+	mi.keepcost = m.idle;
+
+	return mi;
+}
+
+size_t malloc_usable_size(void* p) {
+	if (!p) return 0;
+
+	__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
+
+	if (h->flags & JACL_HDR_ALLOC) return h->size - sizeof(__jacl_memhdr_t);
+
+	// an aligned_alloc() pointer, whatever is left of the block past it
+	uint8_t* raw = *(uint8_t**)((uint8_t*)p - sizeof(void*));
+
+	if (!raw || ((uintptr_t)raw & (JACL_ALIGNMENT - 1)) || (uint8_t*)p <= raw) return 0;
+
+	h = (__jacl_memhdr_t*)raw - 1;
+
+	if (!(h->flags & JACL_HDR_ALLOC)) return 0;
 
-	size_t off = (size_t)((uint8_t*)h - seg->base);
-	int bin = __jacl_membin_get(h->size);
+	return h->size - sizeof(__jacl_memhdr_t) - (size_t)((uint8_t*)p - raw);
+}
+
+void malloc_stats(void) {
+	__jacl_memsnap_t m;
+	size_t n[__JACL_MS_COUNT];
+
+	__jacl_heap_census(&m);
+	__jacl_memstat_sum(n);
+
+	fprintf(stderr, "Arena 0:\n");
+	fprintf(stderr, "system bytes     = %10zu\n", m.arena);
+	fprintf(stderr, "in use bytes     = %10zu\n", m.in_use);
+	fprintf(stderr, "Total (incl. mmap):\n");
+	fprintf(stderr, "system bytes     = %10zu\n", m.arena + m.huge_bytes);
+	fprintf(stderr, "in use bytes     = %10zu\n", m.in_use + m.huge_bytes);
+	fprintf(stderr, "mmap regions     = %10zu\n", m.huge_blocks);
+	fprintf(stderr, "mmap bytes       = %10zu\n", m.huge_bytes);
+
+	#if JACL_MALLOC_STATS
+		for (int i = 0; i < __JACL_MS_COUNT; i++) fprintf(stderr, "%-16s = %10zu\n", __jacl_memstat_names[i], n[i]);
+	#endif
+}
+
+int malloc_info(int options, FILE* stream) {
+	if (options || !stream) return (__errno_set(EINVAL), -1);
 
-	__jacl_memlock_acquire(&__jacl_locks[bin]);
-	__jacl_free_coalesce(seg, off);
-	__jacl_memlock_release(&__jacl_locks[bin]);
+	__jacl_memsnap_t m;
+	size_t n[__JACL_MS_COUNT];
+
+	__jacl_heap_census(&m);
+	__jacl_memstat_sum(n);
+
+	// how much of the free space can't serve a request as big as the largest free block
+	unsigned frag = m.free ? (unsigned)((m.free - m.largest_free) * 1000 / m.free) : 0;
+
+	fprintf(stream, "{\"heap\":{\"current\":%zu,\"max\":%zu,\"segments\":%zu,\"segment_size\":%zu,",
+		atomic_load_explicit(&__jacl_heap_current, memory_order_relaxed), __jacl_heap_max, m.segments, (size_t)JACL_HEAP_SEG);
+	fprintf(stream, "\"arena\":%zu,\"in_use\":%zu,\"free\":%zu,\"free_blocks\":%zu,\"largest_free\":%zu,\"fragmentation\":%u.%03u,",
+		m.arena, m.in_use, m.free, m.free_blocks, m.largest_free, frag / 1000, frag % 1000);
+	fprintf(stream, "\"cached\":%zu,\"cached_blocks\":%zu,\"idle\":%zu,\"slabs\":%zu,\"huge_blocks\":%zu,\"huge_bytes\":%zu},",
+		m.cached, m.cached_blocks, m.idle, m.slabs, m.huge_blocks, m.huge_bytes);
+	fprintf(stream, "\"counters\":");
+
+	if (!JACL_MALLOC_STATS) fprintf(stream, "null");
+	else for (int i = 0; i < __JACL_MS_COUNT; i++) fprintf(stream, "%c\"%s\":%zu", i ? ',' : '{', __jacl_memstat_names[i], n[i]);
+
+	fprintf(stream, "%s}\n", JACL_MALLOC_STATS ? "}" : "");
+
+	return ferror(stream) ? -1 : 0;
 }
 
 void* calloc(size_t nmemb, size_t size) {
@@ -681,7 +1758,13 @@ void* calloc(size_t nmemb, size_t size) {
 	size_t total = nmemb * size;
 	void* p = malloc(total);
 
-	if (p) memset(p, 0, total);
+	if (!p) return NULL;
+
+	__jacl_memhdr_t* h = (__jacl_memhdr_t*)p - 1;
+
+	// fresh from the OS, writing zeros would only fault the pages in
+	if (h->flags & JACL_HDR_ZERO) h->flags &= ~(size_t)JACL_HDR_ZERO;
+	else memset(p, 0, total);
 
 	return p;
 }
@@ -697,45 +1780,17 @@ void* realloc(void* ptr, size_t size) {
 
 	if (size <= old_data) return ptr;
 
-	/*
-	if (h->flags & JACL_HDR_ARENA) {
-		size_t new_total = __jacl_alloc_need(size);
-		uint32_t top = atomic_load_explicit(&__jacl_tls_cursor, memory_order_acquire);
-
-		if ((uint8_t*)h + old_total == __jacl_static_heap + top) {
-			size_t growth = new_total - old_total;
-
-			if (top + growth <= (JACL_HEAP_INIT / 4)) {
-				h->size = new_total;
-
-				atomic_fetch_add_explicit(&__jacl_tls_cursor, (uint32_t)growth, memory_order_release);
-
-				return ptr;
-			}
-		}
-	}
-	*/
-	if (h->flags & JACL_HDR_ARENA) {
-		size_t new_total = __jacl_alloc_need(size);
+	#if JACL_OS_LINUX
+		void* moved;
 
-		if ((uint8_t*)h + old_total == __jacl_static_heap + __jacl_tls_off) {
-			size_t growth = new_total - old_total;
-
-			if (__jacl_tls_off + growth <= __jacl_tls_end) {
-				h->size = new_total;
-				__jacl_tls_off += (uint32_t)growth;
-
-				return ptr;
-			}
-		}
-	}
+		if (__jacl_huge_block(ptr) && (moved = __jacl_realloc_huge(h, __jacl_alloc_need(size)))) return moved;
+	#endif
 
 	void* new_ptr = malloc(size);
 
 	if (new_ptr) {
 		memcpy(new_ptr, ptr, old_data);
-
-		if (!(h->flags & JACL_HDR_ARENA)) free(ptr);
+		free(ptr);
 	}
 
 	return new_ptr;
@@ -10,6 +10,7 @@
 
 _Atomic unsigned int __jacl_pthread_tls_key_counter = 0;
 thread_local void *__jacl_pthread_tls_values[MAX_TLS_KEYS] = {0};
+thread_local pid_t __jacl_pthread_tid = 0;
 
 void (*__jacl_pthread_key_destructors[MAX_TLS_KEYS])(void *) = {0};
 
@@ -19,6 +20,11 @@ _Atomic int __jacl_pthread_inited = 0;
 __jacl_atfork_handler_t *__jacl_atfork_list = NULL;
 pthread_spinlock_t __jacl_atfork_lock = PTHREAD_SPIN_LOCK_INITIALIZER;
 
+pthread_t __jacl_pthread_stack_cache = NULL;
+pthread_t __jacl_pthread_stack_dead = NULL;
+unsigned __jacl_pthread_stack_cached = 0;
+pthread_spinlock_t __jacl_pthread_stack_lock = PTHREAD_SPIN_LOCK_INITIALIZER;
+
 #endif
 
 #endif /* _CORE_PTHREAD_H */
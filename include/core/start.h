@@ -25,6 +25,17 @@ extern int main();
 #define __OS_INIT
 #include JACL_OS_FILE
 
+/* Per-thread TLS blocks (pthread_create carves one from each new stack) */
+#ifdef __jacl_os_tls_init
+size_t __jacl_tls_size(void) { return __jacl_os_tls_size(); }
+void* __jacl_tls_init(void* mem) { return __jacl_os_tls_init(mem); }
+void __jacl_tls_install(void* tp) { __jacl_arch_tls_set(tp); }
+#else
+size_t __jacl_tls_size(void) { return 0; }
+void* __jacl_tls_init(void* mem) { return mem; }
+void __jacl_tls_install(void* tp) { (void)tp; }
+#endif
+
 /* Futex fallback state */
 #if JACL_HAS_POSIX && !JACL_OS_LINUX && !JACL_OS_NETBSD
 #include <pthread.h>
@@ -56,9 +67,8 @@ void _start_main(long *p) {
 		}
 	}
 
-	int r = main(argc, argv, envp);
-
-	_exit(r);
+	/* returning from main is calling exit: handlers run and streams flush */
+	exit(main(argc, argv, envp));
 }
 
 /* Arch _start is ASM */
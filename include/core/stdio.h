@@ -16,42 +16,73 @@ STATIC_FILE(stdin,  0, __SRD, _IOLBF);
 STATIC_FILE(stdout, 1, __SWR, _IOLBF);
 STATIC_FILE(stderr, 2, __SWR, _IONBF);
 
-typedef struct __jacl_stream_node {
-	FILE* stream;
-	struct __jacl_stream_node *next;
-} STREAM_NODE;
-
-static STREAM_NODE* __jacl_stream_list;
 int __jacl_stdio_init = 0;
 
 /* ============================================================= */
 /* Stream Registry                                               */
 /* ============================================================= */
+
+/**
+ * NOTE: Open streams live in JACL_STREAM_SHARDS lists, picked by the FILE's
+ * address and linked through the FILE itself: _next, and _pprev pointing at
+ * whatever points at it. So fopen allocates nothing more, fclose unlinks in
+ * O(1), and threads opening and closing at once mostly take different shard
+ * locks. fflush(NULL) and exit walk one shard at a time under its lock,
+ * taking each stream's own lock inside it; vdprintf takes the lock of the
+ * stream it finds and lets the shard go before it writes. fclose unlinks
+ * before it flushes or frees anything, then waits on the stream's lock, so
+ * a walker never meets a dying stream.
+ */
+#ifndef JACL_STREAM_SHARDS
+#define JACL_STREAM_SHARDS 16
+#endif
+
+typedef struct {
+	FILE *head;
+	#if JACL_HAS_THREADS
+		pthread_mutex_t lock;
+	#endif
+} __jacl_stream_shard_t;
+
+static __jacl_stream_shard_t __jacl_stream_shards[JACL_STREAM_SHARDS];
+
+#if JACL_HAS_THREADS
+	#define __JACL_SHARD_LOCK(sh)   pthread_mutex_lock(&(sh)->lock)
+	#define __JACL_SHARD_UNLOCK(sh) pthread_mutex_unlock(&(sh)->lock)
+#else
+	#define __JACL_SHARD_LOCK(sh)   ((void)0)
+	#define __JACL_SHARD_UNLOCK(sh) ((void)0)
+#endif
+
+#define __JACL_SHARD_OF(f) (&__jacl_stream_shards[(((uintptr_t)(f) >> 4) ^ ((uintptr_t)(f) >> 12)) % JACL_STREAM_SHARDS])
+
 void __jacl_stream_register(FILE *stream) {
-	STREAM_NODE *node = (STREAM_NODE *)malloc(sizeof(STREAM_NODE));
+	__jacl_stream_shard_t *sh = __JACL_SHARD_OF(stream);
 
-	if (!node) return;
+	__JACL_SHARD_LOCK(sh);
 
-	node->stream = stream;
-	node->next = __jacl_stream_list;
+	if (!stream->_pprev) {
+		if ((stream->_next = sh->head)) sh->head->_pprev = &stream->_next;
 
-	__jacl_stream_list = node;
+		stream->_pprev = &sh->head;
+		sh->head = stream;
+	}
+
+	__JACL_SHARD_UNLOCK(sh);
 }
 void __jacl_stream_unregister(FILE *stream) {
-	STREAM_NODE** curr = &__jacl_stream_list;
-
-	while (*curr) {
-		if ((*curr)->stream == stream) {
-			STREAM_NODE* to_free = *curr;
-			*curr = (*curr)->next;
+	__jacl_stream_shard_t *sh = __JACL_SHARD_OF(stream);
 
-			free(to_free);
+	__JACL_SHARD_LOCK(sh);
 
-			return;
-		}
+	if (stream->_pprev) {
+		if ((*stream->_pprev = stream->_next)) stream->_next->_pprev = stream->_pprev;
 
-		curr = &(*curr)->next;
+		stream->_next = NULL;
+		stream->_pprev = NULL;
 	}
+
+	__JACL_SHARD_UNLOCK(sh);
 }
 int __jacl_stream_flush(FILE* stream) {
 	__jacl_init_stdio();
@@ -60,13 +91,22 @@ int __jacl_stream_flush(FILE* stream) {
 
 	int result = 0;
 
-	if (__jacl_buffer_flush(stdout) == EOF) result = EOF;
-	if (__jacl_buffer_flush(stderr) == EOF) result = EOF;
+	for (int i = 0; i < JACL_STREAM_SHARDS; i++) {
+		__jacl_stream_shard_t *sh = &__jacl_stream_shards[i];
+
+		__JACL_SHARD_LOCK(sh);
 
-	for (STREAM_NODE* n = __jacl_stream_list; n; n = n->next) {
-		FILE* s = n->stream;
+		for (FILE* s = sh->head; s; s = s->_next) {
+			if (!(s->_flags & __SWR)) continue;
 
-		if (s && (s->_flags & __SWR) && s != stdout && s != stderr && __jacl_buffer_flush(s) == EOF) result = EOF;
+			flockfile(s);
+
+			if (__jacl_buffer_flush(s) == EOF) result = EOF;
+
+			funlockfile(s);
+		}
+
+		__JACL_SHARD_UNLOCK(sh);
 	}
 
 	return result;
@@ -87,11 +127,31 @@ int sprintf(char * restrict s, const char * restrict fmt, ...) { va_list ap; va_
 int vsnprintf(char * restrict s, size_t n, const char * restrict fmt, va_list ap) { return __jacl_printf(NULL, s, n, fmt, ap); }
 int vdprintf(int fd, const char* restrict fmt, va_list ap) {
 	if (fd < 0) return (__errno_set(EBADF), -1);
+	if (!fmt) return -1;
 
 	__jacl_init_stdio();
 
-	for (STREAM_NODE* n = __jacl_stream_list; n; n = n->next) {
-		if (n->stream && n->stream->_fd == fd) return __jacl_printf(n->stream, NULL, 0, fmt, ap);
+	/* write through a stream already open on fd, so its buffered bytes stay in order */
+	for (int i = 0; i < JACL_STREAM_SHARDS; i++) {
+		__jacl_stream_shard_t *sh = &__jacl_stream_shards[i];
+
+		__JACL_SHARD_LOCK(sh);
+
+		for (FILE* s = sh->head; s; s = s->_next) {
+			if (s->_fd != fd) continue;
+
+			/* its lock, taken before the shard is let go, keeps fclose from freeing it under us */
+			flockfile(s);
+			__JACL_SHARD_UNLOCK(sh);
+
+			int r = __jacl_printf_stream(s, 1, fmt, ap);
+
+			funlockfile(s);
+
+			return r;
+		}
+
+		__JACL_SHARD_UNLOCK(sh);
 	}
 
 	char dummy[1] = {0};
@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <core/format.h>
 #include <core/memory.h>
+#include <pthread.h>
 
 #ifdef __cplusplus
 extern {
@@ -129,6 +130,7 @@ void abort(void) {
 
 void exit(int status) {
 	__jacl_exit_run_handlers();
+	__jacl_stream_flush(NULL);
 
 	#if JACL_HAS_C99
 		_Exit(status);
@@ -144,10 +146,10 @@ void exit(int status) {
 /* ============================================================= */
 #define __jacl_ato_int(name, type, len, usig) type ato##name(const char* str) { \
 	const char* p = str; \
-	int read = 0, ch = 0; \
+	size_t read = 0; \
 	uintmax_t val = 0; \
 	__jacl_fmt_t spec = usig? 10 : 10 | JACL_FMT_VAL(FLAG, sign); \
-	__jacl_read_skip(ch, NULL, &p, &read); \
+	while (__jacl_isspace((unsigned char)*p)) p++; \
 	if (__jacl_input_int(NULL, &p, &read, JACL_FMT_SET(LENGTH, spec, len), INT_MAX, &val)) return (type)val; \
 	return 0; \
 }
@@ -158,10 +160,10 @@ void exit(int status) {
 		return 0; \
 	} \
 	const char* p = str; \
-	int read = 0, ch = 0; \
+	size_t read = 0; \
 	uintmax_t val = 0; \
 	__jacl_fmt_t spec = usig? base : base | JACL_FMT_VAL(FLAG, sign); \
-	__jacl_read_skip(ch, NULL, &p, &read); \
+	while (__jacl_isspace((unsigned char)*p)) p++; \
 	if (__jacl_input_int(NULL, &p, &read, JACL_FMT_SET(LENGTH, spec, len), INT_MAX, &val)) { \
 		if (endptr) *endptr = (char*)p; \
 		return (type)val; \
@@ -169,18 +171,26 @@ void exit(int status) {
 	if (endptr) *endptr = (char*)str; \
 	return 0; \
 }
-#define __jacl_strto_float(suf, type, len) type strto##suf(const char* restrict str, char** restrict endptr) { \
-	const char* p = str; \
-	int read = 0, ch = 0; \
+#define __jacl_strto_float(suf, type, len, PRE) type strto##suf(const char* restrict str, char** restrict endptr) { \
+	const char* p = str, *end; \
+	size_t read = 0; \
 	long double val = 0.0; \
-	__jacl_read_skip(ch, NULL, &p, &read); \
+	__jacl_decimal_t dec; \
+	while (__jacl_isspace((unsigned char)*p)) p++; \
+	if ((end = __jacl_scan_decimal(p, &dec)) != p && *end != 'x' && *end != 'X') { \
+		type r = __jacl_decimal_##PRE(&dec); \
+		if (isinf(r) || (r == 0 && dec.w)) __errno_set(ERANGE); \
+		if (endptr) *endptr = (char*)end; \
+		return r; \
+	} \
 	__jacl_fmt_t spec = 10; \
 	JACL_FMT_SET(LENGTH, spec, len); \
 	if (__jacl_input_special(NULL, &p, &read, spec, INT_MAX, &val) || __jacl_input_float(NULL, &p, &read, spec, INT_MAX, &val)) { \
 		if (endptr) *endptr = (char*)p; \
 		return (type)val; \
 	} \
-	if (endptr) *endptr = (char*)str; \
+	if (endptr) *endptr = (char*)p; \
+	return 0; \
 }
 
 __jacl_ato_int(i, int, 0, 0)
@@ -195,21 +205,181 @@ __jacl_ato_int(ll, long long, ll, 0)
 __jacl_strto_int(ll, long long, ll, 0)
 __jacl_strto_int(ull, unsigned long long, ll, 1)
 
-__jacl_strto_float(f, float, 0)
-__jacl_strto_float(d, double, l)
-__jacl_strto_float(ld, long double, L)
+__jacl_strto_float(f, float, 0, FLT)
+__jacl_strto_float(d, double, l, DBL)
+__jacl_strto_float(ld, long double, L, LDBL)
 #endif
 
 double atof(const char* str) {
-	const char* p = str;
-	int _read = 0;
+	const char* p = str, *end;
+	size_t read = 0;
 	long double val = 0.0;
+	__jacl_decimal_t dec;
 
-	if (__jacl_input_float(NULL, &p, &_read, JACL_FMT_BASE_exp, INT_MAX, &val)) return (double)val;
+	while (__jacl_isspace((unsigned char)*p)) p++;
+
+	if ((end = __jacl_scan_decimal(p, &dec)) != p && *end != 'x' && *end != 'X') return __jacl_decimal_DBL(&dec);
+	if (__jacl_input_special(NULL, &p, &read, JACL_FMT_VAL(LENGTH, l), INT_MAX, &val) || __jacl_input_float(NULL, &p, &read, JACL_FMT_VAL(LENGTH, l), INT_MAX, &val)) return (double)val;
 
 	return 0.0;
 }
 
+/* ============================================================= */
+/* Parallel Sorting                                              */
+/* ============================================================= */
+
+/**
+ * NOTE: qsort_mt is a merge sort over introsorted chunks, one chunk per worker.
+ * Rounds of merges then pair the runs up until one is left, ping-ponging
+ * between the array and a scratch copy. Merges aren't handed out one pair per
+ * thread, which would idle half the workers each round: every worker writes
+ * its own chunk's slice of the output and finds where that slice starts in
+ * both inputs with a binary search (merge path), so all of them stay busy to
+ * the last round. The caller is worker 0 and a barrier separates the rounds.
+ */
+
+typedef struct {
+	unsigned char *base, *tmp;
+	size_t nmemb, size;
+	__jacl_sort_cmp_t compar;
+	void *arg;
+	int kind;
+	unsigned workers;
+	_Atomic int ready;
+	pthread_barrier_t barrier;
+} __jacl_psort_t;
+
+typedef struct {
+	__jacl_psort_t *job;
+	unsigned id;
+} __jacl_psort_worker_t;
+
+static inline unsigned __jacl_psort_cpus(void) {
+	uint64_t mask[16] = {0};
+	unsigned cpus = 0;
+
+	if (sched_getaffinity(0, sizeof(mask), mask) <= 0) return 1;
+
+	for (size_t i = 0; i < sizeof(mask) / sizeof(*mask); i++) cpus += (unsigned)__jacl_pop64(mask[i]);
+
+	return cpus ? cpus : 1;
+}
+static inline size_t __jacl_psort_bound(const __jacl_psort_t *job, unsigned i) {
+	size_t each = job->nmemb / job->workers, rest = job->nmemb % job->workers;
+
+	return each * i + (i < rest ? i : rest);
+}
+static inline void __jacl_psort_move(unsigned char *dst, const unsigned char *src, size_t size, int kind) {
+	switch (kind) {
+#ifdef __JACL_SWAR
+	case __JACL_SORT_U32: *(__jacl_sort_u32_t *)dst = *(const __jacl_sort_u32_t *)src; return;
+	case __JACL_SORT_WORD2: ((__jacl_word_t *)dst)[1] = ((const __jacl_word_t *)src)[1];
+	/* fallthrough */
+	case __JACL_SORT_WORD: *(__jacl_word_t *)dst = *(const __jacl_word_t *)src; return;
+#endif
+	default: memcpy(dst, src, size);
+	}
+}
+/* how many of the first k merged elements come from a, ties going to a */
+static inline size_t __jacl_psort_corank(const __jacl_psort_t *job, const unsigned char *a, size_t m, const unsigned char *b, size_t n, size_t k) {
+	size_t lo = k > n ? k - n : 0, hi = k < m ? k : m;
+
+	while (lo < hi) {
+		size_t i = lo + (hi - lo) / 2;
+
+		if (job->compar(a + i * job->size, b + (k - i - 1) * job->size, job->arg) <= 0) lo = i + 1;
+		else hi = i;
+	}
+
+	return lo;
+}
+static inline void __jacl_psort_merge(const __jacl_psort_t *job, const unsigned char *a, size_t m, const unsigned char *b, size_t n, unsigned char *out, size_t k0, size_t k1) {
+	size_t size = job->size, i = __jacl_psort_corank(job, a, m, b, n, k0), j = k0 - i;
+
+	for (out += k0 * size; k0 < k1; k0++, out += size) {
+		if (j >= n || (i < m && job->compar(a + i * size, b + j * size, job->arg) <= 0)) __jacl_psort_move(out, a + i++ * size, size, job->kind);
+		else __jacl_psort_move(out, b + j++ * size, size, job->kind);
+	}
+}
+static void *__jacl_psort_run(void *arg) {
+	__jacl_psort_worker_t *me = (__jacl_psort_worker_t *)arg;
+	__jacl_psort_t *job = me->job;
+
+	while (!atomic_load(&job->ready)) sched_yield();
+
+	unsigned id = me->id, workers = job->workers;
+	size_t size = job->size, lo = __jacl_psort_bound(job, id), hi = __jacl_psort_bound(job, id + 1);
+	unsigned char *src = job->base, *dst = job->tmp;
+
+	__jacl_sort_again(src + lo * size, hi - lo, size, job->compar, job->arg);
+
+	for (unsigned run = 1; run < workers; run *= 2) {
+		pthread_barrier_wait(&job->barrier);
+
+		unsigned first = id / (2 * run) * (2 * run);
+		size_t a0 = __jacl_psort_bound(job, first);
+		size_t a1 = __jacl_psort_bound(job, first + run < workers ? first + run : workers);
+		size_t b1 = __jacl_psort_bound(job, first + 2 * run < workers ? first + 2 * run : workers);
+
+		__jacl_psort_merge(job, src + a0 * size, a1 - a0, src + a1 * size, b1 - a1, dst + a0 * size, lo - a0, hi - a0);
+
+		unsigned char *t = src;
+
+		src = dst, dst = t;
+	}
+
+	/* the last round read the whole array, so wait for it before copying back */
+	if (src != job->base) {
+		pthread_barrier_wait(&job->barrier);
+		memcpy(job->base + lo * size, src + lo * size, (hi - lo) * size);
+	}
+
+	return NULL;
+}
+
+void qsort_mt(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void *arg, unsigned threads, size_t grain) {
+	if (!base || !compar || size == 0 || nmemb < 2) return;
+	if (!grain) grain = JACL_SORT_GRAIN;
+	if (!threads) threads = __jacl_psort_cpus();
+	if (threads > nmemb / grain) threads = (unsigned)(nmemb / grain);
+	if (threads > JACL_SORT_THREADS) threads = JACL_SORT_THREADS;
+
+#if JACL_HAS_PTHREADS
+	__jacl_psort_t job = { .base = (unsigned char *)base, .nmemb = nmemb, .size = size, .compar = compar, .arg = arg, .kind = __jacl_sort_kind(base, size) };
+
+	if (threads > 1 && nmemb <= SIZE_MAX / size && (job.tmp = malloc(nmemb * size))) {
+		__jacl_psort_worker_t crew[JACL_SORT_THREADS];
+		pthread_t tids[JACL_SORT_THREADS];
+		unsigned started = 1;
+
+		atomic_store(&job.ready, 0);
+
+		for (; started < threads; started++) {
+			crew[started] = (__jacl_psort_worker_t){ &job, started };
+
+			if (pthread_create(&tids[started], NULL, __jacl_psort_run, &crew[started])) break;
+		}
+
+		/* the crew waits for the final head count before touching the array */
+		job.workers = started;
+		pthread_barrier_init(&job.barrier, NULL, started);
+		atomic_store(&job.ready, 1);
+
+		crew[0] = (__jacl_psort_worker_t){ &job, 0 };
+		__jacl_psort_run(&crew[0]);
+
+		for (unsigned i = 1; i < started; i++) pthread_join(tids[i], NULL);
+
+		pthread_barrier_destroy(&job.barrier);
+		free(job.tmp);
+
+		return;
+	}
+#endif
+
+	__jacl_sort_again(base, nmemb, size, compar, arg);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,13 +13,21 @@ extern void __jacl_memlock_block(void);
 extern void __jacl_memlock_clear(void);
 extern void __jacl_memlock_reset(void);
 
+#if JACL_HAS_PTHREADS
+extern thread_local pid_t __jacl_pthread_tid;
+#endif
+
 pid_t fork(void) {
 	__jacl_memlock_block();
 
 	pid_t pid = (pid_t)syscall(SYS_fork);
 
-	if (pid == 0) __jacl_memlock_reset();
-	else if (pid > 0) __jacl_memlock_clear();
+	if (pid == 0) {
+		__jacl_memlock_reset();
+	#if JACL_HAS_PTHREADS
+		__jacl_pthread_tid = 0;
+	#endif
+	} else if (pid > 0) __jacl_memlock_clear();
 
 	return pid;
 }
@@ -872,27 +872,648 @@ static inline long double __jacl_payloadset_LDBL(DBL_UTYPE payload, int signalin
 static const double POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
 static const long double POW10_EXP2[] = { 1e1L, 1e2L, 1e4L, 1e8L, 1e16L, 1e32L, 1e64L, 1e128L, 1e256L, 1e512L, 1e1024L, 1e2048L, 1e4096L };
 
+// ======= SHORTEST AND EXACT DIGITS ========
+/**
+ * NOTE: float and double never go through the long double scaling further
+ * down. __jacl_ryu() is Ulf Adams' Ryu: one 128-bit multiply against a power
+ * of five puts the value and both ends of its rounding interval in decimal,
+ * then digits are dropped while the interval still holds one number. The
+ * result is the shortest digit string that reads back to the same value, and
+ * the closest one when there is a choice. __jacl_fexact() writes m * 2^e2 out
+ * in full with a small bignum so fixed precision can be rounded exactly.
+ */
+#define JACL_RYU_INV_BITS  125
+#define JACL_RYU_POW_BITS  125
+#define JACL_FEXACT_LIMBS  84
+#define JACL_FEXACT_DIGITS 800
+
+static const uint64_t __jacl_ryu_pow5_inv[342][2] = {
+	{ 0x0000000000000001u, 0x2000000000000000u }, { 0x999999999999999au, 0x1999999999999999u },
+	{ 0x47ae147ae147ae15u, 0x147ae147ae147ae1u }, { 0x6c8b4395810624deu, 0x10624dd2f1a9fbe7u },
+	{ 0x7a786c226809d496u, 0x1a36e2eb1c432ca5u }, { 0x61f9f01b866e43abu, 0x14f8b588e368f084u },
+	{ 0xb4c7f34938583622u, 0x10c6f7a0b5ed8d36u }, { 0x87a6520ec08d236au, 0x1ad7f29abcaf4857u },
+	{ 0x9fb841a566d74f88u, 0x15798ee2308c39dfu }, { 0xe62d01511f12a607u, 0x112e0be826d694b2u },
+	{ 0xd6ae6881cb5109a4u, 0x1b7cdfd9d7bdbab7u }, { 0xdef1ed34a2a73aeau, 0x15fd7fe17964955fu },
+	{ 0x7f27f0f6e885c8bbu, 0x119799812dea1119u }, { 0x650cb4be40d60df8u, 0x1c25c268497681c2u },
+	{ 0xea70909833de7193u, 0x16849b86a12b9b01u }, { 0x21f3a6e0297ec143u, 0x1203af9ee756159bu },
+	{ 0x6985d7cd0f313537u, 0x1cd2b297d889bc2bu }, { 0x2137dfd73f5a90f9u, 0x170ef54646d49689u },
+	{ 0xe75fe645cc4873fau, 0x12725dd1d243aba0u }, { 0xa5663d3c7a0d865du, 0x1d83c94fb6d2ac34u },
+	{ 0x511e976394d79eb1u, 0x179ca10c9242235du }, { 0xda7edf82dd794bc1u, 0x12e3b40a0e9b4f7du },
+	{ 0x2a6498d1625bac68u, 0x1e392010175ee596u }, { 0xeeb6e0a781e2f053u, 0x182db34012b25144u },
+	{ 0x58924d52ce4f26a9u, 0x1357c299a88ea76au }, { 0x27507bb7b07ea441u, 0x1ef2d0f5da7dd8aau },
+	{ 0x52a6c95fc0655034u, 0x18c240c4aecb13bbu }, { 0x0eebd44c99eaa690u, 0x13ce9a36f23c0fc9u },
+	{ 0xb17953adc3110a80u, 0x1fb0f6be50601941u }, { 0xc12ddc8b02740867u, 0x195a5efea6b34767u },
+	{ 0x3424b06f3529a052u, 0x14484bfeebc29f86u }, { 0x901d59f290ee19dbu, 0x1039d66589687f9eu },
+	{ 0x4cfbc31db4b0295fu, 0x19f623d5a8a73297u }, { 0x3d9635b15d59bab2u, 0x14c4e977ba1f5bacu },
+	{ 0x97ab5e277de16228u, 0x109d8792fb4c4956u }, { 0xf2abc9d8c9689d0du, 0x1a95a5b7f87a0ef0u },
+	{ 0x5bbca17a3aba173eu, 0x154484932d2e725au }, { 0xafca1ac82efb45cbu, 0x11039d428a8b8eaeu },
+	{ 0xb2dcf7a6b1920945u, 0x1b38fb9daa78e44au }, { 0xf57d92ebc141a104u, 0x15c72fb1552d836eu },
+	{ 0xc46475896767b403u, 0x116c262777579c58u }, { 0x6d6d88dbd8a5ecd2u, 0x1be03d0bf225c6f4u },
+	{ 0x8abe071646eb23dbu, 0x164cfda3281e38c3u }, { 0x6efe6c11d255b649u, 0x11d7314f534b609cu },
+	{ 0xb197134fb6ef8a0eu, 0x1c8b821885456760u }, { 0x27ac0f72f8bfa1a5u, 0x16d601ad376ab91au },
+	{ 0xb95672c260994e1eu, 0x1244ce242c5560e1u }, { 0xf5571e03cdc21695u, 0x1d3ae36d13bbce35u },
+	{ 0x2aac18030b01ababu, 0x17624f8a762fd82bu }, { 0xbbbce0026f348956u, 0x12b50c6ec4f31355u },
+	{ 0x92c7ccd0b1eda889u, 0x1dee7a4ad4b81eefu }, { 0xdbd30a408e57ba07u, 0x17f1fb6f10934bf2u },
+	{ 0x7ca8d50071dfc806u, 0x1327fc58da0f6ff5u }, { 0xfaa7bb33e9660cd6u, 0x1ea6608e29b24cbbu },
+	{ 0x9552fc298784d711u, 0x18851a0b548ea3c9u }, { 0xaaa8c9bad2d0ac0eu, 0x139dae6f76d88307u },
+	{ 0xdddadc5e1e1aace3u, 0x1f62b0b257c0d1a5u }, { 0x7e48b04b4b488a4fu, 0x191bc08eac9a4151u },
+	{ 0xcb6d59d5d5d3a1d9u, 0x141633a556e1cddau }, { 0x3c577b1177dc817bu, 0x1011c2eaabe7d7e2u },
+	{ 0xc6f25e825960cf2au, 0x19b604aaaca62636u }, { 0x6bf518684780a5bbu, 0x14919d5556eb51c5u },
+	{ 0x232a79ed06008496u, 0x10747ddddf22a7d1u }, { 0xd1dd8fe1a3340756u, 0x1a53fc9631d10c81u },
+	{ 0xa7e4731ae8f66c45u, 0x150ffd44f4a73d34u }, { 0x531d28e253f8569eu, 0x10d9976a5d52975du },
+	{ 0xeb61db03b98d5762u, 0x1af5bf109550f22eu }, { 0xbc4e48cfc7a445e8u, 0x159165a6ddda5b58u },
+	{ 0x6371d3d96c836b20u, 0x11411e1f17e1e2adu }, { 0x9f1c8628ad9f11cdu, 0x1b9b6364f3030448u },
+	{ 0xe5b06b53be18db0bu, 0x1615e91d8f359d06u }, { 0xeaf3890fcb4715a2u, 0x11ab20e472914a6bu },
+	{ 0x44b8db4c7871bc37u, 0x1c45016d841baa46u }, { 0x03c715d6c6c1635fu, 0x169d9abe03495505u },
+	{ 0x3638de456bcde919u, 0x1217aefe69077737u }, { 0x56c163a2461641c1u, 0x1cf2b1970e725858u },
+	{ 0xdf011c81d1ab67ceu, 0x17288e1271f51379u }, { 0x7f3416ce4155eca5u, 0x1286d80ec190dc61u },
+	{ 0x6520247d3556476eu, 0x1da48ce468e7c702u }, { 0xea801d30f7783925u, 0x17b6d71d20b96c01u },
+	{ 0xbb99b0f3f92cfa84u, 0x12f8ac174d612334u }, { 0x5f5c4e532847f739u, 0x1e5aacf215683854u },
+	{ 0x7f7d0b75b9d32c2eu, 0x18488a5b44536043u }, { 0x9930d5f7c7dc2358u, 0x136d3b7c36a919cfu },
+	{ 0x8eb4898c72f9d226u, 0x1f152bf9f10e8fb2u }, { 0x722a07a38f2e41b8u, 0x18ddbcc7f40ba628u },
+	{ 0xc1bb394fa5be9afau, 0x13e497065cd61e86u }, { 0x9c5ec2190930f7f6u, 0x1fd424d6faf030d7u },
+	{ 0x49e56814075a5ff8u, 0x197683df2f268d79u }, { 0x6e51201005e1e660u, 0x145ecfe5bf520ac7u },
+	{ 0xf1da800cd181851au, 0x104bd984990e6f05u }, { 0x4fc400148268d4f5u, 0x1a12f5a0f4e3e4d6u },
+	{ 0xd96999aa01ed772bu, 0x14dbf7b3f71cb711u }, { 0xadee1488018ac5bcu, 0x10aff95cc5b09274u },
+	{ 0x497ceda668de092cu, 0x1ab328946f80ea54u }, { 0x3aca57b853e4d424u, 0x155c2076bf9a5510u },
+	{ 0x623b7960431d7683u, 0x1116805effaeaa73u }, { 0x9d2bf566d1c8bd9eu, 0x1b5733cb32b110b8u },
+	{ 0x7dbcc452416d647fu, 0x15df5ca28ef40d60u }, { 0xcafd69db678ab6ccu, 0x117f7d4ed8c33de6u },
+	{ 0xab2f0fc572778adfu, 0x1bff2ee48e052fd7u }, { 0x88f273045b92d580u, 0x1665bf1d3e6a8cacu },
+	{ 0xd3f528d049424466u, 0x11eaff4a98553d56u }, { 0xb988414d4203a0a3u, 0x1cab3210f3bb9557u },
+	{ 0x6139cdd76802e6e9u, 0x16ef5b40c2fc7779u }, { 0xe761717920025254u, 0x125915cd68c9f92du },
+	{ 0xa568b58e999d5086u, 0x1d5b561574765b7cu }, { 0x5120913ee14aa6d2u, 0x177c44ddf6c515fdu },
+	{ 0xa74d40ff1aa21f0eu, 0x12c9d0b1923744cau }, { 0x0baece64f769cb4au, 0x1e0fb44f50586e11u },
+	{ 0x3c8bd850c5ee3c3bu, 0x180c903f7379f1a7u }, { 0xca0979da37f1c9c9u, 0x133d4032c2c7f485u },
+	{ 0xa9a8c2f6bfe942dbu, 0x1ec866b79e0cba6fu }, { 0x2153cf2bccba9be3u, 0x18a0522c7e709526u },
+	{ 0x1aa9728970954982u, 0x13b374f06526ddb8u }, { 0xf775840f1a88759du, 0x1f8587e7083e2f8cu },
+	{ 0x5f9136727ba05e17u, 0x19379fec0698260au }, { 0x1940f85b9619e4dfu, 0x142c7ff0054684d5u },
+	{ 0xe100c6afab47ea4cu, 0x1023998cd1053710u }, { 0xce67a44c453fdd47u, 0x19d28f47b4d524e7u },
+	{ 0xd852e9d69dccb106u, 0x14a8729fc3ddb71fu }, { 0x79dbee454b0a2738u, 0x1086c219697e2c19u },
+	{ 0x295fe3a211a9d859u, 0x1a71368f0f30468fu }, { 0xbab31c81a7bb137au, 0x15275ed8d8f36ba5u },
+	{ 0x6228e39aec95a92fu, 0x10ec4be0ad8f8951u }, { 0x9d0e38f7e0ef7517u, 0x1b13ac9aaf4c0ee8u },
+	{ 0xb0d82d931a592a79u, 0x15a956e225d67253u }, { 0x8d79be0f4847552eu, 0x11544581b7dec1dcu },
+	{ 0x158f967eda0bbb7cu, 0x1bba08cf8c979c94u }, { 0x77a611ff14d62f97u, 0x162e6d72d6dfb076u },
+	{ 0xf951a7ff43de8c79u, 0x11bebdf578b2f391u }, { 0xc21c3ffed2fdad8eu, 0x1c6463225ab7ec1cu },
+	{ 0x01b0333242648ad8u, 0x16b6b5b5155ff017u }, { 0x0159c28e9b83a246u, 0x122bc490dde659acu },
+	{ 0xcef604175f3903a3u, 0x1d12d41afca3c2acu }, { 0x725e69ac4c2d9c83u, 0x17424348ca1c9bbdu },
+	{ 0xf5185489d68ae39cu, 0x129b69070816e2fdu }, { 0xee8d540fbdab05c6u, 0x1dc574d80cf16b2fu },
+	{ 0xbed77672fe226b05u, 0x17d12a4670c1228cu }, { 0xff12c528cb4ebc04u, 0x130dbb6b8d674ed6u },
+	{ 0xcb513b74787df9a0u, 0x1e7c5f127bd87e24u }, { 0x090dc929f9fe614du, 0x18637f41fcad31b7u },
+	{ 0xa0d7d42194cb810au, 0x1382cc34ca2427c5u }, { 0x67bfb9cf5478ce77u, 0x1f37ad21436d0c6fu },
+	{ 0x1fcc94a5dd2d71f9u, 0x18f9574dcf8a7059u }, { 0x7fd6dd517dbdf4c7u, 0x13faac3e3fa1f37au },
+	{ 0xffbe2ee8c92fee0bu, 0x1ff779fd329cb8c3u }, { 0x6631bf20a0f324d6u, 0x1992c7fdc216fa36u },
+	{ 0xb827cc1a1a5c1d78u, 0x14756ccb01abfb5eu }, { 0x935309ae7b7ce460u, 0x105df0a267bcc918u },
+	{ 0x1eeb42b0c594a099u, 0x1a2fe76a3f9474f4u }, { 0xe58902270476e6e1u, 0x14f31f8832dd2a5cu },
+	{ 0xb7a0ce859d2bebe7u, 0x10c27fa028b0eeb0u }, { 0x59014a6f61dfdfd8u, 0x1ad0cc33744e4ab4u },
+	{ 0xe0cdd525e7e64cadu, 0x1573d68f903ea229u }, { 0x4d7177518651d6f1u, 0x11297872d9cbb4eeu },
+	{ 0x7be8bee8d6e957e8u, 0x1b758d848fac54b0u }, { 0xfcba3253df211320u, 0x15f7a46a0c89dd59u },
+	{ 0x63c8284318e74280u, 0x1192e9ee706e4aaeu }, { 0x060d0d3827d86a66u, 0x1c1e43171a4a1117u },
+	{ 0x6b3da42cecad21ebu, 0x167e9c127b6e7412u }, { 0x88fe1cf0bd574e56u, 0x11fee341fc585cdbu },
+	{ 0x419694b462254a23u, 0x1ccb0536608d615fu }, { 0x67abaa29e81dd4e9u, 0x1708d0f84d3de77fu },
+	{ 0xb95621bb2017dd87u, 0x126d73f9d764b932u }, { 0xc223692b668c95a5u, 0x1d7becc2f23ac1eau },
+	{ 0xce82ba891ed6de1du, 0x179657025b6234bbu }, { 0xa53562074bdf1818u, 0x12deac01e2b4f6fcu },
+	{ 0x3b889cd87964f359u, 0x1e3113363787f194u }, { 0xfc6d4a46c783f5e1u, 0x18274291c6065adcu },
+	{ 0x30576e9f06032b1au, 0x13529ba7d19eaf17u }, { 0x1a257dcb3cd1de90u, 0x1eea92a61c311825u },
+	{ 0x481dfe3c30a7e540u, 0x18bba884e35a79b7u }, { 0xd34b31c9c0865100u, 0x13c9539d82aec7c5u },
+	{ 0x5211e942cda3b4cdu, 0x1fa885c8d117a609u }, { 0x74db21023e1c90a4u, 0x19539e3a40dfb807u },
+	{ 0xf715b401cb4a0d50u, 0x1442e4fb67196005u }, { 0xf8de299b09080aa7u, 0x103583fc527ab337u },
+	{ 0x8e304291a80cddd7u, 0x19ef3993b72ab859u }, { 0x3e8d020e200a4b13u, 0x14bf6142f8eef9e1u },
+	{ 0x653d9b3e80083c0fu, 0x10991a9bfa58c7e7u }, { 0x6ec8f864000d2ce4u, 0x1a8e90f9908e0ca5u },
+	{ 0x8bd3f9e999a423eau, 0x153eda614071a3b7u }, { 0x3ca994bae1501cbbu, 0x10ff151a99f482f9u },
+	{ 0xc775bac49bb3612bu, 0x1b31bb5dc320d18eu }, { 0xd2c4956a16291a89u, 0x15c162b168e70e0bu },
+	{ 0xdbd0778811ba7ba1u, 0x11678227871f3e6fu }, { 0x2c80bf401c5d929bu, 0x1bd8d03f3e9863e6u },
+	{ 0xbd33cc3349e47549u, 0x16470cff6546b651u }, { 0xca8fd68f6e505dd4u, 0x11d270cc51055ea7u },
+	{ 0x4419574be3b3c953u, 0x1c83e7ad4e6efdd9u }, { 0x0347790982f63aa9u, 0x16cfec8aa52597e1u },
+	{ 0xcf6c60d468c4fbbau, 0x123ff06eea847980u }, { 0xe57a34870e07f92au, 0x1d331a4b10d3f59au },
+	{ 0x512e906c0b399422u, 0x175c1508da432ae2u }, { 0xda8ba6bcd5c7a9b5u, 0x12b010d3e1cf5581u },
+	{ 0x90df712e22d90f87u, 0x1de6815302e5559cu }, { 0xda4c5a8b4f140c6cu, 0x17eb9aa8cf1dde16u },
+	{ 0xaea37ba2a5a9a38au, 0x1322e220a5b17e78u }, { 0x7dd25f6aa2a905a9u, 0x1e9e369aa2b59727u },
+	{ 0x97db7f888220d154u, 0x187e92154ef7ac1fu }, { 0x797c6606ce80a777u, 0x139874ddd8c6234cu },
+	{ 0x8f2d700ae4010bf1u, 0x1f5a549627a36badu }, { 0x0c2459a25000d65au, 0x191510781fb5efbeu },
+	{ 0x701d1481d99a4515u, 0x1410d9f9b2f7f2feu }, { 0xc017439b147b6a77u, 0x100d7b2e28c65bfeu },
+	{ 0xccf205c4ed9243f2u, 0x19af2b7d0e0a2ccau }, { 0x0a5b37d0be0e9cc2u, 0x148c22ca71a1bd6fu },
+	{ 0x0848f973cb3ee3ceu, 0x10701bd527b4978cu }, { 0xda0e5bec78649fb0u, 0x1a4cf9550c5425acu },
+	{ 0x7b3eaff060507fc0u, 0x150a6110d6a9b7bdu }, { 0x95cbbff380406633u, 0x10d51a73deee2c97u },
+	{ 0xefac665266cd7052u, 0x1aee90b964b04758u }, { 0x2623850eb8a459dbu, 0x158ba6fab6f36c47u },
+	{ 0x1e82d0d893b6ae49u, 0x113c85955f29236cu }, { 0xfd9e1af41f8ab075u, 0x1b9408eefea838acu },
+	{ 0x97b1af29b2d559f7u, 0x16100725988693bdu }, { 0xac8e25baf5777b2cu, 0x11a66c1e139edc97u },
+	{ 0x7a7d092b2258c513u, 0x1c3d79c9b8fe2dbfu }, { 0x61fda0ef4ead6a76u, 0x169794a160cb57ccu },
+	{ 0xe7fe1a590bbdeec5u, 0x1212dd4de7091309u }, { 0xa6635d5b45fcb13au, 0x1ceafbafd80e84dcu },
+	{ 0x851c4aaf6b308dc8u, 0x172262f3133ed0b0u }, { 0xd0e36ef2bc26d7d4u, 0x1281e8c275cbda26u },
+	{ 0xb49f17eac6a48c86u, 0x1d9ca79d894629d7u }, { 0x2a18dfef0550706bu, 0x17b08617a104ee46u },
+	{ 0x54e0b3259dd9f389u, 0x12f39e794d9d8b6bu }, { 0x87cdeb6f62f65274u, 0x1e5297287c2f4578u },
+	{ 0xd30b22bf825ea85du, 0x18421286c9bf6ac6u }, { 0x0f3c1bcc684bb9e4u, 0x13680ed23aff889fu },
+	{ 0x18602c7a4079296du, 0x1f0ce4839198da98u }, { 0x46b356c833942124u, 0x18d71d360e13e213u },
+	{ 0x388f78a029434db6u, 0x13df4a91a4dcb4dcu }, { 0x5a7f2766a86baf8au, 0x1fcbaa82a1612160u },
+	{ 0x153285ebb9efbfa2u, 0x196fbb9bb44db44du }, { 0xaa8ed189618c994eu, 0x145962e2f6a4903du },
+	{ 0xeed8a7a11ad6e10cu, 0x1047824f2bb6d9cau }, { 0x7e27729b5e249b45u, 0x1a0c03b1df8af611u },
+	{ 0xfe85f549181d4904u, 0x14d6695b193bf80du }, { 0xcb9e5dd4134aa0d0u, 0x10ab877c142ff9a4u },
+	{ 0xdf63c9535211014du, 0x1aac0bf9b9e65c3au }, { 0x191ca10f74da6771u, 0x15566ffafb1eb02fu },
+	{ 0xadb080d92a4852c1u, 0x1111f32f2f4bc025u }, { 0x15e7348eaa0d5134u, 0x1b4feb7eb212cd09u },
+	{ 0xab1f5d3eee710dc4u, 0x15d98932280f0a6du }, { 0xbc1917658b8da49du, 0x117ad428200c0857u },
+	{ 0x2cf4f23c127c3a94u, 0x1bf7b9d9cce00d59u }, { 0xf0c3f4fcdb969543u, 0x165fc7e170b33de0u },
+	{ 0x5a365d9716121103u, 0x11e6398126f5cb1au }, { 0x9056fc24f01ce804u, 0x1ca38f350b22de90u },
+	{ 0xd9df301d8ce3ecd0u, 0x16e93f5da2824ba6u }, { 0xe17f59b13d8323dau, 0x125432b14ecea2ebu },
+	{ 0x68cbc2b52f38395cu, 0x1d53844ee47dd179u }, { 0x53d6355dbf602de3u, 0x177603725064a794u },
+	{ 0xa9782ab165e68b1cu, 0x12c4cf8ea6b6ec76u }, { 0x0f26aab56fd744fau, 0x1e07b27dd78b13f1u },
+	{ 0x3f52222abfdf6a62u, 0x18062864ac6f4327u }, { 0x65db4e88997f884eu, 0x1338205089f29c1fu },
+	{ 0x6fc54a7428cc0d4au, 0x1ec033b40fea9365u }, { 0x596aa1f68709a43bu, 0x1899c2f673220f84u },
+	{ 0xadeee7f86c07b696u, 0x13ae3591f5b4d936u }, { 0x497e3ff3e00c5756u, 0x1f7d228322baf524u },
+	{ 0xd464fff64cd6ac45u, 0x1930e868e89590e9u }, { 0x4383fff83d7889d1u, 0x14272053ed4473eeu },
+	{ 0xcf9cccc69793a174u, 0x101f4d0ff1038ff1u }, { 0x7f6147a425b90252u, 0x19cbae7fe805b31cu },
+	{ 0xcc4dd2e9b7c7350fu, 0x14a2f1ffecd15c16u }, { 0x3d0b0f215fd290d9u, 0x10825b3323dab012u },
+	{ 0x61ab4b689950e7c1u, 0x1a6a2b85062ab350u }, { 0x4e22a2ba1440b967u, 0x1521bc6a6b555c40u },
+	{ 0x0b4ee894dd009453u, 0x10e7c9eebc4449cdu }, { 0x1217da87c800ed51u, 0x1b0c764ac6d3a948u },
+	{ 0xdb46486ca000bddau, 0x15a391d56bdc876cu }, { 0x490506bd4ccd64afu, 0x114fa7ddefe39f8au },
+	{ 0xa8080ac87ae23ab1u, 0x1bb2a62fe638ff43u }, { 0x5339a239fbe82ef4u, 0x162884f31e93ff69u },
+	{ 0x75c7b4fb2fecf25du, 0x11ba03f5b20fff87u }, { 0x22d92191e647ea2eu, 0x1c5cd322b67fff3fu },
+	{ 0xb57a8141850654f2u, 0x16b0a8e891ffff65u }, { 0xc4620101373843f5u, 0x1226ed86db3332b7u },
+	{ 0x3a366801f1f39feeu, 0x1d0b15a491eb8459u }, { 0xfb5eb99b27f6198bu, 0x173c115074bc69e0u },
+	{ 0x2f7efae2865e7ad6u, 0x129674405d6387e7u }, { 0xe597f7d0d6fd9156u, 0x1dbd86cd6238d971u },
+	{ 0x8479930d78cadaabu, 0x17cad23de82d7ac1u }, { 0xd06142712d6f1556u, 0x1308a831868ac89au },
+	{ 0x4d686a4eaf182222u, 0x1e74404f3daada91u }, { 0xa453883ef279b4e8u, 0x185d003f6488aedau },
+	{ 0xe9dc6cff28615d87u, 0x137d99cc506d58aeu }, { 0xa960ae650d6895a4u, 0x1f2f5c7a1a488de4u },
+	{ 0xbab3beb73ded4483u, 0x18f2b061aea07183u }, { 0x2ef6322c318a9d36u, 0x13f559e7bee6c136u },
+	{ 0xe4bd1d13827761f0u, 0x1feef63f97d79b89u }, { 0x83ca7da9352c4e5au, 0x198bf832dfdfafa1u },
+	{ 0x9ca1fe20f756a515u, 0x146ff9c24cb2f2e7u }, { 0x4a1b31b3f9121daau, 0x1059949b708f28b9u },
+	{ 0x435eb5ecc1b695ddu, 0x1a28edc580e50df5u }, { 0x35e55e57015ede4au, 0x14ed8b04671da4c4u },
+	{ 0xc4b77eac0118b1d5u, 0x10be08d0527e1d69u }, { 0xa12597799b5ab622u, 0x1ac9a7b3b7302f0fu },
+	{ 0x4db7ac6149155e81u, 0x156e1fc2f8f358d9u }, { 0xd7c6238107444b9bu, 0x1124e63593f5e0adu },
+	{ 0x593d059b3ed3ac2bu, 0x1b6e3d2286563449u }, { 0xe0fd9e15cbdc89bcu, 0x15f1ca820511c36du },
+	{ 0xb3fe18116fe3a163u, 0x118e3b9b37416924u }, { 0x866359b57fd29bd1u, 0x1c16c5c525357507u },
+	{ 0xd1e91491330ee30eu, 0x16789e3750f790d2u }, { 0x74ba76da8f3f1c0bu, 0x11fa182c40c60d75u },
+	{ 0xedf72490e531c678u, 0x1cc359e067a348bbu }, { 0x8b2c1d40b75b052du, 0x1702ae4d1fb5d3c9u },
+	{ 0x6f567dcd5f7c0424u, 0x12688b70e62b0fd4u }, { 0x7ef0c94898c66d06u, 0x1d74124e3d11b2edu },
+	{ 0x98c0a106e09ebd9fu, 0x17900ea4fda7c257u }, { 0x470080d24d4bcae6u, 0x12d9a550caec9b79u },
+	{ 0xd800ce1d487944a2u, 0x1e29088144adc58eu }, { 0x1333d8176d2dd082u, 0x1820d39a9d57d13fu },
+	{ 0xa8f646792424a6ceu, 0x134d76154aaca765u }, { 0x74bd3d8ea03aa47du, 0x1ee25688777aa56fu },
+	{ 0x5d64313ee6955064u, 0x18b51206c5fbb78cu }, { 0x4ab68dcbebaaa6b7u, 0x13c40e6bd1962c70u },
+	{ 0x1124161312aaa457u, 0x1fa01712e8f0471au }, { 0xda8344dc0eeee9dfu, 0x194cdf4253f36c14u },
+	{ 0xe2029d7cd8bf2180u, 0x143d7f6843292343u }, { 0x4e687dfd7a328133u, 0x103132b9cf541c36u },
+	{ 0x4a40c9959050ceb8u, 0x19e851294bb9c6bdu }, { 0x0833d477a6a70bc6u, 0x14b9da876fc7d231u },
+	{ 0xa02976c61eec096bu, 0x1094aed2bfd30e8du }, { 0x004257a364acdbdfu, 0x1a877e1dffb81749u },
+	{ 0xcd01dfb5ea23e319u, 0x153931b1996012a0u }, { 0x70ce4c91881cb5aeu, 0x10fa8e27ade6754du },
+	{ 0x1ae3adb5a69455e2u, 0x1b2a7d0c4970bbafu }, { 0x7be957c4854377e8u, 0x15bb973d078d62f2u },
+	{ 0xc987796a0435f987u, 0x1162df64060ab58eu }, { 0x75a58f1006bcc271u, 0x1bd1656cd67788e4u },
+	{ 0xf7b7a5a66bca3527u, 0x16411df0ab92d3e9u }, { 0x5fc61e1ebca1c41fu, 0x11cdb18d560f0feeu },
+	{ 0xffa363646102d365u, 0x1c7c4f4889b1b316u }, { 0x32e91c504d9bdc51u, 0x16c9d906d48e28dfu },
+	{ 0x8f20e37371497d0eu, 0x123b140576d820b2u }, { 0x7e9b0585820f2e7cu, 0x1d2b533bf159cdeau },
+	{ 0xcbaf379e01a5becau, 0x1755dc2ff447d7eeu }, { 0x0958f94b348498a1u, 0x12ab168cc36cacbfu }
+};
+static const uint64_t __jacl_ryu_pow5[326][2] = {
+	{ 0x0000000000000000u, 0x1000000000000000u }, { 0x0000000000000000u, 0x1400000000000000u },
+	{ 0x0000000000000000u, 0x1900000000000000u }, { 0x0000000000000000u, 0x1f40000000000000u },
+	{ 0x0000000000000000u, 0x1388000000000000u }, { 0x0000000000000000u, 0x186a000000000000u },
+	{ 0x0000000000000000u, 0x1e84800000000000u }, { 0x0000000000000000u, 0x1312d00000000000u },
+	{ 0x0000000000000000u, 0x17d7840000000000u }, { 0x0000000000000000u, 0x1dcd650000000000u },
+	{ 0x0000000000000000u, 0x12a05f2000000000u }, { 0x0000000000000000u, 0x174876e800000000u },
+	{ 0x0000000000000000u, 0x1d1a94a200000000u }, { 0x0000000000000000u, 0x12309ce540000000u },
+	{ 0x0000000000000000u, 0x16bcc41e90000000u }, { 0x0000000000000000u, 0x1c6bf52634000000u },
+	{ 0x0000000000000000u, 0x11c37937e0800000u }, { 0x0000000000000000u, 0x16345785d8a00000u },
+	{ 0x0000000000000000u, 0x1bc16d674ec80000u }, { 0x0000000000000000u, 0x1158e460913d0000u },
+	{ 0x0000000000000000u, 0x15af1d78b58c4000u }, { 0x0000000000000000u, 0x1b1ae4d6e2ef5000u },
+	{ 0x0000000000000000u, 0x10f0cf064dd59200u }, { 0x0000000000000000u, 0x152d02c7e14af680u },
+	{ 0x0000000000000000u, 0x1a784379d99db420u }, { 0x0000000000000000u, 0x108b2a2c28029094u },
+	{ 0x0000000000000000u, 0x14adf4b7320334b9u }, { 0x4000000000000000u, 0x19d971e4fe8401e7u },
+	{ 0x8800000000000000u, 0x1027e72f1f128130u }, { 0xaa00000000000000u, 0x1431e0fae6d7217cu },
+	{ 0xd480000000000000u, 0x193e5939a08ce9dbu }, { 0xc9a0000000000000u, 0x1f8def8808b02452u },
+	{ 0xbe04000000000000u, 0x13b8b5b5056e16b3u }, { 0xad85000000000000u, 0x18a6e32246c99c60u },
+	{ 0xd8e6400000000000u, 0x1ed09bead87c0378u }, { 0x878fe80000000000u, 0x13426172c74d822bu },
+	{ 0x6973e20000000000u, 0x1812f9cf7920e2b6u }, { 0x03d0da8000000000u, 0x1e17b84357691b64u },
+	{ 0x8262889000000000u, 0x12ced32a16a1b11eu }, { 0x22fb2ab400000000u, 0x178287f49c4a1d66u },
+	{ 0xabb9f56100000000u, 0x1d6329f1c35ca4bfu }, { 0xcb54395ca0000000u, 0x125dfa371a19e6f7u },
+	{ 0xbe2947b3c8000000u, 0x16f578c4e0a060b5u }, { 0x2db399a0ba000000u, 0x1cb2d6f618c878e3u },
+	{ 0xfc90400474400000u, 0x11efc659cf7d4b8du }, { 0x7bb4500591500000u, 0x166bb7f0435c9e71u },
+	{ 0xdaa16406f5a40000u, 0x1c06a5ec5433c60du }, { 0xa8a4de8459868000u, 0x118427b3b4a05bc8u },
+	{ 0xd2ce16256fe82000u, 0x15e531a0a1c872bau }, { 0x87819baecbe22800u, 0x1b5e7e08ca3a8f69u },
+	{ 0xf4b1014d3f6d5900u, 0x111b0ec57e6499a1u }, { 0x71dd41a08f48af40u, 0x1561d276ddfdc00au },
+	{ 0x0e549208b31adb10u, 0x1aba4714957d300du }, { 0x28f4db456ff0c8eau, 0x10b46c6cdd6e3e08u },
+	{ 0x33321216cbecfb24u, 0x14e1878814c9cd8au }, { 0xbffe969c7ee839edu, 0x1a19e96a19fc40ecu },
+	{ 0xf7ff1e21cf512434u, 0x105031e2503da893u }, { 0xf5fee5aa43256d41u, 0x14643e5ae44d12b8u },
+	{ 0x337e9f14d3eec892u, 0x197d4df19d605767u }, { 0x005e46da08ea7ab6u, 0x1fdca16e04b86d41u },
+	{ 0xa03aec4845928cb2u, 0x13e9e4e4c2f34448u }, { 0xc849a75a56f72fdeu, 0x18e45e1df3b0155au },
+	{ 0x7a5c1130ecb4fbd6u, 0x1f1d75a5709c1ab1u }, { 0xec798abe93f11d65u, 0x13726987666190aeu },
+	{ 0xa797ed6e38ed64bfu, 0x184f03e93ff9f4dau }, { 0x517de8c9c728bdefu, 0x1e62c4e38ff87211u },
+	{ 0xd2eeb17e1c7976b5u, 0x12fdbb0e39fb474au }, { 0x87aa5ddda397d462u, 0x17bd29d1c87a191du },
+	{ 0xe994f5550c7dc97bu, 0x1dac74463a989f64u }, { 0x11fd195527ce9dedu, 0x128bc8abe49f639fu },
+	{ 0xd67c5faa71c24568u, 0x172ebad6ddc73c86u }, { 0x8c1b77950e32d6c2u, 0x1cfa698c95390ba8u },
+	{ 0x57912abd28dfc639u, 0x121c81f7dd43a749u }, { 0xad75756c7317b7c8u, 0x16a3a275d494911bu },
+	{ 0x98d2d2c78fdda5bau, 0x1c4c8b1349b9b562u }, { 0x9f83c3bcb9ea8794u, 0x11afd6ec0e14115du },
+	{ 0x0764b4abe8652979u, 0x161bcca7119915b5u }, { 0x493de1d6e27e73d7u, 0x1ba2bfd0d5ff5b22u },
+	{ 0x6dc6ad264d8f0866u, 0x1145b7e285bf98f5u }, { 0xc938586fe0f2ca80u, 0x159725db272f7f32u },
+	{ 0x7b866e8bd92f7d20u, 0x1afcef51f0fb5effu }, { 0xad34051767bdae34u, 0x10de1593369d1b5fu },
+	{ 0x9881065d41ad19c1u, 0x15159af804446237u }, { 0x7ea147f492186032u, 0x1a5b01b605557ac5u },
+	{ 0x6f24ccf8db4f3c1fu, 0x1078e111c3556cbbu }, { 0x4aee003712230b27u, 0x14971956342ac7eau },
+	{ 0xdda98044d6abcdf0u, 0x19bcdfabc13579e4u }, { 0x0a89f02b062b60b6u, 0x10160bcb58c16c2fu },
+	{ 0xcd2c6c35c7b638e4u, 0x141b8ebe2ef1c73au }, { 0x8077874339a3c71du, 0x1922726dbaae3909u },
+	{ 0xe0956914080cb8e4u, 0x1f6b0f092959c74bu }, { 0x6c5d61ac8507f38eu, 0x13a2e965b9d81c8fu },
+	{ 0x4774ba17a649f072u, 0x188ba3bf284e23b3u }, { 0x1951e89d8fdc6c8fu, 0x1eae8caef261aca0u },
+	{ 0x0fd3316279e9c3d9u, 0x132d17ed577d0be4u }, { 0x13c7fdbb186434cfu, 0x17f85de8ad5c4eddu },
+	{ 0x58b9fd29de7d4203u, 0x1df67562d8b36294u }, { 0xb7743e3a2b0e4942u, 0x12ba095dc7701d9cu },
+	{ 0xe5514dc8b5d1db92u, 0x17688bb5394c2503u }, { 0xdea5a13ae3465277u, 0x1d42aea2879f2e44u },
+	{ 0x0b2784c4ce0bf38au, 0x1249ad2594c37cebu }, { 0xcdf165f6018ef06du, 0x16dc186ef9f45c25u },
+	{ 0x416dbf7381f2ac88u, 0x1c931e8ab871732fu }, { 0x88e497a83137abd5u, 0x11dbf316b346e7fdu },
+	{ 0xeb1dbd923d8596cau, 0x1652efdc6018a1fcu }, { 0x25e52cf6cce6fc7du, 0x1be7abd3781eca7cu },
+	{ 0x97af3c1a40105dceu, 0x1170cb642b133e8du }, { 0xfd9b0b20d0147542u, 0x15ccfe3d35d80e30u },
+	{ 0x3d01cde904199292u, 0x1b403dcc834e11bdu }, { 0x462120b1a28ffb9bu, 0x1108269fd210cb16u },
+	{ 0xd7a968de0b33fa82u, 0x154a3047c694fddbu }, { 0xcd93c3158e00f923u, 0x1a9cbc59b83a3d52u },
+	{ 0xc07c59ed78c09bb6u, 0x10a1f5b813246653u }, { 0xb09b7068d6f0c2a3u, 0x14ca732617ed7fe8u },
+	{ 0xdcc24c830cacf34cu, 0x19fd0fef9de8dfe2u }, { 0xc9f96fd1e7ec180fu, 0x103e29f5c2b18bedu },
+	{ 0x3c77cbc661e71e13u, 0x144db473335deee9u }, { 0x8b95beb7fa60e598u, 0x1961219000356aa3u },
+	{ 0x6e7b2e65f8f91efeu, 0x1fb969f40042c54cu }, { 0xc50cfcffbb9bb35fu, 0x13d3e2388029bb4fu },
+	{ 0xb6503c3faa82a037u, 0x18c8dac6a0342a23u }, { 0xa3e44b4f95234844u, 0x1efb1178484134acu },
+	{ 0xe66eaf11bd360d2bu, 0x135ceaeb2d28c0ebu }, { 0xe00a5ad62c839075u, 0x183425a5f872f126u },
+	{ 0x980cf18bb7a47493u, 0x1e412f0f768fad70u }, { 0x5f0816f752c6c8dcu, 0x12e8bd69aa19cc66u },
+	{ 0xf6ca1cb527787b13u, 0x17a2ecc414a03f7fu }, { 0xf47ca3e2715699d7u, 0x1d8ba7f519c84f5fu },
+	{ 0xf8cde66d86d62026u, 0x127748f9301d319bu }, { 0xf7016008e88ba830u, 0x17151b377c247e02u },
+	{ 0xb4c1b80b22ae923cu, 0x1cda62055b2d9d83u }, { 0x50f91306f5ad1b65u, 0x12087d4358fc8272u },
+	{ 0xe53757c8b318623fu, 0x168a9c942f3ba30eu }, { 0x9e852dbadfde7acfu, 0x1c2d43b93b0a8bd2u },
+	{ 0xa3133c94cbeb0cc1u, 0x119c4a53c4e69763u }, { 0x8bd80bb9fee5cff1u, 0x16035ce8b6203d3cu },
+	{ 0xaece0ea87e9f43eeu, 0x1b843422e3a84c8bu }, { 0x4d40c9294f238a75u, 0x1132a095ce492fd7u },
+	{ 0x2090fb73a2ec6d12u, 0x157f48bb41db7bcdu }, { 0x68b53a508ba78856u, 0x1adf1aea12525ac0u },
+	{ 0x417144725748b536u, 0x10cb70d24b7378b8u }, { 0x51cd958eed1ae283u, 0x14fe4d06de5056e6u },
+	{ 0xe640faf2a8619b24u, 0x1a3de04895e46c9fu }, { 0xefe89cd7a93d00f7u, 0x1066ac2d5daec3e3u },
+	{ 0xebe2c40d938c4134u, 0x14805738b51a74dcu }, { 0x26db7510f86f5181u, 0x19a06d06e2611214u },
+	{ 0x9849292a9b4592f1u, 0x100444244d7cab4cu }, { 0xbe5b73754216f7adu, 0x1405552d60dbd61fu },
+	{ 0xadf25052929cb598u, 0x1906aa78b912cba7u }, { 0x996ee4673743e2ffu, 0x1f485516e7577e91u },
+	{ 0xffe54ec0828a6ddfu, 0x138d352e5096af1au }, { 0xbfdea270a32d0957u, 0x18708279e4bc5ae1u },
+	{ 0x2fd64b0ccbf84badu, 0x1e8ca3185deb719au }, { 0x5de5eee7ff7b2f4cu, 0x1317e5ef3ab32700u },
+	{ 0x755f6aa1ff59fb1fu, 0x17dddf6b095ff0c0u }, { 0x92b7454a7f3079e7u, 0x1dd55745cbb7ecf0u },
+	{ 0x5bb28b4e8f7e4c30u, 0x12a5568b9f52f416u }, { 0xf29f2e22335ddf3cu, 0x174eac2e8727b11bu },
+	{ 0xef46f9aac035570bu, 0x1d22573a28f19d62u }, { 0xd58c5c0ab8215667u, 0x123576845997025du },
+	{ 0x4aef730d6629ac01u, 0x16c2d4256ffcc2f5u }, { 0x9dab4fd0bfb41701u, 0x1c73892ecbfbf3b2u },
+	{ 0xa28b11e277d08e60u, 0x11c835bd3f7d784fu }, { 0x8b2dd65b15c4b1f9u, 0x163a432c8f5cd663u },
+	{ 0x6df94bf1db35de77u, 0x1bc8d3f7b3340bfcu }, { 0xc4bbcf772901ab0au, 0x115d847ad000877du },
+	{ 0x35eac354f34215cdu, 0x15b4e5998400a95du }, { 0x8365742a30129b40u, 0x1b221effe500d3b4u },
+	{ 0xd21f689a5e0ba108u, 0x10f5535fef208450u }, { 0x06a742c0f58e894au, 0x1532a837eae8a565u },
+	{ 0x4851137132f22b9du, 0x1a7f5245e5a2cebeu }, { 0xed32ac26bfd75b42u, 0x108f936baf85c136u },
+	{ 0xa87f57306fcd3212u, 0x14b378469b673184u }, { 0xd29f2cfc8bc07e97u, 0x19e056584240fde5u },
+	{ 0xa3a37c1dd7584f1eu, 0x102c35f729689eafu }, { 0x8c8c5b254d2e62e6u, 0x14374374f3c2c65bu },
+	{ 0x6faf71eea079fb9fu, 0x1945145230b377f2u }, { 0x0b9b4e6a48987a87u, 0x1f965966bce055efu },
+	{ 0x674111026d5f4c94u, 0x13bdf7e0360c35b5u }, { 0xc111554308b71fbau, 0x18ad75d8438f4322u },
+	{ 0x7155aa93cae4e7a8u, 0x1ed8d34e547313ebu }, { 0x26d58a9c5ecf10c9u, 0x13478410f4c7ec73u },
+	{ 0xf08aed437682d4fbu, 0x1819651531f9e78fu }, { 0xecada89454238a3au, 0x1e1fbe5a7e786173u },
+	{ 0x73ec895cb4963664u, 0x12d3d6f88f0b3ce8u }, { 0x90e7abb3e1bbc3fdu, 0x1788ccb6b2ce0c22u },
+	{ 0x352196a0da2ab4fdu, 0x1d6affe45f818f2bu }, { 0x0134fe24885ab11eu, 0x1262dfeebbb0f97bu },
+	{ 0xc1823dadaa715d65u, 0x16fb97ea6a9d37d9u }, { 0x31e2cd19150db4bfu, 0x1cba7de5054485d0u },
+	{ 0x1f2dc02fad2890f7u, 0x11f48eaf234ad3a2u }, { 0xa6f9303b9872b535u, 0x1671b25aec1d888au },
+	{ 0x50b77c4a7e8f6282u, 0x1c0e1ef1a724eaadu }, { 0x5272adae8f199d91u, 0x1188d357087712acu },
+	{ 0x670f591a32e004f6u, 0x15eb082cca94d757u }, { 0x40d32f60bf980633u, 0x1b65ca37fd3a0d2du },
+	{ 0x4883fd9c77bf03e0u, 0x111f9e62fe44483cu }, { 0x5aa4fd0395aec4d8u, 0x156785fbbdd55a4bu },
+	{ 0x314e3c447b1a760eu, 0x1ac1677aad4ab0deu }, { 0xded0e5aaccf089c9u, 0x10b8e0acac4eae8au },
+	{ 0x96851f15802cac3bu, 0x14e718d7d7625a2du }, { 0xfc2666dae037d74au, 0x1a20df0dcd3af0b8u },
+	{ 0x9d980048cc22e68eu, 0x10548b68a044d673u }, { 0x84fe005aff2ba032u, 0x1469ae42c8560c10u },
+	{ 0xa63d8071bef6883eu, 0x198419d37a6b8f14u }, { 0xcfcce08e2eb42a4eu, 0x1fe52048590672d9u },
+	{ 0x21e00c58dd309a70u, 0x13ef342d37a407c8u }, { 0x2a580f6f147cc10du, 0x18eb0138858d09bau },
+	{ 0xb4ee134ad99bf150u, 0x1f25c186a6f04c28u }, { 0x7114cc0ec80176d2u, 0x137798f428562f99u },
+	{ 0xcd59ff127a01d486u, 0x18557f31326bbb7fu }, { 0xc0b07ed7188249a8u, 0x1e6adefd7f06aa5fu },
+	{ 0xd86e4f466f516e09u, 0x1302cb5e6f642a7bu }, { 0xce89e3180b25c98bu, 0x17c37e360b3d351au },
+	{ 0x822c5bde0def3beeu, 0x1db45dc38e0c8261u }, { 0xf15bb96ac8b58575u, 0x1290ba9a38c7d17cu },
+	{ 0x2db2a7c57ae2e6d2u, 0x1734e940c6f9c5dcu }, { 0x391f51b6d99ba086u, 0x1d022390f8b83753u },
+	{ 0x03b3931248014454u, 0x1221563a9b732294u }, { 0x04a077d6da019569u, 0x16a9abc9424feb39u },
+	{ 0x45c895cc9081fac3u, 0x1c5416bb92e3e607u }, { 0x8b9d5d9fda513cbau, 0x11b48e353bce6fc4u },
+	{ 0xae84b507d0e58be8u, 0x1621b1c28ac20bb5u }, { 0x1a25e249c51eeee3u, 0x1baa1e332d728ea3u },
+	{ 0xf057ad6e1b33554du, 0x114a52dffc679925u }, { 0x6c6d98c9a2002aa1u, 0x159ce797fb817f6fu },
+	{ 0x4788fefc0a803549u, 0x1b04217dfa61df4bu }, { 0x0cb59f5d8690214eu, 0x10e294eebc7d2b8fu },
+	{ 0xcfe30734e83429a1u, 0x151b3a2a6b9c7672u }, { 0x83dbc9022241340au, 0x1a6208b50683940fu },
+	{ 0xb2695da15568c086u, 0x107d457124123c89u }, { 0x1f03b509aac2f0a7u, 0x149c96cd6d16cbacu },
+	{ 0x26c4a24c1573acd1u, 0x19c3bc80c85c7e97u }, { 0x783ae56f8d684c03u, 0x101a55d07d39cf1eu },
+	{ 0x16499ecb70c25f03u, 0x1420eb449c8842e6u }, { 0x9bdc067e4cf2f6c4u, 0x19292615c3aa539fu },
+	{ 0x82d3081de02fb476u, 0x1f736f9b3494e887u }, { 0xb1c3e512ac1dd0c9u, 0x13a825c100dd1154u },
+	{ 0xde34de57572544fcu, 0x18922f31411455a9u }, { 0x55c215ed2cee963bu, 0x1eb6bafd91596b14u },
+	{ 0xb5994db43c151de5u, 0x133234de7ad7e2ecu }, { 0xe2ffa1214b1a655eu, 0x17fec216198ddba7u },
+	{ 0xdbbf89699de0feb6u, 0x1dfe729b9ff15291u }, { 0x2957b5e202ac9f31u, 0x12bf07a143f6d39bu },
+	{ 0xf3ada35a8357c6feu, 0x176ec98994f48881u }, { 0x70990c31242db8bdu, 0x1d4a7bebfa31aaa2u },
+	{ 0x865fa79eb69c9376u, 0x124e8d737c5f0aa5u }, { 0xe7f791866443b854u, 0x16e230d05b76cd4eu },
+	{ 0xa1f575e7fd54a669u, 0x1c9abd04725480a2u }, { 0xa53969b0fe54e801u, 0x11e0b622c774d065u },
+	{ 0x0e87c41d3dea2202u, 0x1658e3ab7952047fu }, { 0xd229b5248d64aa82u, 0x1bef1c9657a6859eu },
+	{ 0x435a1136d85eea91u, 0x117571ddf6c81383u }, { 0x143095848e76a536u, 0x15d2ce55747a1864u },
+	{ 0x193cbae5b2144e83u, 0x1b4781ead1989e7du }, { 0x2fc5f4cf8f4cb112u, 0x110cb132c2ff630eu },
+	{ 0xbbb77203731fdd56u, 0x154fdd7f73bf3bd1u }, { 0x2aa54e844fe7d4acu, 0x1aa3d4df50af0ac6u },
+	{ 0xdaa75112b1f0e4ebu, 0x10a6650b926d66bbu }, { 0xd15125575e6d1e26u, 0x14cffe4e7708c06au },
+	{ 0x85a56ead360865b0u, 0x1a03fde214caf085u }, { 0x7387652c41c53f8eu, 0x10427ead4cfed653u },
+	{ 0x50693e7752368f71u, 0x14531e58a03e8be8u }, { 0x64838e1526c4334eu, 0x1967e5eec84e2ee2u },
+	{ 0xfda4719a70754022u, 0x1fc1df6a7a61ba9au }, { 0xde86c70086494815u, 0x13d92ba28c7d14a0u },
+	{ 0x162878c0a7db9a1au, 0x18cf768b2f9c59c9u }, { 0x5bb296f0d1d280a1u, 0x1f03542dfb83703bu },
+	{ 0x194f9e5683239064u, 0x1362149cbd322625u }, { 0x5fa385ec23ec747eu, 0x183a99c3ec7eafaeu },
+	{ 0xf78c67672ce7919du, 0x1e494034e79e5b99u }, { 0x3ab7c0a07c10bb02u, 0x12edc82110c2f940u },
+	{ 0x4965b0c89b14e9c3u, 0x17a93a2954f3b790u }, { 0x5bbf1cfac1da2433u, 0x1d9388b3aa30a574u },
+	{ 0xb957721cb92856a0u, 0x127c35704a5e6768u }, { 0xe7ad4ea3e7726c48u, 0x171b42cc5cf60142u },
+	{ 0xa198a24ce14f075au, 0x1ce2137f74338193u }, { 0x44ff65700cd16498u, 0x120d4c2fa8a030fcu },
+	{ 0x563f3ecc1005bdbeu, 0x16909f3b92c83d3bu }, { 0x2bcf0e7f14072d2eu, 0x1c34c70a777a4c8au },
+	{ 0x5b61690f6c847c3du, 0x11a0fc668aac6fd6u }, { 0xf239c35347a59b4cu, 0x16093b802d578bcbu },
+	{ 0xeec83428198f021fu, 0x1b8b8a6038ad6ebeu }, { 0x553d20990ff96153u, 0x1137367c236c6537u },
+	{ 0x2a8c68bf53f7b9a8u, 0x1585041b2c477e85u }, { 0x752f82ef28f5a812u, 0x1ae64521f7595e26u },
+	{ 0x093db1d57999890bu, 0x10cfeb353a97dad8u }, { 0x0b8d1e4ad7ffeb4eu, 0x1503e602893dd18eu },
+	{ 0x8e7065dd8dffe622u, 0x1a44df832b8d45f1u }, { 0xf9063faa78bfefd5u, 0x106b0bb1fb384bb6u },
+	{ 0xb747cf9516efebcau, 0x1485ce9e7a065ea4u }, { 0xe519c37a5cabe6bdu, 0x19a742461887f64du },
+	{ 0xaf301a2c79eb7036u, 0x1008896bcf54f9f0u }, { 0xdafc20b798664c43u, 0x140aabc6c32a386cu },
+	{ 0x11bb28e57e7fdf54u, 0x190d56b873f4c688u }, { 0x1629f31ede1fd72au, 0x1f50ac6690f1f82au },
+	{ 0x4dda37f34ad3e67au, 0x13926bc01a973b1au }, { 0xe150c5f01d88e019u, 0x187706b0213d09e0u },
+	{ 0x19a4f76c24eb181fu, 0x1e94c85c298c4c59u }, { 0xb0071aa39712ef13u, 0x131cfd3999f7afb7u },
+	{ 0x9c08e14c7cd7aad8u, 0x17e43c8800759ba5u }, { 0x030b199f9c0d958eu, 0x1ddd4baa0093028fu },
+	{ 0x61e6f003c1887d79u, 0x12aa4f4a405be199u }, { 0xba60ac04b1ea9cd7u, 0x1754e31cd072d9ffu },
+	{ 0xa8f8d705de65440du, 0x1d2a1be4048f907fu }, { 0xc99b8663aaff4a88u, 0x123a516e82d9ba4fu },
+	{ 0xbc0267fc95bf1d2au, 0x16c8e5ca239028e3u }, { 0xab0301fbbb2ee474u, 0x1c7b1f3cac74331cu },
+	{ 0xeae1e13d54fd4ec9u, 0x11ccf385ebc89ff1u }, { 0x659a598caa3ca27bu, 0x1640306766bac7eeu },
+	{ 0xff00efefd4cbcb1au, 0x1bd03c81406979e9u }, { 0x3f6095f5e4ff5ef0u, 0x116225d0c841ec32u },
+	{ 0xcf38bb735e3f36acu, 0x15baaf44fa52673eu }, { 0x8306ea5035cf0457u, 0x1b295b1638e7010eu },
+	{ 0x11e4527221a162b6u, 0x10f9d8ede39060a9u }, { 0x565d670eaa09bb64u, 0x15384f295c7478d3u },
+	{ 0x2bf4c0d2548c2a3du, 0x1a8662f3b3919708u }, { 0x1b78f88374d79a66u, 0x1093fdd8503afe65u },
+	{ 0x625736a4520d8100u, 0x14b8fd4e6449bdfeu }, { 0xfaed044d6690e140u, 0x19e73ca1fd5c2d7du },
+	{ 0xbcd422b0601a8cc8u, 0x103085e53e599c6eu }, { 0x6c092b5c78212ffau, 0x143ca75e8df0038au },
+	{ 0x070b763396297bf8u, 0x194bd136316c046du }, { 0x48ce53c07bb3daf6u, 0x1f9ec583bdc70588u },
+	{ 0x2d80f4584d5068dau, 0x13c33b72569c6375u }, { 0x78e1316e60a48310u, 0x18b40a4eec437c52u }
+};
+
+typedef struct {
+	uint64_t digits;   // decimal significand, no trailing zeros guaranteed
+	int32_t exp;       // value is digits * 10^exp
+} __jacl_ryu_t;
+
+static inline int32_t __jacl_ryu_pow5bits(int32_t e) { return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1; }
+static inline uint32_t __jacl_ryu_log10p2(int32_t e) { return ((uint32_t)e * 78913) >> 18; }
+static inline uint32_t __jacl_ryu_log10p5(int32_t e) { return ((uint32_t)e * 732923) >> 20; }
+static inline int __jacl_ryu_pow5of(uint64_t v, uint32_t p) {
+	uint32_t n = 0;
+
+	while (v % 5 == 0) { v /= 5; n++; }
+
+	return n >= p;
+}
+static inline uint64_t __jacl_ryu_mulshift(uint64_t m, const uint64_t *mul, int32_t j) {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t b0 = (__uint128_t)m * mul[0], b2 = (__uint128_t)m * mul[1];
+
+	return (uint64_t)(((b0 >> 64) + b2) >> (j - 64));
+#else
+	uint64_t ml = (uint32_t)m, mh = m >> 32, hi0, hi2, lo2, t, c;
+
+	// high half of m * mul[0]
+	t = ml * (uint32_t)mul[0];
+	t = mh * (uint32_t)mul[0] + (t >> 32);
+	c = ml * (mul[0] >> 32) + (uint32_t)t;
+	hi0 = mh * (mul[0] >> 32) + (t >> 32) + (c >> 32);
+
+	// full m * mul[1]
+	t = ml * (uint32_t)mul[1];
+	lo2 = (uint32_t)t;
+	t = mh * (uint32_t)mul[1] + (t >> 32);
+	c = ml * (mul[1] >> 32) + (uint32_t)t;
+	lo2 |= c << 32;
+	hi2 = mh * (mul[1] >> 32) + (t >> 32) + (c >> 32);
+
+	// (hi0 + (hi2:lo2)) >> (j - 64)
+	lo2 += hi0;
+	hi2 += lo2 < hi0;
+	j -= 64;
+
+	return j >= 64 ? hi2 >> (j - 64) : (hi2 << (64 - j)) | (lo2 >> j);
+#endif
+}
+
+/**
+ * Shortest decimal for m2 * 2^e2, where the caller has already subtracted
+ * 2 from the binary exponent (Ryu works on 4 * m2 so both interval ends stay
+ * integral). `mmshift` is 0 only when m2 is a power of two above the
+ * smallest normal, where the gap below is half the gap above.
+ */
+static inline __jacl_ryu_t __jacl_ryu(uint64_t m2, int32_t e2, int mmshift) {
+	uint64_t mv = 4 * m2, vr, vp, vm, out;
+	int even = !(m2 & 1), vm_zeros = 0, vr_zeros = 0, removed = 0, up = 0;
+	int32_t e10;
+	uint8_t last = 0;
+
+	if (e2 >= 0) {
+		uint32_t q = __jacl_ryu_log10p2(e2) - (e2 > 3);
+		int32_t k = JACL_RYU_INV_BITS + __jacl_ryu_pow5bits((int32_t)q) - 1, i = -e2 + (int32_t)q + k;
+
+		e10 = (int32_t)q;
+		vr = __jacl_ryu_mulshift(mv, __jacl_ryu_pow5_inv[q], i);
+		vp = __jacl_ryu_mulshift(mv + 2, __jacl_ryu_pow5_inv[q], i);
+		vm = __jacl_ryu_mulshift(mv - 1 - mmshift, __jacl_ryu_pow5_inv[q], i);
+
+		if (q <= 21) {
+			if (mv % 5 == 0) vr_zeros = __jacl_ryu_pow5of(mv, q);
+			else if (even) vm_zeros = __jacl_ryu_pow5of(mv - 1 - mmshift, q);
+			else vp -= __jacl_ryu_pow5of(mv + 2, q);
+		}
+	} else {
+		uint32_t q = __jacl_ryu_log10p5(-e2) - (-e2 > 1);
+		int32_t i = -e2 - (int32_t)q, k = __jacl_ryu_pow5bits(i) - JACL_RYU_POW_BITS, j = (int32_t)q - k;
+
+		e10 = (int32_t)q + e2;
+		vr = __jacl_ryu_mulshift(mv, __jacl_ryu_pow5[i], j);
+		vp = __jacl_ryu_mulshift(mv + 2, __jacl_ryu_pow5[i], j);
+		vm = __jacl_ryu_mulshift(mv - 1 - mmshift, __jacl_ryu_pow5[i], j);
+
+		if (q <= 1) {
+			vr_zeros = 1;
+
+			if (even) vm_zeros = mmshift == 1;
+			else --vp;
+		} else if (q < 63) vr_zeros = !(mv & ((1ULL << q) - 1));
+	}
+
+	if (vm_zeros || vr_zeros) {
+		// rare: the interval ends or the value itself end in zeros
+		for (; vp / 10 > vm / 10; removed++) {
+			vm_zeros &= vm % 10 == 0;
+			vr_zeros &= last == 0;
+			last = (uint8_t)(vr % 10);
+			vr /= 10; vp /= 10; vm /= 10;
+		}
+
+		if (vm_zeros) {
+			for (; vm % 10 == 0; removed++) {
+				vr_zeros &= last == 0;
+				last = (uint8_t)(vr % 10);
+				vr /= 10; vp /= 10; vm /= 10;
+			}
+		}
+
+		if (vr_zeros && last == 5 && vr % 2 == 0) last = 4;
+
+		out = vr + ((vr == vm && (!even || !vm_zeros)) || last >= 5);
+	} else {
+		if (vp / 100 > vm / 100) {
+			up = vr % 100 >= 50;
+			vr /= 100; vp /= 100; vm /= 100;
+			removed += 2;
+		}
+
+		for (; vp / 10 > vm / 10; removed++) {
+			up = vr % 10 >= 5;
+			vr /= 10; vp /= 10; vm /= 10;
+		}
+
+		out = vr + (vr == vm || up);
+	}
+
+	return (__jacl_ryu_t){ out, e10 + removed };
+}
+static inline __jacl_ryu_t __jacl_ryu_DBL(double x) {
+	union { double f; DBL_UTYPE u; } a = { .f = x };
+	uint64_t mant = a.u & ((1ULL << DBL_EXP_LSB) - 1);
+	int32_t be = (int32_t)((a.u >> DBL_EXP_LSB) & DBL_EXP_MASK);
+
+	return __jacl_ryu(be ? mant | (1ULL << DBL_EXP_LSB) : mant, (be ? be : 1) - DBL_EXP_BIAS - DBL_EXP_LSB - 2, mant != 0 || be <= 1);
+}
+static inline __jacl_ryu_t __jacl_ryu_FLT(float x) {
+	union { float f; FLT_UTYPE u; } a = { .f = x };
+	uint64_t mant = a.u & ((1U << FLT_EXP_LSB) - 1);
+	int32_t be = (int32_t)((a.u >> FLT_EXP_LSB) & FLT_EXP_MASK);
+
+	return __jacl_ryu(be ? mant | (1U << FLT_EXP_LSB) : mant, (be ? be : 1) - FLT_EXP_BIAS - FLT_EXP_LSB - 2, mant != 0 || be <= 1);
+}
+
+/**
+ * Every significant digit of m * 2^e2 (m > 0) into buf, which needs
+ * JACL_FEXACT_DIGITS bytes. Trailing zeros are dropped; *dexp gets the
+ * power of ten of the first digit. For e2 < 0 the value is m * 5^-e2 shifted
+ * -e2 decimal places, so the expansion is always finite.
+ */
+static inline int __jacl_fexact(uint64_t m, int32_t e2, char *buf, int *dexp) {
+	uint32_t big[JACL_FEXACT_LIMBS] = { (uint32_t)m, (uint32_t)(m >> 32) }, chunk[JACL_FEXACT_LIMBS + 8];
+	int n = big[1] ? 2 : 1, point = 0, chunks = 0, len = 0, i;
+
+	if (e2 >= 0) {
+		int limbs = e2 / 32, bits = e2 % 32;
+
+		if (bits) {
+			uint32_t carry = 0;
+
+			for (i = 0; i < n; i++) { uint32_t v = big[i]; big[i] = (v << bits) | carry; carry = v >> (32 - bits); }
+			if (carry) big[n++] = carry;
+		}
+		if (limbs) {
+			for (i = n - 1; i >= 0; i--) big[i + limbs] = big[i];
+			for (i = 0; i < limbs; i++) big[i] = 0;
+
+			n += limbs;
+		}
+	} else {
+		static const uint32_t pow5[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625, 1220703125 };
+
+		for (point = -e2; e2 < 0; e2 += 13) {
+			uint64_t mul = pow5[-e2 < 13 ? -e2 : 13], carry = 0;
+
+			for (i = 0; i < n; i++) { carry += (uint64_t)big[i] * mul; big[i] = (uint32_t)carry; carry >>= 32; }
+			if (carry) big[n++] = (uint32_t)carry;
+		}
+	}
+
+	// peel off nine decimal digits at a time, least significant first
+	while (n) {
+		uint64_t rem = 0;
+
+		for (i = n - 1; i >= 0; i--) { rem = (rem << 32) | big[i]; big[i] = (uint32_t)(rem / 1000000000u); rem %= 1000000000u; }
+		while (n && !big[n - 1]) n--;
+
+		chunk[chunks++] = (uint32_t)rem;
+	}
+
+	for (uint32_t v = chunk[--chunks]; v; v /= 10) len++;
+	for (i = len - 1; i >= 0; i--) { buf[i] = '0' + chunk[chunks] % 10; chunk[chunks] /= 10; }
+
+	while (chunks--) {
+		for (i = 8; i >= 0; i--) { buf[len + i] = '0' + chunk[chunks] % 10; chunk[chunks] /= 10; }
+
+		len += 9;
+	}
+
+	*dexp = len - 1 - point;
+
+	while (len > 1 && buf[len - 1] == '0') len--;
+
+	return len;
+}
+
 typedef struct {
-	char digits[40];   // 40 bytes - ASCII digits '0'-'9' (forward order)
-	uint8_t start;     // 1 byte  - first significant digit index
-	uint8_t end;       // 1 byte  - past last digit
-	int16_t exp;       // 2 bytes - decimal exponent
-	uint8_t sign;      // 1 byte  - 0=positive, 1=negative
-	uint8_t _pad;      // 1 byte  - alignment
-} __jacl_fdigits_t;  // Total: 46 bytes
+	char digits[JACL_FEXACT_DIGITS]; // ASCII digits '0'-'9' (forward order)
+	uint16_t start;    // first significant digit index
+	uint16_t end;      // past last digit
+	int16_t exp;       // decimal exponent
+	uint8_t sign;      // 0=positive, 1=negative
+	uint8_t _pad;      // alignment
+} __jacl_fdigits_t;
+
+/**
+ * Round d[0..n) (first digit at 10^*exp) to `keep` digits, half to even,
+ * and return the new digit count. keep < 1 leaves "0" or a lone "1".
+ */
+static inline int __jacl_fdigits_round(char *d, int n, int keep, int *exp) {
+	int up, i;
+
+	if (keep >= n) return n;
+	if (keep < 0) { d[0] = '0'; *exp = 0; return 1; }
+	if (keep == 0) {
+		up = d[0] > '5' || (d[0] == '5' && n > 1);
+		d[0] = up ? '1' : '0';
+		*exp = up ? *exp + 1 : 0;
+
+		return 1;
+	}
+
+	up = d[keep] > '5' || (d[keep] == '5' && (n > keep + 1 || ((d[keep - 1] - '0') & 1)));
+
+	if (up) {
+		for (i = keep - 1; i >= 0 && d[i] == '9'; i--) d[i] = '0';
+
+		if (i < 0) { d[0] = '1'; (*exp)++; return 1; }
+
+		d[i]++;
+	}
+
+	return keep;
+}
+
+/**
+ * Digits of a double, rounded to `sig` significant digits or, with sig 0,
+ * to `prec` places after the point. For normal numbers the shortest string
+ * is enough whenever the cut falls within DBL_DIG digits of its start: the
+ * exact value is then less than half a unit of the last kept digit away, so
+ * both round the same unless the shortest string ends in exactly that half.
+ */
+static inline void __jacl_fdigits_DBL(__jacl_fdigits_t *fd, double val, int prec, int sig) {
+	union { double f; DBL_UTYPE u; } a = { .f = val };
+	uint64_t mant = a.u & ((1ULL << DBL_EXP_LSB) - 1);
+	int32_t be = (int32_t)((a.u >> DBL_EXP_LSB) & DBL_EXP_MASK);
+	__jacl_ryu_t r = __jacl_ryu_DBL(val);
+	char *d = fd->digits;
+	int n = 0, exp, keep;
+
+	for (uint64_t v = r.digits; v; v /= 10) n++;
+	for (int i = n - 1; i >= 0; i--) { d[i] = '0' + r.digits % 10; r.digits /= 10; }
+
+	exp = r.exp + n - 1;
+	keep = sig > 0 ? sig : exp + 1 + prec;
+
+	if (!be || keep > DBL_DIG || (keep >= 0 && n == keep + 1 && d[keep] == '5')) {
+		n = __jacl_fexact(be ? mant | (1ULL << DBL_EXP_LSB) : mant, (be ? be : 1) - DBL_EXP_BIAS - DBL_EXP_LSB, d, &exp);
+		keep = sig > 0 ? sig : exp + 1 + prec;
+	}
+
+	fd->end = (uint16_t)__jacl_fdigits_round(d, n, keep, &exp);
+	fd->exp = (int16_t)exp;
+}
 
 static inline __jacl_fdigits_t __jacl_fdigits(long double val, int prec, int sig, int is_ldbl) {
-	int exp, needed, pos = 39, max = (is_ldbl) ? LDBL_DIG : DBL_DIG;
-	__jacl_fdigits_t fdigits = {0};
+	int exp, needed, pos = JACL_FEXACT_DIGITS - 1, max = (is_ldbl) ? LDBL_DIG : DBL_DIG;
+	__jacl_fdigits_t fdigits;
 	JACL_LDBL_INT scaled;
 	long double scale = 1.0L;
 
+	fdigits.start = fdigits.end = 0;
+	fdigits.digits[0] = '\0';
+	fdigits.exp = 0;
 	fdigits.sign = __jacl_signget_LDBL(val);
 
 	if (fdigits.sign) val = __jacl_signclr_LDBL(val);
 	if (val == 0.0L) { fdigits.digits[0] = '0'; fdigits.end = 1; return fdigits; }
 	if (val != val) { fdigits.digits[0] = 'n'; return fdigits; }
 	if ((val - val) != (val - val)) { fdigits.digits[0] = 'i'; return fdigits; }
+	if (!is_ldbl || LDBL_MANT_DIG == DBL_MANT_DIG) { __jacl_fdigits_DBL(&fdigits, (double)val, prec, sig); return fdigits; }
 
 	// O(log N) normalization for extreme exponents
 	if (val >= 10.0L) {
@@ -959,11 +1580,571 @@ static inline __jacl_fdigits_t __jacl_fdigits(long double val, int prec, int sig
 	else while (scaled > 0 && pos >= 0) { fdigits.digits[pos--] = '0' + (scaled % 10); scaled /= 10; }
 
 	fdigits.start = pos + 1;
-	fdigits.end = 40;
+	fdigits.end = JACL_FEXACT_DIGITS;
 
 	return fdigits;
 }
 
+
+// ========== DECIMAL TO BINARY ============
+/**
+ * NOTE: strtod, strtof, scanf and the JSON reader all end up here with the
+ * digits already gathered into a __jacl_decimal_t: the first 19 significant
+ * digits in w and a power of ten q. __jacl_lemire() is the Eisel-Lemire
+ * algorithm: w * 10^q against a 128-bit truncated power of five settles the
+ * correctly rounded result with one or two 64x64 multiplies, whatever the
+ * range. That is exact for w itself, so only when digits past the 19th were
+ * dropped and w and w + 1 round to different floats does __jacl_decimal_cmp()
+ * walk the full digit string and compare it with the halfway point in a
+ * bignum. Wide long double has no such path and scales w by POW10_EXP2.
+ */
+#define JACL_LEMIRE_QMIN    (-342)
+#define JACL_LEMIRE_QMAX    308
+#define JACL_BIGNUM_LIMBS   128
+
+static const uint64_t __jacl_lemire_pow5[JACL_LEMIRE_QMAX - JACL_LEMIRE_QMIN + 1][2] = {
+	{ 0x113faa2906a13b3fu, 0xeef453d6923bd65au }, { 0x4ac7ca59a424c507u, 0x9558b4661b6565f8u },
+	{ 0x5d79bcf00d2df649u, 0xbaaee17fa23ebf76u }, { 0xf4d82c2c107973dcu, 0xe95a99df8ace6f53u },
+	{ 0x79071b9b8a4be869u, 0x91d8a02bb6c10594u }, { 0x9748e2826cdee284u, 0xb64ec836a47146f9u },
+	{ 0xfd1b1b2308169b25u, 0xe3e27a444d8d98b7u }, { 0xfe30f0f5e50e20f7u, 0x8e6d8c6ab0787f72u },
+	{ 0xbdbd2d335e51a935u, 0xb208ef855c969f4fu }, { 0xad2c788035e61382u, 0xde8b2b66b3bc4723u },
+	{ 0x4c3bcb5021afcc31u, 0x8b16fb203055ac76u }, { 0xdf4abe242a1bbf3du, 0xaddcb9e83c6b1793u },
+	{ 0xd71d6dad34a2af0du, 0xd953e8624b85dd78u }, { 0x8672648c40e5ad68u, 0x87d4713d6f33aa6bu },
+	{ 0x680efdaf511f18c2u, 0xa9c98d8ccb009506u }, { 0x0212bd1b2566def2u, 0xd43bf0effdc0ba48u },
+	{ 0x014bb630f7604b57u, 0x84a57695fe98746du }, { 0x419ea3bd35385e2du, 0xa5ced43b7e3e9188u },
+	{ 0x52064cac828675b9u, 0xcf42894a5dce35eau }, { 0x7343efebd1940993u, 0x818995ce7aa0e1b2u },
+	{ 0x1014ebe6c5f90bf8u, 0xa1ebfb4219491a1fu }, { 0xd41a26e077774ef6u, 0xca66fa129f9b60a6u },
+	{ 0x8920b098955522b4u, 0xfd00b897478238d0u }, { 0x55b46e5f5d5535b0u, 0x9e20735e8cb16382u },
+	{ 0xeb2189f734aa831du, 0xc5a890362fddbc62u }, { 0xa5e9ec7501d523e4u, 0xf712b443bbd52b7bu },
+	{ 0x47b233c92125366eu, 0x9a6bb0aa55653b2du }, { 0x999ec0bb696e840au, 0xc1069cd4eabe89f8u },
+	{ 0xc00670ea43ca250du, 0xf148440a256e2c76u }, { 0x380406926a5e5728u, 0x96cd2a865764dbcau },
+	{ 0xc605083704f5ecf2u, 0xbc807527ed3e12bcu }, { 0xf7864a44c633682eu, 0xeba09271e88d976bu },
+	{ 0x7ab3ee6afbe0211du, 0x93445b8731587ea3u }, { 0x5960ea05bad82964u, 0xb8157268fdae9e4cu },
+	{ 0x6fb92487298e33bdu, 0xe61acf033d1a45dfu }, { 0xa5d3b6d479f8e056u, 0x8fd0c16206306babu },
+	{ 0x8f48a4899877186cu, 0xb3c4f1ba87bc8696u }, { 0x331acdabfe94de87u, 0xe0b62e2929aba83cu },
+	{ 0x9ff0c08b7f1d0b14u, 0x8c71dcd9ba0b4925u }, { 0x07ecf0ae5ee44dd9u, 0xaf8e5410288e1b6fu },
+	{ 0xc9e82cd9f69d6150u, 0xdb71e91432b1a24au }, { 0xbe311c083a225cd2u, 0x892731ac9faf056eu },
+	{ 0x6dbd630a48aaf406u, 0xab70fe17c79ac6cau }, { 0x092cbbccdad5b108u, 0xd64d3d9db981787du },
+	{ 0x25bbf56008c58ea5u, 0x85f0468293f0eb4eu }, { 0xaf2af2b80af6f24eu, 0xa76c582338ed2621u },
+	{ 0x1af5af660db4aee1u, 0xd1476e2c07286faau }, { 0x50d98d9fc890ed4du, 0x82cca4db847945cau },
+	{ 0xe50ff107bab528a0u, 0xa37fce126597973cu }, { 0x1e53ed49a96272c8u, 0xcc5fc196fefd7d0cu },
+	{ 0x25e8e89c13bb0f7au, 0xff77b1fcbebcdc4fu }, { 0x77b191618c54e9acu, 0x9faacf3df73609b1u },
+	{ 0xd59df5b9ef6a2417u, 0xc795830d75038c1du }, { 0x4b0573286b44ad1du, 0xf97ae3d0d2446f25u },
+	{ 0x4ee367f9430aec32u, 0x9becce62836ac577u }, { 0x229c41f793cda73fu, 0xc2e801fb244576d5u },
+	{ 0x6b43527578c1110fu, 0xf3a20279ed56d48au }, { 0x830a13896b78aaa9u, 0x9845418c345644d6u },
+	{ 0x23cc986bc656d553u, 0xbe5691ef416bd60cu }, { 0x2cbfbe86b7ec8aa8u, 0xedec366b11c6cb8fu },
+	{ 0x7bf7d71432f3d6a9u, 0x94b3a202eb1c3f39u }, { 0xdaf5ccd93fb0cc53u, 0xb9e08a83a5e34f07u },
+	{ 0xd1b3400f8f9cff68u, 0xe858ad248f5c22c9u }, { 0x23100809b9c21fa1u, 0x91376c36d99995beu },
+	{ 0xabd40a0c2832a78au, 0xb58547448ffffb2du }, { 0x16c90c8f323f516cu, 0xe2e69915b3fff9f9u },
+	{ 0xae3da7d97f6792e3u, 0x8dd01fad907ffc3bu }, { 0x99cd11cfdf41779cu, 0xb1442798f49ffb4au },
+	{ 0x40405643d711d583u, 0xdd95317f31c7fa1du }, { 0x482835ea666b2572u, 0x8a7d3eef7f1cfc52u },
+	{ 0xda3243650005eecfu, 0xad1c8eab5ee43b66u }, { 0x90bed43e40076a82u, 0xd863b256369d4a40u },
+	{ 0x5a7744a6e804a291u, 0x873e4f75e2224e68u }, { 0x711515d0a205cb36u, 0xa90de3535aaae202u },
+	{ 0x0d5a5b44ca873e03u, 0xd3515c2831559a83u }, { 0xe858790afe9486c2u, 0x8412d9991ed58091u },
+	{ 0x626e974dbe39a872u, 0xa5178fff668ae0b6u }, { 0xfb0a3d212dc8128fu, 0xce5d73ff402d98e3u },
+	{ 0x7ce66634bc9d0b99u, 0x80fa687f881c7f8eu }, { 0x1c1fffc1ebc44e80u, 0xa139029f6a239f72u },
+	{ 0xa327ffb266b56220u, 0xc987434744ac874eu }, { 0x4bf1ff9f0062baa8u, 0xfbe9141915d7a922u },
+	{ 0x6f773fc3603db4a9u, 0x9d71ac8fada6c9b5u }, { 0xcb550fb4384d21d3u, 0xc4ce17b399107c22u },
+	{ 0x7e2a53a146606a48u, 0xf6019da07f549b2bu }, { 0x2eda7444cbfc426du, 0x99c102844f94e0fbu },
+	{ 0xfa911155fefb5308u, 0xc0314325637a1939u }, { 0x793555ab7eba27cau, 0xf03d93eebc589f88u },
+	{ 0x4bc1558b2f3458deu, 0x96267c7535b763b5u }, { 0x9eb1aaedfb016f16u, 0xbbb01b9283253ca2u },
+	{ 0x465e15a979c1cadcu, 0xea9c227723ee8bcbu }, { 0x0bfacd89ec191ec9u, 0x92a1958a7675175fu },
+	{ 0xcef980ec671f667bu, 0xb749faed14125d36u }, { 0x82b7e12780e7401au, 0xe51c79a85916f484u },
+	{ 0xd1b2ecb8b0908810u, 0x8f31cc0937ae58d2u }, { 0x861fa7e6dcb4aa15u, 0xb2fe3f0b8599ef07u },
+	{ 0x67a791e093e1d49au, 0xdfbdcece67006ac9u }, { 0xe0c8bb2c5c6d24e0u, 0x8bd6a141006042bdu },
+	{ 0x58fae9f773886e18u, 0xaecc49914078536du }, { 0xaf39a475506a899eu, 0xda7f5bf590966848u },
+	{ 0x6d8406c952429603u, 0x888f99797a5e012du }, { 0xc8e5087ba6d33b83u, 0xaab37fd7d8f58178u },
+	{ 0xfb1e4a9a90880a64u, 0xd5605fcdcf32e1d6u }, { 0x5cf2eea09a55067fu, 0x855c3be0a17fcd26u },
+	{ 0xf42faa48c0ea481eu, 0xa6b34ad8c9dfc06fu }, { 0xf13b94daf124da26u, 0xd0601d8efc57b08bu },
+	{ 0x76c53d08d6b70858u, 0x823c12795db6ce57u }, { 0x54768c4b0c64ca6eu, 0xa2cb1717b52481edu },
+	{ 0xa9942f5dcf7dfd09u, 0xcb7ddcdda26da268u }, { 0xd3f93b35435d7c4cu, 0xfe5d54150b090b02u },
+	{ 0xc47bc5014a1a6dafu, 0x9efa548d26e5a6e1u }, { 0x359ab6419ca1091bu, 0xc6b8e9b0709f109au },
+	{ 0xc30163d203c94b62u, 0xf867241c8cc6d4c0u }, { 0x79e0de63425dcf1du, 0x9b407691d7fc44f8u },
+	{ 0x985915fc12f542e4u, 0xc21094364dfb5636u }, { 0x3e6f5b7b17b2939du, 0xf294b943e17a2bc4u },
+	{ 0xa705992ceecf9c42u, 0x979cf3ca6cec5b5au }, { 0x50c6ff782a838353u, 0xbd8430bd08277231u },
+	{ 0xa4f8bf5635246428u, 0xece53cec4a314ebdu }, { 0x871b7795e136be99u, 0x940f4613ae5ed136u },
+	{ 0x28e2557b59846e3fu, 0xb913179899f68584u }, { 0x331aeada2fe589cfu, 0xe757dd7ec07426e5u },
+	{ 0x3ff0d2c85def7621u, 0x9096ea6f3848984fu }, { 0x0fed077a756b53a9u, 0xb4bca50b065abe63u },
+	{ 0xd3e8495912c62894u, 0xe1ebce4dc7f16dfbu }, { 0x64712dd7abbbd95cu, 0x8d3360f09cf6e4bdu },
+	{ 0xbd8d794d96aacfb3u, 0xb080392cc4349decu }, { 0xecf0d7a0fc5583a0u, 0xdca04777f541c567u },
+	{ 0xf41686c49db57244u, 0x89e42caaf9491b60u }, { 0x311c2875c522ced5u, 0xac5d37d5b79b6239u },
+	{ 0x7d633293366b828bu, 0xd77485cb25823ac7u }, { 0xae5dff9c02033197u, 0x86a8d39ef77164bcu },
+	{ 0xd9f57f830283fdfcu, 0xa8530886b54dbdebu }, { 0xd072df63c324fd7bu, 0xd267caa862a12d66u },
+	{ 0x4247cb9e59f71e6du, 0x8380dea93da4bc60u }, { 0x52d9be85f074e608u, 0xa46116538d0deb78u },
+	{ 0x67902e276c921f8bu, 0xcd795be870516656u }, { 0x00ba1cd8a3db53b6u, 0x806bd9714632dff6u },
+	{ 0x80e8a40eccd228a4u, 0xa086cfcd97bf97f3u }, { 0x6122cd128006b2cdu, 0xc8a883c0fdaf7df0u },
+	{ 0x796b805720085f81u, 0xfad2a4b13d1b5d6cu }, { 0xcbe3303674053bb0u, 0x9cc3a6eec6311a63u },
+	{ 0xbedbfc4411068a9cu, 0xc3f490aa77bd60fcu }, { 0xee92fb5515482d44u, 0xf4f1b4d515acb93bu },
+	{ 0x751bdd152d4d1c4au, 0x991711052d8bf3c5u }, { 0xd262d45a78a0635du, 0xbf5cd54678eef0b6u },
+	{ 0x86fb897116c87c34u, 0xef340a98172aace4u }, { 0xd45d35e6ae3d4da0u, 0x9580869f0e7aac0eu },
+	{ 0x8974836059cca109u, 0xbae0a846d2195712u }, { 0x2bd1a438703fc94bu, 0xe998d258869facd7u },
+	{ 0x7b6306a34627ddcfu, 0x91ff83775423cc06u }, { 0x1a3bc84c17b1d542u, 0xb67f6455292cbf08u },
+	{ 0x20caba5f1d9e4a93u, 0xe41f3d6a7377eecau }, { 0x547eb47b7282ee9cu, 0x8e938662882af53eu },
+	{ 0xe99e619a4f23aa43u, 0xb23867fb2a35b28du }, { 0x6405fa00e2ec94d4u, 0xdec681f9f4c31f31u },
+	{ 0xde83bc408dd3dd04u, 0x8b3c113c38f9f37eu }, { 0x9624ab50b148d445u, 0xae0b158b4738705eu },
+	{ 0x3badd624dd9b0957u, 0xd98ddaee19068c76u }, { 0xe54ca5d70a80e5d6u, 0x87f8a8d4cfa417c9u },
+	{ 0x5e9fcf4ccd211f4cu, 0xa9f6d30a038d1dbcu }, { 0x7647c3200069671fu, 0xd47487cc8470652bu },
+	{ 0x29ecd9f40041e073u, 0x84c8d4dfd2c63f3bu }, { 0xf468107100525890u, 0xa5fb0a17c777cf09u },
+	{ 0x7182148d4066eeb4u, 0xcf79cc9db955c2ccu }, { 0xc6f14cd848405530u, 0x81ac1fe293d599bfu },
+	{ 0xb8ada00e5a506a7cu, 0xa21727db38cb002fu }, { 0xa6d90811f0e4851cu, 0xca9cf1d206fdc03bu },
+	{ 0x908f4a166d1da663u, 0xfd442e4688bd304au }, { 0x9a598e4e043287feu, 0x9e4a9cec15763e2eu },
+	{ 0x40eff1e1853f29fdu, 0xc5dd44271ad3cdbau }, { 0xd12bee59e68ef47cu, 0xf7549530e188c128u },
+	{ 0x82bb74f8301958ceu, 0x9a94dd3e8cf578b9u }, { 0xe36a52363c1faf01u, 0xc13a148e3032d6e7u },
+	{ 0xdc44e6c3cb279ac1u, 0xf18899b1bc3f8ca1u }, { 0x29ab103a5ef8c0b9u, 0x96f5600f15a7b7e5u },
+	{ 0x7415d448f6b6f0e7u, 0xbcb2b812db11a5deu }, { 0x111b495b3464ad21u, 0xebdf661791d60f56u },
+	{ 0xcab10dd900beec34u, 0x936b9fcebb25c995u }, { 0x3d5d514f40eea742u, 0xb84687c269ef3bfbu },
+	{ 0x0cb4a5a3112a5112u, 0xe65829b3046b0afau }, { 0x47f0e785eaba72abu, 0x8ff71a0fe2c2e6dcu },
+	{ 0x59ed216765690f56u, 0xb3f4e093db73a093u }, { 0x306869c13ec3532cu, 0xe0f218b8d25088b8u },
+	{ 0x1e414218c73a13fbu, 0x8c974f7383725573u }, { 0xe5d1929ef90898fau, 0xafbd2350644eeacfu },
+	{ 0xdf45f746b74abf39u, 0xdbac6c247d62a583u }, { 0x6b8bba8c328eb783u, 0x894bc396ce5da772u },
+	{ 0x066ea92f3f326564u, 0xab9eb47c81f5114fu }, { 0xc80a537b0efefebdu, 0xd686619ba27255a2u },
+	{ 0xbd06742ce95f5f36u, 0x8613fd0145877585u }, { 0x2c48113823b73704u, 0xa798fc4196e952e7u },
+	{ 0xf75a15862ca504c5u, 0xd17f3b51fca3a7a0u }, { 0x9a984d73dbe722fbu, 0x82ef85133de648c4u },
+	{ 0xc13e60d0d2e0ebbau, 0xa3ab66580d5fdaf5u }, { 0x318df905079926a8u, 0xcc963fee10b7d1b3u },
+	{ 0xfdf17746497f7052u, 0xffbbcfe994e5c61fu }, { 0xfeb6ea8bedefa633u, 0x9fd561f1fd0f9bd3u },
+	{ 0xfe64a52ee96b8fc0u, 0xc7caba6e7c5382c8u }, { 0x3dfdce7aa3c673b0u, 0xf9bd690a1b68637bu },
+	{ 0x06bea10ca65c084eu, 0x9c1661a651213e2du }, { 0x486e494fcff30a62u, 0xc31bfa0fe5698db8u },
+	{ 0x5a89dba3c3efccfau, 0xf3e2f893dec3f126u }, { 0xf89629465a75e01cu, 0x986ddb5c6b3a76b7u },
+	{ 0xf6bbb397f1135823u, 0xbe89523386091465u }, { 0x746aa07ded582e2cu, 0xee2ba6c0678b597fu },
+	{ 0xa8c2a44eb4571cdcu, 0x94db483840b717efu }, { 0x92f34d62616ce413u, 0xba121a4650e4ddebu },
+	{ 0x77b020baf9c81d17u, 0xe896a0d7e51e1566u }, { 0x0ace1474dc1d122eu, 0x915e2486ef32cd60u },
+	{ 0x0d819992132456bau, 0xb5b5ada8aaff80b8u }, { 0x10e1fff697ed6c69u, 0xe3231912d5bf60e6u },
+	{ 0xca8d3ffa1ef463c1u, 0x8df5efabc5979c8fu }, { 0xbd308ff8a6b17cb2u, 0xb1736b96b6fd83b3u },
+	{ 0xac7cb3f6d05ddbdeu, 0xddd0467c64bce4a0u }, { 0x6bcdf07a423aa96bu, 0x8aa22c0dbef60ee4u },
+	{ 0x86c16c98d2c953c6u, 0xad4ab7112eb3929du }, { 0xe871c7bf077ba8b7u, 0xd89d64d57a607744u },
+	{ 0x11471cd764ad4972u, 0x87625f056c7c4a8bu }, { 0xd598e40d3dd89bcfu, 0xa93af6c6c79b5d2du },
+	{ 0x4aff1d108d4ec2c3u, 0xd389b47879823479u }, { 0xcedf722a585139bau, 0x843610cb4bf160cbu },
+	{ 0xc2974eb4ee658828u, 0xa54394fe1eedb8feu }, { 0x733d226229feea32u, 0xce947a3da6a9273eu },
+	{ 0x0806357d5a3f525fu, 0x811ccc668829b887u }, { 0xca07c2dcb0cf26f7u, 0xa163ff802a3426a8u },
+	{ 0xfc89b393dd02f0b5u, 0xc9bcff6034c13052u }, { 0xbbac2078d443ace2u, 0xfc2c3f3841f17c67u },
+	{ 0xd54b944b84aa4c0du, 0x9d9ba7832936edc0u }, { 0x0a9e795e65d4df11u, 0xc5029163f384a931u },
+	{ 0x4d4617b5ff4a16d5u, 0xf64335bcf065d37du }, { 0x504bced1bf8e4e45u, 0x99ea0196163fa42eu },
+	{ 0xe45ec2862f71e1d6u, 0xc06481fb9bcf8d39u }, { 0x5d767327bb4e5a4cu, 0xf07da27a82c37088u },
+	{ 0x3a6a07f8d510f86fu, 0x964e858c91ba2655u }, { 0x890489f70a55368bu, 0xbbe226efb628afeau },
+	{ 0x2b45ac74ccea842eu, 0xeadab0aba3b2dbe5u }, { 0x3b0b8bc90012929du, 0x92c8ae6b464fc96fu },
+	{ 0x09ce6ebb40173744u, 0xb77ada0617e3bbcbu }, { 0xcc420a6a101d0515u, 0xe55990879ddcaabdu },
+	{ 0x9fa946824a12232du, 0x8f57fa54c2a9eab6u }, { 0x47939822dc96abf9u, 0xb32df8e9f3546564u },
+	{ 0x59787e2b93bc56f7u, 0xdff9772470297ebdu }, { 0x57eb4edb3c55b65au, 0x8bfbea76c619ef36u },
+	{ 0xede622920b6b23f1u, 0xaefae51477a06b03u }, { 0xe95fab368e45ecedu, 0xdab99e59958885c4u },
+	{ 0x11dbcb0218ebb414u, 0x88b402f7fd75539bu }, { 0xd652bdc29f26a119u, 0xaae103b5fcd2a881u },
+	{ 0x4be76d3346f0495fu, 0xd59944a37c0752a2u }, { 0x6f70a4400c562ddbu, 0x857fcae62d8493a5u },
+	{ 0xcb4ccd500f6bb952u, 0xa6dfbd9fb8e5b88eu }, { 0x7e2000a41346a7a7u, 0xd097ad07a71f26b2u },
+	{ 0x8ed400668c0c28c8u, 0x825ecc24c873782fu }, { 0x728900802f0f32fau, 0xa2f67f2dfa90563bu },
+	{ 0x4f2b40a03ad2ffb9u, 0xcbb41ef979346bcau }, { 0xe2f610c84987bfa8u, 0xfea126b7d78186bcu },
+	{ 0x0dd9ca7d2df4d7c9u, 0x9f24b832e6b0f436u }, { 0x91503d1c79720dbbu, 0xc6ede63fa05d3143u },
+	{ 0x75a44c6397ce912au, 0xf8a95fcf88747d94u }, { 0xc986afbe3ee11abau, 0x9b69dbe1b548ce7cu },
+	{ 0xfbe85badce996168u, 0xc24452da229b021bu }, { 0xfae27299423fb9c3u, 0xf2d56790ab41c2a2u },
+	{ 0xdccd879fc967d41au, 0x97c560ba6b0919a5u }, { 0x5400e987bbc1c920u, 0xbdb6b8e905cb600fu },
+	{ 0x290123e9aab23b68u, 0xed246723473e3813u }, { 0xf9a0b6720aaf6521u, 0x9436c0760c86e30bu },
+	{ 0xf808e40e8d5b3e69u, 0xb94470938fa89bceu }, { 0xb60b1d1230b20e04u, 0xe7958cb87392c2c2u },
+	{ 0xb1c6f22b5e6f48c2u, 0x90bd77f3483bb9b9u }, { 0x1e38aeb6360b1af3u, 0xb4ecd5f01a4aa828u },
+	{ 0x25c6da63c38de1b0u, 0xe2280b6c20dd5232u }, { 0x579c487e5a38ad0eu, 0x8d590723948a535fu },
+	{ 0x2d835a9df0c6d851u, 0xb0af48ec79ace837u }, { 0xf8e431456cf88e65u, 0xdcdb1b2798182244u },
+	{ 0x1b8e9ecb641b58ffu, 0x8a08f0f8bf0f156bu }, { 0xe272467e3d222f3fu, 0xac8b2d36eed2dac5u },
+	{ 0x5b0ed81dcc6abb0fu, 0xd7adf884aa879177u }, { 0x98e947129fc2b4e9u, 0x86ccbb52ea94baeau },
+	{ 0x3f2398d747b36224u, 0xa87fea27a539e9a5u }, { 0x8eec7f0d19a03aadu, 0xd29fe4b18e88640eu },
+	{ 0x1953cf68300424acu, 0x83a3eeeef9153e89u }, { 0x5fa8c3423c052dd7u, 0xa48ceaaab75a8e2bu },
+	{ 0x3792f412cb06794du, 0xcdb02555653131b6u }, { 0xe2bbd88bbee40bd0u, 0x808e17555f3ebf11u },
+	{ 0x5b6aceaeae9d0ec4u, 0xa0b19d2ab70e6ed6u }, { 0xf245825a5a445275u, 0xc8de047564d20a8bu },
+	{ 0xeed6e2f0f0d56712u, 0xfb158592be068d2eu }, { 0x55464dd69685606bu, 0x9ced737bb6c4183du },
+	{ 0xaa97e14c3c26b886u, 0xc428d05aa4751e4cu }, { 0xd53dd99f4b3066a8u, 0xf53304714d9265dfu },
+	{ 0xe546a8038efe4029u, 0x993fe2c6d07b7fabu }, { 0xde98520472bdd033u, 0xbf8fdb78849a5f96u },
+	{ 0x963e66858f6d4440u, 0xef73d256a5c0f77cu }, { 0xdde7001379a44aa8u, 0x95a8637627989aadu },
+	{ 0x5560c018580d5d52u, 0xbb127c53b17ec159u }, { 0xaab8f01e6e10b4a6u, 0xe9d71b689dde71afu },
+	{ 0xcab3961304ca70e8u, 0x9226712162ab070du }, { 0x3d607b97c5fd0d22u, 0xb6b00d69bb55c8d1u },
+	{ 0x8cb89a7db77c506au, 0xe45c10c42a2b3b05u }, { 0x77f3608e92adb242u, 0x8eb98a7a9a5b04e3u },
+	{ 0x55f038b237591ed3u, 0xb267ed1940f1c61cu }, { 0x6b6c46dec52f6688u, 0xdf01e85f912e37a3u },
+	{ 0x2323ac4b3b3da015u, 0x8b61313bbabce2c6u }, { 0xabec975e0a0d081au, 0xae397d8aa96c1b77u },
+	{ 0x96e7bd358c904a21u, 0xd9c7dced53c72255u }, { 0x7e50d64177da2e54u, 0x881cea14545c7575u },
+	{ 0xdde50bd1d5d0b9e9u, 0xaa242499697392d2u }, { 0x955e4ec64b44e864u, 0xd4ad2dbfc3d07787u },
+	{ 0xbd5af13bef0b113eu, 0x84ec3c97da624ab4u }, { 0xecb1ad8aeacdd58eu, 0xa6274bbdd0fadd61u },
+	{ 0x67de18eda5814af2u, 0xcfb11ead453994bau }, { 0x80eacf948770ced7u, 0x81ceb32c4b43fcf4u },
+	{ 0xa1258379a94d028du, 0xa2425ff75e14fc31u }, { 0x096ee45813a04330u, 0xcad2f7f5359a3b3eu },
+	{ 0x8bca9d6e188853fcu, 0xfd87b5f28300ca0du }, { 0x775ea264cf55347eu, 0x9e74d1b791e07e48u },
+	{ 0x95364afe032a819eu, 0xc612062576589ddau }, { 0x3a83ddbd83f52205u, 0xf79687aed3eec551u },
+	{ 0xc4926a9672793543u, 0x9abe14cd44753b52u }, { 0x75b7053c0f178294u, 0xc16d9a0095928a27u },
+	{ 0x5324c68b12dd6339u, 0xf1c90080baf72cb1u }, { 0xd3f6fc16ebca5e04u, 0x971da05074da7beeu },
+	{ 0x88f4bb1ca6bcf585u, 0xbce5086492111aeau }, { 0x2b31e9e3d06c32e6u, 0xec1e4a7db69561a5u },
+	{ 0x3aff322e62439fd0u, 0x9392ee8e921d5d07u }, { 0x09befeb9fad487c3u, 0xb877aa3236a4b449u },
+	{ 0x4c2ebe687989a9b4u, 0xe69594bec44de15bu }, { 0x0f9d37014bf60a11u, 0x901d7cf73ab0acd9u },
+	{ 0x538484c19ef38c95u, 0xb424dc35095cd80fu }, { 0x2865a5f206b06fbau, 0xe12e13424bb40e13u },
+	{ 0xf93f87b7442e45d4u, 0x8cbccc096f5088cbu }, { 0xf78f69a51539d749u, 0xafebff0bcb24aafeu },
+	{ 0xb573440e5a884d1cu, 0xdbe6fecebdedd5beu }, { 0x31680a88f8953031u, 0x89705f4136b4a597u },
+	{ 0xfdc20d2b36ba7c3eu, 0xabcc77118461cefcu }, { 0x3d32907604691b4du, 0xd6bf94d5e57a42bcu },
+	{ 0xa63f9a49c2c1b110u, 0x8637bd05af6c69b5u }, { 0x0fcf80dc33721d54u, 0xa7c5ac471b478423u },
+	{ 0xd3c36113404ea4a9u, 0xd1b71758e219652bu }, { 0x645a1cac083126eau, 0x83126e978d4fdf3bu },
+	{ 0x3d70a3d70a3d70a4u, 0xa3d70a3d70a3d70au }, { 0xcccccccccccccccdu, 0xccccccccccccccccu },
+	{ 0x0000000000000000u, 0x8000000000000000u }, { 0x0000000000000000u, 0xa000000000000000u },
+	{ 0x0000000000000000u, 0xc800000000000000u }, { 0x0000000000000000u, 0xfa00000000000000u },
+	{ 0x0000000000000000u, 0x9c40000000000000u }, { 0x0000000000000000u, 0xc350000000000000u },
+	{ 0x0000000000000000u, 0xf424000000000000u }, { 0x0000000000000000u, 0x9896800000000000u },
+	{ 0x0000000000000000u, 0xbebc200000000000u }, { 0x0000000000000000u, 0xee6b280000000000u },
+	{ 0x0000000000000000u, 0x9502f90000000000u }, { 0x0000000000000000u, 0xba43b74000000000u },
+	{ 0x0000000000000000u, 0xe8d4a51000000000u }, { 0x0000000000000000u, 0x9184e72a00000000u },
+	{ 0x0000000000000000u, 0xb5e620f480000000u }, { 0x0000000000000000u, 0xe35fa931a0000000u },
+	{ 0x0000000000000000u, 0x8e1bc9bf04000000u }, { 0x0000000000000000u, 0xb1a2bc2ec5000000u },
+	{ 0x0000000000000000u, 0xde0b6b3a76400000u }, { 0x0000000000000000u, 0x8ac7230489e80000u },
+	{ 0x0000000000000000u, 0xad78ebc5ac620000u }, { 0x0000000000000000u, 0xd8d726b7177a8000u },
+	{ 0x0000000000000000u, 0x878678326eac9000u }, { 0x0000000000000000u, 0xa968163f0a57b400u },
+	{ 0x0000000000000000u, 0xd3c21bcecceda100u }, { 0x0000000000000000u, 0x84595161401484a0u },
+	{ 0x0000000000000000u, 0xa56fa5b99019a5c8u }, { 0x0000000000000000u, 0xcecb8f27f4200f3au },
+	{ 0x4000000000000000u, 0x813f3978f8940984u }, { 0x5000000000000000u, 0xa18f07d736b90be5u },
+	{ 0xa400000000000000u, 0xc9f2c9cd04674edeu }, { 0x4d00000000000000u, 0xfc6f7c4045812296u },
+	{ 0xf020000000000000u, 0x9dc5ada82b70b59du }, { 0x6c28000000000000u, 0xc5371912364ce305u },
+	{ 0xc732000000000000u, 0xf684df56c3e01bc6u }, { 0x3c7f400000000000u, 0x9a130b963a6c115cu },
+	{ 0x4b9f100000000000u, 0xc097ce7bc90715b3u }, { 0x1e86d40000000000u, 0xf0bdc21abb48db20u },
+	{ 0x1314448000000000u, 0x96769950b50d88f4u }, { 0x17d955a000000000u, 0xbc143fa4e250eb31u },
+	{ 0x5dcfab0800000000u, 0xeb194f8e1ae525fdu }, { 0x5aa1cae500000000u, 0x92efd1b8d0cf37beu },
+	{ 0xf14a3d9e40000000u, 0xb7abc627050305adu }, { 0x6d9ccd05d0000000u, 0xe596b7b0c643c719u },
+	{ 0xe4820023a2000000u, 0x8f7e32ce7bea5c6fu }, { 0xdda2802c8a800000u, 0xb35dbf821ae4f38bu },
+	{ 0xd50b2037ad200000u, 0xe0352f62a19e306eu }, { 0x4526f422cc340000u, 0x8c213d9da502de45u },
+	{ 0x9670b12b7f410000u, 0xaf298d050e4395d6u }, { 0x3c0cdd765f114000u, 0xdaf3f04651d47b4cu },
+	{ 0xa5880a69fb6ac800u, 0x88d8762bf324cd0fu }, { 0x8eea0d047a457a00u, 0xab0e93b6efee0053u },
+	{ 0x72a4904598d6d880u, 0xd5d238a4abe98068u }, { 0x47a6da2b7f864750u, 0x85a36366eb71f041u },
+	{ 0x999090b65f67d924u, 0xa70c3c40a64e6c51u }, { 0xfff4b4e3f741cf6du, 0xd0cf4b50cfe20765u },
+	{ 0xbff8f10e7a8921a4u, 0x82818f1281ed449fu }, { 0xaff72d52192b6a0du, 0xa321f2d7226895c7u },
+	{ 0x9bf4f8a69f764490u, 0xcbea6f8ceb02bb39u }, { 0x02f236d04753d5b4u, 0xfee50b7025c36a08u },
+	{ 0x01d762422c946590u, 0x9f4f2726179a2245u }, { 0x424d3ad2b7b97ef5u, 0xc722f0ef9d80aad6u },
+	{ 0xd2e0898765a7deb2u, 0xf8ebad2b84e0d58bu }, { 0x63cc55f49f88eb2fu, 0x9b934c3b330c8577u },
+	{ 0x3cbf6b71c76b25fbu, 0xc2781f49ffcfa6d5u }, { 0x8bef464e3945ef7au, 0xf316271c7fc3908au },
+	{ 0x97758bf0e3cbb5acu, 0x97edd871cfda3a56u }, { 0x3d52eeed1cbea317u, 0xbde94e8e43d0c8ecu },
+	{ 0x4ca7aaa863ee4bddu, 0xed63a231d4c4fb27u }, { 0x8fe8caa93e74ef6au, 0x945e455f24fb1cf8u },
+	{ 0xb3e2fd538e122b44u, 0xb975d6b6ee39e436u }, { 0x60dbbca87196b616u, 0xe7d34c64a9c85d44u },
+	{ 0xbc8955e946fe31cdu, 0x90e40fbeea1d3a4au }, { 0x6babab6398bdbe41u, 0xb51d13aea4a488ddu },
+	{ 0xc696963c7eed2dd1u, 0xe264589a4dcdab14u }, { 0xfc1e1de5cf543ca2u, 0x8d7eb76070a08aecu },
+	{ 0x3b25a55f43294bcbu, 0xb0de65388cc8ada8u }, { 0x49ef0eb713f39ebeu, 0xdd15fe86affad912u },
+	{ 0x6e3569326c784337u, 0x8a2dbf142dfcc7abu }, { 0x49c2c37f07965404u, 0xacb92ed9397bf996u },
+	{ 0xdc33745ec97be906u, 0xd7e77a8f87daf7fbu }, { 0x69a028bb3ded71a3u, 0x86f0ac99b4e8dafdu },
+	{ 0xc40832ea0d68ce0cu, 0xa8acd7c0222311bcu }, { 0xf50a3fa490c30190u, 0xd2d80db02aabd62bu },
+	{ 0x792667c6da79e0fau, 0x83c7088e1aab65dbu }, { 0x577001b891185938u, 0xa4b8cab1a1563f52u },
+	{ 0xed4c0226b55e6f86u, 0xcde6fd5e09abcf26u }, { 0x544f8158315b05b4u, 0x80b05e5ac60b6178u },
+	{ 0x696361ae3db1c721u, 0xa0dc75f1778e39d6u }, { 0x03bc3a19cd1e38e9u, 0xc913936dd571c84cu },
+	{ 0x04ab48a04065c723u, 0xfb5878494ace3a5fu }, { 0x62eb0d64283f9c76u, 0x9d174b2dcec0e47bu },
+	{ 0x3ba5d0bd324f8394u, 0xc45d1df942711d9au }, { 0xca8f44ec7ee36479u, 0xf5746577930d6500u },
+	{ 0x7e998b13cf4e1ecbu, 0x9968bf6abbe85f20u }, { 0x9e3fedd8c321a67eu, 0xbfc2ef456ae276e8u },
+	{ 0xc5cfe94ef3ea101eu, 0xefb3ab16c59b14a2u }, { 0xbba1f1d158724a12u, 0x95d04aee3b80ece5u },
+	{ 0x2a8a6e45ae8edc97u, 0xbb445da9ca61281fu }, { 0xf52d09d71a3293bdu, 0xea1575143cf97226u },
+	{ 0x593c2626705f9c56u, 0x924d692ca61be758u }, { 0x6f8b2fb00c77836cu, 0xb6e0c377cfa2e12eu },
+	{ 0x0b6dfb9c0f956447u, 0xe498f455c38b997au }, { 0x4724bd4189bd5eacu, 0x8edf98b59a373fecu },
+	{ 0x58edec91ec2cb657u, 0xb2977ee300c50fe7u }, { 0x2f2967b66737e3edu, 0xdf3d5e9bc0f653e1u },
+	{ 0xbd79e0d20082ee74u, 0x8b865b215899f46cu }, { 0xecd8590680a3aa11u, 0xae67f1e9aec07187u },
+	{ 0xe80e6f4820cc9495u, 0xda01ee641a708de9u }, { 0x3109058d147fdcddu, 0x884134fe908658b2u },
+	{ 0xbd4b46f0599fd415u, 0xaa51823e34a7eedeu }, { 0x6c9e18ac7007c91au, 0xd4e5e2cdc1d1ea96u },
+	{ 0x03e2cf6bc604ddb0u, 0x850fadc09923329eu }, { 0x84db8346b786151cu, 0xa6539930bf6bff45u },
+	{ 0xe612641865679a63u, 0xcfe87f7cef46ff16u }, { 0x4fcb7e8f3f60c07eu, 0x81f14fae158c5f6eu },
+	{ 0xe3be5e330f38f09du, 0xa26da3999aef7749u }, { 0x5cadf5bfd3072cc5u, 0xcb090c8001ab551cu },
+	{ 0x73d9732fc7c8f7f6u, 0xfdcb4fa002162a63u }, { 0x2867e7fddcdd9afau, 0x9e9f11c4014dda7eu },
+	{ 0xb281e1fd541501b8u, 0xc646d63501a1511du }, { 0x1f225a7ca91a4226u, 0xf7d88bc24209a565u },
+	{ 0x3375788de9b06958u, 0x9ae757596946075fu }, { 0x0052d6b1641c83aeu, 0xc1a12d2fc3978937u },
+	{ 0xc0678c5dbd23a49au, 0xf209787bb47d6b84u }, { 0xf840b7ba963646e0u, 0x9745eb4d50ce6332u },
+	{ 0xb650e5a93bc3d898u, 0xbd176620a501fbffu }, { 0xa3e51f138ab4cebeu, 0xec5d3fa8ce427affu },
+	{ 0xc66f336c36b10137u, 0x93ba47c980e98cdfu }, { 0xb80b0047445d4184u, 0xb8a8d9bbe123f017u },
+	{ 0xa60dc059157491e5u, 0xe6d3102ad96cec1du }, { 0x87c89837ad68db2fu, 0x9043ea1ac7e41392u },
+	{ 0x29babe4598c311fbu, 0xb454e4a179dd1877u }, { 0xf4296dd6fef3d67au, 0xe16a1dc9d8545e94u },
+	{ 0x1899e4a65f58660cu, 0x8ce2529e2734bb1du }, { 0x5ec05dcff72e7f8fu, 0xb01ae745b101e9e4u },
+	{ 0x76707543f4fa1f73u, 0xdc21a1171d42645du }, { 0x6a06494a791c53a8u, 0x899504ae72497ebau },
+	{ 0x0487db9d17636892u, 0xabfa45da0edbde69u }, { 0x45a9d2845d3c42b6u, 0xd6f8d7509292d603u },
+	{ 0x0b8a2392ba45a9b2u, 0x865b86925b9bc5c2u }, { 0x8e6cac7768d7141eu, 0xa7f26836f282b732u },
+	{ 0x3207d795430cd926u, 0xd1ef0244af2364ffu }, { 0x7f44e6bd49e807b8u, 0x8335616aed761f1fu },
+	{ 0x5f16206c9c6209a6u, 0xa402b9c5a8d3a6e7u }, { 0x36dba887c37a8c0fu, 0xcd036837130890a1u },
+	{ 0xc2494954da2c9789u, 0x802221226be55a64u }, { 0xf2db9baa10b7bd6cu, 0xa02aa96b06deb0fdu },
+	{ 0x6f92829494e5acc7u, 0xc83553c5c8965d3du }, { 0xcb772339ba1f17f9u, 0xfa42a8b73abbf48cu },
+	{ 0xff2a760414536efbu, 0x9c69a97284b578d7u }, { 0xfef5138519684abau, 0xc38413cf25e2d70du },
+	{ 0x7eb258665fc25d69u, 0xf46518c2ef5b8cd1u }, { 0xef2f773ffbd97a61u, 0x98bf2f79d5993802u },
+	{ 0xaafb550ffacfd8fau, 0xbeeefb584aff8603u }, { 0x95ba2a53f983cf38u, 0xeeaaba2e5dbf6784u },
+	{ 0xdd945a747bf26183u, 0x952ab45cfa97a0b2u }, { 0x94f971119aeef9e4u, 0xba756174393d88dfu },
+	{ 0x7a37cd5601aab85du, 0xe912b9d1478ceb17u }, { 0xac62e055c10ab33au, 0x91abb422ccb812eeu },
+	{ 0x577b986b314d6009u, 0xb616a12b7fe617aau }, { 0xed5a7e85fda0b80bu, 0xe39c49765fdf9d94u },
+	{ 0x14588f13be847307u, 0x8e41ade9fbebc27du }, { 0x596eb2d8ae258fc8u, 0xb1d219647ae6b31cu },
+	{ 0x6fca5f8ed9aef3bbu, 0xde469fbd99a05fe3u }, { 0x25de7bb9480d5854u, 0x8aec23d680043beeu },
+	{ 0xaf561aa79a10ae6au, 0xada72ccc20054ae9u }, { 0x1b2ba1518094da04u, 0xd910f7ff28069da4u },
+	{ 0x90fb44d2f05d0842u, 0x87aa9aff79042286u }, { 0x353a1607ac744a53u, 0xa99541bf57452b28u },
+	{ 0x42889b8997915ce8u, 0xd3fa922f2d1675f2u }, { 0x69956135febada11u, 0x847c9b5d7c2e09b7u },
+	{ 0x43fab9837e699095u, 0xa59bc234db398c25u }, { 0x94f967e45e03f4bbu, 0xcf02b2c21207ef2eu },
+	{ 0x1d1be0eebac278f5u, 0x8161afb94b44f57du }, { 0x6462d92a69731732u, 0xa1ba1ba79e1632dcu },
+	{ 0x7d7b8f7503cfdcfeu, 0xca28a291859bbf93u }, { 0x5cda735244c3d43eu, 0xfcb2cb35e702af78u },
+	{ 0x3a0888136afa64a7u, 0x9defbf01b061adabu }, { 0x088aaa1845b8fdd0u, 0xc56baec21c7a1916u },
+	{ 0x8aad549e57273d45u, 0xf6c69a72a3989f5bu }, { 0x36ac54e2f678864bu, 0x9a3c2087a63f6399u },
+	{ 0x84576a1bb416a7ddu, 0xc0cb28a98fcf3c7fu }, { 0x656d44a2a11c51d5u, 0xf0fdf2d3f3c30b9fu },
+	{ 0x9f644ae5a4b1b325u, 0x969eb7c47859e743u }, { 0x873d5d9f0dde1feeu, 0xbc4665b596706114u },
+	{ 0xa90cb506d155a7eau, 0xeb57ff22fc0c7959u }, { 0x09a7f12442d588f2u, 0x9316ff75dd87cbd8u },
+	{ 0x0c11ed6d538aeb2fu, 0xb7dcbf5354e9beceu }, { 0x8f1668c8a86da5fau, 0xe5d3ef282a242e81u },
+	{ 0xf96e017d694487bcu, 0x8fa475791a569d10u }, { 0x37c981dcc395a9acu, 0xb38d92d760ec4455u },
+	{ 0x85bbe253f47b1417u, 0xe070f78d3927556au }, { 0x93956d7478ccec8eu, 0x8c469ab843b89562u },
+	{ 0x387ac8d1970027b2u, 0xaf58416654a6babbu }, { 0x06997b05fcc0319eu, 0xdb2e51bfe9d0696au },
+	{ 0x441fece3bdf81f03u, 0x88fcf317f22241e2u }, { 0xd527e81cad7626c3u, 0xab3c2fddeeaad25au },
+	{ 0x8a71e223d8d3b074u, 0xd60b3bd56a5586f1u }, { 0xf6872d5667844e49u, 0x85c7056562757456u },
+	{ 0xb428f8ac016561dbu, 0xa738c6bebb12d16cu }, { 0xe13336d701beba52u, 0xd106f86e69d785c7u },
+	{ 0xecc0024661173473u, 0x82a45b450226b39cu }, { 0x27f002d7f95d0190u, 0xa34d721642b06084u },
+	{ 0x31ec038df7b441f4u, 0xcc20ce9bd35c78a5u }, { 0x7e67047175a15271u, 0xff290242c83396ceu },
+	{ 0x0f0062c6e984d386u, 0x9f79a169bd203e41u }, { 0x52c07b78a3e60868u, 0xc75809c42c684dd1u },
+	{ 0xa7709a56ccdf8a82u, 0xf92e0c3537826145u }, { 0x88a66076400bb691u, 0x9bbcc7a142b17ccbu },
+	{ 0x6acff893d00ea435u, 0xc2abf989935ddbfeu }, { 0x0583f6b8c4124d43u, 0xf356f7ebf83552feu },
+	{ 0xc3727a337a8b704au, 0x98165af37b2153deu }, { 0x744f18c0592e4c5cu, 0xbe1bf1b059e9a8d6u },
+	{ 0x1162def06f79df73u, 0xeda2ee1c7064130cu }, { 0x8addcb5645ac2ba8u, 0x9485d4d1c63e8be7u },
+	{ 0x6d953e2bd7173692u, 0xb9a74a0637ce2ee1u }, { 0xc8fa8db6ccdd0437u, 0xe8111c87c5c1ba99u },
+	{ 0x1d9c9892400a22a2u, 0x910ab1d4db9914a0u }, { 0x2503beb6d00cab4bu, 0xb54d5e4a127f59c8u },
+	{ 0x2e44ae64840fd61du, 0xe2a0b5dc971f303au }, { 0x5ceaecfed289e5d2u, 0x8da471a9de737e24u },
+	{ 0x7425a83e872c5f47u, 0xb10d8e1456105dadu }, { 0xd12f124e28f77719u, 0xdd50f1996b947518u },
+	{ 0x82bd6b70d99aaa6fu, 0x8a5296ffe33cc92fu }, { 0x636cc64d1001550bu, 0xace73cbfdc0bfb7bu },
+	{ 0x3c47f7e05401aa4eu, 0xd8210befd30efa5au }, { 0x65acfaec34810a71u, 0x8714a775e3e95c78u },
+	{ 0x7f1839a741a14d0du, 0xa8d9d1535ce3b396u }, { 0x1ede48111209a050u, 0xd31045a8341ca07cu },
+	{ 0x934aed0aab460432u, 0x83ea2b892091e44du }, { 0xf81da84d5617853fu, 0xa4e4b66b68b65d60u },
+	{ 0x36251260ab9d668eu, 0xce1de40642e3f4b9u }, { 0xc1d72b7c6b426019u, 0x80d2ae83e9ce78f3u },
+	{ 0xb24cf65b8612f81fu, 0xa1075a24e4421730u }, { 0xdee033f26797b627u, 0xc94930ae1d529cfcu },
+	{ 0x169840ef017da3b1u, 0xfb9b7cd9a4a7443cu }, { 0x8e1f289560ee864eu, 0x9d412e0806e88aa5u },
+	{ 0xf1a6f2bab92a27e2u, 0xc491798a08a2ad4eu }, { 0xae10af696774b1dbu, 0xf5b5d7ec8acb58a2u },
+	{ 0xacca6da1e0a8ef29u, 0x9991a6f3d6bf1765u }, { 0x17fd090a58d32af3u, 0xbff610b0cc6edd3fu },
+	{ 0xddfc4b4cef07f5b0u, 0xeff394dcff8a948eu }, { 0x4abdaf101564f98eu, 0x95f83d0a1fb69cd9u },
+	{ 0x9d6d1ad41abe37f1u, 0xbb764c4ca7a4440fu }, { 0x84c86189216dc5edu, 0xea53df5fd18d5513u },
+	{ 0x32fd3cf5b4e49bb4u, 0x92746b9be2f8552cu }, { 0x3fbc8c33221dc2a1u, 0xb7118682dbb66a77u },
+	{ 0x0fabaf3feaa5334au, 0xe4d5e82392a40515u }, { 0x29cb4d87f2a7400eu, 0x8f05b1163ba6832du },
+	{ 0x743e20e9ef511012u, 0xb2c71d5bca9023f8u }, { 0x914da9246b255416u, 0xdf78e4b2bd342cf6u },
+	{ 0x1ad089b6c2f7548eu, 0x8bab8eefb6409c1au }, { 0xa184ac2473b529b1u, 0xae9672aba3d0c320u },
+	{ 0xc9e5d72d90a2741eu, 0xda3c0f568cc4f3e8u }, { 0x7e2fa67c7a658892u, 0x8865899617fb1871u },
+	{ 0xddbb901b98feeab7u, 0xaa7eebfb9df9de8du }, { 0x552a74227f3ea565u, 0xd51ea6fa85785631u },
+	{ 0xd53a88958f87275fu, 0x8533285c936b35deu }, { 0x8a892abaf368f137u, 0xa67ff273b8460356u },
+	{ 0x2d2b7569b0432d85u, 0xd01fef10a657842cu }, { 0x9c3b29620e29fc73u, 0x8213f56a67f6b29bu },
+	{ 0x8349f3ba91b47b8fu, 0xa298f2c501f45f42u }, { 0x241c70a936219a73u, 0xcb3f2f7642717713u },
+	{ 0xed238cd383aa0110u, 0xfe0efb53d30dd4d7u }, { 0xf4363804324a40aau, 0x9ec95d1463e8a506u },
+	{ 0xb143c6053edcd0d5u, 0xc67bb4597ce2ce48u }, { 0xdd94b7868e94050au, 0xf81aa16fdc1b81dau },
+	{ 0xca7cf2b4191c8326u, 0x9b10a4e5e9913128u }, { 0xfd1c2f611f63a3f0u, 0xc1d4ce1f63f57d72u },
+	{ 0xbc633b39673c8cecu, 0xf24a01a73cf2dccfu }, { 0xd5be0503e085d813u, 0x976e41088617ca01u },
+	{ 0x4b2d8644d8a74e18u, 0xbd49d14aa79dbc82u }, { 0xddf8e7d60ed1219eu, 0xec9c459d51852ba2u },
+	{ 0xcabb90e5c942b503u, 0x93e1ab8252f33b45u }, { 0x3d6a751f3b936243u, 0xb8da1662e7b00a17u },
+	{ 0x0cc512670a783ad4u, 0xe7109bfba19c0c9du }, { 0x27fb2b80668b24c5u, 0x906a617d450187e2u },
+	{ 0xb1f9f660802dedf6u, 0xb484f9dc9641e9dau }, { 0x5e7873f8a0396973u, 0xe1a63853bbd26451u },
+	{ 0xdb0b487b6423e1e8u, 0x8d07e33455637eb2u }, { 0x91ce1a9a3d2cda62u, 0xb049dc016abc5e5fu },
+	{ 0x7641a140cc7810fbu, 0xdc5c5301c56b75f7u }, { 0xa9e904c87fcb0a9du, 0x89b9b3e11b6329bau },
+	{ 0x546345fa9fbdcd44u, 0xac2820d9623bf429u }, { 0xa97c177947ad4095u, 0xd732290fbacaf133u },
+	{ 0x49ed8eabcccc485du, 0x867f59a9d4bed6c0u }, { 0x5c68f256bfff5a74u, 0xa81f301449ee8c70u },
+	{ 0x73832eec6fff3111u, 0xd226fc195c6a2f8cu }, { 0xc831fd53c5ff7eabu, 0x83585d8fd9c25db7u },
+	{ 0xba3e7ca8b77f5e55u, 0xa42e74f3d032f525u }, { 0x28ce1bd2e55f35ebu, 0xcd3a1230c43fb26fu },
+	{ 0x7980d163cf5b81b3u, 0x80444b5e7aa7cf85u }, { 0xd7e105bcc332621fu, 0xa0555e361951c366u },
+	{ 0x8dd9472bf3fefaa7u, 0xc86ab5c39fa63440u }, { 0xb14f98f6f0feb951u, 0xfa856334878fc150u },
+	{ 0x6ed1bf9a569f33d3u, 0x9c935e00d4b9d8d2u }, { 0x0a862f80ec4700c8u, 0xc3b8358109e84f07u },
+	{ 0xcd27bb612758c0fau, 0xf4a642e14c6262c8u }, { 0x8038d51cb897789cu, 0x98e7e9cccfbd7dbdu },
+	{ 0xe0470a63e6bd56c3u, 0xbf21e44003acdd2cu }, { 0x1858ccfce06cac74u, 0xeeea5d5004981478u },
+	{ 0x0f37801e0c43ebc8u, 0x95527a5202df0ccbu }, { 0xd30560258f54e6bau, 0xbaa718e68396cffdu },
+	{ 0x47c6b82ef32a2069u, 0xe950df20247c83fdu }, { 0x4cdc331d57fa5441u, 0x91d28b7416cdd27eu },
+	{ 0xe0133fe4adf8e952u, 0xb6472e511c81471du }, { 0x58180fddd97723a6u, 0xe3d8f9e563a198e5u },
+	{ 0x570f09eaa7ea7648u, 0x8e679c2f5e44ff8fu }
+};
+
+typedef struct {
+	uint64_t w;        // first 19 significant digits
+	int32_t q;         // value is w * 10^q, give or take the dropped digits
+	uint8_t neg;       // 0=positive, 1=negative
+	uint8_t trunc;     // a nonzero digit did not fit in w
+	uint8_t sticky;    // ... nor in text, which the reader had to cut short
+	const char *text;  // the digits as written, '.' included, for the slow path
+	size_t len;
+} __jacl_decimal_t;
+
+typedef struct {
+	uint32_t limb[JACL_BIGNUM_LIMBS];
+	int n;
+} __jacl_bignum_t;
+
+typedef struct {
+	uint64_t mant;     // explicit mantissa bits
+	int32_t exp;       // biased exponent, all ones for infinity
+} __jacl_fbits_t;
+
+static inline uint64_t __jacl_mul64(uint64_t a, uint64_t b, uint64_t *hi) {
+#if defined(__SIZEOF_INT128__)
+	__uint128_t r = (__uint128_t)a * b;
+
+	*hi = (uint64_t)(r >> 64);
+
+	return (uint64_t)r;
+#else
+	uint64_t al = (uint32_t)a, ah = a >> 32, bl = (uint32_t)b, bh = b >> 32;
+	uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+
+	*hi = ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+	return (mid << 32) | (uint32_t)ll;
+#endif
+}
+
+/**
+ * Correctly rounded w * 10^q for a format with `mbits` explicit mantissa bits
+ * and exponent bias `bias`. Ties between w * 10^q and a halfway point can only
+ * happen for q in [even_lo, even_hi], where the product is checked for being
+ * exact before rounding up.
+ */
+static inline __jacl_fbits_t __jacl_lemire(uint64_t w, int32_t q, int mbits, int32_t bias, int32_t even_lo, int32_t even_hi) {
+	int32_t inf = 2 * bias + 1, lz, shift, exp;
+	uint64_t lo, hi, hi2, mant, mask = ~0ULL >> (mbits + 3);
+	const uint64_t *pow5;
+
+	if (!w || q < JACL_LEMIRE_QMIN) return (__jacl_fbits_t){ 0, 0 };
+	if (q > JACL_LEMIRE_QMAX) return (__jacl_fbits_t){ 0, inf };
+
+	lz = (int32_t)__jacl_clz64(w);
+	w <<= lz;
+	pow5 = __jacl_lemire_pow5[q - JACL_LEMIRE_QMIN];
+	lo = __jacl_mul64(w, pow5[1], &hi);
+
+	// the low word only matters when the bits below the mantissa are all ones
+	if ((hi & mask) == mask) {
+		__jacl_mul64(w, pow5[0], &hi2);
+		lo += hi2;
+		hi += lo < hi2;
+	}
+
+	shift = (int32_t)(hi >> 63) + 64 - mbits - 3;
+	mant = hi >> shift;
+	exp = (((152170 + 65536) * q) >> 16) + 63 + (int32_t)(hi >> 63) - lz + bias;
+
+	if (exp <= 0) {
+		if (-exp + 1 >= 64) return (__jacl_fbits_t){ 0, 0 };
+
+		mant >>= -exp + 1;
+		mant += mant & 1;
+		mant >>= 1;
+
+		return (__jacl_fbits_t){ mant & ((1ULL << mbits) - 1), mant >= (1ULL << mbits) };
+	}
+
+	// exactly halfway: round to even instead of up
+	if (lo <= 1 && q >= even_lo && q <= even_hi && (mant & 3) == 1 && (mant << shift) == hi) mant &= ~1ULL;
+
+	mant += mant & 1;
+	mant >>= 1;
+
+	if (mant >= (2ULL << mbits)) { mant = 1ULL << mbits; exp++; }
+	if (exp >= inf) return (__jacl_fbits_t){ 0, inf };
+
+	return (__jacl_fbits_t){ mant & ((1ULL << mbits) - 1), exp };
+}
+
+static inline void __jacl_bignum_muladd(__jacl_bignum_t *b, uint32_t mul, uint32_t add) {
+	uint64_t carry = add;
+
+	for (int i = 0; i < b->n; i++) { carry += (uint64_t)b->limb[i] * mul; b->limb[i] = (uint32_t)carry; carry >>= 32; }
+	if (carry && b->n < JACL_BIGNUM_LIMBS) b->limb[b->n++] = (uint32_t)carry;
+}
+static inline void __jacl_bignum_pow5(__jacl_bignum_t *b, int32_t e) {
+	static const uint32_t pow5[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625, 1220703125 };
+
+	for (; e > 0; e -= 13) __jacl_bignum_muladd(b, pow5[e < 13 ? e : 13], 0);
+}
+static inline void __jacl_bignum_shl(__jacl_bignum_t *b, int32_t s) {
+	int limbs = s / 32, bits = s % 32, i;
+
+	if (!b->n) return;
+	if (bits) {
+		uint32_t carry = 0;
+
+		for (i = 0; i < b->n; i++) { uint32_t v = b->limb[i]; b->limb[i] = (v << bits) | carry; carry = v >> (32 - bits); }
+		if (carry && b->n < JACL_BIGNUM_LIMBS) b->limb[b->n++] = carry;
+	}
+	if (limbs && b->n + limbs <= JACL_BIGNUM_LIMBS) {
+		for (i = b->n - 1; i >= 0; i--) b->limb[i + limbs] = b->limb[i];
+		for (i = 0; i < limbs; i++) b->limb[i] = 0;
+
+		b->n += limbs;
+	}
+}
+static inline int __jacl_bignum_cmp(const __jacl_bignum_t *a, const __jacl_bignum_t *b) {
+	if (a->n != b->n) return a->n < b->n ? -1 : 1;
+
+	for (int i = a->n - 1; i >= 0; i--) if (a->limb[i] != b->limb[i]) return a->limb[i] < b->limb[i] ? -1 : 1;
+
+	return 0;
+}
+
+/**
+ * Sign of the full decimal in d minus hm * 2^he. Reading stops after
+ * JACL_FEXACT_DIGITS significant digits, which is more than any halfway
+ * point between two doubles has, so the rest only counts as nonzero or not.
+ */
+static inline int __jacl_decimal_cmp(const __jacl_decimal_t *d, uint64_t hm, int32_t he) {
+	__jacl_bignum_t a = { { 0 }, 0 }, b = { { (uint32_t)hm, (uint32_t)(hm >> 32) }, hm >> 32 ? 2 : 1 };
+	int32_t kept = 0, sig = 0, q, r;
+	uint32_t chunk = 0, scale = 1;
+	int sticky = d->sticky;
+
+	for (size_t i = 0; i < d->len; i++) {
+		char c = d->text[i];
+
+		if (c == '.' || (!sig && c == '0')) continue;
+		if (++sig > JACL_FEXACT_DIGITS) { sticky |= c != '0'; continue; }
+
+		chunk = chunk * 10 + (uint32_t)(c - '0');
+		scale *= 10;
+		kept++;
+
+		if (scale == 1000000000u) { __jacl_bignum_muladd(&a, scale, chunk); chunk = 0; scale = 1; }
+	}
+	if (scale > 1) __jacl_bignum_muladd(&a, scale, chunk);
+	if (!a.n && chunk) a.limb[a.n++] = chunk;
+
+	// d->q belongs to the 19 digits in w, the last kept digit sits further down
+	q = d->q + (sig < 19 ? sig : 19) - kept;
+
+	if (q >= 0) __jacl_bignum_pow5(&a, q);
+	else __jacl_bignum_pow5(&b, -q);
+
+	if (q > he) __jacl_bignum_shl(&a, q - he);
+	else __jacl_bignum_shl(&b, he - q);
+
+	r = __jacl_bignum_cmp(&a, &b);
+
+	return r ? r : sticky;
+}
+
+/** w * 10^q rounded to `mbits` / `bias`, finishing with the bignum when w was cut short. */
+static inline __jacl_fbits_t __jacl_decimal_bits(const __jacl_decimal_t *d, int mbits, int32_t bias, int32_t even_lo, int32_t even_hi) {
+	__jacl_fbits_t lo = __jacl_lemire(d->w, d->q, mbits, bias, even_lo, even_hi), hi;
+
+	if (!d->trunc) return lo;
+
+	hi = __jacl_lemire(d->w + 1, d->q, mbits, bias, even_lo, even_hi);
+
+	if (lo.mant != hi.mant || lo.exp != hi.exp) {
+		// the answer is lo or the float after it, split at the halfway point
+		uint64_t m = lo.mant | (lo.exp ? 1ULL << mbits : 0);
+		int32_t e = (lo.exp ? lo.exp : 1) - bias - mbits;
+		int r = __jacl_decimal_cmp(d, 2 * m + 1, e - 1);
+
+		if (r > 0 || (r == 0 && (m & 1))) return hi;
+	}
+
+	return lo;
+}
+static inline double __jacl_decimal_DBL(const __jacl_decimal_t *d) {
+	__jacl_fbits_t b = __jacl_decimal_bits(d, DBL_EXP_LSB, DBL_EXP_BIAS, -4, 23);
+	union { double f; DBL_UTYPE u; } a = { .u = ((DBL_UTYPE)d->neg << DBL_SIGN_BIT) | ((DBL_UTYPE)b.exp << DBL_EXP_LSB) | b.mant };
+
+	return a.f;
+}
+static inline float __jacl_decimal_FLT(const __jacl_decimal_t *d) {
+	__jacl_fbits_t b = __jacl_decimal_bits(d, FLT_EXP_LSB, FLT_EXP_BIAS, -17, 10);
+	union { float f; FLT_UTYPE u; } a = { .u = ((FLT_UTYPE)d->neg << FLT_SIGN_BIT) | ((FLT_UTYPE)b.exp << FLT_EXP_LSB) | (FLT_UTYPE)b.mant };
+
+	return a.f;
+}
+#if LDBL_MANT_DIG == DBL_MANT_DIG
+static inline long double __jacl_decimal_LDBL(const __jacl_decimal_t *d) { return __jacl_decimal_DBL(d); }
+#else
+static inline long double __jacl_decimal_LDBL(const __jacl_decimal_t *d) {
+	long double val = (long double)d->w, scale = 1.0L;
+	uint32_t q = (uint32_t)(d->q < 0 ? -d->q : d->q);
+	int i;
+
+	for (i = 0; q && i < (int)(sizeof(POW10_EXP2) / sizeof(*POW10_EXP2)); i++, q >>= 1) if (q & 1) scale *= POW10_EXP2[i];
+
+	// past the end of the table the exponent alone is out of range
+	if (q) val = (d->q < 0 || !d->w) ? 0.0L : 1.0L / 0.0L;
+	else val = d->q < 0 ? val / scale : val * scale;
+
+	return d->neg ? -val : val;
+}
+#endif
+
 #endif /* JACL_HAS_FLOAT */
 
 #ifdef __cplusplus
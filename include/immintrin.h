@@ -31,7 +31,11 @@ extern "C" {
   #define JACL_HAS_SSE4_1 0
 #endif
 
-
+#if defined(__AVX2__)
+  #define JACL_HAS_AVX2 1
+#else
+  #define JACL_HAS_AVX2 0
+#endif
 
 #if defined(__FMA__)
   #define JACL_HAS_FMA 1
@@ -288,6 +292,61 @@ static inline double _mm_reduce_min_pd(__m128d v) { return v[0] < v[1] ? v[0] :
   static inline __m128d _mm_round_pd(__m128d v) { return (__m128d){ round(v[0]), round(v[1]) }; }
 #endif
 
+/* ============================================================ */
+/* Integer Byte Vectors (Compare & Movemask)                    */
+/* ============================================================ */
+
+typedef long long __m128i __attribute__((vector_size(16), aligned(16)));
+typedef long long __jacl_m128i_u __attribute__((vector_size(16), aligned(1), __may_alias__));
+typedef char __jacl_v16qi __attribute__((vector_size(16)));
+
+static inline __m128i _mm_setzero_si128(void) { return (__m128i){ 0, 0 }; }
+static inline __m128i _mm_set1_epi8(char c) { return (__m128i)((__jacl_v16qi){ c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c }); }
+static inline __m128i _mm_load_si128(const __m128i *p) { return *p; }
+static inline __m128i _mm_loadu_si128(const __m128i *p) { return *(const __jacl_m128i_u*)p; }
+static inline void _mm_store_si128(__m128i *p, __m128i v) { *p = v; }
+static inline void _mm_storeu_si128(__m128i *p, __m128i v) { *(__jacl_m128i_u*)p = v; }
+static inline __m128i _mm_cmpeq_epi8(__m128i a, __m128i b) { return (__m128i)((__jacl_v16qi)a == (__jacl_v16qi)b); }
+static inline __m128i _mm_and_si128(__m128i a, __m128i b) { return a & b; }
+static inline __m128i _mm_or_si128(__m128i a, __m128i b) { return a | b; }
+static inline __m128i _mm_xor_si128(__m128i a, __m128i b) { return a ^ b; }
+
+#if JACL_HAS_SSE2
+  static inline int _mm_movemask_epi8(__m128i v) { return __builtin_ia32_pmovmskb128((__jacl_v16qi)v); }
+#elif JACL_HAS_NEON && defined(__aarch64__)
+  static inline int _mm_movemask_epi8(__m128i v) {
+	const int8x16_t sh = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 };
+	uint8x16_t b = vshlq_u8(vshrq_n_u8((uint8x16_t)v, 7), sh);
+
+	return vaddv_u8(vget_low_u8(b)) | (vaddv_u8(vget_high_u8(b)) << 8);
+  }
+#elif JACL_HAS_WASM_SIMD
+  static inline int _mm_movemask_epi8(__m128i v) { typedef signed char v16si8 __attribute__((vector_size(16))); return __builtin_wasm_bitmask_i8x16((v16si8)v); }
+#else
+  static inline int _mm_movemask_epi8(__m128i v) {
+	__jacl_v16qi b = (__jacl_v16qi)v;
+	int m = 0;
+
+	for (int i = 0; i < 16; i++) m |= ((unsigned char)b[i] >> 7) << i;
+
+	return m;
+  }
+#endif
+
+#if JACL_HAS_AVX2
+  typedef long long __m256i __attribute__((vector_size(32), aligned(32)));
+  typedef long long __jacl_m256i_u __attribute__((vector_size(32), aligned(1), __may_alias__));
+  typedef char __jacl_v32qi __attribute__((vector_size(32)));
+
+  static inline __m256i _mm256_setzero_si256(void) { return (__m256i){ 0, 0, 0, 0 }; }
+  static inline __m256i _mm256_set1_epi8(char c) { __m128i h = _mm_set1_epi8(c); return (__m256i){ h[0], h[1], h[0], h[1] }; }
+  static inline __m256i _mm256_loadu_si256(const __m256i *p) { return *(const __jacl_m256i_u*)p; }
+  static inline void _mm256_storeu_si256(__m256i *p, __m256i v) { *(__jacl_m256i_u*)p = v; }
+  static inline __m256i _mm256_cmpeq_epi8(__m256i a, __m256i b) { return (__m256i)((__jacl_v32qi)a == (__jacl_v32qi)b); }
+  static inline __m256i _mm256_or_si256(__m256i a, __m256i b) { return a | b; }
+  static inline int _mm256_movemask_epi8(__m256i v) { return __builtin_ia32_pmovmskb256((__jacl_v32qi)v); }
+#endif
+
 /* ============================================================ */
 /* Trigonometry (Auto-Vectorized)                               */
 /* ============================================================ */
@@ -0,0 +1,72 @@
+/* (c) 2026 FRINKnet & Friends – MIT licence */
+#ifndef _MALLOC_H
+#define _MALLOC_H
+#pragma once
+
+#include <config.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================= */
+/* Heap Maintenance                                              */
+/* ============================================================= */
+
+/**
+ * Hand idle heap memory back to the OS right away instead of waiting for the
+ * JACL_PURGE_DECAY / JACL_UNMAP_DECAY timers. Empty segments are unmapped
+ * except for up to `pad` bytes, which stay mapped but purged. The calling
+ * thread's cache is flushed first. Returns 1 if anything was released.
+ */
+int malloc_trim(size_t pad);
+
+/* ============================================================= */
+/* Introspection                                                 */
+/* ============================================================= */
+
+/**
+ * Heap census in glibc's layout. `arena` is the static heap plus every
+ * segment; it splits into `uordblks` in use, `fordblks` free in the shared
+ * bins (`ordblks` blocks) and `fsmblks` parked in thread caches (`smblks`
+ * blocks). `hblks` / `hblkhd` are the huge blocks with mappings of their own
+ * and `keepcost` is what malloc_trim(0) could hand back right now.
+ */
+struct mallinfo2 {
+	size_t arena;
+	size_t ordblks;
+	size_t smblks;
+	size_t hblks;
+	size_t hblkhd;
+	size_t usmblks;
+	size_t fsmblks;
+	size_t uordblks;
+	size_t fordblks;
+	size_t keepcost;
+};
+
+struct mallinfo2 mallinfo2(void);
+
+/** Bytes the caller may actually use at p, at least what was asked for. */
+size_t malloc_usable_size(void* p);
+
+/**
+ * Print a summary to stderr. Built with JACL_MALLOC_STATS the per-thread
+ * counters (cache and bin hit rates, lock waits, coalesces, ...) follow.
+ */
+void malloc_stats(void);
+
+/**
+ * Write the heap census and counters to `stream` as one line of JSON rather
+ * than glibc's XML. `options` must be 0. Returns 0, or -1 with errno set.
+ */
+int malloc_info(int options, FILE* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MALLOC_H */
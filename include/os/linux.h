@@ -8,6 +8,8 @@
 	#define JACL_BIN elf
 	#define JACL_BIN_ELF 1
 	#define __jacl_os_init      __linux_init
+	#define __jacl_os_tls_size  __linux_tls_size
+	#define __jacl_os_tls_init  __linux_tls_init
 	#define __jacl_os_syscall   __linux_syscall
 	#define __jacl_os_stat      __linux_stat
 	#define __jacl_os_statnorm  __linux_statnorm
@@ -49,33 +51,53 @@
 	#include JACL_ARCH_FILE
 #endif
 
-static inline void __linux_init(void) {
+static inline size_t __linux_tls_size(void) {
 	size_t tls_size, tls_align, tls_init_size;
 	void* tls_image;
 
-	/* 1. Get TLS metadata from format (PT_TLS) */
-	if (!__jacl_tls_get_info(&tls_size, &tls_align, &tls_image, &tls_init_size)) return;
-	if (tls_size == 0) return;
+	/* Get TLS metadata from format (PT_TLS) */
+	if (!__jacl_tls_get_info(&tls_size, &tls_align, &tls_image, &tls_init_size)) return 0;
+	if (tls_size == 0) return 0;
 
-	/* 2. Allocate TLS+TCB (Linux-specific) */
-	size_t total = tls_size + tls_align + JACL_TCB_SIZE;
-	void* mem = mmap(NULL, total, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	return tls_size + tls_align + JACL_TCB_SIZE;
+}
 
-	if (mem == MAP_FAILED) return;
+/* Lay out TLS+TCB in mem (at least __linux_tls_size bytes) and return the thread pointer */
+static inline void* __linux_tls_init(void* mem) {
+	size_t tls_size, tls_align, tls_init_size;
+	void* tls_image;
+
+	if (!__jacl_tls_get_info(&tls_size, &tls_align, &tls_image, &tls_init_size)) return NULL;
 
-	/* 3. Compute aligned addresses */
+	/* 1. Compute aligned addresses */
 	uintptr_t tls_base = JACL_ALIGN_UP((uintptr_t)mem, tls_align);
 	uintptr_t tcb_addr = tls_base + JACL_ALIGN_UP(tls_size, tls_align);
 
-	/* 4. Initialize TLS data */
+	/* 2. Initialize TLS data */
 	if (tls_image && tls_init_size > 0) memcpy((void*)tls_base, tls_image, tls_init_size);
 	if (tls_size > tls_init_size) memset((void*)(tls_base + tls_init_size), 0, tls_size - tls_init_size);
 
-	/* 5. Set TCB self-pointer */
+	/* 3. Set TCB self-pointer */
+	memset((void*)tcb_addr, 0, JACL_TCB_SIZE);
+
 	*(void**)tcb_addr = (void*)tcb_addr;
 
-	/* 6. Install TLS pointer */
-	__jacl_arch_tls_set((void*)tcb_addr);
+	return (void*)tcb_addr;
+}
+
+static inline void __linux_init(void) {
+	/* 1. Size TLS+TCB (Linux-specific) */
+	size_t total = __linux_tls_size();
+
+	if (!total) return;
+
+	/* 2. Allocate and lay out */
+	void* mem = mmap(NULL, total, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+	if (mem == MAP_FAILED) return;
+
+	/* 3. Install TLS pointer */
+	__jacl_arch_tls_set(__linux_tls_init(mem));
 }
 
 #undef __OS_INIT
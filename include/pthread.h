@@ -5,6 +5,7 @@
 
 #include <config.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
@@ -76,9 +77,45 @@ extern "C" {
 #define PTHREAD_DETACHED_WAIT       5000
 #endif
 
+/**
+ * NOTE: A mutex word is FREE, HELD, or QUEUED when it is held and somebody
+ * may be asleep on it (Drepper's "Futexes Are Tricky", mutex 3). Locking is
+ * one CAS from FREE to HELD and unlocking swaps FREE back in, entering the
+ * kernel only if the old word was QUEUED, so an uncontended lock and unlock
+ * never make a syscall. A locker that finds the word HELD spins for up to
+ * JACL_MUTEX_SPIN pauses hoping the holder is nearly done, gives up at once
+ * on QUEUED since there's already a line, then marks the word QUEUED and
+ * sleeps. Process-private mutexes use the private futex operations.
+ */
+#ifndef JACL_MUTEX_SPIN
+#define JACL_MUTEX_SPIN             100
+#endif
+
+/**
+ * NOTE: A thread's stack, TLS block, control block and start arguments all
+ * come out of one mapping: a PROT_NONE guard page at the bottom, the control
+ * block with the arguments behind it at the top, TLS just below, so creating
+ * a thread costs one mmap at most and nothing from malloc. Once the kernel
+ * has cleared a thread's ctid it is off that mapping for good, and its joiner
+ * (or, for a detached thread, the next pthread_create) parks the mapping in a
+ * cache of up to JACL_STACK_CACHE, where the next create asking for the same
+ * size picks it up. pthread_prewarm_np fills the cache ahead of time. Only
+ * Linux says when a thread is gone, so elsewhere used stacks aren't reused.
+ */
+#ifndef JACL_STACK_CACHE
+#define JACL_STACK_CACHE            16
+#endif
+#ifndef JACL_STACK_SIZE
+#define JACL_STACK_SIZE             (1024 * 1024)
+#endif
+
+#define __JACL_MUTEX_FREE           0
+#define __JACL_MUTEX_HELD           1
+#define __JACL_MUTEX_QUEUED         2
+
 #define PTHREAD_ONCE_INIT               {0}
-#define PTHREAD_MUTEX_INITIALIZER       { 0, 0, PTHREAD_MUTEX_NORMAL, 0 }
-#define PTHREAD_COND_INITIALIZER        { 0, 0 }
+#define PTHREAD_MUTEX_INITIALIZER       { 0, 0, PTHREAD_MUTEX_NORMAL, 0, PTHREAD_PROCESS_PRIVATE }
+#define PTHREAD_COND_INITIALIZER        { 0, 0, CLOCK_REALTIME, 0, NULL }
 #define PTHREAD_RWLOCK_INITIALIZER      { 0, 0, 0, 0 }
 #define PTHREAD_BARRIER_INITIALIZER     { 0, 0, 0, 0 }
 #define PTHREAD_SPIN_LOCK_INITIALIZER   { 0 }
@@ -99,12 +136,17 @@ extern thread_local void *__jacl_pthread_tls_values[MAX_TLS_KEYS];
 extern pthread_key_t __jacl_pthread_self_key;
 extern void (*__jacl_pthread_key_destructors[MAX_TLS_KEYS])(void *);
 extern _Atomic int __jacl_pthread_inited;
+extern size_t __jacl_tls_size(void);
+extern void *__jacl_tls_init(void *mem);
+extern void __jacl_tls_install(void *tp);
+extern void __jacl_memcache_exit(void);
 #endif
 
 typedef struct {
 	void *(*start_routine)(void *);
 	void *arg;
 	pthread_t thread_ptr;
+	void *tls;
 } __jacl_thread_arg_t;
 
 typedef struct __jacl_atfork_handler {
@@ -118,25 +160,135 @@ extern __jacl_atfork_handler_t *__jacl_atfork_list;
 extern pthread_spinlock_t __jacl_atfork_lock;
 
 #if PTHREAD_POSIX
+extern pthread_t __jacl_pthread_stack_cache;
+extern pthread_t __jacl_pthread_stack_dead;
+extern unsigned __jacl_pthread_stack_cached;
+extern pthread_spinlock_t __jacl_pthread_stack_lock;
+#endif
+
+#if PTHREAD_POSIX
+
+/* the kernel thread id never changes, so each thread asks once (fork clears it) */
+extern thread_local pid_t __jacl_pthread_tid;
+
+/**
+ * NOTE: Timed waits hand the kernel an absolute deadline rather than polling
+ * the clock. Linux's FUTEX_WAIT_BITSET takes one on CLOCK_MONOTONIC, or on
+ * CLOCK_REALTIME with FUTEX_CLOCK_REALTIME, and FreeBSD's _umtx_op takes an
+ * absolute _umtx_time; Darwin's ulock only knows a relative timeout in
+ * microseconds, so that is worked out afresh for every sleep. A NULL deadline
+ * waits for ever. __jacl_pthread_futex_timedwait returns -ETIMEDOUT once the
+ * deadline has passed and 0 otherwise, however it woke, so callers recheck
+ * their word. __jacl_pthread_futex_requeue wakes one sleeper on addr and
+ * moves the rest onto `to` unless addr no longer holds val; it fails where
+ * the kernel can't do that.
+ */
+static inline int __jacl_pthread_expired(clockid_t clock, const struct timespec *abstime) {
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+
+	return now.tv_sec > abstime->tv_sec || (now.tv_sec == abstime->tv_sec && now.tv_nsec >= abstime->tv_nsec);
+}
 
 #if JACL_OS_LINUX
-	static inline pid_t __jacl_pthread_gettid(void) { return (pid_t)syscall(SYS_gettid); }
+	static inline pid_t __jacl_pthread_gettid(void) { return __jacl_pthread_tid ? __jacl_pthread_tid : (__jacl_pthread_tid = (pid_t)syscall(SYS_gettid)); }
 	static inline int __jacl_pthread_futex_wait(void *addr, int val) { return syscall(SYS_futex, addr, 0, val, NULL, NULL, 0); }
 	static inline int __jacl_pthread_futex_wake(void *addr, int num) { return syscall(SYS_futex, addr, 1, num, NULL, NULL, 0); }
+	/* FUTEX_PRIVATE_FLAG: no shared-mapping lookup in the kernel */
+	static inline int __jacl_pthread_futex_wait_private(void *addr, int val) { return syscall(SYS_futex, addr, 128, val, NULL, NULL, 0); }
+	static inline int __jacl_pthread_futex_wake_private(void *addr, int num) { return syscall(SYS_futex, addr, 129, num, NULL, NULL, 0); }
+	static inline int __jacl_pthread_futex_timedwait(void *addr, int val, clockid_t clock, const struct timespec *abstime, int shared) {
+		if (abstime && abstime->tv_sec < 0) return -ETIMEDOUT;
+
+		/* FUTEX_WAIT_BITSET with FUTEX_BITSET_MATCH_ANY is FUTEX_WAIT with an absolute timeout */
+		int op = 9 | (shared ? 0 : 128) | (abstime && clock == CLOCK_REALTIME ? 256 : 0);
+
+		if (syscall(SYS_futex, addr, op, val, abstime, NULL, -1) == 0) return 0;
+
+		/* the word test comes before the clock, so a caller spinning on a
+		   moved word learns of the deadline here */
+		return errno == ETIMEDOUT || (abstime && __jacl_pthread_expired(clock, abstime)) ? -ETIMEDOUT : 0;
+	}
+	/* FUTEX_CMP_REQUEUE passes the requeue count in the timeout slot */
+	static inline int __jacl_pthread_futex_requeue(void *addr, int val, void *to, int shared) { return syscall(SYS_futex, addr, 4 | (shared ? 0 : 128), 1, INT_MAX, to, val) < 0 ? -1 : 0; }
 #elif JACL_OS_DARWIN
-	static inline pid_t __jacl_pthread_gettid(void) { return (pid_t)syscall(SYS_thread_selfid); }
+	static inline pid_t __jacl_pthread_gettid(void) { return __jacl_pthread_tid ? __jacl_pthread_tid : (__jacl_pthread_tid = (pid_t)syscall(SYS_thread_selfid)); }
 	extern int __ulock_wait(uint32_t, void *, uint64_t, uint32_t);
 	extern int __ulock_wake(uint32_t, void *);
 	static inline int __jacl_pthread_futex_wait(void *addr, int val) { return syscall(SYS_ulock_wait, 1, addr, val, 0); }
 	static inline int __jacl_pthread_futex_wake(void *addr, int num) { uint32_t op = (num == 1) ? 0x101 : 0x100; return syscall(SYS_ulock_wake, op, addr); }
+	/* UL_COMPARE_AND_WAIT is already process private */
+	static inline int __jacl_pthread_futex_wait_private(void *addr, int val) { return __jacl_pthread_futex_wait(addr, val); }
+	static inline int __jacl_pthread_futex_wake_private(void *addr, int num) { return __jacl_pthread_futex_wake(addr, num); }
+	static inline int __jacl_pthread_futex_timedwait(void *addr, int val, clockid_t clock, const struct timespec *abstime, int shared) {
+		uint32_t us = 0;
+
+		(void)shared;
+
+		if (abstime) {
+			struct timespec now;
+
+			clock_gettime(clock, &now);
+
+			long long left = (long long)(abstime->tv_sec - now.tv_sec) * 1000000 + (abstime->tv_nsec - now.tv_nsec + 999) / 1000;
+
+			if (left <= 0) return -ETIMEDOUT;
+
+			us = left > UINT32_MAX ? UINT32_MAX : (uint32_t)left;
+		}
+
+		syscall(SYS_ulock_wait, 1, addr, val, us);
+
+		return abstime && __jacl_pthread_expired(clock, abstime) ? -ETIMEDOUT : 0;
+	}
+	static inline int __jacl_pthread_futex_requeue(void *addr, int val, void *to, int shared) { (void)addr; (void)val; (void)to; (void)shared; return -1; }
 #elif JACL_OS_FREEBSD
-	static inline pid_t __jacl_pthread_gettid(void) { long tid; syscall(SYS_thr_self, &tid); return (pid_t)tid; }
+	static inline pid_t __jacl_pthread_gettid(void) { long tid; if (!__jacl_pthread_tid) { syscall(SYS_thr_self, &tid); __jacl_pthread_tid = (pid_t)tid; } return __jacl_pthread_tid; }
 	static inline int __jacl_pthread_futex_wait(void *addr, int val) { return syscall(SYS__umtx_op, addr, 3, val, NULL, NULL); }
 	static inline int __jacl_pthread_futex_wake(void *addr, int num) { return syscall(SYS__umtx_op, addr, 4, num, NULL, NULL); }
+	/* UMTX_OP_WAIT_UINT_PRIVATE / UMTX_OP_WAKE_PRIVATE */
+	static inline int __jacl_pthread_futex_wait_private(void *addr, int val) { return syscall(SYS__umtx_op, addr, 15, val, NULL, NULL); }
+	static inline int __jacl_pthread_futex_wake_private(void *addr, int num) { return syscall(SYS__umtx_op, addr, 16, num, NULL, NULL); }
+	static inline int __jacl_pthread_futex_timedwait(void *addr, int val, clockid_t clock, const struct timespec *abstime, int shared) {
+		/* struct _umtx_time with UMTX_ABSTIME */
+		struct { struct timespec timeout; uint32_t flags; uint32_t clockid; } ut;
+
+		if (!abstime) { syscall(SYS__umtx_op, addr, shared ? 3 : 15, val, NULL, NULL); return 0; }
+
+		ut.timeout = *abstime; ut.flags = 1; ut.clockid = (uint32_t)clock;
+		syscall(SYS__umtx_op, addr, shared ? 3 : 15, val, (void *)sizeof ut, &ut);
+
+		return __jacl_pthread_expired(clock, abstime) ? -ETIMEDOUT : 0;
+	}
+	static inline int __jacl_pthread_futex_requeue(void *addr, int val, void *to, int shared) { (void)addr; (void)val; (void)to; (void)shared; return -1; }
 #else
 	static inline pid_t __jacl_pthread_gettid(void) { return getpid(); }
 	static inline int __jacl_pthread_futex_wait(void *addr, int val) { return -1; }
 	static inline int __jacl_pthread_futex_wake(void *addr, int num) { return -1; }
+	static inline int __jacl_pthread_futex_wait_private(void *addr, int val) { return -1; }
+	static inline int __jacl_pthread_futex_wake_private(void *addr, int num) { return -1; }
+	/* nothing to sleep on, so nap and let the caller look again */
+	static inline int __jacl_pthread_futex_timedwait(void *addr, int val, clockid_t clock, const struct timespec *abstime, int shared) {
+		struct timespec nap = {0, 1000000};
+
+		(void)addr; (void)val; (void)shared;
+
+		if (abstime && __jacl_pthread_expired(clock, abstime)) return -ETIMEDOUT;
+
+		nanosleep(&nap, NULL);
+
+		return abstime && __jacl_pthread_expired(clock, abstime) ? -ETIMEDOUT : 0;
+	}
+	static inline int __jacl_pthread_futex_requeue(void *addr, int val, void *to, int shared) { (void)addr; (void)val; (void)to; (void)shared; return -1; }
+#endif
+
+#if JACL_ARCH_X64 || JACL_ARCH_X86
+	#define __jacl_pthread_relax() __asm__ volatile("pause" ::: "memory")
+#elif JACL_ARCH_ARM64
+	#define __jacl_pthread_relax() __asm__ volatile("yield" ::: "memory")
+#else
+	#define __jacl_pthread_relax() __asm__ volatile("" ::: "memory")
 #endif
 
 static inline void __jacl_pthread_init_keys(void) {
@@ -169,7 +321,8 @@ static inline int __jacl_pthread_attr_is_valid(const pthread_attr_t *attr) { if
 static inline int __jacl_pthread_mutex_is_valid(const pthread_mutex_t *mutex) {
 	if (!mutex) return 0;
 	int f = atomic_load(&mutex->futex);
-	if (f != 0 && f != 1) return 0;
+	if (f < __JACL_MUTEX_FREE || f > __JACL_MUTEX_QUEUED) return 0;
+	if (mutex->pshared != PTHREAD_PROCESS_PRIVATE && mutex->pshared != PTHREAD_PROCESS_SHARED) return 0;
 	if (mutex->type != PTHREAD_MUTEX_NORMAL && mutex->type != PTHREAD_MUTEX_RECURSIVE && mutex->type != PTHREAD_MUTEX_ERRORCHECK && mutex->type != PTHREAD_MUTEX_ROBUST) return 0;
 	return 1;
 }
@@ -185,49 +338,134 @@ static inline void __jacl_pthread_destroy(void) {
 	} while (had_values && --iterations > 0);
 }
 static inline void __jacl_pthread_set_self(pthread_t thread_ptr) { if (__jacl_pthread_self_key < MAX_TLS_KEYS) __jacl_pthread_tls_values[__jacl_pthread_self_key] = thread_ptr; }
+static inline int pthread_spin_lock(pthread_spinlock_t *lock);
+static inline int pthread_spin_unlock(pthread_spinlock_t *lock);
+
+/* the control block and the argument block behind it, rounded to a cache line */
+#define __JACL_TCB_SIZE (((sizeof(struct __jacl_pthread) + sizeof(__jacl_thread_arg_t)) + 63) & ~(size_t)63)
+
+static inline size_t __jacl_pthread_stack_bytes(size_t stack_size) {
+	/* room for the thread's own TLS block comes on top of the stack asked for */
+	size_t tls_size = __jacl_tls_size();
+	if (tls_size) stack_size += tls_size + 63;
+	return ((stack_size + PAGESIZE - 1) & ~(size_t)(PAGESIZE - 1)) + PAGESIZE;
+}
+static inline pthread_t __jacl_pthread_stack_map(size_t size) {
+	void *map = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK, -1, 0);
+	if (map == MAP_FAILED) return NULL;
+	mprotect(map, PAGESIZE, PROT_NONE);
+	/* fresh pages are zero, so the control block needs no clearing */
+	pthread_t t = (pthread_t)((char *)map + size - __JACL_TCB_SIZE);
+	t->stack = map; t->stack_size = size; t->stack_is_mmap = 1;
+	return t;
+}
+/* park a mapping nobody runs on any more; 0 if the cache was full and it went back to the OS */
+static inline int __jacl_pthread_stack_put(pthread_t t) {
+	void *map = t->stack;
+	size_t size = t->stack_size;
+	pthread_spin_lock(&__jacl_pthread_stack_lock);
+	if (__jacl_pthread_stack_cached < JACL_STACK_CACHE) {
+		t->next = __jacl_pthread_stack_cache;
+		__jacl_pthread_stack_cache = t;
+		__jacl_pthread_stack_cached++;
+		map = NULL;
+	}
+	pthread_spin_unlock(&__jacl_pthread_stack_lock);
+	if (map) munmap(map, size);
+	return !map;
+}
+static inline pthread_t __jacl_pthread_stack_get(size_t size) {
+	pthread_t t = NULL, gone = NULL;
+	pthread_spin_lock(&__jacl_pthread_stack_lock);
+	/* detached threads the kernel has since seen off */
+	for (pthread_t *p = &__jacl_pthread_stack_dead; *p; ) {
+		pthread_t dead = *p;
+		if (atomic_load(&dead->ctid)) { p = &dead->next; continue; }
+		*p = dead->next;
+		dead->next = gone;
+		gone = dead;
+	}
+	for (pthread_t *p = &__jacl_pthread_stack_cache; *p; p = &(*p)->next) {
+		if ((*p)->stack_size != size) continue;
+		t = *p;
+		*p = t->next;
+		__jacl_pthread_stack_cached--;
+		break;
+	}
+	pthread_spin_unlock(&__jacl_pthread_stack_lock);
+	while (gone) {
+		pthread_t next = gone->next;
+		if (!t && gone->stack_size == size) t = gone;
+		else __jacl_pthread_stack_put(gone);
+		gone = next;
+	}
+	if (!t) return __jacl_pthread_stack_map(size);
+	void *map = t->stack;
+	memset(t, 0, __JACL_TCB_SIZE);
+	t->stack = map; t->stack_size = size; t->stack_is_mmap = 1;
+	return t;
+}
+/* a detached thread's mapping waits on the dead list until its ctid clears;
+   whichever of exit and pthread_detach comes second claims it via `joined` */
+static inline void __jacl_pthread_bury(pthread_t t) {
+	#if JACL_OS_LINUX
+		int expected = 0;
+		if (!t->stack || !atomic_compare_exchange_strong(&t->joined, &expected, 1)) return;
+		pthread_spin_lock(&__jacl_pthread_stack_lock);
+		t->next = __jacl_pthread_stack_dead;
+		__jacl_pthread_stack_dead = t;
+		pthread_spin_unlock(&__jacl_pthread_stack_lock);
+	#else
+		(void)t;
+	#endif
+}
+static inline void __jacl_pthread_finish(pthread_t t) {
+	atomic_store(&t->finished, 1);
+	#if !JACL_OS_LINUX
+		__jacl_pthread_futex_wake(&t->finished, INT_MAX);
+	#endif
+	if (atomic_load(&t->detached)) __jacl_pthread_bury(t);
+}
 static inline int __jacl_pthread_entry(void *arg) {
 	__jacl_thread_arg_t *ta = (__jacl_thread_arg_t *)arg;
+	if (ta->tls) __jacl_tls_install(ta->tls);
 	pthread_t t = ta->thread_ptr;
+	/* our parent may not have stored it yet, and pthread_self checks it */
+	if (t) t->tid = __jacl_pthread_gettid();
+	#if JACL_OS_LINUX
+		/* CLONE_CHILD_CLEARTID after the fact: the kernel zeroes ctid and wakes it once we're gone */
+		if (t) syscall(SYS_set_tid_address, &t->ctid);
+	#endif
 	__jacl_pthread_set_self(t);
 	void *result = NULL;
 	int err = EINVAL;
 	if (t != NULL) { result = ta->start_routine(ta->arg); t->result = result; err = 0; }
-	atomic_store(&t->finished, 1);
-	free(ta);
+	__jacl_memcache_exit();
+	if (t) __jacl_pthread_finish(t);
 	return err;
 }
 static inline pid_t __jacl_pthread_clone_thread(void *stack, size_t stack_size, int (*fn)(void *), void *arg) { return __jacl_arch_clone_thread(stack, stack_size, fn, arg); }
 static inline int pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start_routine)(void *), void *arg) {
 	if (!thread || !start_routine) return EINVAL;
 	__jacl_pthread_init_keys();
-	pthread_t t = calloc(1, sizeof *t);
-	if (!t) return ENOMEM;
-	__jacl_thread_arg_t *ta = malloc(sizeof *ta);
-	if (!ta) { free(t); return ENOMEM; }
-	size_t stack_size = (attr && attr->stack_size) ? attr->stack_size : 1024 * 1024;
-	void *stack = NULL;
-	int stack_is_mmap = 0;
-	stack = mmap(NULL, stack_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK, -1, 0);
-	if (stack != MAP_FAILED) stack_is_mmap = 1;
-	else stack = NULL;
-	if (!stack) {
-		stack = malloc(stack_size);
-		if (!stack) { free(ta); free(t); return ENOMEM; }
-		stack_is_mmap = 0;
-	}
-	ta->start_routine = start_routine; ta->arg = arg; ta->thread_ptr = t;
-	t->stack = stack; t->stack_size = stack_size; t->stack_is_mmap = stack_is_mmap;
-	t->result = NULL;
-	atomic_store(&t->finished, 0);
+	size_t size = __jacl_pthread_stack_bytes((attr && attr->stack_size) ? attr->stack_size : JACL_STACK_SIZE);
+	pthread_t t = __jacl_pthread_stack_get(size);
+	if (!t) return EAGAIN;
+	__jacl_thread_arg_t *ta = (__jacl_thread_arg_t *)(t + 1);
+	ta->start_routine = start_routine; ta->arg = arg; ta->thread_ptr = t; ta->tls = NULL;
 	atomic_store(&t->detached, (attr && attr->detached) ? 1 : 0);
-	atomic_store(&t->joined, 0);
-	pid_t tid = __jacl_pthread_clone_thread(stack, stack_size, __jacl_pthread_entry, ta);
-	if (tid > 0) { t->tid = tid; *thread = t; return 0; }
-	if (stack) {
-		if (stack_is_mmap) munmap(stack, stack_size);
-		else free(stack);
+	atomic_store(&t->ctid, 1);
+	/* the thread's own TLS block sits just below its control block */
+	char *base = (char *)t->stack + PAGESIZE, *top = (char *)t;
+	size_t tls_size = __jacl_tls_size();
+	if (tls_size && tls_size + 63 < (size_t)(top - base)) {
+		top = (char *)((uintptr_t)(top - tls_size) & ~(uintptr_t)63);
+		ta->tls = __jacl_tls_init(top);
 	}
-	free(ta); free(t); return EAGAIN;
+	pid_t tid = __jacl_pthread_clone_thread(base, (size_t)(top - base), __jacl_pthread_entry, ta);
+	if (tid > 0) { t->tid = tid; *thread = t; return 0; }
+	__jacl_pthread_stack_put(t);
+	return EAGAIN;
 }
 static inline int pthread_join(pthread_t thread, void **retval) {
 	if (!thread) return EINVAL;
@@ -235,12 +473,22 @@ static inline int pthread_join(pthread_t thread, void **retval) {
 	__jacl_pthread_init_keys();
 	int expected = 0;
 	if (!atomic_compare_exchange_strong(&thread->joined, &expected, 1)) return EINVAL;
-	struct timespec ts = {0, 100000};
-	while (!atomic_load(&thread->finished)) {
-		if (atomic_load(&thread->detached)) return ESRCH;
-		nanosleep(&ts, NULL);
+	if (atomic_load(&thread->detached)) {
+		/* detached under us: hand the claim back, and bury it ourselves if its exit already tried */
+		atomic_store(&thread->joined, 0);
+		if (atomic_load(&thread->finished)) __jacl_pthread_bury(thread);
+		return ESRCH;
 	}
+	#if JACL_OS_LINUX
+		/* the kernel's wake is a shared one, so the wait must be too */
+		for (int ctid; (ctid = atomic_load(&thread->ctid)); ) __jacl_pthread_futex_wait(&thread->ctid, ctid);
+	#else
+		while (!atomic_load(&thread->finished)) __jacl_pthread_futex_timedwait(&thread->finished, 0, CLOCK_REALTIME, NULL, 1);
+	#endif
 	if (retval) *retval = thread->result;
+	#if JACL_OS_LINUX
+		if (thread->stack) __jacl_pthread_stack_put(thread);
+	#endif
 	return 0;
 }
 static inline pthread_t pthread_self(void) {
@@ -256,7 +504,7 @@ static inline noreturn void pthread_exit(void *retval) {
 	if (self) {
 		self->result = retval;
 
-		atomic_store(&self->finished, 1);
+		__jacl_pthread_finish(self);
 		__jacl_pthread_destroy();
 
 		__jacl_cleanup_node_t *item = self->cleanup_stack;
@@ -268,6 +516,8 @@ static inline noreturn void pthread_exit(void *retval) {
 
 			item = next;
 		}
+
+		__jacl_memcache_exit();
 	}
 
 	#if JACL_OS_LINUX
@@ -286,16 +536,55 @@ static inline int pthread_detach(pthread_t thread) {
 	__jacl_pthread_register_self();
 	int expected = 0;
 	if (!atomic_compare_exchange_strong(&thread->detached, &expected, 1)) return EINVAL;
+	if (atomic_load(&thread->finished)) __jacl_pthread_bury(thread);
+	return 0;
+}
+/* map `count` stacks of `stacksize` (0 for the default) into the cache, stopping once it's full */
+static inline int pthread_prewarm_np(unsigned count, size_t stacksize) {
+	size_t size = __jacl_pthread_stack_bytes(stacksize ? stacksize : JACL_STACK_SIZE);
+	while (count--) {
+		pthread_t t = __jacl_pthread_stack_map(size);
+		if (!t) return ENOMEM;
+		if (!__jacl_pthread_stack_put(t)) break;
+	}
 	return 0;
 }
 static inline int pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr) {
 	if (!mutex) return EINVAL;
 	int type = (attr && attr->type) ? attr->type : PTHREAD_MUTEX_NORMAL;
 	if (type != PTHREAD_MUTEX_NORMAL && type != PTHREAD_MUTEX_RECURSIVE && type != PTHREAD_MUTEX_ERRORCHECK && type != PTHREAD_MUTEX_ROBUST) return EINVAL;
-	atomic_store(&mutex->futex, 0);
+	atomic_store(&mutex->futex, __JACL_MUTEX_FREE);
 	mutex->owner = 0; mutex->type = type; mutex->recursive_count = 0;
+	mutex->pshared = attr ? attr->pshared : PTHREAD_PROCESS_PRIVATE;
+	return 0;
+}
+static inline int __jacl_pthread_mutex_acquire(pthread_mutex_t *mutex, clockid_t clock, const struct timespec *abstime) {
+	int state = __JACL_MUTEX_FREE;
+
+	if (atomic_compare_exchange_strong(&mutex->futex, &state, __JACL_MUTEX_HELD)) return 0;
+
+	/* short critical sections usually end within the spin; a queue means they don't */
+	for (int spin = JACL_MUTEX_SPIN; spin-- && state == __JACL_MUTEX_HELD; ) {
+		__jacl_pthread_relax();
+
+		if ((state = atomic_load_explicit(&mutex->futex, memory_order_relaxed)) == __JACL_MUTEX_FREE && atomic_compare_exchange_weak(&mutex->futex, &state, __JACL_MUTEX_HELD)) return 0;
+	}
+
+	/* whoever takes it from here takes it queued, since others may be asleep;
+	   a waiter that times out looks once more, as the wake may have been its */
+	while (atomic_exchange(&mutex->futex, __JACL_MUTEX_QUEUED) != __JACL_MUTEX_FREE) {
+		if (__jacl_pthread_futex_timedwait(&mutex->futex, __JACL_MUTEX_QUEUED, clock, abstime, mutex->pshared) == -ETIMEDOUT)
+			return atomic_exchange(&mutex->futex, __JACL_MUTEX_QUEUED) == __JACL_MUTEX_FREE ? 0 : ETIMEDOUT;
+	}
+
 	return 0;
 }
+static inline void __jacl_pthread_mutex_release(pthread_mutex_t *mutex) {
+	if (atomic_exchange(&mutex->futex, __JACL_MUTEX_FREE) != __JACL_MUTEX_QUEUED) return;
+
+	if (mutex->pshared) __jacl_pthread_futex_wake(&mutex->futex, 1);
+	else __jacl_pthread_futex_wake_private(&mutex->futex, 1);
+}
 static inline int pthread_mutex_lock(pthread_mutex_t *mutex) {
 	if (!mutex) return EINVAL;
 
@@ -312,27 +601,7 @@ static inline int pthread_mutex_lock(pthread_mutex_t *mutex) {
 		}
 	}
 
-	int expected = 0;
-
-	while (!atomic_compare_exchange_weak(&mutex->futex, &expected, 1)) {
-		expected = 0;
-
-		int ret = __jacl_pthread_futex_wait(&mutex->futex, 1);
-
-		/* Handle Robust Mutex Death */
-		if (ret != 0 && errno == EOWNERDEAD) {
-			mutex->owner = 0; /* Clear dead owner */
-
-			return EOWNERDEAD;
-		}
-
-		/* Spurious wakeups or errors: backoff */
-		if (ret != 0) {
-			struct timespec ts = {0, 1000};
-
-			nanosleep(&ts, NULL);
-		}
-	}
+	__jacl_pthread_mutex_acquire(mutex, CLOCK_REALTIME, NULL);
 
 	mutex->owner = __jacl_pthread_gettid();
 
@@ -345,37 +614,26 @@ static inline int pthread_mutex_trylock(pthread_mutex_t *mutex) {
 	if (mutex->type == PTHREAD_MUTEX_ERRORCHECK) { pid_t tid = __jacl_pthread_gettid(); if (mutex->owner == tid) return EDEADLK; }
 	if (mutex->type == PTHREAD_MUTEX_RECURSIVE) { pid_t tid = __jacl_pthread_gettid(); if (mutex->owner == tid) { mutex->recursive_count++; return 0; } }
 	int expected = 0;
-	if (atomic_compare_exchange_strong(&mutex->futex, &expected, 1)) {
+	if (atomic_compare_exchange_strong(&mutex->futex, &expected, __JACL_MUTEX_HELD)) {
 		mutex->owner = __jacl_pthread_gettid();
 		if (mutex->type == PTHREAD_MUTEX_RECURSIVE) mutex->recursive_count = 1;
 		return 0;
 	}
 	return EBUSY;
 }
-static inline int pthread_mutex_timedlock(pthread_mutex_t *mutex, const struct timespec *ts) {
-	if (!mutex || !ts) return EINVAL;
-	if (ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000) return EINVAL;
+static inline int pthread_mutex_clocklock(pthread_mutex_t *mutex, clockid_t clock_id, const struct timespec *abstime) {
+	if (!mutex || !abstime) return EINVAL;
+	if (abstime->tv_nsec < 0 || abstime->tv_nsec >= 1000000000) return EINVAL;
+	if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC) return EINVAL;
 	if (mutex->type == PTHREAD_MUTEX_ERRORCHECK) { pid_t tid = __jacl_pthread_gettid(); if (mutex->owner == tid) return EDEADLK; }
 	if (mutex->type == PTHREAD_MUTEX_RECURSIVE) { pid_t tid = __jacl_pthread_gettid(); if (mutex->owner == tid) { mutex->recursive_count++; return 0; } }
-	struct timespec end, now;
-	clock_gettime(CLOCK_REALTIME, &end);
-	end.tv_sec += ts->tv_sec; end.tv_nsec += ts->tv_nsec;
-	if (end.tv_nsec >= 1000000000) { end.tv_sec++; end.tv_nsec -= 1000000000; }
-	int expected = 0, backoff = 1000;
-	while (!atomic_compare_exchange_weak(&mutex->futex, &expected, 1)) {
-		expected = 0;
-		clock_gettime(CLOCK_REALTIME, &now);
-		if (now.tv_sec > end.tv_sec || (now.tv_sec == end.tv_sec && now.tv_nsec >= end.tv_nsec)) return ETIMEDOUT;
-		struct timespec ts_wait = {0, backoff}; nanosleep(&ts_wait, NULL);
-		if (backoff < 1000000) backoff *= 2;
-	}
+	if (__jacl_pthread_mutex_acquire(mutex, clock_id, abstime)) return ETIMEDOUT;
 	mutex->owner = __jacl_pthread_gettid();
 	if (mutex->type == PTHREAD_MUTEX_RECURSIVE) mutex->recursive_count = 1;
 	return 0;
 }
-static inline int pthread_mutex_clocklock(pthread_mutex_t *mutex, clockid_t clock_id, const struct timespec *abstime) {
-	(void)clock_id;
-	return pthread_mutex_timedlock(mutex, abstime);
+static inline int pthread_mutex_timedlock(pthread_mutex_t *mutex, const struct timespec *abstime) {
+	return pthread_mutex_clocklock(mutex, CLOCK_REALTIME, abstime);
 }
 static inline int pthread_mutex_unlock(pthread_mutex_t *mutex) {
 	if (!mutex) return EINVAL;
@@ -385,8 +643,7 @@ static inline int pthread_mutex_unlock(pthread_mutex_t *mutex) {
 	} else {
 		mutex->owner = 0;
 	}
-	atomic_store(&mutex->futex, 0);
-	__jacl_pthread_futex_wake(&mutex->futex, 1);
+	__jacl_pthread_mutex_release(mutex);
 	return 0;
 }
 static inline int pthread_mutex_destroy(pthread_mutex_t *mutex) {
@@ -399,8 +656,8 @@ static inline int pthread_mutex_consistent(pthread_mutex_t *mutex) {
 	if (!mutex || mutex->type != PTHREAD_MUTEX_ROBUST) return EINVAL;
 
 	/* The mutex is now consistent. The next lock will succeed. */
-	atomic_store(&mutex->futex, 0);
-	__jacl_pthread_futex_wake(&mutex->futex, 1);
+	atomic_store(&mutex->futex, __JACL_MUTEX_QUEUED);
+	__jacl_pthread_mutex_release(mutex);
 
 	return 0;
 }
@@ -438,60 +695,73 @@ static inline int pthread_mutexattr_getrobust(const pthread_mutexattr_t *attr, i
 	*robust = attr->robust;
 	return 0;
 }
+/**
+ * NOTE: A condvar is a sequence word that signal and broadcast bump before
+ * waking, so a waiter that read it before letting go of the mutex can't miss
+ * a wakeup: the futex wait fails at once if the word has moved. Broadcast
+ * doesn't wake the whole crowd only to have it pile up on the mutex; while
+ * the broadcaster holds that mutex it wakes one waiter and requeues the rest
+ * onto the mutex word, marked QUEUED, so each unlock lets the next one in.
+ * Since a waiter can't tell whether it was requeued, it always relocks QUEUED.
+ */
 static inline int pthread_cond_init(pthread_cond_t *cond, const pthread_condattr_t *attr) {
-	(void)attr; if (!cond) return EINVAL;
-	atomic_store(&cond->futex, 0); atomic_store(&cond->waiters, 0); return 0;
-}
-static inline int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
-	if (!cond || !mutex) return EINVAL;
-	atomic_fetch_add(&cond->waiters, 1);
-	int old = atomic_load(&cond->futex);
-	pthread_mutex_unlock(mutex);
-	if (__jacl_pthread_futex_wait(&cond->futex, old) != 0) {
-		while (atomic_load(&cond->futex) == old) {
-			struct timespec ts = {0, 1000000};
-			nanosleep(&ts, NULL);
-		}
-	}
-	pthread_mutex_lock(mutex);
-	atomic_fetch_sub(&cond->waiters, 1);
+	if (!cond) return EINVAL;
+	atomic_store(&cond->futex, 0); atomic_store(&cond->waiters, 0);
+	cond->clock = attr ? attr->clock_id : CLOCK_REALTIME;
+	cond->pshared = attr ? attr->pshared == PTHREAD_PROCESS_SHARED : 0;
+	cond->mutex = NULL;
 	return 0;
 }
-static inline int pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *abstime) {
-	if (!cond || !mutex || !abstime) return EINVAL;
+static inline int __jacl_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, clockid_t clock, const struct timespec *abstime) {
 	atomic_fetch_add(&cond->waiters, 1);
-	int old = atomic_load(&cond->futex);
+	uint32_t seq = atomic_load(&cond->futex);
+	cond->mutex = mutex;
 	pthread_mutex_unlock(mutex);
-	struct timespec now;
-	while (atomic_load(&cond->futex) == old) {
-		clock_gettime(CLOCK_REALTIME, &now);
-		if (now.tv_sec > abstime->tv_sec || (now.tv_sec == abstime->tv_sec && now.tv_nsec >= abstime->tv_nsec)) {
-			pthread_mutex_lock(mutex);
-			atomic_fetch_sub(&cond->waiters, 1);
-			return ETIMEDOUT;
-		}
-		struct timespec ts = {0, 1000000}; nanosleep(&ts, NULL);
-	}
-	pthread_mutex_lock(mutex);
+	int ret = __jacl_pthread_futex_timedwait(&cond->futex, seq, clock, abstime, cond->pshared);
 	atomic_fetch_sub(&cond->waiters, 1);
-	return 0;
+	while (atomic_exchange(&mutex->futex, __JACL_MUTEX_QUEUED) != __JACL_MUTEX_FREE) __jacl_pthread_futex_timedwait(&mutex->futex, __JACL_MUTEX_QUEUED, CLOCK_REALTIME, NULL, mutex->pshared);
+	mutex->owner = __jacl_pthread_gettid();
+	if (mutex->type == PTHREAD_MUTEX_RECURSIVE) mutex->recursive_count = 1;
+	/* a wakeup that raced the deadline still counts */
+	return ret == -ETIMEDOUT && atomic_load(&cond->futex) == seq ? ETIMEDOUT : 0;
+}
+static inline int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+	if (!cond || !mutex) return EINVAL;
+	return __jacl_pthread_cond_wait(cond, mutex, cond->clock, NULL);
 }
 static inline int pthread_cond_clockwait(pthread_cond_t *cond, pthread_mutex_t *mutex, clockid_t clock_id, const struct timespec *abstime) {
-	(void)clock_id;
-	return pthread_cond_timedwait(cond, mutex, abstime);
+	if (!cond || !mutex || !abstime) return EINVAL;
+	if (abstime->tv_nsec < 0 || abstime->tv_nsec >= 1000000000) return EINVAL;
+	if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC) return EINVAL;
+	return __jacl_pthread_cond_wait(cond, mutex, clock_id, abstime);
+}
+static inline int pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *abstime) {
+	if (!cond) return EINVAL;
+	return pthread_cond_clockwait(cond, mutex, cond->clock, abstime);
+}
+static inline void __jacl_pthread_cond_wake(pthread_cond_t *cond, int num) {
+	if (cond->pshared) __jacl_pthread_futex_wake(&cond->futex, num);
+	else __jacl_pthread_futex_wake_private(&cond->futex, num);
 }
 static inline int pthread_cond_signal(pthread_cond_t *cond) {
 	if (!cond) return EINVAL;
 	if (atomic_load(&cond->waiters) > 0) {
 		atomic_fetch_add(&cond->futex, 1);
-		__jacl_pthread_futex_wake(&cond->futex, 1);
+		__jacl_pthread_cond_wake(cond, 1);
 	}
 	return 0;
 }
 static inline int pthread_cond_broadcast(pthread_cond_t *cond) {
 	if (!cond) return EINVAL;
-	int w = atomic_load(&cond->waiters);
-	if (w > 0) { atomic_fetch_add(&cond->futex, 1); __jacl_pthread_futex_wake(&cond->futex, w); }
+	if (atomic_load(&cond->waiters) == 0) return 0;
+	int seq = atomic_fetch_add(&cond->futex, 1) + 1;
+	pthread_mutex_t *mutex = cond->mutex;
+	/* only our own hold on the mutex promises the unlock that starts the line moving */
+	if (mutex && mutex->owner == __jacl_pthread_gettid() && mutex->pshared == cond->pshared) {
+		atomic_store(&mutex->futex, __JACL_MUTEX_QUEUED);
+		if (__jacl_pthread_futex_requeue(&cond->futex, seq, &mutex->futex, cond->pshared) == 0) return 0;
+	}
+	__jacl_pthread_cond_wake(cond, INT_MAX);
 	return 0;
 }
 static inline int pthread_cond_destroy(pthread_cond_t *cond) { if (!cond) return EINVAL; return 0; }
@@ -589,27 +859,22 @@ static inline int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock) {
 }
 static inline int pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock, const struct timespec *abstime) {
 	if (!rwlock || !abstime) return EINVAL;
-	struct timespec now;
+	if (abstime->tv_nsec < 0 || abstime->tv_nsec >= 1000000000) return EINVAL;
 	while (atomic_load(&rwlock->writers) != 0 || atomic_load(&rwlock->write_waiters) > 0) {
-		clock_gettime(CLOCK_REALTIME, &now);
-		if (now.tv_sec > abstime->tv_sec || (now.tv_sec == abstime->tv_sec && now.tv_nsec >= abstime->tv_nsec))
-			return ETIMEDOUT;
-		__jacl_pthread_futex_wait(&rwlock->writers, 1);
+		if (__jacl_pthread_futex_timedwait(&rwlock->writers, 1, CLOCK_REALTIME, abstime, 1) == -ETIMEDOUT) return ETIMEDOUT;
 	}
 	atomic_fetch_add(&rwlock->readers, 1);
 	return 0;
 }
 static inline int pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock, const struct timespec *abstime) {
 	if (!rwlock || !abstime) return EINVAL;
-	struct timespec now;
+	if (abstime->tv_nsec < 0 || abstime->tv_nsec >= 1000000000) return EINVAL;
 	atomic_fetch_add(&rwlock->write_waiters, 1);
 	while (atomic_load(&rwlock->readers) != 0 || atomic_load(&rwlock->writers) != 0) {
-		clock_gettime(CLOCK_REALTIME, &now);
-		if (now.tv_sec > abstime->tv_sec || (now.tv_sec == abstime->tv_sec && now.tv_nsec >= abstime->tv_nsec)) {
+		if (__jacl_pthread_futex_timedwait(&rwlock->readers, 0, CLOCK_REALTIME, abstime, 1) == -ETIMEDOUT) {
 			atomic_fetch_sub(&rwlock->write_waiters, 1);
 			return ETIMEDOUT;
 		}
-		__jacl_pthread_futex_wait(&rwlock->readers, 0);
 	}
 	atomic_fetch_sub(&rwlock->write_waiters, 1);
 	atomic_store(&rwlock->writers, 1);
@@ -897,6 +1162,7 @@ static inline int pthread_getcpuclockid(pthread_t thread, clockid_t *clock_id) {
 #define pthread_create(t,a,s,arg) (ENOSYS)
 #define pthread_join(t,r) (ENOSYS)
 #define pthread_detach(t) (ENOSYS)
+#define pthread_prewarm_np(n,s) (ENOSYS)
 #define pthread_atfork(r) (ENOSYS)
 #define pthread_exit(r) do { exit(0); } while(0)
 #define pthread_self() ((pthread_t){0})
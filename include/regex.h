@@ -19,6 +19,26 @@
 #define MATCH_MAX_BACKTRACK 255
 #endif
 
+#ifndef MATCH_MAX_PROG
+#define MATCH_MAX_PROG 4096
+#endif
+
+#ifndef MATCH_MAX_LITS
+#define MATCH_MAX_LITS 8
+#endif
+
+#ifndef MATCH_MAX_LITLEN
+#define MATCH_MAX_LITLEN 16
+#endif
+
+#ifndef MATCH_MAX_DFA
+#define MATCH_MAX_DFA 4096
+#endif
+
+#ifndef MATCH_MAX_BITS
+#define MATCH_MAX_BITS (32 * 1024)
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -75,6 +95,22 @@ typedef struct match_node {
 	mexec_flag_t eflags;
 } match_node_t;
 
+typedef enum {
+	MVM_CHAR, MVM_CLASS, MVM_ANY, MVM_MATCH, MVM_ASSERT, MVM_SAVE, MVM_SPLIT, MVM_JMP
+} match_op_t;
+
+typedef struct match_inst {
+	uint8_t op, flag;
+	uint32_t val, x, y;
+} match_inst_t;
+
+typedef struct match_lits {
+	uint8_t n, ic, nl, wide;
+	int32_t lead;
+	uint8_t len[MATCH_MAX_LITS];
+	char lit[MATCH_MAX_LITS][MATCH_MAX_LITLEN];
+} match_lits_t;
+
 typedef struct match_parser {
 	const char *p, *end;
 	matcher_t *m;
@@ -92,8 +128,7 @@ typedef struct matcher {
 	size_t m_nsub;
 	mcomp_flag_t cflags;
 	mexec_flag_t eflags;
-	uint8_t nlit;
-	char lit[32];
+	match_lits_t pre, req;
 	uint32_t root;
 	int nr;
 	uint32_t rlo[32];
@@ -107,8 +142,35 @@ typedef struct matcher {
 	match_node_t *arena;
 	uint32_t count;
 	uint32_t capacity;
+	match_inst_t *prog;
+	uint32_t nprog;
+	uint8_t anchored, asserts, refs, nullrep;
 } matcher_t;
 
+typedef struct __jacl_dfa __jacl_dfa_t;
+
+typedef struct matchset {
+	matcher_t *pats;
+	uint32_t n, cap;
+	match_inst_t *prog;
+	uint32_t nprog, nvm;
+	uint32_t *starts, *slow, nslow, *found;
+	uint8_t *hit;
+	uint8_t ready;
+	__jacl_dfa_t *dfa;
+} matchset_t;
+
+typedef struct __jacl_stream __jacl_stream_t;
+
+typedef struct matchstream {
+	const matcher_t *m;
+	mexec_flag_t ef;
+	matchoff_t off, fed;
+	char *hold;
+	size_t nhold, cap;
+	__jacl_stream_t *vm;
+} matchstream_t;
+
 typedef struct __jacl_rep_ws {
 	const char *path[MATCH_MAX_BACKTRACK];
 	matchoff_t cpath[MATCH_MAX_BACKTRACK][MATCH_MAX_GROUPS * 2];
@@ -121,6 +183,7 @@ typedef struct {
 	int ic, nl, ef, depth;
 	match_err_t error;
 	__jacl_rep_ws_t *rep_ws;
+	uint32_t ncap;
 } match_ctx_t;
 /* POSIX types */
 typedef matcher_t regex_t;
@@ -144,10 +207,19 @@ typedef size_t PCRE2_SIZE;
 
 /* RE2 types */
 typedef matcher_t re2_t;
+typedef matchset_t re2_set_t;
 
 extern match_err_t matchcomp(matcher_t *restrict m, const char *pat, mcomp_flag_t fl);
 extern match_err_t matchexec(const matcher_t *restrict m, const char *s, const char *end, match_find_t *pm, size_t nm, mexec_flag_t fl);
 extern void matchfree(matcher_t *restrict m);
+extern match_err_t matchsetadd(matchset_t *restrict s, const char *pat, mcomp_flag_t cf, mexec_flag_t ef);
+extern match_err_t matchsetcomp(matchset_t *restrict s);
+extern match_err_t matchsetexec(matchset_t *restrict s, const char *str, const char *end, uint32_t *ids, size_t *nids, mexec_flag_t fl);
+extern void matchsetfree(matchset_t *restrict s);
+extern match_err_t matchstreaminit(matchstream_t *restrict ms, const matcher_t *m, size_t nm, mexec_flag_t fl);
+extern match_err_t matchstreamfeed(matchstream_t *restrict ms, const char *buf, size_t len, size_t *used, match_find_t *pm, size_t nm);
+extern match_err_t matchstreamend(matchstream_t *restrict ms, match_find_t *pm, size_t nm);
+extern void matchstreamfree(matchstream_t *restrict ms);
 
 /* ===================================================================== */
 /* Mode Flags (mutually exclusive - pick ONE)                            */
@@ -493,6 +565,32 @@ static inline int re2fullmatch(const re2_t *re, const char *text, size_t textlen
 
 static inline void re2free(re2_t *re) { matchfree(re); free(re); }
 
+/* ===================================================================== */
+/* RE2 Set API                                                           */
+/* ===================================================================== */
+
+static inline re2_set_t *re2setnew(void) { return calloc(1, sizeof(re2_set_t)); }
+
+static inline int re2setadd(re2_set_t *set, const char *pattern) {
+	if (!set || !pattern) return -1;
+
+	uint32_t id = set->n;
+
+	return (matchsetadd(set, pattern, MCOMP_RE2, MEXEC_RE2) == M_SUCCESS) ? (int)id : -1;
+}
+
+static inline int re2setcomp(re2_set_t *set) { return (set && matchsetcomp(set) == M_SUCCESS) ? 1 : 0; }
+
+static inline size_t re2setmatch(re2_set_t *set, const char *text, size_t textlen, uint32_t *ids, size_t nids) {
+	if (!set || !text) return 0;
+
+	int err = matchsetexec(set, text, text + textlen, ids, &nids, MEXEC_RE2);
+
+	return (err == M_SUCCESS) ? nids : 0;
+}
+
+static inline void re2setfree(re2_set_t *set) { matchsetfree(set); free(set); }
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,6 +17,9 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <signal.h>
+#if JACL_HAS_THREADS
+#include <pthread.h>
+#endif
 
 #if JACL_HAS_C23
 #define __STDC_VERSION_STDIO_H__ 202311L
@@ -121,6 +124,10 @@ typedef struct __jacl_file {
 	size_t _bufsiz;    // Buffer size (excluding overflow)
 	size_t _ovrsiz;    // Overflow/pushback size
 
+	// Registry fields
+	struct __jacl_file *_next;    // Next stream in the same shard
+	struct __jacl_file **_pprev;  // Whatever points at us (NULL once unregistered)
+
 	#if JACL_HAS_THREADS
 		pthread_mutex_t _lock;
 	#endif
@@ -160,7 +167,12 @@ static inline void __jacl_init_stdio(void) {
 }
 
 /* File Macros */
-#define FILE_INIT(fd, flags, mode, buf) { 0, fd, buf + OVRSIZ, buf + OVRBUF, buf, flags, mode, 0, 0, 1, 0, 0, NULL, BUFSIZ, OVRSIZ }
+#if JACL_HAS_THREADS
+	#define __JACL_FILE_LOCK_INIT , PTHREAD_MUTEX_INITIALIZER
+#else
+	#define __JACL_FILE_LOCK_INIT
+#endif
+#define FILE_INIT(fd, flags, mode, buf) { 0, fd, buf + OVRSIZ, buf + OVRBUF, buf, flags, mode, 0, 0, 1, 0, 0, NULL, BUFSIZ, OVRSIZ, NULL, NULL __JACL_FILE_LOCK_INIT }
 #define STATIC_FILE(name, fd, flags, mode) \
 static char __jacl_##name##_buf[OVRBUF]; \
 static FILE __jacl_##name##_file = FILE_INIT(fd, flags, mode, __jacl_##name##_buf); \
@@ -350,7 +362,9 @@ static inline void __jacl_stream_free(FILE *f) {
 	pthread_mutex_destroy(&f->_lock);
 	#endif
 
-	if (f != stdin && f != stdout && f != stderr) { __jacl_stream_unregister(f); free(f); }
+	__jacl_stream_unregister(f);
+
+	if (f != stdin && f != stdout && f != stderr) free(f);
 }
 static inline off_t __jacl_special_seek(FILE *f, off_t offset, int whence) {
 	if (f->_flags & __SMEM) {
@@ -477,7 +491,6 @@ static inline void setbuf(FILE* restrict f, char* restrict buf) { setvbuf(f, buf
 
 /* Thread Support */
 #if JACL_HAS_THREADS
-#include <pthread.h>
 static inline void flockfile(FILE *f) { if (f) pthread_mutex_lock(&f->_lock); }
 static inline int ftrylockfile(FILE *f) { return f ? pthread_mutex_trylock(&f->_lock) : 0; }
 static inline void funlockfile(FILE *f) { if (f) pthread_mutex_unlock(&f->_lock); }
@@ -699,6 +712,12 @@ static inline FILE* fopen(const char* restrict path, const char* restrict mode)
 static inline int fclose(FILE* f) {
 	if (!f) { return (__errno_set(EBADF), EOF); }
 
+	/* out of the registry first, so fflush(NULL) can't be mid-flush as we free */
+	__jacl_stream_unregister(f);
+	/* and wait out a vdprintf that found it there before it left */
+	flockfile(f);
+	funlockfile(f);
+
 	int ret = 0;
 
 	if (__JACL_HAS_MODE(f, __SMEM)) {
@@ -728,7 +747,7 @@ static inline int fclose(FILE* f) {
 
 	return ret;
 }
-static inline int fflush(FILE* f) { return f ? __jacl_stream_flush(f) : (__jacl_stream_flush(stdout) | __jacl_stream_flush(stderr)); }
+static inline int fflush(FILE* f) { return __jacl_stream_flush(f); }
 static inline size_t fread(void* restrict ptr, size_t size, size_t nmemb, FILE* restrict f) { __JACL_RTN_UNLOCK(f, fread_unlocked(ptr, size, nmemb, f)); }
 static inline size_t fwrite(const void* restrict ptr, size_t size, size_t nmemb, FILE* restrict f) { __JACL_RTN_UNLOCK(f, fwrite_unlocked(ptr, size, nmemb, f)); }
 static inline FILE *freopen(const char* restrict path, const char* restrict mode, FILE* restrict f) {
@@ -812,6 +831,8 @@ static inline int pclose(FILE *f) {
 	if (!f) { return (__errno_set(EBADF), -1); }
 	if (!__JACL_HAS_MODE(f, __SPOPEN)) { return (__errno_set(EINVAL), -1); }
 
+	__jacl_stream_unregister(f);
+
 	pid_t pid = (pid_t)(intptr_t)f->_tmpfname; f->_tmpfname = NULL;
 
 	__JACL_CLR_MODE(f, __SPOPEN);
@@ -134,58 +134,206 @@ static inline int rand(void) { __jacl_rand_seed = __jacl_rand_seed * 1103515245u
 /* Sorting & Searching                                           */
 /* ============================================================= */
 
-static inline void __jacl_sort_swap(unsigned char* a, unsigned char* b, size_t size) {
-	while (size--) {
-		unsigned char tmp = *a;
+/**
+ * NOTE: qsort is an introsort. Ranges of JACL_SORT_INSERTION elements or less
+ * are insertion sorted; bigger ones are partitioned around a median of three
+ * (a ninther past 128 elements) that is parked in the first slot, so there is
+ * no pivot copy to allocate. Elements equal to the pivot stop both scans, which
+ * keeps runs of duplicates balanced. As in pdqsort, a partition that swapped
+ * nothing tries a bounded insertion sort in case the input was sorted, and a
+ * lopsided one scrambles a few elements to break the pattern. The smaller side
+ * recurses and the larger one loops, and once the depth passes 2*log2(n) the
+ * range is heapsorted: O(n log n) time and O(log n) stack in the worst case.
+ * The swap width is picked once per call: a 4 byte, one word or two word
+ * element when aligned, whole words for other aligned sizes, bytes otherwise.
+ */
+
+#ifndef JACL_SORT_INSERTION
+#define JACL_SORT_INSERTION 12
+#endif
+
+#ifdef __JACL_SWAR
+typedef uint32_t __jacl_sort_u32_t __attribute__((__may_alias__));
+#endif
+
+enum { __JACL_SORT_BYTES, __JACL_SORT_U32, __JACL_SORT_WORD, __JACL_SORT_WORD2, __JACL_SORT_WORDS };
+
+typedef int (*__jacl_sort_cmp_t)(const void*, const void*, void*);
+
+static inline int __jacl_sort_kind(const void* base, size_t size) {
+#ifdef __JACL_SWAR
+	uintptr_t bits = (uintptr_t)base | size;
+
+	if (size == 4 && !(bits & 3)) return __JACL_SORT_U32;
+	if (bits & __JACL_WMASK) return __JACL_SORT_BYTES;
+	if (size == __JACL_WSIZE) return __JACL_SORT_WORD;
+	if (size == 2 * __JACL_WSIZE) return __JACL_SORT_WORD2;
+
+	return __JACL_SORT_WORDS;
+#else
+	(void)base; (void)size;
+
+	return __JACL_SORT_BYTES;
+#endif
+}
+static inline void __jacl_sort_swap(unsigned char* a, unsigned char* b, size_t size, int kind) {
+	switch (kind) {
+#ifdef __JACL_SWAR
+	case __JACL_SORT_U32: {
+		uint32_t t = *(__jacl_sort_u32_t*)a;
+
+		*(__jacl_sort_u32_t*)a = *(__jacl_sort_u32_t*)b;
+		*(__jacl_sort_u32_t*)b = t;
+
+		return;
+	}
+	case __JACL_SORT_WORD2: {
+		size_t t = ((__jacl_word_t*)a)[1];
+
+		((__jacl_word_t*)a)[1] = ((__jacl_word_t*)b)[1];
+		((__jacl_word_t*)b)[1] = t;
+	}
+	/* fallthrough */
+	case __JACL_SORT_WORD: {
+		size_t t = *(__jacl_word_t*)a;
+
+		*(__jacl_word_t*)a = *(__jacl_word_t*)b;
+		*(__jacl_word_t*)b = t;
 
-		*a++ = *b;
-		*b++ = tmp;
+		return;
+	}
+	case __JACL_SORT_WORDS:
+		for (size_t n = size / __JACL_WSIZE; n--; a += __JACL_WSIZE, b += __JACL_WSIZE) {
+			size_t t = *(__jacl_word_t*)a;
+
+			*(__jacl_word_t*)a = *(__jacl_word_t*)b;
+			*(__jacl_word_t*)b = t;
+		}
+
+		return;
+#endif
+	default:
+		while (size--) {
+			unsigned char tmp = *a;
+
+			*a++ = *b;
+			*b++ = tmp;
+		}
 	}
 }
 static inline int __jacl_sort_call(const void *a, const void *b, void *fn) { return ((int (*)(const void *, const void *))fn)(a, b); }
-static inline void __jacl_sort_again(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void *arg) {
-	if (nmemb < 2) return;
+static inline size_t __jacl_sort_med3(unsigned char* arr, size_t size, size_t a, size_t b, size_t c, __jacl_sort_cmp_t compar, void* arg) {
+	unsigned char *pa = arr + a * size, *pb = arr + b * size, *pc = arr + c * size;
 
-	unsigned char* arr = (unsigned char*)base;
-	size_t low = 0, high = nmemb - 1, mid = low + (high - low) / 2;
+	if (compar(pa, pb, arg) < 0) return compar(pb, pc, arg) < 0 ? b : compar(pa, pc, arg) < 0 ? c : a;
 
-	if (compar(arr + low * size, arr + mid * size, arg) > 0) __jacl_sort_swap(arr + low * size, arr + mid * size, size);
-	if (compar(arr + mid * size, arr + high * size, arg) > 0) __jacl_sort_swap(arr + mid * size, arr + high * size, size);
-	if (compar(arr + low * size, arr + mid * size, arg) > 0) __jacl_sort_swap(arr + low * size, arr + mid * size, size);
+	return compar(pb, pc, arg) > 0 ? b : compar(pa, pc, arg) < 0 ? a : c;
+}
+static inline void __jacl_sort_insertion(unsigned char* arr, size_t nmemb, size_t size, int kind, __jacl_sort_cmp_t compar, void* arg) {
+	for (size_t i = 1; i < nmemb; i++) {
+		for (unsigned char* p = arr + i * size; p > arr && compar(p - size, p, arg) > 0; p -= size) __jacl_sort_swap(p - size, p, size, kind);
+	}
+}
+static inline int __jacl_sort_nearly(unsigned char* arr, size_t nmemb, size_t size, int kind, __jacl_sort_cmp_t compar, void* arg) {
+	size_t moves = 0;
 
-	void* pivot = malloc(size);
+	for (size_t i = 1; i < nmemb; i++) {
+		for (unsigned char* p = arr + i * size; p > arr && compar(p - size, p, arg) > 0; p -= size) {
+			if (++moves > 8) return 0;
 
-	if (!pivot) {
-		for (size_t i = 0; i < nmemb - 1; i++) {
-			for (size_t j = 0; j < nmemb - i - 1; j++) {
-				if (compar(arr + j * size, arr + (j + 1) * size, arg) > 0) __jacl_sort_swap(arr + j * size, arr + (j + 1) * size, size);
-			}
+			__jacl_sort_swap(p - size, p, size, kind);
 		}
+	}
 
-		return;
+	return 1;
+}
+static inline void __jacl_sort_shuffle(unsigned char* arr, size_t nmemb, size_t size, int kind) {
+	if (nmemb < JACL_SORT_INSERTION) return;
+
+	size_t q = nmemb / 4;
+
+	__jacl_sort_swap(arr, arr + q * size, size, kind);
+	__jacl_sort_swap(arr + (nmemb - 1) * size, arr + (nmemb - q) * size, size, kind);
+}
+static inline void __jacl_sort_sift(unsigned char* arr, size_t root, size_t nmemb, size_t size, int kind, __jacl_sort_cmp_t compar, void* arg) {
+	for (size_t child; (child = 2 * root + 1) < nmemb; root = child) {
+		if (child + 1 < nmemb && compar(arr + child * size, arr + (child + 1) * size, arg) < 0) child++;
+		if (compar(arr + root * size, arr + child * size, arg) >= 0) return;
+
+		__jacl_sort_swap(arr + root * size, arr + child * size, size, kind);
+	}
+}
+static inline void __jacl_sort_heap(unsigned char* arr, size_t nmemb, size_t size, int kind, __jacl_sort_cmp_t compar, void* arg) {
+	for (size_t i = nmemb / 2; i--; ) __jacl_sort_sift(arr, i, nmemb, size, kind, compar, arg);
+
+	while (nmemb > 1) {
+		__jacl_sort_swap(arr, arr + --nmemb * size, size, kind);
+		__jacl_sort_sift(arr, 0, nmemb, size, kind, compar, arg);
 	}
+}
+static inline void __jacl_sort_intro(unsigned char* arr, size_t nmemb, size_t size, int kind, __jacl_sort_cmp_t compar, void* arg, unsigned depth) {
+	while (nmemb > JACL_SORT_INSERTION) {
+		if (!depth--) {
+			__jacl_sort_heap(arr, nmemb, size, kind, compar, arg);
+
+			return;
+		}
+
+		size_t high = nmemb - 1, mid = nmemb / 2, piv;
 
-	memcpy(pivot, arr + mid * size, size);
+		if (nmemb > 128) {
+			size_t step = nmemb / 8;
 
-	size_t i = 0, j = nmemb - 1;
+			piv = __jacl_sort_med3(arr, size,
+				__jacl_sort_med3(arr, size, 0, step, 2 * step, compar, arg),
+				__jacl_sort_med3(arr, size, mid - step, mid, mid + step, compar, arg),
+				__jacl_sort_med3(arr, size, high - 2 * step, high - step, high, compar, arg), compar, arg);
+		} else piv = __jacl_sort_med3(arr, size, 0, mid, high, compar, arg);
 
-	while (1) {
-		while (i < nmemb && compar(arr + i * size, pivot, arg) < 0) i++;
-		while (j > 0 && compar(arr + j * size, pivot, arg) > 0) j--;
+		if (piv) __jacl_sort_swap(arr, arr + piv * size, size, kind);
 
-		if (i >= j) break;
+		size_t i = 0, j = nmemb;
+		int swapped = 0;
 
-		__jacl_sort_swap(arr + i * size, arr + j * size, size);
+		while (1) {
+			while (++i < nmemb && compar(arr + i * size, arr, arg) < 0);
+			while (--j > 0 && compar(arr + j * size, arr, arg) > 0);
 
-		i++;
+			if (i >= j) break;
 
-		if (j > 0) j--;
+			__jacl_sort_swap(arr + i * size, arr + j * size, size, kind);
+			swapped = 1;
+		}
+
+		if (j) __jacl_sort_swap(arr, arr + j * size, size, kind);
+
+		unsigned char* right = arr + (j + 1) * size;
+		size_t left_n = j, right_n = nmemb - j - 1;
+
+		/* a lopsided split means the input has a pattern, so break it up; a
+		   split with nothing to swap may well be sorted already, so try that */
+		if (left_n < nmemb / 8 || right_n < nmemb / 8) {
+			__jacl_sort_shuffle(arr, left_n, size, kind);
+			__jacl_sort_shuffle(right, right_n, size, kind);
+		} else if (!swapped && __jacl_sort_nearly(arr, left_n, size, kind, compar, arg) && __jacl_sort_nearly(right, right_n, size, kind, compar, arg)) return;
+
+		if (left_n < right_n) {
+			__jacl_sort_intro(arr, left_n, size, kind, compar, arg, depth);
+			arr = right, nmemb = right_n;
+		} else {
+			__jacl_sort_intro(right, right_n, size, kind, compar, arg, depth);
+			nmemb = left_n;
+		}
 	}
 
-	free(pivot);
+	__jacl_sort_insertion(arr, nmemb, size, kind, compar, arg);
+}
+static inline void __jacl_sort_again(void* base, size_t nmemb, size_t size, __jacl_sort_cmp_t compar, void *arg) {
+	unsigned depth = 0;
+
+	for (size_t n = nmemb; n; n >>= 1) depth += 2;
 
-	if (j > 0) __jacl_sort_again(arr, j + 1, size, compar, arg);
-	if (i < nmemb - 1) __jacl_sort_again(arr + (i + 1) * size, nmemb - i - 1, size, compar, arg);
+	__jacl_sort_intro((unsigned char*)base, nmemb, size, __jacl_sort_kind(base, size), compar, arg, depth);
 }
 
 static inline void qsort_r(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void *arg) {
@@ -199,6 +347,22 @@ static inline void qsort(void* base, size_t nmemb, size_t size, int (*compar)(co
 	__jacl_sort_again(base, nmemb, size, __jacl_sort_call, (void *)compar);
 }
 
+#ifndef JACL_SORT_GRAIN
+#define JACL_SORT_GRAIN 16384
+#endif
+
+#ifndef JACL_SORT_THREADS
+#define JACL_SORT_THREADS 64
+#endif
+
+/**
+ * Sort like qsort_r on up to `threads` threads, 0 meaning one per CPU the
+ * process may run on. A thread isn't worth starting for less than `grain`
+ * elements (0 for JACL_SORT_GRAIN), so small arrays sort serially, as does
+ * everything when threads or the nmemb * size scratch copy can't be had.
+ */
+void qsort_mt(void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*, void*), void *arg, unsigned threads, size_t grain);
+
 static inline void* bsearch(const void* key, const void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*)) {
 	if (!key || !base || !compar || size == 0 || nmemb == 0) return NULL;
 
@@ -217,6 +381,42 @@ static inline void* bsearch(const void* key, const void* base, size_t nmemb, siz
 	return NULL;
 }
 
+/**
+ * NOTE: bsearch_batch looks up `nkeys` keys of `ksize` bytes, sorted in the
+ * order of base, in one forward pass. Each search gallops from where the last
+ * one stopped, so k keys over n elements cost O(k log(n/k)) comparisons rather
+ * than O(k log n), and close keys hit memory that is already cached. found[i]
+ * gets the match for key i or NULL; the return is the number of matches.
+ */
+static inline size_t bsearch_batch(const void* keys, size_t nkeys, size_t ksize, const void* base, size_t nmemb, size_t size, int (*compar)(const void*, const void*), void** found) {
+	if (!keys || !found || !compar || size == 0) return 0;
+
+	const unsigned char* key = (const unsigned char*)keys, *arr = (const unsigned char*)base;
+	size_t pos = 0, hits = 0;
+
+	for (size_t k = 0; k < nkeys; k++, key += ksize) {
+		size_t lo = pos, hi = pos, step = 1;
+
+		while (hi < nmemb && compar(key, arr + hi * size) > 0) {
+			lo = hi + 1;
+			hi = (nmemb - hi > step) ? hi + step : nmemb;
+			step <<= 1;
+		}
+
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if (compar(key, arr + mid * size) > 0) lo = mid + 1;
+			else hi = mid;
+		}
+
+		pos = lo;
+		found[k] = (lo < nmemb && compar(key, arr + lo * size) == 0) ? (hits++, (void*)(arr + lo * size)) : NULL;
+	}
+
+	return hits;
+}
+
 /* ============================================================= */
 /* Program Termination & Exit                                    */
 /* ============================================================= */
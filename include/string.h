@@ -9,6 +9,11 @@
 #include <stdint.h>
 #include <signal.h>
 #include <sys/types.h>
+#include <stdbit.h>
+
+#if JACL_HAS_IMMINTRIN
+#include <immintrin.h>
+#endif
 
 #if JACL_HAS_C23
 #define __STDC_VERSION_STRING_H__ 202311L
@@ -20,13 +25,187 @@ extern "C" {
 
 void* malloc(size_t);
 
+/* ============================================================= */
+/* Word & Vector Kernels                                         */
+/* ============================================================= */
+
+/**
+ * NOTE: Everything below the user API funnels through these helpers. SWAR
+ * (SIMD within a register) runs a size_t at a time on any compiler that can
+ * alias unaligned words. When <immintrin.h> is usable we widen to 16 bytes
+ * (SSE2, NEON, simd128) or 32 bytes (AVX2). Unbounded scans only ever load
+ * aligned blocks so they can never fault on a page the string doesn't touch.
+ */
+
+#if __has_attribute(__may_alias__) && __has_attribute(__aligned__)
+	#define __JACL_SWAR 1
+
+	typedef size_t __jacl_word_t __attribute__((__may_alias__));
+	typedef size_t __jacl_uword_t __attribute__((__may_alias__, __aligned__(1)));
+#endif
+
+#define __JACL_WSIZE      sizeof(size_t)
+#define __JACL_WMASK      (sizeof(size_t) - 1)
+#define __JACL_WONES      ((size_t)-1 / 0xFF)
+#define __JACL_WLOWS      (__JACL_WONES * 0x7F)
+#define __JACL_WSPLAT(c)  (__JACL_WONES * (unsigned char)(c))
+#define __JACL_WZERO(w)   (((w) - __JACL_WONES) & ~(w) & (__JACL_WONES * 0x80))
+#define __JACL_WZMASK(w)  (~((((w) & __JACL_WLOWS) + __JACL_WLOWS) | (w) | __JACL_WLOWS))
+#define __JACL_WLOAD(p)   (*(const __jacl_uword_t*)(const void*)(p))
+#define __JACL_WSTORE(p, w) (*(__jacl_uword_t*)(void*)(p) = (w))
+
+#if JACL_HAS_IMMINTRIN && JACL_HAS_AVX2
+	#define __JACL_VSIZE  32
+	#define __JACL_VFULL  0xFFFFFFFFu
+
+	typedef __m256i __jacl_vec_t;
+
+	#define __jacl_vload(p)      _mm256_loadu_si256((const __m256i*)(const void*)(p))
+	#define __jacl_vstore(p, v)  _mm256_storeu_si256((__m256i*)(void*)(p), v)
+	#define __jacl_vsplat(c)     _mm256_set1_epi8((char)(c))
+	#define __jacl_veq(a, b)     ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)))
+	#define __jacl_vcmp(a, b)    _mm256_cmpeq_epi8(a, b)
+	#define __jacl_vor(a, b)     _mm256_or_si256(a, b)
+	#define __jacl_vmask(v)      ((unsigned)_mm256_movemask_epi8(v))
+#elif JACL_HAS_IMMINTRIN
+	#define __JACL_VSIZE  16
+	#define __JACL_VFULL  0xFFFFu
+
+	typedef __m128i __jacl_vec_t;
+
+	#define __jacl_vload(p)      _mm_loadu_si128((const __m128i*)(const void*)(p))
+	#define __jacl_vstore(p, v)  _mm_storeu_si128((__m128i*)(void*)(p), v)
+	#define __jacl_vsplat(c)     _mm_set1_epi8((char)(c))
+	#define __jacl_veq(a, b)     ((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)))
+	#define __jacl_vcmp(a, b)    _mm_cmpeq_epi8(a, b)
+	#define __jacl_vor(a, b)     _mm_or_si128(a, b)
+	#define __jacl_vmask(v)      ((unsigned)_mm_movemask_epi8(v))
+#endif
+
+// pages are never smaller than this so an unaligned vector short of it is safe
+#define __JACL_PAGE_MIN  4096u
+#define __JACL_PAGE_SAFE(p, w) (((uintptr_t)(p) & (__JACL_PAGE_MIN - 1)) <= __JACL_PAGE_MIN - (w))
+
+#if __has_builtin(__builtin_ctz) && __has_builtin(__builtin_ctzll) && __has_builtin(__builtin_clzll)
+	#define __jacl_mem_ctz(m)  __builtin_ctz(m)
+	#define __jacl_mem_ctzw(w) __builtin_ctzll(w)
+	#define __jacl_mem_clzw(w) (__builtin_clzll(w) - (64 - 8 * (int)__JACL_WSIZE))
+#else
+	#define __jacl_mem_ctz(m)  __jacl_ctz32(m)
+	#define __jacl_mem_ctzw(w) __jacl_ctz64(w)
+	#define __jacl_mem_clzw(w) (__jacl_clz64(w) - (64 - 8 * (int)__JACL_WSIZE))
+#endif
+
+// index of the first flagged byte in a __JACL_WZMASK() result
+#if JACL_HAS_BE
+	#define __jacl_mem_wfind(m) ((size_t)__jacl_mem_clzw(m) >> 3)
+#else
+	#define __jacl_mem_wfind(m) ((size_t)__jacl_mem_ctzw(m) >> 3)
+#endif
+
+static inline void __jacl_mem_fwd(unsigned char* d, const unsigned char* s, size_t n) {
+	size_t i = 0;
+
+#ifdef __JACL_VSIZE
+	if (n >= __JACL_VSIZE) {
+		__jacl_vec_t t = __jacl_vload(s + n - __JACL_VSIZE);
+
+		for (; i + 4 * __JACL_VSIZE <= n; i += 4 * __JACL_VSIZE) {
+			__jacl_vec_t a = __jacl_vload(s + i), b = __jacl_vload(s + i + __JACL_VSIZE);
+			__jacl_vec_t c = __jacl_vload(s + i + 2 * __JACL_VSIZE), e = __jacl_vload(s + i + 3 * __JACL_VSIZE);
+
+			__jacl_vstore(d + i, a); __jacl_vstore(d + i + __JACL_VSIZE, b);
+			__jacl_vstore(d + i + 2 * __JACL_VSIZE, c); __jacl_vstore(d + i + 3 * __JACL_VSIZE, e);
+		}
+
+		for (; i + __JACL_VSIZE < n; i += __JACL_VSIZE) __jacl_vstore(d + i, __jacl_vload(s + i));
+
+		__jacl_vstore(d + n - __JACL_VSIZE, t);
+
+		return;
+	}
+#endif
+#ifdef __JACL_SWAR
+	if (n >= __JACL_WSIZE) {
+		size_t t = __JACL_WLOAD(s + n - __JACL_WSIZE);
+
+		for (; i + __JACL_WSIZE < n; i += __JACL_WSIZE) __JACL_WSTORE(d + i, __JACL_WLOAD(s + i));
+
+		__JACL_WSTORE(d + n - __JACL_WSIZE, t);
+
+		return;
+	}
+#endif
+
+	for (; i < n; i++) d[i] = s[i];
+}
+
+static inline void __jacl_mem_bwd(unsigned char* d, const unsigned char* s, size_t n) {
+#ifdef __JACL_VSIZE
+	if (n >= __JACL_VSIZE) {
+		__jacl_vec_t t = __jacl_vload(s);
+
+		for (; n >= 4 * __JACL_VSIZE; n -= 4 * __JACL_VSIZE) {
+			__jacl_vec_t a = __jacl_vload(s + n - __JACL_VSIZE), b = __jacl_vload(s + n - 2 * __JACL_VSIZE);
+			__jacl_vec_t c = __jacl_vload(s + n - 3 * __JACL_VSIZE), e = __jacl_vload(s + n - 4 * __JACL_VSIZE);
+
+			__jacl_vstore(d + n - __JACL_VSIZE, a); __jacl_vstore(d + n - 2 * __JACL_VSIZE, b);
+			__jacl_vstore(d + n - 3 * __JACL_VSIZE, c); __jacl_vstore(d + n - 4 * __JACL_VSIZE, e);
+		}
+
+		for (; n > __JACL_VSIZE; n -= __JACL_VSIZE) __jacl_vstore(d + n - __JACL_VSIZE, __jacl_vload(s + n - __JACL_VSIZE));
+
+		__jacl_vstore(d, t);
+
+		return;
+	}
+#endif
+#ifdef __JACL_SWAR
+	if (n >= __JACL_WSIZE) {
+		size_t t = __JACL_WLOAD(s);
+
+		for (; n > __JACL_WSIZE; n -= __JACL_WSIZE) __JACL_WSTORE(d + n - __JACL_WSIZE, __JACL_WLOAD(s + n - __JACL_WSIZE));
+
+		__JACL_WSTORE(d, t);
+
+		return;
+	}
+#endif
+
+	while (n--) d[n] = s[n];
+}
+
 /* Memory Operations */
 static inline void* memset(void* s, int c, size_t n) {
 	if (JACL_UNLIKELY(!s)) return NULL;
 
 	unsigned char* p = (unsigned char* )s;
+	size_t i = 0;
+
+#ifdef __JACL_VSIZE
+	if (n >= __JACL_VSIZE) {
+		__jacl_vec_t v = __jacl_vsplat(c);
+
+		for (; i + __JACL_VSIZE < n; i += __JACL_VSIZE) __jacl_vstore(p + i, v);
+
+		__jacl_vstore(p + n - __JACL_VSIZE, v);
+
+		return s;
+	}
+#endif
+#ifdef __JACL_SWAR
+	if (n >= __JACL_WSIZE) {
+		size_t w = __JACL_WSPLAT(c);
+
+		for (; i + __JACL_WSIZE < n; i += __JACL_WSIZE) __JACL_WSTORE(p + i, w);
+
+		__JACL_WSTORE(p + n - __JACL_WSIZE, w);
+
+		return s;
+	}
+#endif
 
-	for (size_t i = 0; i < n; i++) p[i] = (unsigned char)c;
+	for (; i < n; i++) p[i] = (unsigned char)c;
 
 	return s;
 }
@@ -37,11 +216,10 @@ static inline void* memmove(void* dest, const void* src, size_t n) {
 	unsigned char* d = (unsigned char* )dest;
 	const unsigned char* s = (const unsigned char* )src;
 
-	if (d < s) {
-		for (size_t i = 0; i < n; i++) d[i] = s[i];
-	} else {
-		for (size_t i = n; i-- > 0;) d[i] = s[i];
-	}
+	if (d == s) return dest;
+
+	if ((uintptr_t)d - (uintptr_t)s >= n) __jacl_mem_fwd(d, s, n);
+	else __jacl_mem_bwd(d, s, n);
 
 	return dest;
 }
@@ -51,8 +229,26 @@ static inline int memcmp(const void* a, const void* b, size_t n) {
 
 	const unsigned char* x = (const unsigned char* )a;
 	const unsigned char* y = (const unsigned char* )b;
+	size_t i = 0;
 
-	for (size_t i = 0; i < n; i++) {
+#ifdef __JACL_VSIZE
+	for (; i + __JACL_VSIZE <= n; i += __JACL_VSIZE) {
+		unsigned m = __jacl_veq(__jacl_vload(x + i), __jacl_vload(y + i)) ^ __JACL_VFULL;
+
+		if (m) {
+			i += __jacl_mem_ctz(m);
+
+			return x[i] < y[i] ? -1 : 1;
+		}
+	}
+#endif
+#ifdef __JACL_SWAR
+	for (; i + __JACL_WSIZE <= n; i += __JACL_WSIZE) {
+		if (__JACL_WLOAD(x + i) != __JACL_WLOAD(y + i)) break;
+	}
+#endif
+
+	for (; i < n; i++) {
 		if (x[i] != y[i]) return x[i] < y[i] ? -1 : 1;
 	}
 
@@ -60,39 +256,212 @@ static inline int memcmp(const void* a, const void* b, size_t n) {
 }
 
 static inline void* memchr(const void* s, int c, size_t n) {
-	if (!s) return NULL;
+	if (!s || !n) return NULL;
 
 	const unsigned char* p = (const unsigned char* )s;
+	unsigned char ch = (unsigned char)c;
 
-	for (size_t i = 0; i < n; i++) {
-		if (p[i] == (unsigned char)c) return (void* )&p[i];
+#ifdef __JACL_VSIZE
+	__jacl_vec_t v = __jacl_vsplat(ch);
+	size_t off = (uintptr_t)p & (__JACL_VSIZE - 1);
+	unsigned m = __jacl_veq(__jacl_vload(p - off), v) >> off;
+
+	if (m) return (size_t)__jacl_mem_ctz(m) < n ? (void* )(p + __jacl_mem_ctz(m)) : NULL;
+
+	for (size_t i = __JACL_VSIZE - off; i < n; i += __JACL_VSIZE) {
+		m = __jacl_veq(__jacl_vload(p + i), v);
+
+		if (m) return i + (size_t)__jacl_mem_ctz(m) < n ? (void* )(p + i + __jacl_mem_ctz(m)) : NULL;
 	}
 
 	return NULL;
+#else
+	size_t i = 0;
+
+	#ifdef __JACL_SWAR
+		size_t w = __JACL_WSPLAT(ch);
+
+		for (; i < n && ((uintptr_t)(p + i) & __JACL_WMASK); i++) {
+			if (p[i] == ch) return (void* )&p[i];
+		}
+
+		for (; i + __JACL_WSIZE <= n; i += __JACL_WSIZE) {
+			if (__JACL_WZERO(*(const __jacl_word_t*)(const void*)(p + i) ^ w)) break;
+		}
+	#endif
+
+	for (; i < n; i++) {
+		if (p[i] == ch) return (void* )&p[i];
+	}
+
+	return NULL;
+#endif
 }
 
 static inline void* memcpy(void* restrict dest, const void* restrict src, size_t n) {
 	if (JACL_UNLIKELY(!dest || !src)) return NULL;
 
-	unsigned char* d = (unsigned char* )dest;
-	const unsigned char* s = (const unsigned char* )src;
-
-	for (size_t i = 0; i < n; i++) d[i] = s[i];
+	__jacl_mem_fwd((unsigned char* )dest, (const unsigned char* )src, n);
 
 	return dest;
 }
 
-static inline void* memmem(const void* hay, size_t hl, const void* ndl, size_t nl) {
-	if (!hay || !ndl || nl > hl) return NULL;
+/* ============================================================= */
+/* Substring Search Engine                                       */
+/* ============================================================= */
+
+/**
+ * NOTE: strstr, memmem, strcasestr and the regex literal gate all land here.
+ * With vectors a prefilter tests the first and last needle byte across a whole
+ * block and only verifies the candidates both agree on. Once verification has
+ * cost more than a few times the bytes scanned it hands the rest over to
+ * Two-Way (Crochemore-Perrin), which is linear in the haystack, skips ahead on
+ * a bad last byte and never allocates. Case folding is ASCII only.
+ */
+
+#define __JACL_FOLD(c, ic)    ((ic) && (unsigned)((c) - 'A') < 26u ? (unsigned char)((c) | 0x20) : (unsigned char)(c))
+
+static inline int __jacl_mem_same(const unsigned char* a, const unsigned char* b, size_t n, int ic) {
+	if (!ic) return !memcmp(a, b, n);
+
+	for (size_t i = 0; i < n; i++) if (__JACL_FOLD(a[i], 1) != __JACL_FOLD(b[i], 1)) return 0;
+
+	return 1;
+}
+
+#ifdef __JACL_VSIZE
+// sets *rest to where Two-Way should take over when candidate checks cost too much, NULL when done
+static inline const unsigned char* __jacl_mem_prefilter(const unsigned char* h, size_t hl, const unsigned char* n, size_t l, int ic, const unsigned char** rest) {
+	unsigned char f = __JACL_FOLD(n[0], ic), e = __JACL_FOLD(n[l - 1], ic);
+	unsigned char fu = (ic && (unsigned)(f - 'a') < 26u) ? f - 32 : f, eu = (ic && (unsigned)(e - 'a') < 26u) ? e - 32 : e;
+	__jacl_vec_t vf = __jacl_vsplat(f), vfu = __jacl_vsplat(fu), ve = __jacl_vsplat(e), veu = __jacl_vsplat(eu);
+	size_t i = 0, work = 0;
+
+	*rest = NULL;
+
+	for (; i + l - 1 + __JACL_VSIZE <= hl; i += __JACL_VSIZE) {
+		__jacl_vec_t a = __jacl_vload(h + i), b = __jacl_vload(h + i + l - 1);
+		unsigned m = (__jacl_veq(a, vf) | __jacl_veq(a, vfu)) & (__jacl_veq(b, ve) | __jacl_veq(b, veu));
 
-	const unsigned char* h = (const unsigned char* )hay;
+		for (; m; m &= m - 1) {
+			size_t j = i + __jacl_mem_ctz(m);
 
-	for (size_t i = 0; i <= hl - nl; i++) {
-		if (!memcmp(h + i, ndl, nl)) return (void* )(h + i);
+			if (l < 3 || __jacl_mem_same(h + j + 1, n + 1, l - 2, ic)) return h + j;
+			if ((work += l) > 4 * j + 512) { *rest = h + j + 1; return NULL; }
+		}
+	}
+
+	for (; i + l <= hl; i++) {
+		if (__JACL_FOLD(h[i], ic) != f) continue;
+		if (__jacl_mem_same(h + i, n, l, ic)) return h + i;
+		if ((work += l) > 4 * i + 512) { *rest = h + i + 1; return NULL; }
 	}
 
 	return NULL;
 }
+#endif
+
+static inline size_t __jacl_mem_suffix(const unsigned char* n, size_t l, int ic, int rev, size_t* per) {
+	size_t ip = (size_t)-1, jp = 0, k = 1, p = 1;
+
+	while (jp + k < l) {
+		unsigned char a = __JACL_FOLD(n[ip + k], ic), b = __JACL_FOLD(n[jp + k], ic);
+
+		if (a == b) {
+			if (k == p) { jp += p; k = 1; }
+			else k++;
+		} else if (rev ? a < b : a > b) {
+			jp += k; k = 1; p = jp - ip;
+		} else {
+			ip = jp++; k = p = 1;
+		}
+	}
+
+	*per = p;
+
+	return ip;
+}
+
+// z is the end of the haystack, or when str is set the end of what is known to be before the nul
+static inline const unsigned char* __jacl_mem_twoway(const unsigned char* h, const unsigned char* z, const unsigned char* n, size_t l, int ic, int str) {
+	size_t byteset[256 / (8 * sizeof(size_t))] = { 0 };
+	size_t shift[256];
+	size_t ms, ms2, p, p2, mem = 0, mem0, k;
+
+	for (k = 0; k < l; k++) {
+		unsigned char c = __JACL_FOLD(n[k], ic);
+
+		byteset[c / (8 * sizeof(size_t))] |= (size_t)1 << (c % (8 * sizeof(size_t)));
+		shift[c] = k + 1;
+	}
+
+	ms = __jacl_mem_suffix(n, l, ic, 0, &p);
+	ms2 = __jacl_mem_suffix(n, l, ic, 1, &p2);
+
+	if (ms2 + 1 > ms + 1) { ms = ms2; p = p2; }
+
+	if (!__jacl_mem_same(n, n + p, ms + 1, ic)) {
+		mem0 = 0;
+		p = (ms > l - ms - 1 ? ms : l - ms - 1) + 1;
+	} else mem0 = l - p;
+
+	for (;;) {
+		if ((size_t)(z - h) < l) {
+			if (!str) return NULL;
+
+			size_t grow = l | 63;
+			const unsigned char* nul = (const unsigned char* )memchr(z, 0, grow);
+
+			if (nul) { z = nul; if ((size_t)(z - h) < l) return NULL; }
+			else z += grow;
+		}
+
+		unsigned char c = __JACL_FOLD(h[l - 1], ic);
+
+		if (!(byteset[c / (8 * sizeof(size_t))] & ((size_t)1 << (c % (8 * sizeof(size_t)))))) { h += l; mem = 0; continue; }
+
+		if ((k = l - shift[c])) {
+			h += k < mem ? mem : k;
+			mem = 0;
+
+			continue;
+		}
+
+		for (k = (ms + 1 > mem ? ms + 1 : mem); k < l && __JACL_FOLD(n[k], ic) == __JACL_FOLD(h[k], ic); k++);
+
+		if (k < l) { h += k - ms; mem = 0; continue; }
+
+		for (k = ms + 1; k > mem && __JACL_FOLD(n[k - 1], ic) == __JACL_FOLD(h[k - 1], ic); k--);
+
+		if (k <= mem) return h;
+
+		h += p;
+		mem = mem0;
+	}
+}
+
+static inline const unsigned char* __jacl_mem_search(const unsigned char* h, size_t hl, const unsigned char* n, size_t l, int ic) {
+	if (!l) return h;
+	if (l > hl) return NULL;
+	if (l == 1 && !ic) return (const unsigned char* )memchr(h, n[0], hl);
+
+#ifdef __JACL_VSIZE
+	const unsigned char* rest, * hit = __jacl_mem_prefilter(h, hl, n, l, ic, &rest);
+
+	if (hit || !rest) return hit;
+
+	hl -= rest - h;
+	h = rest;
+#endif
+
+	return __jacl_mem_twoway(h, h + hl, n, l, ic, 0);
+}
+
+static inline void* memmem(const void* hay, size_t hl, const void* ndl, size_t nl) {
+	if (!hay || !ndl || nl > hl) return NULL;
+
+	return (void* )__jacl_mem_search((const unsigned char* )hay, hl, (const unsigned char* )ndl, nl, 0);
+}
 
 static inline void* memccpy(void* restrict dest, const void* restrict src, int c, size_t n) {
 	if (!dest || !src) return NULL;
@@ -113,11 +482,36 @@ static inline void* memccpy(void* restrict dest, const void* restrict src, int c
 static inline size_t strlen(const char* s) {
 	if (!s) return 0;
 
+#ifdef __JACL_VSIZE
+	__jacl_vec_t z = __jacl_vsplat(0);
+	size_t off = (uintptr_t)s & (__JACL_VSIZE - 1);
+	const char* p = s - off;
+	unsigned m = __jacl_veq(__jacl_vload(p), z) >> off;
+
+	if (m) return __jacl_mem_ctz(m);
+
+	for (p += __JACL_VSIZE;; p += __JACL_VSIZE) {
+		m = __jacl_veq(__jacl_vload(p), z);
+
+		if (m) return (size_t)(p - s) + __jacl_mem_ctz(m);
+	}
+#elif defined(__JACL_SWAR)
+	const char* p = s;
+
+	for (; (uintptr_t)p & __JACL_WMASK; p++) if (!*p) return (size_t)(p - s);
+
+	for (;; p += __JACL_WSIZE) {
+		size_t w = *(const __jacl_word_t*)(const void*)p;
+
+		if (__JACL_WZERO(w)) return (size_t)(p - s) + __jacl_mem_wfind(__JACL_WZMASK(w));
+	}
+#else
 	size_t len = 0;
 
 	while (s[len]) len++;
 
 	return len;
+#endif
 }
 
 static inline size_t strnlen(const char* s, size_t n) {
@@ -236,9 +630,44 @@ static inline char* stpncpy(char* restrict dest, const char* restrict src, size_
 static inline int strcmp(const char* a, const char* b) {
 	if (!a || !b) return a == b ? 0 : (a ? 1 : -1);
 
-	while (*a && *a == *b) { a++; b++; }
+	const unsigned char* x = (const unsigned char* )a;
+	const unsigned char* y = (const unsigned char* )b;
+
+#ifdef __JACL_VSIZE
+	__jacl_vec_t z = __jacl_vsplat(0);
+
+	for (;;) {
+		if (__JACL_PAGE_SAFE(x, __JACL_VSIZE) && __JACL_PAGE_SAFE(y, __JACL_VSIZE)) {
+			__jacl_vec_t vx = __jacl_vload(x);
+			unsigned m = (__jacl_veq(vx, __jacl_vload(y)) ^ __JACL_VFULL) | __jacl_veq(vx, z);
+
+			if (m) { x += __jacl_mem_ctz(m); y += __jacl_mem_ctz(m); break; }
+
+			x += __JACL_VSIZE; y += __JACL_VSIZE;
+		} else {
+			if (!*x || *x != *y) break;
+
+			x++; y++;
+		}
+	}
+#elif defined(__JACL_SWAR)
+	if (!(((uintptr_t)x ^ (uintptr_t)y) & __JACL_WMASK)) {
+		for (; (uintptr_t)x & __JACL_WMASK; x++, y++) if (!*x || *x != *y) goto done;
 
-	return (*a < *b) ? -1 : (*a > *b);
+		for (;; x += __JACL_WSIZE, y += __JACL_WSIZE) {
+			size_t w = *(const __jacl_word_t*)(const void*)x;
+
+			if (w != *(const __jacl_word_t*)(const void*)y || __JACL_WZERO(w)) break;
+		}
+	}
+#endif
+
+	while (*x && *x == *y) { x++; y++; }
+
+#if !defined(__JACL_VSIZE) && defined(__JACL_SWAR)
+done:
+#endif
+	return (*x < *y) ? -1 : (*x > *y);
 }
 
 static inline int strncmp(const char* a, const char* b, size_t n) {
@@ -376,11 +805,48 @@ static inline int strerror_r(int err, char* buf, size_t buflen) {
 /* Search & Tokenization */
 static inline char* strchr(const char* s, int c) {
 	if (!s) return NULL;
+
+#ifdef __JACL_VSIZE
+	__jacl_vec_t v = __jacl_vsplat(c), z = __jacl_vsplat(0);
+	size_t off = (uintptr_t)s & (__JACL_VSIZE - 1);
+	const char* p = s - off;
+	__jacl_vec_t b = __jacl_vload(p);
+	unsigned m = (__jacl_veq(b, v) | __jacl_veq(b, z)) >> off;
+
+	if (m) p = s + __jacl_mem_ctz(m);
+	else {
+		for (p += __JACL_VSIZE;; p += __JACL_VSIZE) {
+			b = __jacl_vload(p);
+			m = __jacl_veq(b, v) | __jacl_veq(b, z);
+
+			if (m) { p += __jacl_mem_ctz(m); break; }
+		}
+	}
+
+	return *p == (char)c ? (char* )p : NULL;
+#else
+	#ifdef __JACL_SWAR
+		size_t v = __JACL_WSPLAT(c);
+
+		for (; (uintptr_t)s & __JACL_WMASK; s++) {
+			if (*s == (char)c) return (char* )s;
+			if (!*s) return NULL;
+		}
+
+		for (;; s += __JACL_WSIZE) {
+			size_t w = *(const __jacl_word_t*)(const void*)s;
+
+			if (__JACL_WZERO(w) || __JACL_WZERO(w ^ v)) break;
+		}
+	#endif
+
 	for (;; s++) {
 		if (*s == (char)c) return (char* )s;
 		if (!*s) break;
 	}
+
 	return NULL;
+#endif
 }
 
 static inline char* strrchr(const char* s, int c) {
@@ -396,46 +862,161 @@ static inline char* strrchr(const char* s, int c) {
 	return (char* )r;
 }
 
+static inline const char* __jacl_str_search(const char* h, const char* n, int ic) {
+	size_t l = strlen(n);
+
+	if (!l) return h;
+	if (l == 1 && !ic) return strchr(h, n[0]);
+
+#ifdef __JACL_VSIZE
+	// find the nul a window at a time, doubling as we go, so an early match never pays for the rest of h
+	const unsigned char* p = (const unsigned char* )h, * z = p, * nul = NULL, * rest, * hit;
+	size_t step = (l | 63) + 1;
+
+	while (!nul) {
+		nul = (const unsigned char* )memchr(z, 0, step);
+		z = nul ? nul : z + step;
+
+		if ((size_t)(z - p) < l) continue;
+		if ((hit = __jacl_mem_prefilter(p, (size_t)(z - p), (const unsigned char* )n, l, ic, &rest))) return (const char* )hit;
+		if (rest) return (const char* )__jacl_mem_twoway(rest, z, (const unsigned char* )n, l, ic, 1);
+
+		// the last l - 1 bytes can still start a match that runs into the next window
+		p = z - (l - 1);
+
+		if (step < 4096) step *= 2;
+	}
+
+	return NULL;
+#else
+	return (const char* )__jacl_mem_twoway((const unsigned char* )h, (const unsigned char* )h, (const unsigned char* )n, l, ic, 1);
+#endif
+}
+
 static inline char* strstr(const char* h, const char* n) {
 	if (!h || !n) return NULL;
 
-	size_t nl = strlen(n);
+	return (char* )__jacl_str_search(h, n, 0);
+}
+
+static inline char* strcasestr(const char* h, const char* n) {
+	if (!h || !n) return NULL;
+
+	return (char* )__jacl_str_search(h, n, 1);
+}
+
+/**
+ * NOTE: strspn and friends share one membership table built per call. Sets
+ * of up to __JACL_SET_VEC bytes are matched a whole vector at a time, one
+ * compare per set byte, and sets of one or two bytes skip the table entirely
+ * without vectors. NUL is never a member, so every scan stops on it.
+ */
+
+#define __JACL_SET_BITS      (8 * sizeof(size_t))
+#define __JACL_SET_HAS(t, c) (((t)->bits[(unsigned char)(c) / __JACL_SET_BITS] >> ((unsigned char)(c) % __JACL_SET_BITS)) & 1)
+#define __JACL_SET_VEC       16
+
+typedef struct {
+	const unsigned char* set;
+	size_t n;
+	size_t bits[256 / __JACL_SET_BITS];
+} __jacl_set_t;
+
+static inline void __jacl_set_init(__jacl_set_t* t, const char* set) {
+	memset(t->bits, 0, sizeof(t->bits));
+
+	t->set = (const unsigned char* )set;
+	t->n = 0;
+
+	for (; set[t->n]; t->n++) {
+		unsigned char c = (unsigned char)set[t->n];
 
-	if (!nl) return (char* )h;
+		t->bits[c / __JACL_SET_BITS] |= (size_t)1 << (c % __JACL_SET_BITS);
+	}
+}
+
+// length of the prefix of s whose bytes are all members (in) or all non-members (!in)
+static inline size_t __jacl_set_span(const __jacl_set_t* t, const char* s, int in) {
+	const unsigned char* p = (const unsigned char* )s;
+
+	if (!t->n) return in ? 0 : strlen(s);
+
+#ifdef __JACL_VSIZE
+	if (t->n <= __JACL_SET_VEC) {
+		__jacl_vec_t v[__JACL_SET_VEC], z = __jacl_vsplat(0);
+		size_t off = (uintptr_t)p & (__JACL_VSIZE - 1), k;
+		const unsigned char* q = p - off;
+
+		for (k = 0; k < t->n; k++) v[k] = __jacl_vsplat(t->set[k]);
+
+		for (;; q += __JACL_VSIZE) {
+			__jacl_vec_t b = __jacl_vload(q), hit = __jacl_vcmp(b, v[0]);
 
-	for (; *h; h++) {
-		if (!strncmp(h, n, nl)) return (char* )h;
+			for (k = 1; k < t->n; k++) hit = __jacl_vor(hit, __jacl_vcmp(b, v[k]));
+
+			unsigned m = in ? __JACL_VFULL ^ __jacl_vmask(hit) : __jacl_vmask(__jacl_vor(hit, __jacl_vcmp(b, z)));
+
+			if (q < p) m = (m >> off) << off;
+			if (m) return (size_t)(q - p) + __jacl_mem_ctz(m);
+		}
 	}
+#else
+	unsigned char a = t->set[0], b = t->set[t->n > 1];
 
-	return NULL;
+	if (t->n <= 2) {
+		const unsigned char* q = p;
+
+		if (in) while (*q == a || *q == b) q++;
+		else while (*q && *q != a && *q != b) q++;
+
+		return (size_t)(q - p);
+	}
+#endif
+
+	size_t i = 0;
+
+	if (in) {
+		for (;; i += 4) {
+			if (!__JACL_SET_HAS(t, p[i])) return i;
+			if (!__JACL_SET_HAS(t, p[i + 1])) return i + 1;
+			if (!__JACL_SET_HAS(t, p[i + 2])) return i + 2;
+			if (!__JACL_SET_HAS(t, p[i + 3])) return i + 3;
+		}
+	}
+
+	for (;; i++) if (!p[i] || __JACL_SET_HAS(t, p[i])) return i;
 }
 
 static inline size_t strspn(const char* s, const char* accept) {
 	if (!s || !accept) return 0;
 
-	size_t i = 0;
+	__jacl_set_t t;
 
-	while (s[i] && strchr(accept, s[i])) i++;
+	__jacl_set_init(&t, accept);
 
-	return i;
+	return __jacl_set_span(&t, s, 1);
 }
 
 static inline size_t strcspn(const char* s, const char* reject) {
 	if (!s) return 0;
+	if (!reject) return strlen(s);
 
-	size_t i = 0;
+	__jacl_set_t t;
 
-	while (s[i] && !strchr(reject, s[i])) i++;
+	__jacl_set_init(&t, reject);
 
-	return i;
+	return __jacl_set_span(&t, s, 0);
 }
 
 static inline char* strpbrk(const char* s, const char* accept) {
 	if (!s || !accept) return NULL;
 
-	for (; *s; s++) if (strchr(accept, *s)) return (char* )s;
+	__jacl_set_t t;
 
-	return NULL;
+	__jacl_set_init(&t, accept);
+	s += __jacl_set_span(&t, s, 0);
+
+	return *s ? (char* )s : NULL;
 }
 
 static inline char* strtok_r(char* s, const char* delim, char** save) {
@@ -445,11 +1026,15 @@ static inline char* strtok_r(char* s, const char* delim, char** save) {
 
 	if (!p) return NULL;
 
-	p += strspn(p, delim);
+	__jacl_set_t t;
+
+	__jacl_set_init(&t, delim);
+
+	p += __jacl_set_span(&t, p, 1);
 
 	if (!*p) { *save = NULL; return NULL; }
 
-	char* q = p + strcspn(p, delim);
+	char* q = p + __jacl_set_span(&t, p, 0);
 
 	if (*q) *q++ = '\0';
 
@@ -18,6 +18,7 @@ extern "C" {
 #elif JACL_ARCH_WASM
 /* WASM doesn't support memory mapping */
 #else
+	#include <stdarg.h>
 	#include <unistd.h>
 	#include <sys/syscall.h>
 #endif
@@ -53,6 +54,10 @@ extern "C" {
 #define MAP_HUGETLB    0x40000
 #define MAP_SYNC       0x80000 /* DAX sync */
 #define MAP_UNINITIALIZED 0x4000000 /* Kernel config dependent */
+
+#define MREMAP_MAYMOVE   1
+#define MREMAP_FIXED     2
+#define MREMAP_DONTUNMAP 4 /* Linux 5.7+ */
 #endif
 
 /* Error return value */
@@ -207,6 +212,22 @@ static inline int munlock(const void *addr, size_t len) { return (int)syscall(SY
 static inline int mlockall(int flags) { return (int)syscall(SYS_mlockall, (long)flags); }
 static inline int munlockall(void) { return (int)syscall(SYS_munlockall); }
 static inline int mincore(void *addr, size_t length, unsigned char *vec) { return (int)syscall(SYS_mincore, (long)(uintptr_t)addr, (long)length, (long)(uintptr_t)vec); }
+#if JACL_OS_LINUX
+static inline void *mremap(void *old_address, size_t old_size, size_t new_size, int flags, ...) {
+	void *new_address = NULL;
+
+	/* the target address only exists with MREMAP_FIXED */
+	if (flags & MREMAP_FIXED) {
+		va_list ap;
+
+		va_start(ap, flags);
+		new_address = va_arg(ap, void*);
+		va_end(ap);
+	}
+
+	return (void*)syscall(SYS_mremap, (long)(uintptr_t)old_address, (long)old_size, (long)new_size, (long)flags, (long)(uintptr_t)new_address);
+}
+#endif
 #endif
 
 #ifdef __cplusplus
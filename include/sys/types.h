@@ -219,7 +219,9 @@ typedef struct __jacl_cleanup_node {
 		_Atomic int cancel_state;
 		_Atomic int cancel_type;
 		_Atomic int canceled;
+		_Atomic int ctid;
 		__jacl_cleanup_node_t *cleanup_stack;
+		struct __jacl_pthread *next;
 	};
 
 	typedef struct __jacl_pthread *pthread_t;
@@ -229,11 +231,15 @@ typedef struct __jacl_cleanup_node {
 		pid_t owner;
 		int type;
 		int recursive_count;
+		int pshared;
 	} pthread_mutex_t;
 
 	typedef struct {
 		_Atomic int futex;
 		_Atomic int waiters;
+		clockid_t clock;
+		int pshared;
+		pthread_mutex_t *mutex;
 	} pthread_cond_t;
 
 	typedef unsigned int pthread_key_t;
@@ -232,6 +232,8 @@ static inline size_t wcstombs(char *s, const wchar_t *pw, size_t n) {
 		i++;
 	}
 
+	if (s && t < n) s[t] = '\0';
+
 	return t;
 }
 
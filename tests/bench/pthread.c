@@ -0,0 +1,280 @@
+/* (c) 2026 FRINKnet & Friends – MIT licence */
+#include <testing.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+TEST_TYPE(bench)
+TEST_UNIT(pthread.h)
+
+/**
+ * NOTE: mutex benches. The uncontended rows are the cost every stdio call
+ * pays for its FILE lock; the contended rows hammer one lock from a crew of
+ * threads, with a short and a longer critical section, and check the counter
+ * it guards came out right. The wakeup rows time how quickly a sleeper comes
+ * back: a join on a thread that has just returned, a condvar ping-pong, and
+ * a broadcast to a crew that must all get through the mutex again. The burst
+ * rows start and join crews that fit the stack cache and crews that don't.
+ */
+
+#define BENCH_PAIRS   2000000
+#define BENCH_ROUNDS  200000
+#define BENCH_WAKES   20000
+
+static double bench_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(uncontended)
+
+static void bench_pairs(const char* name, int type) {
+	pthread_mutex_t m;
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, type);
+	pthread_mutex_init(&m, &attr);
+
+	double t0 = bench_now();
+
+	for (int i = 0; i < BENCH_PAIRS; i++) {
+		pthread_mutex_lock(&m);
+		pthread_mutex_unlock(&m);
+	}
+
+	double t = bench_now() - t0;
+
+	TEST_INFO("%-11s %7.1f ns/pair %8.2f Mpairs/s", name, t / BENCH_PAIRS * 1e9, BENCH_PAIRS / t / 1e6);
+
+	pthread_mutex_destroy(&m);
+	pthread_mutexattr_destroy(&attr);
+}
+
+TEST(mutex_uncontended) {
+	bench_pairs("normal", PTHREAD_MUTEX_NORMAL);
+	bench_pairs("errorcheck", PTHREAD_MUTEX_ERRORCHECK);
+	bench_pairs("recursive", PTHREAD_MUTEX_RECURSIVE);
+}
+
+TEST(flockfile_uncontended) {
+	FILE* f = fopen("/dev/null", "w");
+
+	if (!f) TEST_SKIP("no /dev/null");
+
+	double t0 = bench_now();
+
+	for (int i = 0; i < BENCH_PAIRS; i++) putc('x', f);
+
+	double t = bench_now() - t0;
+
+	TEST_INFO("putc        %7.1f ns/call", t / BENCH_PAIRS * 1e9);
+	fclose(f);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(contended)
+
+typedef struct {
+	pthread_mutex_t* m;
+	volatile long* counter;
+	int work;
+} bench_lock_t;
+
+static void* bench_locker(void* arg) {
+	bench_lock_t* job = (bench_lock_t*)arg;
+
+	for (int i = 0; i < BENCH_ROUNDS; i++) {
+		pthread_mutex_lock(job->m);
+
+		for (int w = 0; w <= job->work; w++) ++*job->counter;
+
+		pthread_mutex_unlock(job->m);
+	}
+
+	return NULL;
+}
+
+static void bench_crew(int threads, int work) {
+	pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+	pthread_t tids[16];
+	volatile long counter = 0;
+	bench_lock_t job = { &m, &counter, work };
+
+	double t0 = bench_now();
+
+	for (int i = 0; i < threads; i++) pthread_create(&tids[i], NULL, bench_locker, &job);
+	for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+
+	double t = bench_now() - t0;
+	long want = (long)threads * BENCH_ROUNDS * (work + 1);
+
+	TEST_INFO("%2d threads  work %3d  %7.1f ns/lock %8.2f Mlocks/s", threads, work, t / ((double)threads * BENCH_ROUNDS) * 1e9, (double)threads * BENCH_ROUNDS / t / 1e6);
+
+	if (counter != want) TEST_FAIL("%d threads: counter %ld, want %ld", threads, counter, want);
+}
+
+TEST(mutex_contended) {
+	static const int crews[] = { 1, 2, 4, 8, 16 };
+
+	for (int k = 0; k < 5; k++) bench_crew(crews[k], 0);
+	for (int k = 0; k < 5; k++) bench_crew(crews[k], 100);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(wakeup)
+
+static void* bench_noop(void* arg) { return arg; }
+
+TEST(join_latency) {
+	int n = BENCH_WAKES / 10;
+	double t0 = bench_now();
+
+	for (int i = 0; i < n; i++) {
+		pthread_t t;
+		void* res = NULL;
+
+		if (pthread_create(&t, NULL, bench_noop, &n)) TEST_FAIL("pthread_create failed at %d", i);
+		if (pthread_join(t, &res) || res != &n) TEST_FAIL("join %d came back wrong", i);
+	}
+
+	double t = bench_now() - t0;
+
+	TEST_INFO("create+join %7.1f us/thread", t / n * 1e6);
+}
+
+TEST(create_burst) {
+	static const unsigned crews[] = { 4, 16, 64 };
+
+	/* the first burst of 16 comes out of a warm cache, wider ones spill to mmap */
+	pthread_prewarm_np(16, 0);
+
+	for (int k = 0; k < 3; k++) {
+		pthread_t tids[64];
+		int rounds = BENCH_WAKES / 10 / (int)crews[k];
+		double t0 = bench_now();
+
+		for (int r = 0; r < rounds; r++) {
+			for (unsigned i = 0; i < crews[k]; i++) pthread_create(&tids[i], NULL, bench_noop, NULL);
+			for (unsigned i = 0; i < crews[k]; i++) pthread_join(tids[i], NULL);
+		}
+
+		double t = bench_now() - t0;
+
+		TEST_INFO("burst of %2u %7.1f us/thread", crews[k], t / (rounds * crews[k]) * 1e6);
+	}
+}
+
+typedef struct {
+	pthread_mutex_t m;
+	pthread_cond_t c;
+	int turn, gen, seen, crew;
+} bench_cond_t;
+
+static void* bench_ponger(void* arg) {
+	bench_cond_t* b = (bench_cond_t*)arg;
+
+	pthread_mutex_lock(&b->m);
+
+	for (int i = 0; i < BENCH_WAKES; i++) {
+		while (b->turn != 1) pthread_cond_wait(&b->c, &b->m);
+
+		b->turn = 0;
+		pthread_cond_signal(&b->c);
+	}
+
+	pthread_mutex_unlock(&b->m);
+
+	return NULL;
+}
+
+TEST(cond_pingpong) {
+	static bench_cond_t b = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0 };
+	pthread_t tid;
+
+	pthread_create(&tid, NULL, bench_ponger, &b);
+
+	double t0 = bench_now();
+
+	pthread_mutex_lock(&b.m);
+
+	for (int i = 0; i < BENCH_WAKES; i++) {
+		b.turn = 1;
+		pthread_cond_signal(&b.c);
+
+		while (b.turn != 0) pthread_cond_wait(&b.c, &b.m);
+	}
+
+	pthread_mutex_unlock(&b.m);
+
+	double t = bench_now() - t0;
+
+	pthread_join(tid, NULL);
+	TEST_INFO("ping-pong   %7.1f us/round trip", t / BENCH_WAKES * 1e6);
+}
+
+static void* bench_listener(void* arg) {
+	bench_cond_t* b = (bench_cond_t*)arg;
+	int gen = 0;
+
+	pthread_mutex_lock(&b->m);
+
+	for (int i = 0; i < BENCH_WAKES / 10; i++) {
+		while (b->gen == gen) pthread_cond_wait(&b->c, &b->m);
+
+		gen = b->gen;
+		b->seen++;
+	}
+
+	pthread_mutex_unlock(&b->m);
+
+	return NULL;
+}
+
+static void bench_broadcast(int crew) {
+	bench_cond_t b = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, crew };
+	pthread_t tids[16];
+	int rounds = BENCH_WAKES / 10;
+
+	for (int i = 0; i < crew; i++) pthread_create(&tids[i], NULL, bench_listener, &b);
+
+	double t0 = bench_now();
+
+	for (int r = 0; r < rounds; r++) {
+		pthread_mutex_lock(&b.m);
+
+		/* everyone has seen the last generation, and is waiting or on the way */
+		while (b.seen < crew * r) {
+			pthread_mutex_unlock(&b.m);
+			sched_yield();
+			pthread_mutex_lock(&b.m);
+		}
+
+		b.gen++;
+		pthread_cond_broadcast(&b.c);
+		pthread_mutex_unlock(&b.m);
+	}
+
+	for (int i = 0; i < crew; i++) pthread_join(tids[i], NULL);
+
+	double t = bench_now() - t0;
+
+	TEST_INFO("%2d waiters  %7.1f us/broadcast", crew, t / rounds * 1e6);
+
+	if (b.seen != crew * rounds) TEST_FAIL("%d waiters: %d wakeups, want %d", crew, b.seen, crew * rounds);
+}
+
+TEST(cond_broadcast) {
+	static const int crews[] = { 1, 2, 4, 8, 16 };
+
+	for (int k = 0; k < 5; k++) bench_broadcast(crews[k]);
+}
+
+TEST_MAIN()
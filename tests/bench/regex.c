@@ -0,0 +1,311 @@
+/* (c) 2026 FRINKnet & Friends – MIT licence */
+#include <testing.h>
+#include <regex.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+TEST_TYPE(bench)
+TEST_UNIT(regex.h)
+
+/**
+ * NOTE: Engine benches. Each row compiles one pattern, then scans a subject
+ * of every size with matchexec twice: once as compiled (the Pike VM when the
+ * pattern is regular, or its bit-state search while the program times the
+ * subject fits MATCH_MAX_BITS) and once with the program dropped so the same matcher
+ * runs on the recursive backtracker. The backtracker column shows its result
+ * code too, because on long subjects it tends to stop with M_EDEPTH rather
+ * than answer. The prefilter rows scan a log-shaped subject with the literal
+ * sets matchcomp extracted and again with them cleared, so the gap is what
+ * the gate buys. The set rows route log lines through 10, 100 and 1000 rules,
+ * once as a matchset and once the way a router without one would: every rule
+ * through matchexec, line by line. The set is timed on its first pass, while
+ * its DFA is still being built, and again once the states are cached. The
+ * stream rows feed the log subject to a matchstream in 64 byte and 4 KiB
+ * chunks, counting every match, next to matchexec doing the same over the
+ * whole buffer. The boolean rows time regexec on short lines with nmatch 0,
+ * the way filters call it, against the same calls asking for every group.
+ */
+
+#define BENCH_BYTES  (4u * 1024 * 1024)
+
+typedef struct { const char* name; const char* pat; int flags; char fill[4]; char tail; } bench_row_t;
+
+static const bench_row_t bench_rows[] = {
+	{ "literal",  "needle",             REG_EXTENDED, "hay ",  'x' },
+	{ "class",    "[0-9]+x",            REG_EXTENDED, "ab1 ",  'y' },
+	{ "alt",      "(GET|PUT|POST) /",   REG_EXTENDED, "GETx",  'z' },
+	{ "dotstar",  "a.*z",               REG_EXTENDED, "abcd",  'z' },
+	{ "nested",   "(a|aa)*b",           REG_EXTENDED, "aaaa",  'c' },
+	{ "counted",  "(ab){2,5}c",         REG_EXTENDED, "abab",  'c' },
+};
+
+static const size_t bench_sizes[] = { 64, 1024, 16384, 262144 };
+
+static char bench_subject[262144 + 1];
+
+static double bench_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static const char* const bench_log_pats[] = {
+	"(GET|PUT|POST) /admin",
+	"[0-9]+ FATAL",
+	"user=.*denied",
+	"(?i)panic: ",
+};
+
+static const size_t bench_rule_counts[] = { 10, 100, 1000 };
+
+static const size_t bench_chunks[] = { 64, 4096 };
+
+static const struct { const char* pat; int flags; const char* line; } bench_bool_rows[] = {
+	{ "(GET|POST) (/[a-z/]*) HTTP",          REG_EXTENDED, "GET /index/page/more HTTP/1.1" },
+	{ "([a-z]+)@([a-z]+)\\.com",             REG_EXTENDED, "mail to someone@example.com today" },
+	{ "([0-9]{1,3})\\.([0-9]{1,3})\\.([0-9]+)", REG_EXTENDED, "from host 192.168.100.200 port" },
+	{ "(\\w+)\\s+\\1",                       REG_PCRE2,    "the quick brown fox jumps over the the lazy dog" },
+	{ "(?<=id=)([0-9]+)(?!x)",               REG_PCRE2,    "GET /item?id=12345&ref=home" },
+};
+
+#define BENCH_LINES 512
+
+static void bench_rule(char* buf, size_t sz, size_t i) {
+	switch (i % 4) {
+		case 0:  snprintf(buf, sz, "(GET|POST) /api/v%zu/item", i); break;
+		case 1:  snprintf(buf, sz, "user=u%zu\\b", i); break;
+		case 2:  snprintf(buf, sz, "code [45]%02zu .*timeout", i % 100); break;
+		default: snprintf(buf, sz, "^host%zu[a-z]* ", i); break;
+	}
+}
+
+static double bench_mbs(size_t n, size_t reps, double t) { return t > 0 ? (double)n * (double)reps / t / 1e6 : 0; }
+
+/* ============================================================================ */
+
+TEST_SUITE(engine)
+
+TEST(engine_vm_vs_backtrack) {
+	for (size_t r = 0; r < sizeof(bench_rows) / sizeof(*bench_rows); r++) {
+		const bench_row_t* row = &bench_rows[r];
+		regex_t re, bt;
+		match_find_t pm[1];
+
+		if (regcomp(&re, row->pat, row->flags)) TEST_FAIL("regcomp('%s') failed", row->pat);
+		if (!re.prog) TEST_FAIL("'%s' did not get a program", row->pat);
+
+		bt = re; bt.prog = NULL;
+
+		for (size_t k = 0; k < sizeof(bench_sizes) / sizeof(*bench_sizes); k++) {
+			size_t n = bench_sizes[k], reps = BENCH_BYTES / n + 1;
+
+			for (size_t i = 0; i < n; i++) bench_subject[i] = row->fill[i & 3];
+
+			bench_subject[n - 1] = row->tail;
+
+			int vr = 0, br = 0;
+			double t0 = bench_now();
+
+			for (size_t i = 0; i < reps; i++) vr = matchexec(&re, bench_subject, bench_subject + n, pm, 1, re.eflags);
+
+			double t1 = bench_now();
+			size_t breps = reps / 16 + 1;
+
+			for (size_t i = 0; i < breps; i++) br = matchexec(&bt, bench_subject, bench_subject + n, pm, 1, bt.eflags);
+
+			double t2 = bench_now();
+
+			if (vr != M_SUCCESS && vr != M_NOMATCH) TEST_FAIL("%s: vm returned %d at %zu bytes", row->name, vr, n);
+
+			TEST_INFO("%-8s %7zu bytes %9.1f MB/s  (backtrack %9.1f MB/s, rc %d vs %d)", row->name, n, bench_mbs(n, reps, t1 - t0), bench_mbs(n, breps, t2 - t1), vr, br);
+		}
+
+		regfree(&re);
+	}
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(prefilter)
+
+TEST(prefilter_log_scan) {
+	static const char line[] = "2026-01-01 12:00:00 GET /index.html 200 user=guest ok\n";
+	size_t n = 0;
+
+	while (n + sizeof(line) < sizeof(bench_subject)) { memcpy(bench_subject + n, line, sizeof(line) - 1); n += sizeof(line) - 1; }
+
+	bench_subject[n] = '\0';
+
+	for (size_t r = 0; r < sizeof(bench_log_pats) / sizeof(*bench_log_pats); r++) {
+		regex_t re, raw;
+		match_find_t pm[1];
+		size_t reps = BENCH_BYTES / n + 1;
+
+		if (regcomp(&re, bench_log_pats[r], REG_PCRE2)) TEST_FAIL("regcomp('%s') failed", bench_log_pats[r]);
+
+		raw = re; raw.pre.n = raw.req.n = 0;
+
+		int gr = 0, rr = 0;
+		double t0 = bench_now();
+
+		for (size_t i = 0; i < reps; i++) gr = matchexec(&re, bench_subject, bench_subject + n, pm, 1, re.eflags);
+
+		double t1 = bench_now();
+
+		for (size_t i = 0; i < reps; i++) rr = matchexec(&raw, bench_subject, bench_subject + n, pm, 1, raw.eflags);
+
+		double t2 = bench_now();
+
+		if (gr != rr) TEST_FAIL("'%s': gated %d vs ungated %d", bench_log_pats[r], gr, rr);
+
+		TEST_INFO("%-24s pre %u req %u %9.1f MB/s  (no literals %9.1f MB/s)", bench_log_pats[r], re.pre.n, re.req.n, bench_mbs(n, reps, t1 - t0), bench_mbs(n, reps, t2 - t1));
+
+		regfree(&re);
+	}
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(set)
+
+TEST(set_rules_per_line) {
+	static char lines[BENCH_LINES][96];
+	static matcher_t one[1000];
+	size_t bytes = 0;
+
+	for (size_t i = 0; i < BENCH_LINES; i++) {
+		snprintf(lines[i], sizeof(lines[i]), "host%zu web GET /api/v%zu/item?id=%zu user=u%zu code %d%02zu in 12ms", i % 7, i % 1300, i, (i * 37) % 1500, 4 + (int)(i & 1), i % 100);
+		bytes += strlen(lines[i]);
+	}
+
+	for (size_t c = 0; c < sizeof(bench_rule_counts) / sizeof(*bench_rule_counts); c++) {
+		size_t rules = bench_rule_counts[c], hits = 0, loop_hits = 0;
+		matchset_t set = { 0 };
+		char pat[64];
+		uint32_t ids[8];
+
+		for (size_t i = 0; i < rules; i++) {
+			bench_rule(pat, sizeof(pat), i);
+
+			if (matchsetadd(&set, pat, MCOMP_EXTENDED, 0) != M_SUCCESS || matchcomp(&one[i], pat, MCOMP_EXTENDED) != M_SUCCESS) TEST_FAIL("rule '%s' did not compile", pat);
+		}
+
+		if (matchsetcomp(&set) != M_SUCCESS) TEST_FAIL("matchsetcomp failed at %zu rules", rules);
+
+		double t[3];
+
+		for (int pass = 0; pass < 3; pass++) {
+			t[pass] = bench_now();
+			hits = 0;
+
+			for (size_t i = 0; i < BENCH_LINES; i++) {
+				size_t n = 8;
+
+				if (matchsetexec(&set, lines[i], lines[i] + strlen(lines[i]), ids, &n, 0) == M_SUCCESS) hits += n;
+			}
+		}
+
+		double t3 = bench_now();
+
+		for (size_t i = 0; i < BENCH_LINES; i++) for (size_t r = 0; r < rules; r++) if (matchexec(&one[r], lines[i], lines[i] + strlen(lines[i]), NULL, 0, 0) == M_SUCCESS) loop_hits++;
+
+		double t4 = bench_now();
+
+		if (hits != loop_hits) TEST_FAIL("%zu rules: set found %zu matches, the loop %zu", rules, hits, loop_hits);
+
+		TEST_INFO("%4zu rules %9.1f MB/s cold %9.1f MB/s warm  (rule by rule %9.1f MB/s, %zu matches)", rules, bench_mbs(bytes, 1, t[1] - t[0]), bench_mbs(bytes, 2, t3 - t[1]), bench_mbs(bytes, 1, t4 - t3), hits);
+
+		for (size_t i = 0; i < rules; i++) matchfree(&one[i]);
+
+		matchsetfree(&set);
+	}
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(stream)
+
+TEST(stream_chunked_log_scan) {
+	static const char line[] = "2026-01-01 12:00:00 GET /index.html 200 user=guest ok\n";
+	size_t n = 0;
+
+	while (n + sizeof(line) < sizeof(bench_subject)) { memcpy(bench_subject + n, line, sizeof(line) - 1); n += sizeof(line) - 1; }
+
+	for (size_t r = 0; r < sizeof(bench_log_pats) / sizeof(*bench_log_pats); r++) {
+		matcher_t m;
+		match_find_t pm[1];
+		size_t reps = BENCH_BYTES / n + 1, whole = 0;
+
+		if (matchcomp(&m, bench_log_pats[r], MCOMP_PCRE2) != M_SUCCESS) TEST_FAIL("matchcomp('%s') failed", bench_log_pats[r]);
+
+		double t0 = bench_now();
+
+		for (size_t i = 0; i < reps; i++) for (const char* p = bench_subject; matchexec(&m, p, bench_subject + n, pm, 1, 0) == M_SUCCESS; p += pm[0].rm_eo > 0 ? pm[0].rm_eo : 1) whole++;
+
+		double t1 = bench_now(), mbs[2];
+
+		for (size_t c = 0; c < sizeof(bench_chunks) / sizeof(*bench_chunks); c++) {
+			size_t found = 0;
+			double t2 = bench_now();
+
+			for (size_t i = 0; i < reps; i++) {
+				matchstream_t ms;
+
+				if (matchstreaminit(&ms, &m, 1, 0) != M_SUCCESS) TEST_FAIL("'%s' can't be streamed", bench_log_pats[r]);
+
+				for (size_t at = 0; at < n; at += bench_chunks[c]) {
+					size_t k = n - at < bench_chunks[c] ? n - at : bench_chunks[c], off = 0, used;
+
+					while (off < k && matchstreamfeed(&ms, bench_subject + at + off, k - off, &used, pm, 1) == M_SUCCESS) { found++; off += used; }
+				}
+
+				while (matchstreamend(&ms, pm, 1) == M_SUCCESS) found++;
+
+				matchstreamfree(&ms);
+			}
+
+			mbs[c] = bench_mbs(n, reps, bench_now() - t2);
+
+			if (found != whole) TEST_FAIL("'%s': %zu byte chunks found %zu matches, matchexec %zu", bench_log_pats[r], bench_chunks[c], found, whole);
+		}
+
+		TEST_INFO("%-24s %9.1f MB/s in 64 B chunks %9.1f MB/s in 4 KiB  (whole buffer %9.1f MB/s, %zu matches)", bench_log_pats[r], mbs[0], mbs[1], bench_mbs(n, reps, t1 - t0), whole);
+
+		matchfree(&m);
+	}
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(boolean)
+
+TEST(boolean_regexec_short_lines) {
+	for (size_t r = 0; r < sizeof(bench_bool_rows) / sizeof(*bench_bool_rows); r++) {
+		regex_t re;
+		regmatch_t pm[4];
+		size_t reps = 200000, a = 0, b = 0;
+
+		if (regcomp(&re, bench_bool_rows[r].pat, bench_bool_rows[r].flags)) TEST_FAIL("regcomp('%s') failed", bench_bool_rows[r].pat);
+
+		double t0 = bench_now();
+
+		for (size_t i = 0; i < reps; i++) a += !regexec(&re, bench_bool_rows[r].line, 0, NULL, 0);
+
+		double t1 = bench_now();
+
+		for (size_t i = 0; i < reps; i++) b += !regexec(&re, bench_bool_rows[r].line, 4, pm, 0);
+
+		double t2 = bench_now();
+
+		if (a != reps || b != reps) TEST_FAIL("'%s' missed its line", bench_bool_rows[r].pat);
+
+		TEST_INFO("%-34s %-9s %7.0f ns boolean  (%7.0f ns with groups)", bench_bool_rows[r].pat, re.prog ? "program" : "backtrack", (t1 - t0) / (double)reps * 1e9, (t2 - t1) / (double)reps * 1e9);
+
+		regfree(&re);
+	}
+}
+
+TEST_MAIN()
@@ -0,0 +1,178 @@
+/* (c) 2026 FRINKnet & Friends – MIT licence */
+#include <testing.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+TEST_TYPE(bench)
+TEST_UNIT(stdio.h)
+
+/**
+ * NOTE: printf benches. Every format goes through the same __jacl_printf, so
+ * the tables differ only in the sink: a FILE buffer (fprintf), a caller's
+ * array (snprintf) and an unbuffered descriptor (dprintf). The sweep checks
+ * that truncating at every length agrees with the untruncated output. The
+ * registry rows hold thousands of streams open at once, close them oldest
+ * first, and time fflush(NULL) across all of them.
+ */
+
+#define BENCH_CALLS  200000
+#define BENCH_FILES  20000
+
+typedef struct { const char* name; const char* fmt; } bench_fmt_t;
+
+static const bench_fmt_t bench_fmts[] = {
+	{ "literal", "the quick brown fox jumps over the lazy dog %d\n" },
+	{ "ints",    "%d %5u %-8x %08o %lld %+d\n" },
+	{ "strings", "%s=%-12s|%20s|%.3s\n" },
+	{ "floats",  "%f %.2f %e %g\n" },
+	{ "padded",  "%40d|%-40s|%040x\n" },
+	{ "shortest", "%r %r %hr\n" },
+	{ "wide",    "%llu %llx %llX %llo\n" },
+};
+
+static double bench_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int bench_call(int k, int (*emit)(void*, const char*, ...), void* to, size_t i) {
+	switch (k) {
+	case 0: return emit(to, bench_fmts[0].fmt, (int)i);
+	case 1: return emit(to, bench_fmts[1].fmt, (int)i, (unsigned)i, (unsigned)i * 2654435761u, (unsigned)i, (long long)i << 20, -(int)i);
+	case 2: return emit(to, bench_fmts[2].fmt, "key", "value", "right aligned", "truncated");
+	case 3: return emit(to, bench_fmts[3].fmt, i * 0.125, 3.14159, 12345.678, 1e-5 * (double)i);
+	case 4: return emit(to, bench_fmts[4].fmt, (int)i, "left", (unsigned)i);
+	case 5: return emit(to, bench_fmts[5].fmt, (double)i / 7, 1e-3 * (double)i * 1.1, (float)i / 3);
+	default: return emit(to, bench_fmts[6].fmt, (unsigned long long)i * 0x9E3779B97F4A7C15ull, (unsigned long long)i << 40 | i, ~(unsigned long long)i, (unsigned long long)i * 2654435761u);
+	}
+}
+
+static char bench_buf[512];
+static size_t bench_cap = sizeof(bench_buf);
+
+static int emit_file(void* to, const char* fmt, ...) { va_list ap; va_start(ap, fmt); int r = vfprintf((FILE*)to, fmt, ap); va_end(ap); return r; }
+static int emit_string(void* to, const char* fmt, ...) { va_list ap; va_start(ap, fmt); int r = vsnprintf(bench_buf, bench_cap, fmt, ap); va_end(ap); (void)to; return r; }
+static int emit_fd(void* to, const char* fmt, ...) { va_list ap; va_start(ap, fmt); int r = vdprintf(*(int*)to, fmt, ap); va_end(ap); return r; }
+
+static void bench_table(const char* sink, int (*emit)(void*, const char*, ...), void* to, size_t calls) {
+	for (int k = 0; k < (int)(sizeof(bench_fmts) / sizeof(*bench_fmts)); k++) {
+		size_t bytes = 0;
+		double t0 = bench_now();
+
+		for (size_t i = 0; i < calls; i++) bytes += (size_t)bench_call(k, emit, to, i);
+
+		double t = bench_now() - t0;
+
+		TEST_INFO("%-8s %-8s %8.2f Mcalls/s %8.1f MB/s", sink, bench_fmts[k].name, t > 0 ? (double)calls / t / 1e6 : 0, t > 0 ? (double)bytes / t / 1e6 : 0);
+	}
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(snprintf)
+
+TEST(snprintf_truncation_sweep) {
+	char full[sizeof(bench_buf)];
+
+	for (int k = 0; k < (int)(sizeof(bench_fmts) / sizeof(*bench_fmts)); k++) {
+		for (size_t i = 0; i < 64; i++) {
+			bench_cap = sizeof(bench_buf);
+
+			int n = bench_call(k, emit_string, NULL, i);
+
+			memcpy(full, bench_buf, (size_t)n + 1);
+
+			for (bench_cap = 0; bench_cap <= (size_t)n + 1; bench_cap++) {
+				memset(bench_buf, 0x7F, sizeof(bench_buf));
+
+				int r = bench_call(k, emit_string, NULL, i);
+
+				if (r != n) TEST_FAIL("%s: cap %zu returned %d, want %d", bench_fmts[k].name, bench_cap, r, n);
+				if (bench_cap && (memcmp(bench_buf, full, bench_cap - 1) || bench_buf[bench_cap - 1] != '\0')) TEST_FAIL("%s: cap %zu wrote \"%s\"", bench_fmts[k].name, bench_cap, bench_buf);
+				if (!bench_cap && bench_buf[0] != 0x7F) TEST_FAIL("%s: cap 0 wrote to the buffer", bench_fmts[k].name);
+			}
+		}
+	}
+
+	bench_cap = sizeof(bench_buf);
+}
+
+TEST(snprintf_throughput) {
+	bench_table("snprintf", emit_string, NULL, BENCH_CALLS);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(fprintf)
+
+TEST(fprintf_throughput) {
+	FILE* f = fopen("/dev/null", "w");
+
+	if (!f) TEST_SKIP("no /dev/null");
+
+	bench_table("fprintf", emit_file, f, BENCH_CALLS);
+	fclose(f);
+}
+
+TEST(fprintf_unbuffered_throughput) {
+	FILE* f = fopen("/dev/null", "w");
+
+	if (!f) TEST_SKIP("no /dev/null");
+
+	setvbuf(f, NULL, _IONBF, 0);
+	bench_table("fp/nbf", emit_file, f, BENCH_CALLS / 10);
+	fclose(f);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(dprintf)
+
+TEST(dprintf_throughput) {
+	int fd = open("/dev/null", O_WRONLY);
+
+	if (fd < 0) TEST_SKIP("no /dev/null");
+
+	bench_table("dprintf", emit_fd, &fd, BENCH_CALLS / 10);
+	close(fd);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(registry)
+
+TEST(fopen_fclose_many_open) {
+	static FILE* files[BENCH_FILES];
+	static char bufs[BENCH_FILES][16];
+	double t0 = bench_now();
+
+	for (int i = 0; i < BENCH_FILES; i++) {
+		if (!(files[i] = fmemopen(bufs[i], sizeof(bufs[i]), "w"))) TEST_FAIL("fmemopen %d failed", i);
+		fputc('x', files[i]);
+	}
+
+	double t1 = bench_now();
+
+	fflush(NULL);
+
+	double t2 = bench_now();
+
+	if (bufs[BENCH_FILES - 1][0] != 'x') TEST_FAIL("fflush(NULL) missed stream %d", BENCH_FILES - 1);
+	if (bufs[0][0] != 'x') TEST_FAIL("fflush(NULL) missed stream %d", 0);
+
+	for (int i = 0; i < BENCH_FILES; i++) fclose(files[i]);
+
+	double t3 = bench_now();
+
+	TEST_INFO("open        %7.1f ns/stream", (t1 - t0) / BENCH_FILES * 1e9);
+	TEST_INFO("fflush(NULL) %6.1f ns/stream", (t2 - t1) / BENCH_FILES * 1e9);
+	TEST_INFO("close       %7.1f ns/stream (oldest first)", (t3 - t2) / BENCH_FILES * 1e9);
+}
+
+TEST_MAIN()
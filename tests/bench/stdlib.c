@@ -0,0 +1,663 @@
+/* (c) 2025 FRINKnet & Friends – MIT licence */
+#include <testing.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <pthread.h>
+
+TEST_TYPE(bench)
+TEST_UNIT(stdlib.h)
+
+/**
+ * NOTE: Allocator benches. Sizes are picked to land in a particular part of
+ * core/memory.h so each table measures one path rather than a blend of them.
+ */
+
+#define BENCH_SEGS  512
+#define BENCH_HUGE  (900u * 1024)
+
+static void* bench_live[BENCH_SEGS];
+
+static double bench_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* the segment walk free() used before the page map */
+static __jacl_memseg_t* ref_memseg_walk(void* p) {
+	for (__jacl_memseg_t* seg = __jacl_memseg_head; seg; seg = seg->next) if (p >= (void*)seg->base && p < (void*)(seg->base + seg->size)) return seg;
+
+	return NULL;
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(free)
+
+TEST(free_segment_lookup) {
+	static const size_t counts[] = { 1, 16, 64, 256, 512 };
+	size_t live = 0;
+
+	for (size_t k = 0; k < sizeof(counts) / sizeof(*counts); k++) {
+		for (; live < counts[k]; live++) {
+			bench_live[live] = malloc(BENCH_HUGE);
+
+			if (!bench_live[live]) TEST_FAIL("malloc %zu", live);
+		}
+
+		size_t reps = 20000 / live + 1, hits = 0;
+		double t0 = bench_now();
+
+		for (size_t r = 0; r < reps; r++) for (size_t i = 0; i < live; i++) hits += __jacl_memseg_find((__jacl_memhdr_t*)bench_live[i] - 1) != NULL;
+
+		double t1 = bench_now();
+
+		for (size_t r = 0; r < reps; r++) for (size_t i = 0; i < live; i++) hits += ref_memseg_walk((__jacl_memhdr_t*)bench_live[i] - 1) != NULL;
+
+		double t2 = bench_now();
+
+		if (hits != 2 * reps * live) TEST_FAIL("%zu segments lost a lookup", live);
+
+		for (size_t i = 0; i < live; i++) free(bench_live[i]);
+
+		double t3 = bench_now();
+
+		for (size_t i = 0; i < live; i++) bench_live[i] = malloc(BENCH_HUGE);
+
+		double ops = (double)(reps * live);
+
+		TEST_INFO("%4zu segments  page map %7.1f ns  (list walk %8.1f ns)  free %7.1f ns", live, (t1 - t0) / ops * 1e9, (t2 - t1) / ops * 1e9, (t3 - t2) / (double)live * 1e9);
+	}
+
+	for (size_t i = 0; i < live; i++) free(bench_live[i]);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(malloc)
+
+/**
+ * Threads pair up as producer and consumer around a single-producer ring:
+ * the producer mallocs and stamps a block, the consumer checks and frees it,
+ * so every handed-off block is a remote free. Each thread also churns its own
+ * short-lived blocks in between. With one thread there is only the churn.
+ */
+
+#define BENCH_THREADS  64
+#define BENCH_RING     256
+#define BENCH_OPS      100000
+
+typedef struct {
+	_Alignas(64) _Atomic size_t head;
+	_Alignas(64) _Atomic size_t tail;
+	void* slot[BENCH_RING];
+} bench_ring_t;
+
+typedef struct {
+	bench_ring_t* ring;
+	int role;  /* 0 solo, 1 producer, 2 consumer */
+	size_t ops, bad;
+	unsigned seed;
+} bench_worker_t;
+
+static bench_ring_t bench_rings[BENCH_THREADS / 2];
+static bench_worker_t bench_workers[BENCH_THREADS];
+
+static size_t bench_size(unsigned* seed) {
+	*seed = *seed * 1103515245u + 12345u;
+
+	return 16 + ((*seed >> 16) % 496);
+}
+
+static void* bench_worker(void* arg) {
+	bench_worker_t* w = arg;
+	void* local[16] = { 0 };
+
+	for (size_t i = 0; i < BENCH_OPS; i++) {
+		size_t k = i & 15, n = bench_size(&w->seed);
+
+		free(local[k]);
+
+		local[k] = malloc(n);
+
+		if (!local[k]) { w->bad++; continue; }
+
+		memset(local[k], (int)k, n < 64 ? n : 64);
+
+		w->ops += 2;
+
+		if (w->role == 1) {
+			unsigned char* b = malloc(n);
+
+			if (!b) { w->bad++; continue; }
+
+			memcpy(b, &n, sizeof(n));
+			b[n - 1] = (unsigned char)n;
+
+			while (atomic_load_explicit(&w->ring->head, memory_order_acquire) - atomic_load_explicit(&w->ring->tail, memory_order_acquire) >= BENCH_RING) sched_yield();
+
+			size_t h = atomic_load_explicit(&w->ring->head, memory_order_relaxed);
+
+			w->ring->slot[h % BENCH_RING] = b;
+
+			atomic_store_explicit(&w->ring->head, h + 1, memory_order_release);
+
+			w->ops++;
+		} else if (w->role == 2) {
+			size_t t = atomic_load_explicit(&w->ring->tail, memory_order_relaxed);
+
+			while (atomic_load_explicit(&w->ring->head, memory_order_acquire) == t) sched_yield();
+
+			unsigned char* b = w->ring->slot[t % BENCH_RING];
+
+			atomic_store_explicit(&w->ring->tail, t + 1, memory_order_release);
+
+			size_t bn;
+
+			memcpy(&bn, b, sizeof(bn));
+
+			if (bn < 16 || bn > 512 || b[bn - 1] != (unsigned char)bn) w->bad++;
+
+			free(b);
+
+			w->ops++;
+		}
+	}
+
+	for (int k = 0; k < 16; k++) free(local[k]);
+
+	return NULL;
+}
+
+TEST(malloc_thread_scaling) {
+	static const int counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+	pthread_t tid[BENCH_THREADS];
+	double base = 0;
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(*counts); c++) {
+		int n = counts[c];
+		size_t ops = 0, bad = 0;
+
+		for (int i = 0; i < n; i++) {
+			bench_worker_t* w = &bench_workers[i];
+
+			memset(w, 0, sizeof(*w));
+
+			w->ring = &bench_rings[i / 2];
+			w->role = n == 1 ? 0 : 1 + (i & 1);
+			w->seed = 0x9E3779B9u * (unsigned)(i + 1);
+
+			if (!(i & 1)) {
+				atomic_store(&w->ring->head, 0);
+				atomic_store(&w->ring->tail, 0);
+			}
+		}
+
+		double t0 = bench_now();
+
+		for (int i = 0; i < n; i++) if (pthread_create(&tid[i], NULL, bench_worker, &bench_workers[i])) TEST_FAIL("pthread_create %d", i);
+		for (int i = 0; i < n; i++) pthread_join(tid[i], NULL);
+
+		double t = bench_now() - t0;
+
+		for (int i = 0; i < n; i++) { ops += bench_workers[i].ops; bad += bench_workers[i].bad; }
+
+		if (bad) TEST_FAIL("%d threads: %zu bad blocks", n, bad);
+
+		double rate = (double)ops / t / 1e6;
+
+		if (n == 1) base = rate;
+
+		TEST_INFO("%2d threads  %8.2f Mops/s  (%5.2fx one thread)", n, rate, base > 0 ? rate / base : 0);
+	}
+}
+
+/**
+ * A buffer growing a megabyte at a time, the way a vector or an
+ * open_memstream buffer does. Huge blocks move by remapping pages, the
+ * reference copies every byte on each step.
+ */
+
+#define BENCH_GROW_STEP  (1u << 20)
+#define BENCH_GROW_MAX   (64u << 20)
+
+TEST(realloc_growth) {
+	unsigned char *p = NULL, *q = NULL;
+	double t0 = bench_now();
+
+	for (size_t n = BENCH_GROW_STEP; n <= BENCH_GROW_MAX; n += BENCH_GROW_STEP) {
+		if (!(p = realloc(p, n))) TEST_FAIL("realloc %zu", n);
+
+		p[n - BENCH_GROW_STEP] = (unsigned char)(n >> 20);
+	}
+
+	double t1 = bench_now();
+
+	for (size_t n = BENCH_GROW_STEP; n <= BENCH_GROW_MAX; n += BENCH_GROW_STEP) {
+		unsigned char* r = malloc(n);
+
+		if (!r) TEST_FAIL("malloc %zu", n);
+		if (q) { memcpy(r, q, n - BENCH_GROW_STEP); free(q); }
+
+		q = r;
+		q[n - BENCH_GROW_STEP] = (unsigned char)(n >> 20);
+	}
+
+	double t2 = bench_now();
+
+	for (size_t n = BENCH_GROW_STEP; n <= BENCH_GROW_MAX; n += BENCH_GROW_STEP) {
+		if (p[n - BENCH_GROW_STEP] != (unsigned char)(n >> 20)) TEST_FAIL("lost byte at %zu", n - BENCH_GROW_STEP);
+	}
+
+	free(p);
+	free(q);
+
+	TEST_INFO("grow to %u MiB  realloc %8.2f ms  (malloc+copy %8.2f ms)", BENCH_GROW_MAX >> 20, (t1 - t0) * 1e3, (t2 - t1) * 1e3);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(calloc)
+
+/**
+ * Zeroed buffers carved from fresh segments or mapped on their own. calloc
+ * knows those read as zero already, so the only pages it faults in are the
+ * ones holding headers; the reference zeroes them by hand like calloc used to.
+ */
+
+#define BENCH_ZERO_BYTES  (64u << 20)
+
+static long bench_faults(void) {
+	struct rusage ru;
+
+	return getrusage(RUSAGE_SELF, &ru) ? 0 : ru.ru_minflt;
+}
+
+TEST(calloc_page_touch) {
+	static const size_t sizes[] = { 256u << 10, 8u << 20 };
+
+	for (size_t k = 0; k < sizeof(sizes) / sizeof(*sizes); k++) {
+		size_t n = sizes[k], count = BENCH_ZERO_BYTES / n;
+
+		malloc_trim(0);
+
+		long f0 = bench_faults();
+		double t0 = bench_now();
+
+		for (size_t i = 0; i < count; i++) if (!(bench_live[i] = calloc(1, n))) TEST_FAIL("calloc %zu", n);
+
+		long f1 = bench_faults();
+		double t1 = bench_now();
+
+		for (size_t i = 0; i < count; i++) free(bench_live[i]);
+
+		malloc_trim(0);
+
+		long f2 = bench_faults();
+		double t2 = bench_now();
+
+		for (size_t i = 0; i < count; i++) {
+			if (!(bench_live[i] = malloc(n))) TEST_FAIL("malloc %zu", n);
+
+			memset(bench_live[i], 0, n);
+		}
+
+		long f3 = bench_faults();
+		double t3 = bench_now();
+
+		for (size_t i = 0; i < count; i++) free(bench_live[i]);
+
+		malloc_trim(0);
+
+		TEST_INFO("%5zu KiB x %3zu  calloc %6ld faults %7.2f ms  (malloc+memset %6ld faults %7.2f ms)", n >> 10, count, f1 - f0, (t1 - t0) * 1e3, f3 - f2, (t3 - t2) * 1e3);
+	}
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(malloc_trim)
+
+/**
+ * Resident set size around a burst of big frees: what the decay timers hold
+ * on to, and what malloc_trim hands back right away.
+ */
+
+#define BENCH_BURST  128
+#define BENCH_BLOCK  (256u * 1024)
+
+static size_t bench_rss(void) {
+	FILE* f = fopen("/proc/self/statm", "r");
+	size_t pages = 0, rss = 0;
+
+	if (!f) return 0;
+	if (fscanf(f, "%zu %zu", &pages, &rss) != 2) rss = 0;
+
+	fclose(f);
+
+	return rss * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+TEST(malloc_trim_rss) {
+	size_t start = bench_rss();
+
+	if (!start) TEST_SKIP("no /proc/self/statm");
+
+	for (int i = 0; i < BENCH_BURST; i++) {
+		if (!(bench_live[i] = malloc(BENCH_BLOCK))) TEST_FAIL("malloc %d", i);
+
+		memset(bench_live[i], i, BENCH_BLOCK);
+	}
+
+	size_t full = bench_rss();
+
+	for (int i = 0; i < BENCH_BURST; i++) free(bench_live[i]);
+
+	size_t freed = bench_rss();
+	double t0 = bench_now();
+	int released = malloc_trim(0);
+	double t1 = bench_now();
+	size_t trimmed = bench_rss();
+
+	if (!released || trimmed >= full) TEST_FAIL("malloc_trim kept %zu KiB", trimmed >> 10);
+
+	TEST_INFO("start %6zu KiB  allocated %6zu KiB  freed %6zu KiB  trimmed %6zu KiB (%.1f us)", start >> 10, full >> 10, freed >> 10, trimmed >> 10, (t1 - t0) * 1e6);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strtod)
+
+/**
+ * Parse throughput over a column of numbers, one table row per shape: CSV
+ * style fixed decimals, shortest round-trip output, full 17 digits and
+ * integers. Every value is checked against the bits it was printed from
+ * where the text is exact.
+ */
+
+#define BENCH_NUMS  100000
+
+static char* bench_column(const char* fmt, int exact) {
+	char* text = malloc(BENCH_NUMS * 32), *p = text;
+	uint64_t seed = 0x853C49E6748FEA9Bull;
+
+	if (!text) return NULL;
+
+	for (int i = 0; i < BENCH_NUMS; i++) {
+		seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+
+		double v = exact ? (double)(int64_t)(seed >> 24) : (double)(seed >> 11) / 9007199254740992.0 * 2000.0 - 1000.0;
+
+		if (!exact && (i & 3) == 3) v *= 1e-12 * (double)(seed & 0xFFFFFF);
+
+		p += sprintf(p, fmt, v);
+		*p++ = '\n';
+	}
+
+	*p = '\0';
+
+	return text;
+}
+
+static void bench_parse(const char* name, const char* fmt, int exact) {
+	char* text = bench_column(fmt, exact);
+
+	if (!text) return;
+
+	size_t bytes = strlen(text), count = 0;
+	double sum = 0, t0 = bench_now();
+
+	for (int r = 0; r < 5; r++) {
+		for (char* p = text; *p; p++, count++) sum += strtod(p, &p);
+	}
+
+	double t1 = bench_now();
+
+	for (char* p = text; *p; p++) sum += strtof(p, &p);
+
+	double t2 = bench_now();
+
+	TEST_INFO("%-8s strtod %8.1f MB/s %6.1f ns/num   strtof %8.1f MB/s   (%zu nums, sum %g)", name, 5.0 * (double)bytes / (t1 - t0) / 1e6, (t1 - t0) / (double)count * 1e9, (double)bytes / (t2 - t1) / 1e6, count / 5, sum);
+
+	free(text);
+}
+
+TEST(strtod_throughput) {
+	bench_parse("fixed", "%.3f", 0);
+	bench_parse("shortest", "%r", 0);
+	bench_parse("digits17", "%.17g", 0);
+	bench_parse("integers", "%.0f", 1);
+}
+
+TEST(strtod_round_trip) {
+	char* text = bench_column("%r", 0);
+
+	if (!text) TEST_SKIP("no memory");
+
+	size_t bad = 0, count = 0;
+	uint64_t seed = 0x853C49E6748FEA9Bull;
+
+	for (char* p = text; *p; p++, count++) {
+		seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+
+		double v = (double)(seed >> 11) / 9007199254740992.0 * 2000.0 - 1000.0;
+
+		if ((count & 3) == 3) v *= 1e-12 * (double)(seed & 0xFFFFFF);
+		if (strtod(p, &p) != v) bad++;
+	}
+
+	free(text);
+
+	if (bad) TEST_FAIL("%zu of %zu values did not read back", bad, count);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strtoull)
+
+/**
+ * Integer parse throughput per base over full-width random values, so the
+ * eight-at-a-time scan gets long runs, plus short ids where it never kicks
+ * in. Each column is checked against the values it was printed from.
+ */
+
+static void bench_strtoull(const char* name, const char* fmt, int base, int shift) {
+	char* text = malloc(BENCH_NUMS * 68), *p = text;
+	uint64_t seed = 0x9E3779B97F4A7C15ull, check = 0, sum = 0;
+
+	if (!text) return;
+
+	for (int i = 0; i < BENCH_NUMS; i++) {
+		seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+
+		unsigned long long v = seed >> shift;
+
+		check += v;
+
+		if (base == 2) {
+			int n = 64 - shift;
+
+			while (n--) *p++ = (char)('0' + ((v >> n) & 1));
+		} else p += sprintf(p, fmt, v);
+
+		*p++ = '\n';
+	}
+
+	*p = '\0';
+
+	size_t bytes = strlen(text);
+	double t0 = bench_now();
+
+	for (int r = 0; r < 5; r++) {
+		sum = 0;
+
+		for (char* q = text; *q; q++) sum += strtoull(q, &q, base);
+	}
+
+	double t = bench_now() - t0;
+
+	TEST_INFO("%-8s base %2d %8.1f MB/s %6.1f ns/num", name, base, 5.0 * (double)bytes / t / 1e6, t / (5.0 * BENCH_NUMS) * 1e9);
+
+	if (sum != check) TEST_FAIL("%s: base %d read back the wrong values", name, base);
+
+	free(text);
+}
+
+TEST(strtoull_throughput) {
+	bench_strtoull("full", "%llu", 10, 0);
+	bench_strtoull("full", "%llx", 16, 0);
+	bench_strtoull("full", "%llo", 8, 0);
+	bench_strtoull("full", "", 2, 0);
+	bench_strtoull("ids", "%llu", 10, 50);
+	bench_strtoull("ids", "%llx", 16, 50);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(qsort)
+
+/**
+ * Sort time per input shape and element size. The 4 and 8 byte rows take the
+ * single-word swaps, 24 bytes the word loop; comparisons are counted so a
+ * pivot regression shows up even where the clock is noisy.
+ */
+
+#define BENCH_SORT_N  200000
+
+static size_t bench_sort_calls;
+
+static int bench_sort_cmp(const void* a, const void* b) {
+	unsigned x = *(const unsigned*)a, y = *(const unsigned*)b;
+
+	bench_sort_calls++;
+
+	return (x > y) - (x < y);
+}
+
+static void bench_sort(const char* name, int shape, size_t size) {
+	unsigned char* arr = malloc(BENCH_SORT_N * size);
+	unsigned seed = 0x2545F491u;
+
+	if (!arr) return;
+
+	memset(arr, 0, BENCH_SORT_N * size);
+
+	for (size_t i = 0; i < BENCH_SORT_N; i++) {
+		seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+
+		unsigned v = shape == 0 ? (unsigned)i : shape == 1 ? (unsigned)(BENCH_SORT_N - i) : shape == 2 ? seed : seed % 16;
+
+		memcpy(arr + i * size, &v, sizeof(v));
+	}
+
+	bench_sort_calls = 0;
+
+	double t0 = bench_now();
+
+	qsort(arr, BENCH_SORT_N, size, bench_sort_cmp);
+
+	double t = bench_now() - t0;
+
+	for (size_t i = 1; i < BENCH_SORT_N; i++) {
+		if (bench_sort_cmp(arr + (i - 1) * size, arr + i * size) > 0) {
+			TEST_FAIL("%s/%zu: out of order at %zu", name, size, i);
+			break;
+		}
+	}
+
+	TEST_INFO("%-10s %2zu bytes %8.2f ms %6.1f ns/elem %6.2f cmp/elem log2", name, size, t * 1e3, t / BENCH_SORT_N * 1e9, (double)bench_sort_calls / BENCH_SORT_N / 17.6);
+
+	free(arr);
+}
+
+TEST(qsort_shapes) {
+	static const char* names[] = { "sorted", "reversed", "random", "dups16" };
+	static const size_t sizes[] = { 4, 8, 24 };
+
+	for (int shape = 0; shape < 4; shape++) {
+		for (int k = 0; k < 3; k++) bench_sort(names[shape], shape, sizes[k]);
+	}
+}
+
+static int bench_sort_cmp_r(const void* a, const void* b, void* arg) {
+	(void)arg;
+
+	return bench_sort_cmp(a, b);
+}
+
+TEST(qsort_mt_scaling) {
+	unsigned* arr = malloc(BENCH_SORT_N * 8 * sizeof(unsigned));
+	static const unsigned crews[] = { 1, 2, 4, 8, 16 };
+	size_t n = BENCH_SORT_N * 8;
+
+	if (!arr) TEST_SKIP("no memory");
+
+	for (int k = 0; k < 5; k++) {
+		unsigned seed = 0x2545F491u;
+
+		for (size_t i = 0; i < n; i++) {
+			seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+			arr[i] = seed;
+		}
+
+		double t0 = bench_now();
+
+		qsort_mt(arr, n, sizeof(*arr), bench_sort_cmp_r, NULL, crews[k], 0);
+
+		double t = bench_now() - t0;
+
+		for (size_t i = 1; i < n; i++) {
+			if (arr[i - 1] > arr[i]) {
+				TEST_FAIL("%u threads: out of order at %zu", crews[k], i);
+				break;
+			}
+		}
+
+		TEST_INFO("qsort_mt %2u threads %8.2f ms %6.1f ns/elem", crews[k], t * 1e3, t / (double)n * 1e9);
+	}
+
+	free(arr);
+}
+
+TEST(bsearch_batch_vs_loop) {
+	size_t n = BENCH_SORT_N * 8;
+	unsigned* arr = malloc(n * sizeof(unsigned)), *keys = malloc(n / 4 * sizeof(unsigned));
+	void** found = malloc(n / 4 * sizeof(void*));
+
+	if (!arr || !keys || !found) TEST_SKIP("no memory");
+
+	for (size_t i = 0; i < n; i++) arr[i] = (unsigned)(3 * i);
+
+	/* dense and sparse key sets: one per 4 elements, one per 1024 */
+	for (size_t gap = 4; gap <= 1024; gap *= 16) {
+		size_t k = n / gap, loop = 0, batch;
+
+		for (size_t i = 0; i < k; i++) keys[i] = (unsigned)(3 * i * gap + (i & 1));
+
+		double t0 = bench_now();
+
+		for (size_t i = 0; i < k; i++) loop += bsearch(&keys[i], arr, n, sizeof(unsigned), bench_sort_cmp) != NULL;
+
+		double t1 = bench_now();
+
+		batch = bsearch_batch(keys, k, sizeof(unsigned), arr, n, sizeof(unsigned), bench_sort_cmp, found);
+
+		double t2 = bench_now();
+
+		TEST_INFO("1 key per %4zu  bsearch %6.1f ns/key  batch %6.1f ns/key", gap, (t1 - t0) / (double)k * 1e9, (t2 - t1) / (double)k * 1e9);
+
+		if (loop != batch) TEST_FAIL("gap %zu: bsearch found %zu, batch %zu", gap, loop, batch);
+	}
+
+	free(arr); free(keys); free(found);
+}
+
+/* ============================================================================ */
+
+TEST_MAIN()
@@ -0,0 +1,436 @@
+/* (c) 2025 FRINKnet & Friends – MIT licence */
+#include <testing.h>
+#include <string.h>
+#include <time.h>
+
+TEST_TYPE(bench)
+TEST_UNIT(string.h)
+
+/**
+ * NOTE: Each suite runs a correctness sweep and then a throughput table. The
+ * sweep visits every size from 0 to 64 KiB and rotates the destination and
+ * source misalignment (0-63 each) with the size so every pairing is hit many
+ * times along the way. Throughput is reported against a plain byte loop which
+ * is exactly what string.h used to do before the word and vector kernels.
+ */
+
+#define BENCH_MAX    (64 * 1024)
+#define BENCH_PAD    128
+#define BENCH_BYTES  (64u * 1024 * 1024)
+
+static unsigned char bench_src[BENCH_MAX + 2 * BENCH_PAD];
+static unsigned char bench_dst[BENCH_MAX + 2 * BENCH_PAD];
+static const size_t bench_sizes[] = { 8, 16, 64, 256, 1024, 4096, 16384, 65536 };
+
+static double bench_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void bench_fill(unsigned char* p, size_t n, unsigned seed) {
+	for (size_t i = 0; i < n; i++) p[i] = (unsigned char)(i * 131 + seed) | 1;
+}
+
+static size_t bench_reps(size_t n) { return n ? BENCH_BYTES / n + 1 : 1; }
+static double bench_mbs(size_t n, size_t reps, double t) { return t > 0 ? (double)n * (double)reps / t / 1e6 : 0; }
+
+/* byte loop references (the previous implementation) */
+static void* ref_memcpy(void* d, const void* s, size_t n) { volatile unsigned char* x = d; const unsigned char* y = s; for (size_t i = 0; i < n; i++) x[i] = y[i]; return d; }
+static void* ref_memset(void* d, int c, size_t n) { volatile unsigned char* x = d; for (size_t i = 0; i < n; i++) x[i] = (unsigned char)c; return d; }
+static int ref_memcmp(const void* a, const void* b, size_t n) { const volatile unsigned char* x = a; const unsigned char* y = b; for (size_t i = 0; i < n; i++) if (x[i] != y[i]) return x[i] < y[i] ? -1 : 1; return 0; }
+static void* ref_memchr(const void* s, int c, size_t n) { const volatile unsigned char* p = s; for (size_t i = 0; i < n; i++) if (p[i] == (unsigned char)c) return (void*)((const unsigned char*)s + i); return NULL; }
+static size_t ref_strlen(const char* s) { const volatile char* p = s; size_t n = 0; while (p[n]) n++; return n; }
+static size_t ref_strcspn(const char* s, const char* r) { const volatile char* p = s; size_t i = 0; while (p[i] && !strchr(r, p[i])) i++; return i; }
+static void* ref_memmem(const void* h, size_t hl, const void* n, size_t nl) { for (size_t i = 0; i + nl <= hl; i++) if (!ref_memcmp((const unsigned char*)h + i, n, nl)) return (void*)((const unsigned char*)h + i); return NULL; }
+
+static const void* volatile bench_sink;
+
+#define BENCH_TABLE(name, setup, fast, slow) do { \
+	for (size_t __k = 0; __k < sizeof(bench_sizes) / sizeof(*bench_sizes); __k++) { \
+		size_t n = bench_sizes[__k], reps = bench_reps(n); \
+		setup; \
+		double __t0 = bench_now(); \
+		for (size_t __r = 0; __r < reps; __r++) { fast; } \
+		double __t1 = bench_now(); \
+		for (size_t __r = 0; __r < reps; __r++) { slow; } \
+		double __t2 = bench_now(); \
+		TEST_INFO("%-8s %6zu bytes %10.1f MB/s  (byte loop %8.1f MB/s)", name, n, bench_mbs(n, reps, __t1 - __t0), bench_mbs(n, reps, __t2 - __t1)); \
+	} \
+} while (0)
+
+/* ============================================================================ */
+
+TEST_SUITE(memcpy)
+
+TEST(memcpy_sweep) {
+	bench_fill(bench_src, sizeof(bench_src), 7);
+
+	for (size_t n = 0; n <= BENCH_MAX; n++) {
+		size_t da = n & 63, sa = (n >> 6) & 63;
+		unsigned char* d = bench_dst + da;
+
+		memset(bench_dst, 0xEE, n + BENCH_PAD);
+
+		ASSERT_PTR_EQ(d, memcpy(d, bench_src + sa, n));
+
+		for (size_t i = 0; i < n; i++) if (d[i] != bench_src[sa + i]) TEST_FAIL("size %zu offset %zu", n, i);
+		for (size_t i = 0; i < da; i++) if (bench_dst[i] != 0xEE) TEST_FAIL("size %zu underrun %zu", n, i);
+		for (size_t i = 0; i < 64; i++) if (d[n + i] != 0xEE) TEST_FAIL("size %zu overrun %zu", n, i);
+	}
+}
+
+TEST(memcpy_throughput) {
+	BENCH_TABLE("memcpy", (void)0, memcpy(bench_dst + 1, bench_src, n), ref_memcpy(bench_dst + 1, bench_src, n));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(memmove)
+
+TEST(memmove_sweep) {
+	for (size_t n = 0; n <= BENCH_MAX; n += 1 + (n >> 7)) {
+		for (size_t shift = 1; shift < 64; shift += 9) {
+			bench_fill(bench_dst, n + BENCH_PAD, 3);
+			memmove(bench_dst + shift, bench_dst, n);
+
+			for (size_t i = 0; i < n; i++) if (bench_dst[shift + i] != (unsigned char)((i * 131 + 3) | 1)) TEST_FAIL("forward size %zu shift %zu at %zu", n, shift, i);
+
+			bench_fill(bench_dst, n + BENCH_PAD, 3);
+			memmove(bench_dst, bench_dst + shift, n);
+
+			for (size_t i = 0; i < n; i++) if (bench_dst[i] != (unsigned char)(((i + shift) * 131 + 3) | 1)) TEST_FAIL("backward size %zu shift %zu at %zu", n, shift, i);
+		}
+	}
+}
+
+TEST(memmove_throughput) {
+	BENCH_TABLE("memmove", (void)0, memmove(bench_dst + 3, bench_dst, n), ref_memcpy(bench_src + 3, bench_src, n));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(memset)
+
+TEST(memset_sweep) {
+	for (size_t n = 0; n <= BENCH_MAX; n++) {
+		size_t da = n & 63;
+		unsigned char* d = bench_dst + da;
+		int c = (int)(n & 0xFF);
+
+		ref_memset(bench_dst, 0xEE, n + BENCH_PAD);
+		memset(d, c, n);
+
+		for (size_t i = 0; i < n; i++) if (d[i] != (unsigned char)c) TEST_FAIL("size %zu offset %zu", n, i);
+		for (size_t i = 0; i < 64; i++) if (d[n + i] != 0xEE) TEST_FAIL("size %zu overrun %zu", n, i);
+	}
+}
+
+TEST(memset_throughput) {
+	BENCH_TABLE("memset", (void)0, memset(bench_dst + 1, 0x5A, n), ref_memset(bench_dst + 1, 0x5A, n));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(memcmp)
+
+TEST(memcmp_sweep) {
+	bench_fill(bench_src, sizeof(bench_src), 11);
+
+	for (size_t n = 0; n <= BENCH_MAX; n++) {
+		size_t da = n & 63, sa = (n >> 6) & 63;
+		unsigned char* d = bench_dst + da;
+
+		memcpy(d, bench_src + sa, n);
+
+		if (memcmp(d, bench_src + sa, n)) TEST_FAIL("size %zu not equal", n);
+		if (!n) continue;
+
+		size_t at = (n * 2654435761u) % n;
+
+		d[at] ^= 0x80;
+
+		if (memcmp(d, bench_src + sa, n) != ref_memcmp(d, bench_src + sa, n)) TEST_FAIL("size %zu diff at %zu", n, at);
+	}
+}
+
+TEST(memcmp_throughput) {
+	BENCH_TABLE("memcmp", memcpy(bench_dst + 1, bench_src, n), (void)memcmp(bench_dst + 1, bench_src, n), (void)ref_memcmp(bench_dst + 1, bench_src, n));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(memchr)
+
+TEST(memchr_sweep) {
+	for (size_t n = 0; n <= BENCH_MAX; n++) {
+		size_t da = n & 63;
+		unsigned char* d = bench_dst + da;
+
+		ref_memset(bench_dst, 'a', n + BENCH_PAD);
+
+		d[n] = 'Z';
+
+		if (memchr(d, 'Z', n)) TEST_FAIL("size %zu read past end", n);
+		if (!n) continue;
+
+		size_t at = (n * 2654435761u) % n;
+
+		d[at] = 'Z';
+
+		if (memchr(d, 'Z', n) != d + at) TEST_FAIL("size %zu missed %zu", n, at);
+	}
+}
+
+TEST(memchr_throughput) {
+	BENCH_TABLE("memchr", (ref_memset(bench_dst, 'a', n + 1), bench_dst[n] = 'Z'), (void)memchr(bench_dst, 'Z', n), (void)ref_memchr(bench_dst, 'Z', n));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strlen)
+
+TEST(strlen_sweep) {
+	for (size_t n = 0; n <= BENCH_MAX; n++) {
+		char* s = (char*)bench_dst + (n & 63);
+
+		ref_memset(s, 'x', n);
+
+		s[n] = '\0';
+
+		if (strlen(s) != n) TEST_FAIL("size %zu misaligned %zu", n, n & 63);
+	}
+}
+
+TEST(strlen_throughput) {
+	BENCH_TABLE("strlen", (ref_memset(bench_dst, 'x', n), bench_dst[n] = 0), (void)strlen((char*)bench_dst), (void)ref_strlen((char*)bench_dst));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strchr)
+
+TEST(strchr_sweep) {
+	for (size_t n = 1; n <= BENCH_MAX; n++) {
+		char* s = (char*)bench_dst + (n & 63);
+		size_t at = (n * 2654435761u) % n;
+
+		ref_memset(s, 'x', n);
+
+		s[n] = '\0';
+		s[n + 1] = 'Z';
+
+		if (strchr(s, 'Z')) TEST_FAIL("size %zu read past nul", n);
+		if (strchr(s, '\0') != s + n) TEST_FAIL("size %zu missed nul", n);
+
+		s[at] = 'Z';
+
+		if (strchr(s, 'Z') != s + at) TEST_FAIL("size %zu missed %zu", n, at);
+	}
+}
+
+TEST(strchr_throughput) {
+	BENCH_TABLE("strchr", (ref_memset(bench_dst, 'x', n), bench_dst[n] = 0), (void)strchr((char*)bench_dst, 'Z'), (void)ref_memchr(bench_dst, 'Z', n + 1));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strcmp)
+
+TEST(strcmp_sweep) {
+	for (size_t n = 1; n <= BENCH_MAX; n++) {
+		char* a = (char*)bench_dst + (n & 63);
+		char* b = (char*)bench_src + ((n >> 6) & 63);
+
+		ref_memset(a, 'q', n); a[n] = '\0';
+		ref_memset(b, 'q', n); b[n] = '\0';
+
+		if (strcmp(a, b)) TEST_FAIL("size %zu not equal", n);
+
+		b[n - 1] = (char)0xF0;
+
+		if (strcmp(a, b) >= 0) TEST_FAIL("size %zu high byte not above", n);
+
+		b[n - 1] = '\0';
+
+		if (strcmp(a, b) <= 0) TEST_FAIL("size %zu prefix not below", n);
+	}
+}
+
+TEST(strcmp_throughput) {
+	BENCH_TABLE("strcmp", (ref_memset(bench_dst, 'q', n), bench_dst[n] = 0, ref_memset(bench_src + 1, 'q', n), bench_src[n + 1] = 0), (void)strcmp((char*)bench_dst, (char*)bench_src + 1), (void)ref_memcmp(bench_dst, bench_src + 1, n + 1));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strstr)
+
+/* needles of 'a' with one 'b' at the end or middle against a haystack of 'a' are quadratic for the naive loop */
+static const size_t bench_needles[] = { 2, 4, 8, 16, 32, 64, 256, 1024 };
+
+TEST(strstr_sweep) {
+	char* h = (char*)bench_dst;
+	char* n = (char*)bench_src;
+
+	for (size_t l = 1; l <= 300; l++) {
+		ref_memset(h, 'a', BENCH_MAX / 16);
+		ref_memset(n, 'a', l);
+
+		h[BENCH_MAX / 16] = '\0';
+		n[l - 1] = 'b';
+		n[l] = '\0';
+
+		if (strstr(h, n)) TEST_FAIL("needle %zu false positive", l);
+
+		size_t at = (l * 2654435761u) % (BENCH_MAX / 16 - l);
+
+		h[at + l - 1] = 'b';
+
+		if (strstr(h, n) != h + at) TEST_FAIL("needle %zu missed %zu", l, at);
+		if (memmem(h, BENCH_MAX / 16, n, l) != h + at) TEST_FAIL("memmem needle %zu missed %zu", l, at);
+	}
+}
+
+TEST(strstr_throughput) {
+	size_t hl = BENCH_MAX, reps = 64;
+
+	ref_memset(bench_dst, 'a', hl);
+
+	bench_dst[hl] = '\0';
+
+	for (size_t k = 0; k < 2 * sizeof(bench_needles) / sizeof(*bench_needles); k++) {
+		size_t l = bench_needles[k >> 1], at = k & 1 ? l / 2 : l - 1;
+
+		ref_memset(bench_src, 'a', l);
+
+		bench_src[at] = 'b';
+		bench_src[l] = '\0';
+
+		double t0 = bench_now();
+
+		for (size_t r = 0; r < reps; r++) bench_sink = strstr((char*)bench_dst, (char*)bench_src);
+
+		double t1 = bench_now();
+
+		for (size_t r = 0; r < reps; r++) bench_sink = memmem(bench_dst, hl, bench_src, l);
+
+		double t2 = bench_now();
+
+		for (size_t r = 0; r < (reps + 7) / 8; r++) bench_sink = ref_memmem(bench_dst, hl, bench_src, l);
+
+		double t3 = bench_now();
+
+		TEST_INFO("needle %5zu b@%-4zu strstr %8.1f MB/s  memmem %8.1f MB/s  (naive %8.1f MB/s)", l, at, bench_mbs(hl, reps, t1 - t0), bench_mbs(hl, reps, t2 - t1), bench_mbs(hl, (reps + 7) / 8, t3 - t2));
+	}
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strcspn)
+
+/* delimiter sets drawn from printable punctuation, haystack of letters so the scan runs the full length */
+static const char bench_delims[] = ",;:|\t/\\-_.+=*&^%$#@!~?<>()[]{}'\"";
+
+TEST(strcspn_sweep) {
+	char set[33];
+	char* s = (char*)bench_dst;
+
+	for (size_t k = 0; k <= 32; k++) {
+		memcpy(set, bench_delims, k);
+
+		set[k] = '\0';
+
+		for (size_t n = 0; n <= 4096; n += 1 + (n >> 5)) {
+			char* p = s + (n & 63);
+
+			for (size_t i = 0; i < n; i++) p[i] = 'a' + (char)(i % 26);
+
+			p[n] = '\0';
+
+			if (strcspn(p, set) != n) TEST_FAIL("set %zu size %zu ran short", k, n);
+			if (strspn(p, set) != 0) TEST_FAIL("set %zu size %zu spanned letters", k, n);
+			if (!k || !n) continue;
+
+			size_t at = (n * 2654435761u) % n;
+
+			p[at] = set[at % k];
+
+			if (strcspn(p, set) != at) TEST_FAIL("set %zu size %zu missed %zu", k, n, at);
+			if (strpbrk(p, set) != p + at) TEST_FAIL("strpbrk set %zu size %zu missed %zu", k, n, at);
+
+			for (size_t i = 0; i < n; i++) p[i] = set[i % k];
+
+			if (strspn(p, set) != n) TEST_FAIL("strspn set %zu size %zu", k, n);
+		}
+	}
+}
+
+TEST(strcspn_throughput) {
+	static const size_t sets[] = { 1, 2, 3, 4, 8, 12, 16, 24, 32 };
+	size_t n = 16384, reps = BENCH_BYTES / n / 4;
+	char set[33];
+
+	for (size_t i = 0; i < n; i++) bench_dst[i] = 'a' + (unsigned char)(i % 26);
+
+	bench_dst[n] = '\0';
+
+	for (size_t j = 0; j < sizeof(sets) / sizeof(*sets); j++) {
+		size_t k = sets[j];
+
+		memcpy(set, bench_delims, k);
+
+		set[k] = '\0';
+
+		double t0 = bench_now();
+
+		for (size_t r = 0; r < reps; r++) bench_sink = (void*)strcspn((char*)bench_dst, set);
+
+		double t1 = bench_now();
+
+		for (size_t r = 0; r < reps / 64 + 1; r++) bench_sink = (void*)ref_strcspn((char*)bench_dst, set);
+
+		double t2 = bench_now();
+
+		TEST_INFO("set %2zu strcspn %8.1f MB/s  (strchr loop %7.1f MB/s)", k, bench_mbs(n, reps, t1 - t0), bench_mbs(n, reps / 64 + 1, t2 - t1));
+	}
+}
+
+TEST(strtok_r_throughput) {
+	static const size_t sets[] = { 1, 2, 4, 8, 16, 32 };
+	static char line[BENCH_MAX + 1];
+	size_t n = BENCH_MAX, reps = 256;
+	char set[33];
+
+	for (size_t j = 0; j < sizeof(sets) / sizeof(*sets); j++) {
+		size_t k = sets[j], tokens = 0;
+
+		memcpy(set, bench_delims, k);
+
+		set[k] = '\0';
+
+		double t = 0;
+
+		for (size_t r = 0; r < reps; r++) {
+			for (size_t i = 0; i < n; i++) line[i] = (i % 12) == 11 ? set[i % k] : 'a' + (char)(i % 26);
+
+			line[n] = '\0';
+
+			double t0 = bench_now();
+			char* save;
+
+			for (char* tok = strtok_r(line, set, &save); tok; tok = strtok_r(NULL, set, &save)) tokens++;
+
+			t += bench_now() - t0;
+		}
+
+		if (tokens != reps * (n / 12 + (n % 12 != 0))) TEST_FAIL("set %zu token count %zu", k, tokens);
+
+		TEST_INFO("set %2zu strtok_r %8.1f MB/s  %6.1f Mtok/s", k, bench_mbs(n, reps, t), t > 0 ? (double)tokens / t / 1e6 : 0);
+	}
+}
+
+/* ============================================================================ */
+
+TEST_MAIN()
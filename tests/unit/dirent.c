@@ -199,10 +199,16 @@ TEST(closedir_null) {
 	ASSERT_EQ(EBADF, errno);
 }
 
-TEST(closedir_double) {
+TEST(closedir_reopen) {
 	create_test_directory();
 	DIR *dir = opendir(test_dir);
-	closedir(dir);
+	ASSERT_NOT_NULL(dir);
+	ASSERT_EQ(0, closedir(dir));
+
+	/* a closed stream is gone, so close the directory again through a fresh one */
+	dir = opendir(test_dir);
+	ASSERT_NOT_NULL(dir);
+	ASSERT_NOT_NULL(readdir(dir));
 	int result = closedir(dir);
 	ASSERT_EQ(0, result);
 	cleanup_test_directory();
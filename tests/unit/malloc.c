@@ -0,0 +1,380 @@
+/* (c) 2026 FRINKnet & Friends – MIT licence */
+#include <testing.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+TEST_TYPE(unit);
+TEST_UNIT(malloc.h);
+
+/* ============================================================================ */
+
+/* big enough to need a segment, small enough not to get a mapping of its own */
+#define TEST_BIG   (JACL_HUGE_MIN / 2)
+#define TEST_HUGE  (4u << 20)
+
+/* ============================================================================ */
+TEST_SUITE(malloc_trim);
+
+TEST(malloc_trim_releases_segments) {
+	void *blocks[8];
+
+	for (int i = 0; i < 8; i++) {
+		blocks[i] = malloc(TEST_BIG);
+		ASSERT_NOT_NULL(blocks[i]);
+		memset(blocks[i], i, TEST_BIG);
+	}
+
+	size_t before = __jacl_heap_current;
+
+	for (int i = 0; i < 8; i++) free(blocks[i]);
+
+	ASSERT_INT_EQ(1, malloc_trim(0));
+	ASSERT_TRUE(__jacl_heap_current <= before - 8 * TEST_BIG);
+}
+
+TEST(malloc_trim_releases_past_one_batch) {
+	// one segment apiece, and more of them than a single sweep batches up
+	enum { N = 40 };
+	size_t big = JACL_HEAP_SEG / 2 + JACL_HEAP_SEG / 4;
+	void *blocks[N];
+
+	for (int i = 0; i < N; i++) {
+		blocks[i] = malloc(big);
+		ASSERT_NOT_NULL(blocks[i]);
+		memset(blocks[i], i, big);
+	}
+
+	size_t before = __jacl_heap_current;
+
+	for (int i = 0; i < N; i++) free(blocks[i]);
+
+	ASSERT_INT_EQ(1, malloc_trim(0));
+	ASSERT_TRUE(__jacl_heap_current <= before - N * (size_t)JACL_HEAP_SEG);
+}
+
+TEST(malloc_trim_keeps_live_blocks) {
+	unsigned char *live = malloc(TEST_BIG);
+	void *dead = malloc(TEST_BIG);
+
+	ASSERT_NOT_NULL(live);
+	ASSERT_NOT_NULL(dead);
+
+	memset(live, 0x5A, TEST_BIG);
+	free(dead);
+	malloc_trim(0);
+
+	ASSERT_INT_EQ(0x5A, live[0]);
+	ASSERT_INT_EQ(0x5A, live[TEST_BIG - 1]);
+	ASSERT_PTR_EQ(__jacl_memseg_find((__jacl_memhdr_t *)live - 1), __jacl_pagemap_get(live));
+
+	free(live);
+}
+
+TEST(malloc_trim_pad_keeps_purged) {
+	void *blocks[4];
+
+	for (int i = 0; i < 4; i++) ASSERT_NOT_NULL(blocks[i] = malloc(TEST_BIG));
+	for (int i = 0; i < 4; i++) free(blocks[i]);
+
+	size_t before = __jacl_heap_current;
+
+	malloc_trim((size_t)-1);
+
+	ASSERT_TRUE(__jacl_heap_current == before);
+
+	/* purging must leave the segment records alone */
+	int segs = 0;
+
+	for (__jacl_memseg_t *seg = __jacl_memseg_head->next; seg; seg = seg->next, segs++) ASSERT_TRUE(seg->size > 0);
+
+	ASSERT_TRUE(segs >= 4);
+
+	/* the purged segments still serve allocations */
+	void *again = malloc(TEST_BIG);
+
+	ASSERT_NOT_NULL(again);
+	memset(again, 1, TEST_BIG);
+	free(again);
+	malloc_trim(0);
+}
+
+TEST(malloc_trim_idle_heap) {
+	malloc_trim(0);
+
+	ASSERT_INT_EQ(0, malloc_trim(0));
+}
+
+TEST(malloc_trim_then_grow) {
+	for (int round = 0; round < 4; round++) {
+		void *p = malloc(TEST_BIG);
+
+		ASSERT_NOT_NULL(p);
+		memset(p, round, TEST_BIG);
+		free(p);
+		ASSERT_INT_EQ(1, malloc_trim(0));
+	}
+}
+
+/* ============================================================================ */
+TEST_SUITE(malloc_huge);
+
+TEST(malloc_huge_own_mapping) {
+	size_t before = __jacl_heap_current;
+	unsigned char *p = malloc(TEST_HUGE);
+
+	ASSERT_NOT_NULL(p);
+	ASSERT_NULL(__jacl_memseg_find((__jacl_memhdr_t *)p - 1));
+	ASSERT_PTR_EQ((__jacl_memhdr_t *)p - 1, __jacl_huge_block(p));
+	ASSERT_TRUE(__jacl_heap_current >= before + TEST_HUGE);
+
+	memset(p, 0x3C, TEST_HUGE);
+	free(p);
+
+	ASSERT_INT_EQ(before, __jacl_heap_current);
+}
+
+TEST(malloc_huge_realloc_grows) {
+	unsigned char *p = malloc(TEST_HUGE);
+
+	ASSERT_NOT_NULL(p);
+
+	for (size_t i = 0; i < TEST_HUGE; i += 4096) p[i] = (unsigned char)(i >> 12);
+
+	p = realloc(p, 4 * TEST_HUGE);
+
+	ASSERT_NOT_NULL(p);
+	ASSERT_NOT_NULL(__jacl_huge_block(p));
+
+	for (size_t i = 0; i < TEST_HUGE; i += 4096) ASSERT_INT_EQ((unsigned char)(i >> 12), p[i]);
+
+	p[4 * TEST_HUGE - 1] = 1;
+	free(p);
+}
+
+TEST(malloc_huge_realloc_from_segment) {
+	unsigned char *p = malloc(TEST_BIG);
+
+	ASSERT_NOT_NULL(p);
+	ASSERT_NULL(__jacl_huge_block(p));
+
+	memset(p, 0x11, TEST_BIG);
+	p = realloc(p, TEST_HUGE);
+
+	ASSERT_NOT_NULL(p);
+	ASSERT_NOT_NULL(__jacl_huge_block(p));
+	ASSERT_INT_EQ(0x11, p[TEST_BIG - 1]);
+
+	free(p);
+}
+
+TEST(malloc_huge_aligned) {
+	size_t before = __jacl_heap_current;
+	void *p = aligned_alloc(1u << 16, TEST_HUGE);
+
+	ASSERT_NOT_NULL(p);
+	ASSERT_INT_EQ(0, (uintptr_t)p & 0xFFFF);
+
+	memset(p, 0x7E, TEST_HUGE);
+	free(p);
+
+	ASSERT_INT_EQ(before, __jacl_heap_current);
+}
+
+/* ============================================================================ */
+TEST_SUITE(calloc_zero);
+
+#if JACL_OS_LINUX
+TEST(calloc_huge_leaves_pages_alone) {
+	static unsigned char vec[TEST_HUGE / 4096 + 1];
+	unsigned char *p = calloc(1, TEST_HUGE);
+
+	ASSERT_NOT_NULL(p);
+
+	uint8_t *page = (uint8_t *)((uintptr_t)p & ~(uintptr_t)4095);
+	size_t pages = (size_t)(p + TEST_HUGE - page + 4095) / 4096, resident = 0;
+
+	ASSERT_INT_EQ(0, mincore(page, pages * 4096, vec));
+
+	for (size_t i = 0; i < pages; i++) resident += vec[i] & 1;
+
+	/* the header page is the only one written */
+	ASSERT_TRUE(resident <= 1);
+	ASSERT_INT_EQ(0, p[0]);
+	ASSERT_INT_EQ(0, p[TEST_HUGE - 1]);
+
+	free(p);
+}
+#endif
+
+TEST(calloc_reused_block_is_zeroed) {
+	for (int round = 0; round < 4; round++) {
+		unsigned char *p = malloc(TEST_BIG);
+
+		ASSERT_NOT_NULL(p);
+		memset(p, 0xFF, TEST_BIG);
+		free(p);
+
+		p = calloc(TEST_BIG / 64, 64);
+
+		ASSERT_NOT_NULL(p);
+
+		for (size_t i = 0; i < TEST_BIG; i += 512) ASSERT_INT_EQ(0, p[i]);
+
+		ASSERT_INT_EQ(0, p[TEST_BIG - 1]);
+		ASSERT_INT_EQ(0, ((__jacl_memhdr_t *)p - 1)->flags & JACL_HDR_ZERO);
+
+		free(p);
+
+		if (round & 1) malloc_trim((size_t)-1);
+	}
+}
+
+TEST(calloc_fresh_segment_skips_memset) {
+	malloc_trim(0);
+
+	/* too big for what's left of the static heap, so it comes from a new segment */
+	unsigned char *p = malloc(TEST_BIG);
+
+	ASSERT_NOT_NULL(p);
+	ASSERT_TRUE(((__jacl_memhdr_t *)p - 1)->flags & JACL_HDR_ZERO);
+
+	for (size_t i = 0; i < TEST_BIG; i += 512) ASSERT_INT_EQ(0, p[i]);
+
+	free(p);
+}
+
+/* ============================================================================ */
+TEST_SUITE(mallinfo2);
+
+TEST(mallinfo2_tracks_segment_blocks) {
+	struct mallinfo2 before = mallinfo2();
+	void *p = malloc(TEST_BIG);
+
+	ASSERT_NOT_NULL(p);
+
+	struct mallinfo2 during = mallinfo2();
+
+	ASSERT_TRUE(during.uordblks >= before.uordblks + TEST_BIG);
+	ASSERT_INT_EQ(during.arena, during.uordblks + during.fordblks + during.fsmblks);
+
+	free(p);
+
+	struct mallinfo2 after = mallinfo2();
+
+	ASSERT_TRUE(after.uordblks < during.uordblks);
+	ASSERT_INT_EQ(after.arena, after.uordblks + after.fordblks + after.fsmblks);
+}
+
+TEST(mallinfo2_counts_huge_blocks) {
+	struct mallinfo2 before = mallinfo2();
+	void *p = malloc(TEST_HUGE);
+
+	ASSERT_NOT_NULL(p);
+
+	struct mallinfo2 during = mallinfo2();
+
+	ASSERT_INT_EQ(before.hblks + 1, during.hblks);
+	ASSERT_TRUE(during.hblkhd >= before.hblkhd + TEST_HUGE);
+
+	free(p);
+
+	ASSERT_INT_EQ(before.hblks, mallinfo2().hblks);
+	ASSERT_INT_EQ(before.hblkhd, mallinfo2().hblkhd);
+}
+
+TEST(mallinfo2_keepcost_is_trimmable) {
+	malloc_trim(0);
+
+	void *p = malloc(TEST_BIG);
+
+	ASSERT_NOT_NULL(p);
+	free(p);
+
+	ASSERT_TRUE(mallinfo2().keepcost > 0);
+
+	malloc_trim(0);
+
+	ASSERT_INT_EQ(0, mallinfo2().keepcost);
+}
+
+/* ============================================================================ */
+TEST_SUITE(malloc_usable_size);
+
+TEST(malloc_usable_size_covers_request) {
+	static const size_t sizes[] = { 1, 24, 100, 1000, 5000, TEST_BIG, TEST_HUGE };
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+		unsigned char *p = malloc(sizes[i]);
+
+		ASSERT_NOT_NULL(p);
+
+		size_t n = malloc_usable_size(p);
+
+		ASSERT_TRUE(n >= sizes[i]);
+
+		memset(p, 0xA5, n);
+		free(p);
+	}
+}
+
+TEST(malloc_usable_size_aligned) {
+	void *p = aligned_alloc(256, 1024);
+
+	ASSERT_NOT_NULL(p);
+	ASSERT_TRUE(malloc_usable_size(p) >= 1024);
+
+	free(p);
+}
+
+TEST(malloc_usable_size_null) {
+	ASSERT_INT_EQ(0, malloc_usable_size(NULL));
+}
+
+/* ============================================================================ */
+TEST_SUITE(malloc_info);
+
+TEST(malloc_info_writes_json) {
+	char buf[2048] = { 0 };
+	FILE *f = tmpfile();
+
+	ASSERT_NOT_NULL(f);
+	ASSERT_INT_EQ(0, malloc_info(0, f));
+
+	rewind(f);
+
+	size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+
+	fclose(f);
+
+	ASSERT_TRUE(n > 0);
+	ASSERT_INT_EQ('{', buf[0]);
+	ASSERT_INT_EQ('\n', buf[n - 1]);
+	ASSERT_NOT_NULL(strstr(buf, "\"heap\":{\"current\":"));
+	ASSERT_NOT_NULL(strstr(buf, "\"fragmentation\":"));
+	ASSERT_NOT_NULL(strstr(buf, "\"counters\":"));
+}
+
+TEST(malloc_info_rejects_options) {
+	errno = 0;
+
+	ASSERT_INT_EQ(-1, malloc_info(1, stderr));
+	ASSERT_INT_EQ(EINVAL, errno);
+}
+
+#if JACL_MALLOC_STATS
+TEST(malloc_info_counts_calls) {
+	size_t before[__JACL_MS_COUNT], after[__JACL_MS_COUNT];
+
+	__jacl_memstat_sum(before);
+
+	for (int i = 0; i < 100; i++) free(malloc(64));
+
+	__jacl_memstat_sum(after);
+
+	ASSERT_TRUE(after[__JACL_MS_MALLOC] >= before[__JACL_MS_MALLOC] + 100);
+	ASSERT_TRUE(after[__JACL_MS_FREE] >= before[__JACL_MS_FREE] + 100);
+}
+#endif
+
+TEST_MAIN()
@@ -73,6 +73,93 @@ static void *__cond_signaler(void *arg) {
 	return NULL;
 }
 
+typedef struct {
+	pthread_mutex_t m;
+	pthread_cond_t c;
+	int go, waiting, woken;
+} __cond_crowd_t;
+
+static void *__cond_crowd_waiter(void *arg) {
+	__cond_crowd_t *crowd = (__cond_crowd_t *)arg;
+
+	pthread_mutex_lock(&crowd->m);
+	crowd->waiting++;
+	while (!crowd->go) pthread_cond_wait(&crowd->c, &crowd->m);
+	crowd->woken++;
+	pthread_mutex_unlock(&crowd->m);
+
+	return NULL;
+}
+
+static void *__exit_late(void *arg) {
+	struct timespec ts = {0, 20000000};
+
+	nanosleep(&ts, NULL);
+	pthread_exit(arg);
+}
+
+static long __ms_since(const struct timespec *t0) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (long)(now.tv_sec - t0->tv_sec) * 1000 + (now.tv_nsec - t0->tv_nsec) / 1000000;
+}
+
+static struct timespec __deadline(clockid_t clock, long ms) {
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (ms % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000) { ts.tv_sec++; ts.tv_nsec -= 1000000000; }
+
+	return ts;
+}
+
+typedef struct {
+	pthread_mutex_t *m;
+	long *counter;
+	int rounds;
+} __mutex_args_t;
+
+static void *__mutex_adder(void *arg) {
+	__mutex_args_t *args = (__mutex_args_t *)arg;
+
+	for (int i = 0; i < args->rounds; i++) {
+		pthread_mutex_lock(args->m);
+		++*args->counter;
+		pthread_mutex_unlock(args->m);
+	}
+
+	return NULL;
+}
+
+static thread_local int __test_tls_val = 7;
+
+static void *__tls_worker(void *arg) {
+	*(int *)arg = __test_tls_val;
+	__test_tls_val = 99;
+	return NULL;
+}
+
+static void *__malloc_worker(void *arg) {
+	void **blocks = (void **)arg;
+	for (int i = 0; i < 64; i++) { blocks[i] = malloc(16 + i * 8); if (blocks[i]) memset(blocks[i], i, 16 + i * 8); }
+	return NULL;
+}
+
+static void *__arena_worker(void *arg) {
+	void *blocks[256];
+	int *hits = (int *)arg;
+	for (int i = 0; i < 256; i++) {
+		blocks[i] = malloc(48);
+		if ((uint8_t *)blocks[i] >= __jacl_static_heap && (uint8_t *)blocks[i] < __jacl_static_heap + JACL_HEAP_INIT / 4) (*hits)++;
+	}
+	for (int i = 0; i < 256; i++) free(blocks[i]);
+	return NULL;
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(constants);
@@ -610,6 +697,40 @@ TEST(pthread_mutex_unlock_null_mutex) {
 	ASSERT_INT_EQ(EINVAL, pthread_mutex_unlock(NULL));
 }
 
+TEST(pthread_mutex_unlock_after_contention) {
+	pthread_mutex_t m;
+	pthread_t t[4];
+	long counter = 0;
+	__mutex_args_t args = { &m, &counter, 20000 };
+
+	pthread_mutex_init(&m, NULL);
+
+	for (int i = 0; i < 4; i++) ASSERT_INT_EQ(0, pthread_create(&t[i], NULL, __mutex_adder, &args));
+	for (int i = 0; i < 4; i++) pthread_join(t[i], NULL);
+
+	/* the queued state never outlives the last unlock */
+	ASSERT_TRUE(counter == 4 * 20000);
+	ASSERT_INT_EQ(0, m.futex);
+	ASSERT_INT_EQ(0, pthread_mutex_destroy(&m));
+}
+
+TEST(pthread_mutex_unlock_shared_mutex) {
+	pthread_mutex_t m;
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_mutex_init(&m, &attr);
+
+	ASSERT_INT_EQ(PTHREAD_PROCESS_SHARED, m.pshared);
+	ASSERT_INT_EQ(0, pthread_mutex_lock(&m));
+	ASSERT_INT_EQ(0, pthread_mutex_unlock(&m));
+	ASSERT_INT_EQ(0, m.futex);
+
+	pthread_mutex_destroy(&m);
+	pthread_mutexattr_destroy(&attr);
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(pthread_mutex_timedlock);
@@ -633,6 +754,20 @@ TEST(pthread_mutex_timedlock_locked_mutex) {
 	pthread_mutex_destroy(&m);
 }
 
+TEST(pthread_mutex_timedlock_waits_for_deadline) {
+	pthread_mutex_t m;
+	struct timespec t0;
+	pthread_mutex_init(&m, NULL);
+	pthread_mutex_lock(&m);
+	struct timespec ts = __deadline(CLOCK_REALTIME, 30);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ASSERT_INT_EQ(ETIMEDOUT, pthread_mutex_timedlock(&m, &ts));
+	ASSERT_TRUE(__ms_since(&t0) >= 25);
+	pthread_mutex_unlock(&m);
+	ASSERT_INT_EQ(0, m.futex);
+	pthread_mutex_destroy(&m);
+}
+
 TEST(pthread_mutex_timedlock_null_mutex) {
 	struct timespec ts = {0, 1000000};
 	ASSERT_INT_EQ(EINVAL, pthread_mutex_timedlock(NULL, &ts));
@@ -799,6 +934,69 @@ TEST(pthread_cond_timedwait_timeout) {
 	pthread_mutex_destroy(&m);
 }
 
+TEST(pthread_cond_timedwait_woken_before_deadline) {
+	pthread_cond_t c;
+	pthread_mutex_t m;
+	pthread_t t;
+	__cond_args_t args = { &m, &c, 0 };
+	struct timespec t0;
+
+	pthread_cond_init(&c, NULL);
+	pthread_mutex_init(&m, NULL);
+	pthread_mutex_lock(&m);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	struct timespec ts = __deadline(CLOCK_REALTIME, 10000);
+
+	ASSERT_INT_EQ(0, pthread_create(&t, NULL, __cond_signaler, &args));
+	ASSERT_INT_EQ(0, pthread_cond_timedwait(&c, &m, &ts));
+	ASSERT_TRUE(__ms_since(&t0) < 5000);
+
+	pthread_mutex_unlock(&m);
+	pthread_join(t, NULL);
+	pthread_cond_destroy(&c);
+	pthread_mutex_destroy(&m);
+}
+
+TEST(pthread_cond_timedwait_monotonic_attr) {
+	pthread_condattr_t a;
+	pthread_cond_t c;
+	pthread_mutex_t m;
+	struct timespec t0;
+
+	pthread_condattr_init(&a);
+	ASSERT_INT_EQ(0, pthread_condattr_setclock(&a, CLOCK_MONOTONIC));
+	pthread_cond_init(&c, &a);
+	pthread_mutex_init(&m, NULL);
+	pthread_mutex_lock(&m);
+
+	/* a monotonic deadline read as realtime would be decades past */
+	struct timespec ts = __deadline(CLOCK_MONOTONIC, 30);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ASSERT_INT_EQ(ETIMEDOUT, pthread_cond_timedwait(&c, &m, &ts));
+	ASSERT_TRUE(__ms_since(&t0) >= 25);
+
+	pthread_mutex_unlock(&m);
+	pthread_cond_destroy(&c);
+	pthread_mutex_destroy(&m);
+}
+
+TEST(pthread_cond_clockwait_rejects_clock) {
+	pthread_cond_t c;
+	pthread_mutex_t m;
+	struct timespec ts = {0, 0};
+
+	pthread_cond_init(&c, NULL);
+	pthread_mutex_init(&m, NULL);
+	pthread_mutex_lock(&m);
+	ASSERT_INT_EQ(EINVAL, pthread_cond_clockwait(&c, &m, CLOCK_PROCESS_CPUTIME_ID, &ts));
+	ASSERT_INT_EQ(ETIMEDOUT, pthread_cond_clockwait(&c, &m, CLOCK_MONOTONIC, &ts));
+	pthread_mutex_unlock(&m);
+	pthread_cond_destroy(&c);
+	pthread_mutex_destroy(&m);
+}
+
 TEST(pthread_cond_timedwait_null_cond) {
 	pthread_mutex_t m;
 	pthread_mutex_init(&m, NULL);
@@ -851,6 +1049,34 @@ TEST(pthread_cond_broadcast_valid_cond) {
 	pthread_cond_destroy(&c);
 }
 
+TEST(pthread_cond_broadcast_wakes_every_waiter) {
+	static __cond_crowd_t crowd;
+	pthread_t t[6];
+
+	pthread_mutex_init(&crowd.m, NULL);
+	pthread_cond_init(&crowd.c, NULL);
+
+	for (int i = 0; i < 6; i++) ASSERT_INT_EQ(0, pthread_create(&t[i], NULL, __cond_crowd_waiter, &crowd));
+
+	for (;;) {
+		pthread_mutex_lock(&crowd.m);
+		if (crowd.waiting == 6) break;
+		pthread_mutex_unlock(&crowd.m);
+		sched_yield();
+	}
+
+	/* broadcast under the mutex: the crowd is handed on one unlock at a time */
+	crowd.go = 1;
+	ASSERT_INT_EQ(0, pthread_cond_broadcast(&crowd.c));
+	pthread_mutex_unlock(&crowd.m);
+
+	for (int i = 0; i < 6; i++) pthread_join(t[i], NULL);
+
+	ASSERT_INT_EQ(6, crowd.woken);
+	ASSERT_INT_EQ(0, crowd.m.futex);
+	ASSERT_INT_EQ(0, crowd.c.waiters);
+}
+
 TEST(pthread_cond_broadcast_null_cond) {
 	ASSERT_INT_EQ(EINVAL, pthread_cond_broadcast(NULL));
 }
@@ -1173,6 +1399,38 @@ TEST(pthread_rwlock_unlock_null_rwlock) {
 
 /* ============================================================================ */
 
+TEST_SUITE(pthread_rwlock_timedwrlock);
+
+TEST(pthread_rwlock_timedwrlock_read_held) {
+	pthread_rwlock_t rw;
+	struct timespec t0;
+	pthread_rwlock_init(&rw, NULL);
+	pthread_rwlock_rdlock(&rw);
+	struct timespec ts = __deadline(CLOCK_REALTIME, 30);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ASSERT_INT_EQ(ETIMEDOUT, pthread_rwlock_timedwrlock(&rw, &ts));
+	ASSERT_TRUE(__ms_since(&t0) >= 25);
+	ASSERT_INT_EQ(0, rw.write_waiters);
+	pthread_rwlock_unlock(&rw);
+	ASSERT_INT_EQ(0, pthread_rwlock_timedwrlock(&rw, &ts));
+	pthread_rwlock_unlock(&rw);
+	pthread_rwlock_destroy(&rw);
+}
+
+TEST(pthread_rwlock_timedrdlock_write_held) {
+	pthread_rwlock_t rw;
+	pthread_rwlock_init(&rw, NULL);
+	pthread_rwlock_wrlock(&rw);
+	struct timespec ts = __deadline(CLOCK_REALTIME, 20);
+	ASSERT_INT_EQ(ETIMEDOUT, pthread_rwlock_timedrdlock(&rw, &ts));
+	ts.tv_nsec = 1000000000;
+	ASSERT_INT_EQ(EINVAL, pthread_rwlock_timedrdlock(&rw, &ts));
+	pthread_rwlock_unlock(&rw);
+	pthread_rwlock_destroy(&rw);
+}
+
+/* ============================================================================ */
+
 TEST_SUITE(pthread_barrier_init);
 
 TEST(pthread_barrier_init_count_two) {
@@ -1371,6 +1629,91 @@ TEST(pthread_create_null_routine) {
 	ASSERT_INT_EQ(EINVAL, pthread_create(&t, NULL, NULL, NULL));
 }
 
+TEST(pthread_create_own_tls) {
+	pthread_t t;
+	int seen = 0;
+	__test_tls_val = 5;
+	ASSERT_INT_EQ(0, pthread_create(&t, NULL, __tls_worker, &seen));
+	pthread_join(t, NULL);
+	ASSERT_INT_EQ(7, seen);
+	ASSERT_INT_EQ(5, __test_tls_val);
+}
+
+TEST(pthread_create_arena_returned) {
+	int hits[16] = {0};
+	for (int i = 0; i < 16; i++) {
+		pthread_t t;
+		ASSERT_INT_EQ(0, pthread_create(&t, NULL, __arena_worker, &hits[i]));
+		pthread_join(t, NULL);
+	}
+	ASSERT_INT_GT(hits[0], 0);
+	ASSERT_INT_EQ(hits[0], hits[15]);
+}
+
+#if JACL_OS_LINUX
+TEST(pthread_create_reuses_joined_stack) {
+	pthread_t a, b;
+	int val = 0;
+	ASSERT_INT_EQ(0, pthread_create(&a, NULL, __test_thread_fn_42, &val));
+	pthread_join(a, NULL);
+	ASSERT_INT_EQ(0, pthread_create(&b, NULL, __test_thread_fn_99, &val));
+	pthread_join(b, NULL);
+	/* same size, so the second thread gets the first one's mapping back */
+	ASSERT_PTR_EQ(a, b);
+	ASSERT_INT_EQ(99, val);
+}
+
+TEST(pthread_create_reclaims_detached_stack) {
+	pthread_attr_t attr;
+	pthread_t a, b;
+	int val = 0;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 192 * 1024);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ASSERT_INT_EQ(0, pthread_create(&a, &attr, __test_thread_fn_42, &val));
+	/* it sits on the dead list, still mapped, until the kernel clears ctid */
+	while (atomic_load(&a->ctid)) sched_yield();
+	ASSERT_INT_EQ(0, pthread_create(&b, &attr, __test_thread_fn_99, &val));
+	ASSERT_PTR_EQ(a, b);
+	while (atomic_load(&b->ctid)) sched_yield();
+	ASSERT_INT_EQ(99, val);
+	pthread_attr_destroy(&attr);
+}
+
+TEST(pthread_join_detached_keeps_reclaim) {
+	pthread_attr_t attr;
+	pthread_t a, b;
+	int val = 0;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 208 * 1024);
+	ASSERT_INT_EQ(0, pthread_create(&a, &attr, __detach_worker, NULL));
+	ASSERT_INT_EQ(0, pthread_detach(a));
+	ASSERT_INT_EQ(EINVAL, pthread_join(a, NULL));
+	/* the failed join mustn't keep its exit from burying the stack */
+	while (atomic_load(&a->ctid)) sched_yield();
+	ASSERT_INT_EQ(0, pthread_create(&b, &attr, __test_thread_fn_42, &val));
+	ASSERT_PTR_EQ(a, b);
+	ASSERT_INT_EQ(0, pthread_join(b, NULL));
+	ASSERT_INT_EQ(42, val);
+	pthread_attr_destroy(&attr);
+}
+#endif
+
+TEST(pthread_create_free_foreign_blocks) {
+	pthread_t t;
+	void *blocks[64] = {0};
+	ASSERT_INT_EQ(0, pthread_create(&t, NULL, __malloc_worker, blocks));
+	pthread_join(t, NULL);
+	for (int i = 0; i < 64; i++) {
+		ASSERT_NOT_NULL(blocks[i]);
+		ASSERT_INT_EQ(i, ((unsigned char *)blocks[i])[15 + i * 8]);
+		free(blocks[i]);
+	}
+	void *again = malloc(24);
+	ASSERT_NOT_NULL(again);
+	free(again);
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(pthread_join);
@@ -1383,6 +1726,16 @@ TEST(pthread_join_joinable_thread) {
 	ASSERT_INT_EQ(99, val);
 }
 
+TEST(pthread_join_waits_for_exit) {
+	pthread_t t;
+	void *res = NULL;
+	int val = 0;
+
+	ASSERT_INT_EQ(0, pthread_create(&t, NULL, __exit_late, &val));
+	ASSERT_INT_EQ(0, pthread_join(t, &res));
+	ASSERT_PTR_EQ(&val, res);
+}
+
 TEST(pthread_join_null_thread) {
 	ASSERT_INT_EQ(EINVAL, pthread_join(NULL, NULL));
 }
@@ -1393,6 +1746,53 @@ TEST(pthread_join_detached_thread) {
 	pthread_detach(t);
 	/* Joining a detached thread should fail with EINVAL */
 	ASSERT_INT_EQ(EINVAL, pthread_join(t, NULL));
+#if JACL_OS_LINUX
+	/* let it finish here rather than in the middle of a later test */
+	while (atomic_load(&t->ctid)) sched_yield();
+#endif
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(pthread_prewarm_np);
+
+TEST(pthread_prewarm_np_fills_cache) {
+	pthread_attr_t attr;
+	pthread_t t;
+	int val = 0;
+	/* the next create moves stacks of finished detached threads into the cache, so get that done first */
+	ASSERT_INT_EQ(0, pthread_create(&t, NULL, __test_thread_fn_42, &val));
+	pthread_join(t, NULL);
+	unsigned before = __jacl_pthread_stack_cached;
+	unsigned want = before + 2 < JACL_STACK_CACHE ? before + 2 : JACL_STACK_CACHE;
+	ASSERT_INT_EQ(0, pthread_prewarm_np(2, 320 * 1024));
+	ASSERT_INT_EQ(want, __jacl_pthread_stack_cached);
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 320 * 1024);
+	ASSERT_INT_EQ(0, pthread_create(&t, &attr, __test_thread_fn_42, &val));
+	ASSERT_INT_EQ(want - 1, __jacl_pthread_stack_cached);
+	pthread_join(t, NULL);
+	ASSERT_INT_EQ(42, val);
+	pthread_attr_destroy(&attr);
+}
+
+TEST(pthread_prewarm_np_guard_page) {
+	ASSERT_INT_EQ(0, pthread_prewarm_np(1, 0));
+	ASSERT_NOT_NULL(__jacl_pthread_stack_cache);
+	char *bottom = (char *)__jacl_pthread_stack_cache->stack;
+	pid_t pid = fork();
+	if (pid == 0) { *(volatile char *)bottom = 1; _exit(0); }
+	int status = 0;
+	ASSERT_INT_EQ(pid, waitpid(pid, &status, 0));
+	ASSERT_TRUE(WIFSIGNALED(status));
+	ASSERT_INT_EQ(SIGSEGV, WTERMSIG(status));
+	/* the page above it is stack */
+	bottom[PAGESIZE] = 1;
+}
+
+TEST(pthread_prewarm_np_stops_when_full) {
+	ASSERT_INT_EQ(0, pthread_prewarm_np(JACL_STACK_CACHE + 4, 0));
+	ASSERT_INT_EQ(JACL_STACK_CACHE, __jacl_pthread_stack_cached);
 }
 
 /* ============================================================================ */
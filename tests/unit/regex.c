@@ -1813,6 +1813,470 @@ TEST(unicode_case_fold_turkish) {
 
 /* ============================================================================ */
 
+TEST_SUITE(linear)
+
+TEST(linear_star_gives_back) {
+	regex_t re;
+	regmatch_t pm[1];
+	ASSERT_REG_BUILD(&re, "a*ab", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, "xaab", 1, pm, 0);
+	ASSERT_EQ(1, pm[0].rm_so);
+	ASSERT_EQ(4, pm[0].rm_eo);
+	regfree(&re);
+}
+
+TEST(linear_dot_star_gives_back) {
+	regex_t re;
+	ASSERT_REG_BUILD(&re, ".*b", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, "aaab", 1, NULL, 0);
+	regfree(&re);
+}
+
+TEST(linear_alternation_retried) {
+	regex_t re;
+	regmatch_t pm[2];
+	ASSERT_REG_BUILD(&re, "(a|ab)c", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, "abc", 2, pm, 0);
+	ASSERT_EQ(0, pm[0].rm_so);
+	ASSERT_EQ(3, pm[0].rm_eo);
+	ASSERT_EQ(0, pm[1].rm_so);
+	ASSERT_EQ(2, pm[1].rm_eo);
+	regfree(&re);
+}
+
+TEST(linear_lazy_shortest) {
+	regex_t re;
+	regmatch_t pm[1];
+	ASSERT_REG_BUILD(&re, "<.+?>", REG_PCRE2);
+	ASSERT_REG_MATCH(&re, "<a><b>", 1, pm, 0);
+	ASSERT_EQ(0, pm[0].rm_so);
+	ASSERT_EQ(3, pm[0].rm_eo);
+	regfree(&re);
+}
+
+TEST(linear_counted_repeat) {
+	regex_t re;
+	regmatch_t pm[1];
+	ASSERT_REG_BUILD(&re, "a{2,3}", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, "aaaa", 1, pm, 0);
+	ASSERT_EQ(0, pm[0].rm_so);
+	ASSERT_EQ(3, pm[0].rm_eo);
+	ASSERT_REG_FAILS(&re, "a", 1, NULL, 0);
+	regfree(&re);
+}
+
+TEST(linear_nested_alternation_no_blowup) {
+	regex_t re;
+	regmatch_t pm[2];
+	char s[80];
+	memset(s, 'a', 64);
+	s[64] = 'c'; s[65] = '\0';
+	ASSERT_REG_BUILD(&re, "(a|aa)*b", REG_EXTENDED);
+	ASSERT_REG_FAILS(&re, s, 2, pm, 0);
+	s[64] = 'b';
+	ASSERT_REG_MATCH(&re, s, 2, pm, 0);
+	ASSERT_EQ(0, pm[0].rm_so);
+	ASSERT_EQ(65, pm[0].rm_eo);
+	ASSERT_EQ(63, pm[1].rm_so);
+	ASSERT_EQ(64, pm[1].rm_eo);
+	regfree(&re);
+}
+
+TEST(linear_long_subject) {
+	regex_t re;
+	regmatch_t pm[1];
+	size_t n = 100000;
+	char *s = malloc(n + 2);
+	ASSERT_NOT_NULL(s);
+	for (size_t i = 0; i < n; i++) s[i] = "ab"[i & 1];
+	s[n] = 'c'; s[n + 1] = '\0';
+	ASSERT_REG_BUILD(&re, "(a|b)*c", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, s, 1, pm, 0);
+	ASSERT_EQ(0, pm[0].rm_so);
+	ASSERT_EQ((regoff_t)n + 1, pm[0].rm_eo);
+	regfree(&re);
+	free(s);
+}
+
+TEST(linear_many_nodes_keep_groups) {
+	regex_t re;
+	regmatch_t pm[4];
+	ASSERT_REG_BUILD(&re, "(b([ab][^a].))[^a]|(a.{2,}?)", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, "cbbacacca", 4, pm, 0);
+	ASSERT_EQ(2, pm[0].rm_so);
+	ASSERT_EQ(7, pm[0].rm_eo);
+	ASSERT_EQ(3, pm[2].rm_so);
+	ASSERT_EQ(6, pm[2].rm_eo);
+	ASSERT_EQ(-1, pm[3].rm_so);
+	regfree(&re);
+}
+
+TEST(linear_engine_selected) {
+	regex_t re;
+	ASSERT_REG_BUILD(&re, "^(ab|cd)+[0-9]?$", REG_EXTENDED);
+	ASSERT_NOT_NULL(re.prog);
+	regfree(&re);
+	ASSERT_REG_BUILD(&re, "(a)\\1", REG_PCRE2);
+	ASSERT_NULL(re.prog);
+	ASSERT_REG_MATCH(&re, "xaa", 1, NULL, 0);
+	regfree(&re);
+	ASSERT_REG_BUILD(&re, "a(?=b)", REG_PCRE2);
+	ASSERT_NULL(re.prog);
+	regfree(&re);
+}
+
+TEST(linear_bitstate_agrees_with_vm) {
+	static const char *pats[] = { "(a|b)*c(d)?", "([a-z]+)@([a-z]+)\\.com", "(x*)(x|y)+?z", "\\b(\\w+) (\\w+)$", "((ab|a)(c|bcd))(d*)" };
+	static const char *subjects[] = { "ababcd", "mail foo@bar.com now", "xxxyyz", "one two", "abcd" };
+	size_t pad = MATCH_MAX_BITS;
+	char *big = malloc(pad + 64);
+	ASSERT_NOT_NULL(big);
+	memset(big, '-', pad);
+	for (int i = 0; i < 5; i++) {
+		regex_t re;
+		regmatch_t a[4], b[4];
+		ASSERT_REG_BUILD(&re, pats[i], REG_EXTENDED);
+		ASSERT_NOT_NULL(re.prog);
+		strcpy(big + pad, subjects[i]);
+		ASSERT_REG_MATCH(&re, subjects[i], 4, a, 0);
+		ASSERT_REG_MATCH(&re, big, 4, b, 0);
+		for (int k = 0; k < 4; k++) {
+			ASSERT_EQ(a[k].rm_so < 0 ? -1 : a[k].rm_so + (regoff_t)pad, b[k].rm_so);
+			ASSERT_EQ(a[k].rm_eo < 0 ? -1 : a[k].rm_eo + (regoff_t)pad, b[k].rm_eo);
+		}
+		ASSERT_REG_MATCH(&re, subjects[i], 0, NULL, 0);
+		ASSERT_REG_MATCH(&re, big, 0, NULL, 0);
+		regfree(&re);
+	}
+	free(big);
+}
+
+TEST(linear_empty_iteration_leaves_loop) {
+	static const struct { const char *pat, *subj; regoff_t so, eo; } rows[] = {
+		{ "(a*?)*.", "a ab ", 0, 1 },
+		{ "c|bb(.??)*|$", " bbab b", 1, 3 },
+		{ "(((a{2,}|b)??.??(a[^a]??){0,2})*)", "cbc", 0, 0 },
+		{ "(c?|ab)+", "cabbc", 0, 1 },
+		{ "(a?)*b", "aab", 0, 3 },
+	};
+	size_t pad = MATCH_MAX_BITS;
+	char *big = malloc(pad + 64);
+	ASSERT_NOT_NULL(big);
+	for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+		regex_t re;
+		regmatch_t pm[1];
+		ASSERT_REG_BUILD(&re, rows[i].pat, REG_PCRE2);
+		ASSERT_REG_MATCH(&re, rows[i].subj, 1, pm, 0);
+		ASSERT_EQ(rows[i].so, pm[0].rm_so);
+		ASSERT_EQ(rows[i].eo, pm[0].rm_eo);
+		// trailing padding moves none of these matches but keeps the subject on the Pike VM
+		strcpy(big, rows[i].subj);
+		memset(big + strlen(big), '-', pad);
+		big[strlen(rows[i].subj) + pad] = '\0';
+		ASSERT_REG_MATCH(&re, big, 1, pm, 0);
+		ASSERT_EQ(rows[i].so, pm[0].rm_so);
+		ASSERT_EQ(rows[i].eo, pm[0].rm_eo);
+		// and the backtracker agrees
+		match_inst_t *prog = re.prog;
+		re.prog = NULL;
+		ASSERT_REG_MATCH(&re, rows[i].subj, 1, pm, 0);
+		re.prog = prog;
+		ASSERT_EQ(rows[i].so, pm[0].rm_so);
+		ASSERT_EQ(rows[i].eo, pm[0].rm_eo);
+		regfree(&re);
+	}
+	free(big);
+}
+
+TEST(linear_boolean_keeps_backreferences) {
+	regex_t re;
+	ASSERT_REG_BUILD(&re, "([a-c]+)-\\1", REG_PCRE2);
+	ASSERT_NULL(re.prog);
+	ASSERT_REG_MATCH(&re, "x abc-abc", 0, NULL, 0);
+	ASSERT_REG_FAILS(&re, "x abc-abd", 0, NULL, 0);
+	regfree(&re);
+}
+
+TEST(linear_nosub_leaves_pmatch) {
+	regex_t re;
+	regmatch_t pm[2] = { { 7, 7 }, { 7, 7 } };
+	ASSERT_REG_BUILD(&re, "(b)c", REG_EXTENDED | REG_NOSUB);
+	ASSERT_REG_MATCH(&re, "abc", 2, pm, 0);
+	ASSERT_EQ(7, pm[0].rm_so);
+	ASSERT_EQ(7, pm[1].rm_eo);
+	regfree(&re);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(prefilter)
+
+TEST(prefilter_alternation_set) {
+	regex_t re;
+	regmatch_t pm[2];
+	ASSERT_REG_BUILD(&re, "(GET|PUT|POST) /", REG_EXTENDED);
+	ASSERT_EQ(3, re.pre.n);
+	ASSERT_REG_MATCH(&re, "GETS PUTS POST /x", 2, pm, 0);
+	ASSERT_EQ(10, pm[0].rm_so);
+	ASSERT_EQ(10, pm[1].rm_so);
+	ASSERT_EQ(14, pm[1].rm_eo);
+	ASSERT_REG_FAILS(&re, "GET PUT POST", 0, NULL, 0);
+	regfree(&re);
+}
+
+TEST(prefilter_required_inner_literal) {
+	regex_t re;
+	regmatch_t pm[1];
+	ASSERT_REG_BUILD(&re, "[0-9]+ ERROR", REG_EXTENDED);
+	ASSERT_EQ(0, re.pre.n);
+	ASSERT_EQ(1, re.req.n);
+	ASSERT_EQ(6, re.req.len[0]);
+	ASSERT_REG_MATCH(&re, "12 INFO\n345 ERROR", 1, pm, 0);
+	ASSERT_EQ(8, pm[0].rm_so);
+	ASSERT_REG_FAILS(&re, "12 INFO\nERROR 345", 0, NULL, 0);
+	regfree(&re);
+}
+
+TEST(prefilter_required_skips_lines) {
+	regex_t re;
+	regmatch_t pm[1];
+	char buf[4096];
+	size_t n = 0;
+	while (n < sizeof(buf) - 64) { memcpy(buf + n, "key value\n", 10); n += 10; }
+	strcpy(buf + n, "  key value timeout\n");
+	ASSERT_REG_BUILD(&re, "key.*timeout", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, buf, 1, pm, 0);
+	ASSERT_EQ((regoff_t)n + 2, pm[0].rm_so);
+	regfree(&re);
+	ASSERT_REG_BUILD(&re, "ab(.|\n)*cd", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, "xab\n\n\ncd", 1, pm, 0);
+	ASSERT_EQ(1, pm[0].rm_so);
+	regfree(&re);
+}
+
+TEST(prefilter_icase) {
+	regex_t re;
+	ASSERT_REG_BUILD(&re, "hello (world|there)", REG_EXTENDED | REG_ICASE);
+	ASSERT_REG_MATCH(&re, "say HeLLo THERE", 0, NULL, 0);
+	ASSERT_REG_FAILS(&re, "say HeLLo you", 0, NULL, 0);
+	regfree(&re);
+	ASSERT_REG_BUILD(&re, "(?i)abc(?-i)DEF", REG_PCRE2);
+	ASSERT_REG_MATCH(&re, "xxABCDEF", 0, NULL, 0);
+	ASSERT_REG_FAILS(&re, "xxABCdef", 0, NULL, 0);
+	regfree(&re);
+}
+
+TEST(prefilter_many_candidates) {
+	regex_t re;
+	regmatch_t pm[1];
+	char buf[1024];
+	for (size_t i = 0; i < sizeof(buf) - 1; i++) buf[i] = "fobaz"[i % 5];
+	buf[sizeof(buf) - 1] = '\0';
+	memcpy(buf + 700, "bazooka", 7);
+	ASSERT_REG_BUILD(&re, "(foo|bar|bazoo)ka", REG_EXTENDED);
+	ASSERT_REG_MATCH(&re, buf, 1, pm, 0);
+	ASSERT_EQ(700, pm[0].rm_so);
+	regfree(&re);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(set)
+
+TEST(set_reports_every_match) {
+	static const char *pats[] = { "GET", "POST", "^GET /", "error$", "\\berr\\b", "5[0-9]{2}", "HTTP$" };
+	static const char line[] = "GET /admin HTTP 500 error";
+	re2_set_t *set = re2setnew();
+	uint32_t ids[8];
+	ASSERT_NOT_NULL(set);
+	for (int i = 0; i < 7; i++) ASSERT_EQ(i, re2setadd(set, pats[i]));
+	ASSERT_TRUE(re2setcomp(set));
+	ASSERT_EQ(4, re2setmatch(set, line, strlen(line), ids, 8));
+	ASSERT_EQ(0, ids[0]);
+	ASSERT_EQ(2, ids[1]);
+	ASSERT_EQ(3, ids[2]);
+	ASSERT_EQ(5, ids[3]);
+	ASSERT_EQ(0, re2setmatch(set, "PUT /x", 6, ids, 8));
+	ASSERT_EQ(1, re2setmatch(set, "POST /x", 7, ids, 8));
+	ASSERT_EQ(1, ids[0]);
+	re2setfree(set);
+}
+
+TEST(set_rejects_bad_pattern) {
+	re2_set_t *set = re2setnew();
+	uint32_t ids[2];
+	ASSERT_EQ(0, re2setadd(set, "ok"));
+	ASSERT_EQ(-1, re2setadd(set, "(unclosed"));
+	ASSERT_EQ(1, re2setadd(set, "fine"));
+	ASSERT_TRUE(re2setcomp(set));
+	ASSERT_EQ(1, re2setmatch(set, "fine", 4, ids, 2));
+	ASSERT_EQ(1, ids[0]);
+	re2setfree(set);
+}
+
+TEST(set_member_flags) {
+	matchset_t set = { 0 };
+	uint32_t ids[4];
+	size_t n = 4;
+	static const char text[] = "one\nTWO three";
+	ASSERT_EQ(M_SUCCESS, matchsetadd(&set, "two", MCOMP_EXTENDED, MEXEC_ICASE));
+	ASSERT_EQ(M_SUCCESS, matchsetadd(&set, "^TWO", MCOMP_EXTENDED, MEXEC_NEWLINE));
+	ASSERT_EQ(M_SUCCESS, matchsetadd(&set, "^TWO", MCOMP_EXTENDED, 0));
+	ASSERT_EQ(M_SUCCESS, matchsetadd(&set, "(e)\\1", MCOMP_PCRE2, 0));
+	ASSERT_EQ(M_SUCCESS, matchsetexec(&set, text, text + strlen(text), ids, &n, 0));
+	ASSERT_EQ(3, n);
+	ASSERT_EQ(0, ids[0]);
+	ASSERT_EQ(1, ids[1]);
+	ASSERT_EQ(3, ids[2]);
+	n = 1;
+	ASSERT_EQ(M_SUCCESS, matchsetexec(&set, text, text + strlen(text), ids, &n, 0));
+	ASSERT_EQ(3, n);
+	ASSERT_EQ(0, ids[0]);
+	matchsetfree(&set);
+}
+
+TEST(set_agrees_with_matchexec) {
+	matchset_t set = { 0 };
+	matcher_t one[40];
+	char pat[32], text[256];
+	uint32_t ids[40];
+	for (int i = 0; i < 40; i++) {
+		snprintf(pat, sizeof(pat), "%c[a-z]*%d|\\b%d%c", 'a' + i % 26, i % 10, i, 'a' + (i * 7) % 26);
+		ASSERT_EQ(M_SUCCESS, matchsetadd(&set, pat, MCOMP_EXTENDED, 0));
+		ASSERT_EQ(M_SUCCESS, matchcomp(&one[i], pat, MCOMP_EXTENDED));
+	}
+	for (int round = 0; round < 50; round++) {
+		size_t len = 0, n = 40;
+		unsigned seed = (unsigned)round * 2654435761u;
+		while (len < sizeof(text) - 1) { seed = seed * 1103515245u + 12345u; text[len++] = " abcxyz0123456789\n"[(seed >> 16) % 18]; }
+		text[len] = '\0';
+		matchsetexec(&set, text, text + len, ids, &n, 0);
+		size_t k = 0;
+		for (uint32_t i = 0; i < 40; i++) {
+			int want = matchexec(&one[i], text, text + len, NULL, 0, 0) == M_SUCCESS;
+			int got = k < n && ids[k] == i;
+			if (got) k++;
+			ASSERT_EQ(want, got);
+		}
+		ASSERT_EQ(n, k);
+	}
+	for (int i = 0; i < 40; i++) matchfree(&one[i]);
+	matchsetfree(&set);
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(stream)
+
+TEST(stream_match_split_across_chunks) {
+	static const char text[] = "xx needle 42 and needle 7";
+	matcher_t m;
+	matchstream_t ms;
+	match_find_t pm[2];
+	matchoff_t found[4][2];
+	int n = 0;
+	ASSERT_EQ(M_SUCCESS, matchcomp(&m, "needle ([0-9]+)", MCOMP_EXTENDED));
+	ASSERT_EQ(M_SUCCESS, matchstreaminit(&ms, &m, 2, 0));
+	for (size_t i = 0; i < sizeof(text) - 1; i++) {
+		size_t used;
+		while (matchstreamfeed(&ms, text + i, 1, &used, pm, 2) == M_SUCCESS && n < 4) { found[n][0] = pm[1].rm_so; found[n++][1] = pm[1].rm_eo; if (used) break; }
+	}
+	while (matchstreamend(&ms, pm, 2) == M_SUCCESS && n < 4) { found[n][0] = pm[1].rm_so; found[n++][1] = pm[1].rm_eo; }
+	ASSERT_EQ(2, n);
+	ASSERT_EQ(10, found[0][0]);
+	ASSERT_EQ(12, found[0][1]);
+	ASSERT_EQ(24, found[1][0]);
+	ASSERT_EQ(25, found[1][1]);
+	matchstreamfree(&ms);
+	matchfree(&m);
+}
+
+TEST(stream_anchors_at_chunk_edges) {
+	static const char *chunks[] = { "ab\n", "x", "\nxy", "\nx" };
+	matcher_t m;
+	matchstream_t ms;
+	match_find_t pm[1];
+	matchoff_t so[4];
+	int n = 0;
+	ASSERT_EQ(M_SUCCESS, matchcomp(&m, "^x$", MCOMP_EXTENDED));
+	ASSERT_EQ(M_SUCCESS, matchstreaminit(&ms, &m, 1, MEXEC_NEWLINE));
+	for (int c = 0; c < 4; c++) {
+		const char *p = chunks[c], *end = p + strlen(p);
+		size_t used;
+		while (p < end && matchstreamfeed(&ms, p, (size_t)(end - p), &used, pm, 1) == M_SUCCESS) { so[n++] = pm[0].rm_so; p += used; }
+	}
+	// the last x is only a whole line once the stream ends
+	ASSERT_EQ(1, n);
+	ASSERT_EQ(M_SUCCESS, matchstreamend(&ms, pm, 1));
+	so[n++] = pm[0].rm_so;
+	ASSERT_EQ(M_NOMATCH, matchstreamend(&ms, pm, 1));
+	ASSERT_EQ(3, so[0]);
+	ASSERT_EQ(8, so[1]);
+	matchstreamfree(&ms);
+	matchfree(&m);
+}
+
+TEST(stream_utf8_cut_by_chunk) {
+	static const char text[] = "a\xC3\xA9\xC3\xA9 \xC3\xA9";
+	matcher_t m;
+	matchstream_t ms;
+	match_find_t pm[2];
+	size_t used;
+	ASSERT_EQ(M_SUCCESS, matchcomp(&m, "(\xC3\xA9+) \xC3\xA9", MCOMP_EXTENDED));
+	ASSERT_EQ(M_SUCCESS, matchstreaminit(&ms, &m, 2, 0));
+	ASSERT_EQ(M_NOMATCH, matchstreamfeed(&ms, text, 2, &used, pm, 2));
+	ASSERT_EQ(2, used);
+	ASSERT_EQ(M_NOMATCH, matchstreamfeed(&ms, text + 2, 5, &used, pm, 2));
+	ASSERT_EQ(M_NOMATCH, matchstreamfeed(&ms, text + 7, 1, &used, pm, 2));
+	ASSERT_EQ(M_SUCCESS, matchstreamend(&ms, pm, 2));
+	ASSERT_EQ(1, pm[0].rm_so);
+	ASSERT_EQ(8, pm[0].rm_eo);
+	ASSERT_EQ(1, pm[1].rm_so);
+	ASSERT_EQ(5, pm[1].rm_eo);
+	ASSERT_EQ(M_NOMATCH, matchstreamend(&ms, pm, 2));
+	matchstreamfree(&ms);
+	matchfree(&m);
+}
+
+TEST(stream_reads_file) {
+	FILE *f = tmpfile();
+	matcher_t m;
+	matchstream_t ms;
+	match_find_t pm[1];
+	char buf[7], *text = malloc(64 * 40 + 1);
+	size_t len = 0, got = 0, want = 0, n;
+	ASSERT_NOT_NULL(f);
+	ASSERT_NOT_NULL(text);
+	for (int i = 0; i < 64; i++) len += (size_t)snprintf(text + len, 41, "%03d GET /item code=%d%s\n", i, 200 + i % 3 * 100, i % 5 ? "" : " slow");
+	fwrite(text, 1, len, f);
+	rewind(f);
+	ASSERT_EQ(M_SUCCESS, matchcomp(&m, "code=[45]0+( slow)?$", MCOMP_EXTENDED));
+	for (const char *p = text; matchexec(&m, p, text + len, pm, 1, MEXEC_NEWLINE) == M_SUCCESS; p += pm[0].rm_eo) want++;
+	ASSERT_EQ(M_SUCCESS, matchstreaminit(&ms, &m, 1, MEXEC_NEWLINE));
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		size_t off = 0, used;
+		while (off < n && matchstreamfeed(&ms, buf + off, n - off, &used, pm, 1) == M_SUCCESS) { ASSERT_EQ(0, memcmp(text + pm[0].rm_so, "code=", 5)); got++; off += used; }
+	}
+	while (matchstreamend(&ms, pm, 1) == M_SUCCESS) got++;
+	ASSERT_EQ(21, want);
+	ASSERT_EQ(want, got);
+	matchstreamfree(&ms);
+	matchfree(&m);
+	free(text);
+	fclose(f);
+}
+
+TEST(stream_rejects_backtrack_only) {
+	matcher_t m;
+	matchstream_t ms;
+	ASSERT_EQ(M_SUCCESS, matchcomp(&m, "(a)\\1", MCOMP_PCRE2));
+	ASSERT_EQ(M_BADPAT, matchstreaminit(&ms, &m, 1, 0));
+	matchstreamfree(&ms);
+	matchfree(&m);
+}
+
+/* ============================================================================ */
+
 TEST_SUITE(errors)
 
 TEST(errors_compile_invalid) {
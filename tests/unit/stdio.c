@@ -691,6 +691,149 @@ TEST(printf_g_negative_nan)
 
 /* ============================================================= */
 
+TEST_SUITE(printf_exact);
+
+TEST(printf_exact_fixed_digits) {
+	char buf[512] = {0};
+
+	snprintf(buf, sizeof(buf), "%.20f", 0.1);
+	ASSERT_STR_EQ("0.10000000000000000555", buf);
+	snprintf(buf, sizeof(buf), "%.0f", 1e23);
+	ASSERT_STR_EQ("99999999999999991611392", buf);
+	snprintf(buf, sizeof(buf), "%.3e", 4.9406564584124654e-324);
+	ASSERT_STR_EQ("4.941e-324", buf);
+	snprintf(buf, sizeof(buf), "%.17g", 0.1);
+	ASSERT_STR_EQ("0.10000000000000001", buf);
+	snprintf(buf, sizeof(buf), "%.30e", 1.0 / 3);
+	ASSERT_STR_EQ("3.333333333333333148296162562474e-01", buf);
+}
+
+TEST(printf_exact_half_even) {
+	char buf[64] = {0};
+
+	snprintf(buf, sizeof(buf), "%.0f %.0f %.0f %.0f", 0.5, 1.5, 2.5, 3.5);
+	ASSERT_STR_EQ("0 2 2 4", buf);
+	snprintf(buf, sizeof(buf), "%.1f %.2f", 0.25, 1.005);
+	ASSERT_STR_EQ("0.2 1.00", buf);
+}
+
+TEST(printf_exact_g_trailing_zeros) {
+	char buf[64] = {0};
+
+	snprintf(buf, sizeof(buf), "%g %g %g", 100000.0, 1e6, 0.0001);
+	ASSERT_STR_EQ("100000 1e+06 0.0001", buf);
+	snprintf(buf, sizeof(buf), "%#g %#.3g", 1.0, 0.5);
+	ASSERT_STR_EQ("1.00000 0.500", buf);
+}
+
+/* ============================================================= */
+
+TEST_SUITE(printf_r);
+
+TEST(printf_r_shortest) {
+	static const struct { double v; const char *want; } cases[] = {
+		{ 0.1, "0.1" }, { 0.3, "0.3" }, { 1.0 / 3, "0.3333333333333333" }, { 100.0, "100" },
+		{ 1e16, "1e+16" }, { 1e23, "1e+23" }, { 123456789012345680.0, "1.2345678901234568e+17" },
+		{ 0.0001, "0.0001" }, { 0.00001, "1e-05" }, { -0.0, "-0" }, { 5e-324, "5e-324" },
+		{ 1.7976931348623157e308, "1.7976931348623157e+308" }, { 2.2250738585072014e-308, "2.2250738585072014e-308" },
+	};
+	char buf[64] = {0};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+		snprintf(buf, sizeof(buf), "%r", cases[i].v);
+		ASSERT_STR_EQ(cases[i].want, buf);
+	}
+}
+
+TEST(printf_r_float) {
+	char buf[64] = {0};
+
+	snprintf(buf, sizeof(buf), "%hr %hr %hr", 0.1f, 1.0f / 3, FLT_MAX);
+	ASSERT_STR_EQ("0.1 0.33333334 3.4028235e+38", buf);
+}
+
+TEST(printf_r_flags) {
+	char buf[64] = {0};
+
+	snprintf(buf, sizeof(buf), "%+r|%8r|%-8r|%R", 1.5, 0.25, 2.0, 1e-300);
+	ASSERT_STR_EQ("+1.5|    0.25|2       |1E-300", buf);
+	snprintf(buf, sizeof(buf), "%r %r", INFINITY, -INFINITY);
+	ASSERT_STR_EQ("inf -inf", buf);
+}
+
+/* compare two digit strings carrying the power of ten of their first digit */
+static int cmp_decimal(const char *a, int alen, int aexp, const char *b, int blen, int bexp) {
+	if (aexp != bexp) return aexp < bexp ? -1 : 1;
+
+	for (int i = 0; i < alen || i < blen; i++) {
+		char x = i < alen ? a[i] : '0', y = i < blen ? b[i] : '0';
+
+		if (x != y) return x < y ? -1 : 1;
+	}
+
+	return 0;
+}
+
+TEST(printf_r_random_interval) {
+	static char lo[JACL_FEXACT_DIGITS], hi[JACL_FEXACT_DIGITS];
+	uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+	for (int iter = 0; iter < 20000; iter++) {
+		seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+
+		union { double f; uint64_t u; } a = { .u = seed };
+
+		if (!isfinite(a.f) || a.f == 0) continue;
+
+		// the rounding interval is (4m - 1 - shift, 4m + 2) * 2^e2, the same as __jacl_ryu_DBL's
+		uint64_t mant = a.u & ((1ULL << 52) - 1);
+		int32_t be = (int32_t)((a.u >> 52) & 0x7FF), e2 = (be ? be : 1) - 1075 - 2;
+		uint64_t m = be ? mant | (1ULL << 52) : mant;
+		int even = !(m & 1), lexp, hexp;
+		int llen = __jacl_fexact(4 * m - 1 - (mant != 0 || be <= 1), e2, lo, &lexp);
+		int hlen = __jacl_fexact(4 * m + 2, e2, hi, &hexp);
+
+		char buf[64], digits[20], *p = buf;
+		int n = 0, exp10;
+
+		snprintf(buf, sizeof(buf), "%r", fabs(a.f));
+
+		// pull the digits and exponent back out of whichever layout %r chose
+		char *e = strchr(buf, 'e');
+		int point = 0, dot = 0;
+
+		for (; *p && p != e; p++) {
+			if (*p == '.') dot = 1;
+			else if (n || *p != '0') { digits[n++] = *p; point += !dot; }
+			else point -= dot;
+		}
+
+		while (n > 1 && digits[n - 1] == '0') n--;
+
+		exp10 = point - 1 + (e ? atoi(e + 1) : 0);
+
+		int below = cmp_decimal(lo, llen, lexp, digits, n, exp10), above = cmp_decimal(digits, n, exp10, hi, hlen, hexp);
+
+		if (below > 0 || above > 0 || (!even && (below == 0 || above == 0))) TEST_FAIL("%.17g: %s outside the rounding interval", a.f, buf);
+		if (n == 1) continue;
+
+		// neither neighbour one digit shorter may land inside the interval
+		char down[20], up[20];
+		int ulen = n - 1, uexp = exp10;
+
+		memcpy(down, digits, (size_t)n - 1);
+		memcpy(up, digits, (size_t)n - 1);
+
+		for (int i = ulen - 1; i >= 0 && ++up[i] > '9'; i--) {
+			up[i] = '0';
+			if (!i) { up[0] = '1'; uexp++; }
+		}
+
+		if (cmp_decimal(lo, llen, lexp, down, n - 1, exp10) < 0 || (even && cmp_decimal(lo, llen, lexp, down, n - 1, exp10) == 0)) TEST_FAIL("%.17g: %s is not the shortest", a.f, buf);
+		if (cmp_decimal(up, ulen, uexp, hi, hlen, hexp) < 0 || (even && cmp_decimal(up, ulen, uexp, hi, hlen, hexp) == 0)) TEST_FAIL("%.17g: %s is not the shortest", a.f, buf);
+	}
+}
+
 TEST_SUITE(printf_n);
 
 TEST(printf_n_basic) {
@@ -907,6 +1050,19 @@ TEST(printf_s_minus_width) {
 	ASSERT_TRUE(strlen(buf) >= 15);
 }
 
+TEST(printf_s_truncated) {
+	char buf[4] = {0};
+	ASSERT_INT_EQ(5, snprintf(buf, sizeof(buf), "%5s", "abc"));
+	ASSERT_STR_EQ("  a", buf);
+	ASSERT_INT_EQ(11, snprintf(buf, sizeof(buf), "%s %s", "hello", "world"));
+	ASSERT_STR_EQ("hel", buf);
+}
+
+TEST(printf_s_count_only) {
+	ASSERT_INT_EQ(6, snprintf(NULL, 0, "%s-%s", "ab", "cde"));
+	ASSERT_INT_EQ(8, snprintf(NULL, 0, "%-8s", "x"));
+}
+
 /* ============================================================= */
 
 TEST_SUITE(printf_u);
@@ -975,6 +1131,15 @@ TEST(printf_x_uppercase) {
 	ASSERT_STR_EQ("FF", buf);
 }
 
+TEST(printf_x_every_width) {
+	char buf[64] = {0};
+
+	snprintf(buf, sizeof(buf), "%llx %llX %llx %x %x", 0xFEDCBA9876543210ULL, 0xABCDEF012ULL, 0x100ULL, 0xF, 0);
+	ASSERT_STR_EQ("fedcba9876543210 ABCDEF012 100 f 0", buf);
+	snprintf(buf, sizeof(buf), "%llu %llu %llu", ULLONG_MAX, 100000000ULL, 99999999ULL);
+	ASSERT_STR_EQ("18446744073709551615 100000000 99999999", buf);
+}
+
 TEST(printf_x_hash) {
 	char buf[256] = {0};
 	snprintf(buf, sizeof(buf), "%#x", 255);
@@ -1139,6 +1304,17 @@ TEST(scanf_d_width) {
 	ASSERT_INT_EQ(42, parsed);
 }
 
+TEST(scanf_d_width_splits_run) {
+	int a = 0, b = 0, c = 0;
+
+	ASSERT_INT_EQ(3, sscanf("123456789-12345", "%3d%4d%3d", &a, &b, &c));
+	ASSERT_INT_EQ(123, a);
+	ASSERT_INT_EQ(4567, b);
+	ASSERT_INT_EQ(89, c);
+	ASSERT_INT_EQ(1, sscanf("-1234", "%3d", &a));
+	ASSERT_INT_EQ(-12, a);
+}
+
 TEST(scanf_d_negative) {
 	char buf[256] = {0};
 	int parsed;
@@ -1296,6 +1472,31 @@ TEST(scanf_f_negative_inf)
 	ASSERT_TRUE(parsed < 0);
 }
 
+TEST(scanf_f_exact) {
+	double d = 0, e = 0;
+	float f = 0;
+	int n = 0;
+
+	ASSERT_INT_EQ(3, sscanf("0.1 9007199254740993.0000000000000000001 3.4028235677973366e38", "%lf %lf %f%n", &d, &e, &f, &n));
+	ASSERT_TRUE(d == 0.1);
+	ASSERT_TRUE(e == 9007199254740994.0);
+	ASSERT_TRUE(f == FLT_MAX);
+	ASSERT_INT_EQ(62, n);
+}
+
+TEST(scanf_f_width_and_bare_exponent) {
+	double d = 0;
+	char rest[8] = {0};
+
+	ASSERT_INT_EQ(2, sscanf("123.456", "%4lf%s", &d, rest));
+	ASSERT_DBL_EQ(123.0, d);
+	ASSERT_STR_EQ("456", rest);
+
+	ASSERT_INT_EQ(2, sscanf("2.5e+x", "%lf%s", &d, rest));
+	ASSERT_DBL_EQ(2.5, d);
+	ASSERT_STR_EQ("e+x", rest);
+}
+
 /* ============================================================= */
 
 #if JACL_HAS_C99
@@ -2625,6 +2826,16 @@ TEST(setvbuf_line_buffer) {
 	fclose(f);
 }
 
+TEST(setvbuf_no_buffer_fprintf) {
+	FILE *f = tmpfile();
+	char buf[64] = {0};
+	ASSERT_INT_EQ(0, setvbuf(f, NULL, _IONBF, 0));
+	ASSERT_INT_EQ(14, fprintf(f, "%s=%05d|%-3c|", "key", 42, 'x'));
+	ASSERT_INT_EQ(14, (int)pread(fileno(f), buf, sizeof(buf) - 1, 0));
+	ASSERT_STR_EQ("key=00042|x  |", buf);
+	fclose(f);
+}
+
 /* ============================================================= */
 
 TEST_SUITE(setbuf);
@@ -3126,6 +3337,79 @@ TEST(fflush_null) {
 	ASSERT_INT_EQ(0, fflush(NULL));
 }
 
+static int registered(FILE *f) {
+	for (int i = 0; i < JACL_STREAM_SHARDS; i++) {
+		for (FILE *s = __jacl_stream_shards[i].head; s; s = s->_next) if (s == f) return 1;
+	}
+	return 0;
+}
+
+TEST(fflush_null_flushes_every_stream) {
+	FILE *f[8];
+	char buf[16];
+
+	for (int i = 0; i < 8; i++) {
+		f[i] = tmpfile();
+		ASSERT_NOT_NULL(f[i]);
+		fprintf(f[i], "stream %d", i);
+	}
+
+	ASSERT_INT_EQ(0, fflush(NULL));
+
+	for (int i = 0; i < 8; i++) {
+		char want[16];
+		snprintf(want, sizeof want, "stream %d", i);
+		memset(buf, 0, sizeof buf);
+		ASSERT_INT_EQ(0, lseek(fileno(f[i]), 0, SEEK_SET));
+		ASSERT_INT_EQ((int)strlen(want), read(fileno(f[i]), buf, sizeof buf - 1));
+		ASSERT_STR_EQ(want, buf);
+		fclose(f[i]);
+	}
+}
+
+TEST(fflush_null_after_out_of_order_closes) {
+	FILE *f[64];
+
+	for (int i = 0; i < 64; i++) ASSERT_NOT_NULL(f[i] = tmpfile());
+	for (int i = 0; i < 64; i++) ASSERT_TRUE(registered(f[i]));
+
+	/* 7 is coprime to 64, so this visits every stream once, all over each shard */
+	for (int i = 0; i < 64; i++) {
+		FILE *g = f[i * 7 % 64];
+		fputc('x', g);
+		ASSERT_INT_EQ(0, fclose(g));
+		ASSERT_INT_EQ(0, fflush(NULL));
+	}
+
+	for (int i = 0; i < 64; i++) ASSERT_FALSE(registered(f[i]));
+	ASSERT_TRUE(registered(stdout));
+}
+
+TEST(fflush_exit_flushes_streams) {
+	char tmpname[L_tmpnam] = {0};
+	char buf[16] = {0};
+	int status = 0;
+	tmpnam(tmpname);
+
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		FILE *f = fopen(tmpname, "w");
+		fputs("unflushed", f);
+		exit(0);
+	}
+
+	ASSERT_INT_EQ(pid, waitpid(pid, &status, 0));
+
+	FILE *f = fopen(tmpname, "r");
+	ASSERT_NOT_NULL(f);
+	fgets(buf, sizeof buf, f);
+	fclose(f);
+	remove(tmpname);
+
+	ASSERT_STR_EQ("unflushed", buf);
+}
+
 TEST(fflush_read_only_stream) {
 	char tmpname[L_tmpnam] = {0};
 	tmpnam(tmpname);
@@ -3842,6 +4126,87 @@ TEST(ftrylockfile_null) {
 
 /* ============================================================= */
 
+TEST_SUITE(stream_registry);
+
+static _Atomic int __test_registry_stop;
+
+static void *__test_registry_churn(void *arg) {
+	char buf[64];
+	int ok = 0;
+
+	for (int i = 0; i < 2000; i++) {
+		FILE *f = fmemopen(buf, sizeof(buf), "w");
+
+		if (!f) continue;
+		if (fputs("registry churn", f) >= 0) ok++;
+
+		fclose(f);
+	}
+
+	return (void *)(intptr_t)ok;
+}
+
+static void *__test_registry_flush(void *arg) {
+	while (!__test_registry_stop) fflush(NULL);
+
+	return NULL;
+}
+
+TEST(stream_registry_threaded_churn) {
+	pthread_t workers[8], flusher;
+	int total = 0;
+
+	__test_registry_stop = 0;
+	ASSERT_INT_EQ(0, pthread_create(&flusher, NULL, __test_registry_flush, NULL));
+
+	for (int i = 0; i < 8; i++) ASSERT_INT_EQ(0, pthread_create(&workers[i], NULL, __test_registry_churn, NULL));
+	for (int i = 0; i < 8; i++) {
+		void *ret;
+
+		ASSERT_INT_EQ(0, pthread_join(workers[i], &ret));
+		total += (int)(intptr_t)ret;
+	}
+
+	__test_registry_stop = 1;
+	ASSERT_INT_EQ(0, pthread_join(flusher, NULL));
+	ASSERT_INT_EQ(8 * 2000, total);
+	ASSERT_INT_EQ(0, fflush(NULL));
+}
+
+static void *__test_registry_dprintf(void *arg) {
+	FILE *f = (FILE *)arg;
+
+	for (int i = 0; i < 1000; i++) dprintf(fileno(f), "d%04d\n", i);
+
+	return NULL;
+}
+
+TEST(stream_registry_dprintf_shares_stream_lock) {
+	FILE *f = tmpfile();
+	pthread_t writer;
+	char line[16];
+	int fp = 0, dp = 0;
+
+	ASSERT_NOT_NULL(f);
+	ASSERT_INT_EQ(0, pthread_create(&writer, NULL, __test_registry_dprintf, f));
+	for (int i = 0; i < 1000; i++) fprintf(f, "f%04d\n", i);
+	ASSERT_INT_EQ(0, pthread_join(writer, NULL));
+
+	/* each write lands whole and in order, whichever way it went in */
+	rewind(f);
+	while (fgets(line, sizeof(line), f)) {
+		ASSERT_INT_EQ(6, (int)strlen(line));
+		if (line[0] == 'f') ASSERT_INT_EQ(fp++, atoi(line + 1));
+		else if (line[0] == 'd') ASSERT_INT_EQ(dp++, atoi(line + 1));
+		else ASSERT_TRUE(0);
+	}
+	ASSERT_INT_EQ(1000, fp);
+	ASSERT_INT_EQ(1000, dp);
+	fclose(f);
+}
+
+/* ============================================================= */
+
 TEST_SUITE(getc_unlocked);
 
 TEST(getc_unlocked_basic) {
@@ -535,6 +535,41 @@ TEST(strtoull_negative_input) {
 	ASSERT_INT_EQ(v, ULLONG_MAX);
 }
 
+TEST(strtoull_long_runs) {
+	char *end;
+
+	errno = 0;
+	ASSERT_TRUE(strtoull("18446744073709551615", &end, 10) == ULLONG_MAX);
+	ASSERT_INT_EQ(0, errno);
+	ASSERT_INT_EQ('\0', *end);
+
+	ASSERT_TRUE(strtoull("18446744073709551616", &end, 10) == ULLONG_MAX);
+	ASSERT_ERRNO(ERANGE);
+	ASSERT_INT_EQ('\0', *end);
+
+	errno = 0;
+	ASSERT_TRUE(strtoull("00000000000000000000001234567890123456789x", &end, 10) == 1234567890123456789ULL);
+	ASSERT_INT_EQ('x', *end);
+	ASSERT_TRUE(strtoull("fEdCbA9876543210", &end, 16) == 0xFEDCBA9876543210ULL);
+	ASSERT_INT_EQ('\0', *end);
+	ASSERT_TRUE(strtoull("12345678g", &end, 16) == 0x12345678ULL);
+	ASSERT_INT_EQ('g', *end);
+
+	strtoull("1fedcba98765432100", &end, 16);
+	ASSERT_ERRNO(ERANGE);
+	ASSERT_INT_EQ('\0', *end);
+}
+
+TEST(strtoull_octal_endptr) {
+	char buf[] = "0g", other[] = "g";
+	char *end;
+
+	ASSERT_INT_EQ(0, strtoull(buf, &end, 0));
+	ASSERT_PTR_EQ(buf + 1, end);
+	ASSERT_INT_EQ(0, strtoull(other, &end, 8));
+	ASSERT_PTR_EQ(other, end);
+}
+
 /* ============================================================= */
 
 TEST_SUITE(strtod)
@@ -613,6 +648,68 @@ TEST(strtod_subnormal) {
 	ASSERT_TRUE(v >= 0.0 && v <= 1e-308);
 }
 
+TEST(strtod_correctly_rounded) {
+	static const struct { const char *s; uint64_t bits; } cases[] = {
+		{ "0.1", 0x3FB999999999999Aull },
+		{ "9007199254740993", 0x4340000000000000ull },
+		{ "9007199254740993.00000000000000000000001", 0x4340000000000001ull },
+		{ "2.4703282292062327e-324", 0 },
+		{ "2.4703282292062328e-324", 1 },
+		{ "2.2250738585072011e-308", 0x000FFFFFFFFFFFFFull },
+		{ "1.7976931348623157e308", 0x7FEFFFFFFFFFFFFFull },
+		{ "123456789012345678901234567890", 0x45F8EE90FF6C373Eull },
+		{ "0.000000000000000000000000000000000000000000000000000000000000000001", 0x323AF5BF109550F2ull },
+	};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+		union { double f; uint64_t u; } a = { .f = strtod(cases[i].s, NULL) };
+
+		if (a.u != cases[i].bits) TEST_FAIL("%s gave %016llx", cases[i].s, (unsigned long long)a.u);
+	}
+}
+
+TEST(strtod_halfway_long_digits) {
+	// exactly between 1 and the next double, then a hair either side of it
+	static const char half[] = "1.00000000000000011102230246251565404236316680908203125";
+	char buf[128];
+
+	ASSERT_DBL_EQ(1.0, strtod(half, NULL));
+
+	snprintf(buf, sizeof(buf), "%s%s", half, "00000000000000000000000000000000000000001");
+	ASSERT_DBL_EQ(1.0000000000000002, strtod(buf, NULL));
+
+	snprintf(buf, sizeof(buf), "%.*s4%s", (int)sizeof(half) - 2, half, "99999999999999999999999999999999999999");
+	ASSERT_DBL_EQ(1.0, strtod(buf, NULL));
+}
+
+TEST(strtod_overflow_sets_erange) {
+	errno = 0;
+	ASSERT_TRUE(isinf(strtod("1.7976931348623159e308", NULL)));
+	ASSERT_ERRNO(ERANGE);
+
+	errno = 0;
+	ASSERT_DBL_EQ(0.0, strtod("1e-400", NULL));
+	ASSERT_ERRNO(ERANGE);
+}
+
+TEST(strtod_random_round_trip) {
+	uint64_t seed = 0x2545F4914F6CDD1Dull;
+	char buf[64], *end;
+
+	for (int i = 0; i < 20000; i++) {
+		seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+
+		union { double f; uint64_t u; } a = { .u = seed }, b;
+
+		if (!isfinite(a.f)) continue;
+
+		snprintf(buf, sizeof(buf), (i & 1) ? "%r" : "%.17g", a.f);
+		b.f = strtod(buf, &end);
+
+		if (b.u != a.u || *end) TEST_FAIL("%s read back as %.17g", buf, b.f);
+	}
+}
+
 /* ============================================================= */
 
 TEST_SUITE(strtof)
@@ -702,6 +799,31 @@ TEST(strtof_endptr_stops_at_invalid_char) {
 	ASSERT_INT_EQ(*ep, '@');
 }
 
+TEST(strtof_random_round_trip) {
+	uint32_t seed = 0x9E3779B9u;
+	char buf[64];
+
+	for (int i = 0; i < 20000; i++) {
+		seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+
+		union { float f; uint32_t u; } a = { .u = seed }, b;
+
+		if (!isfinite(a.f)) continue;
+
+		snprintf(buf, sizeof(buf), "%hr", a.f);
+		b.f = strtof(buf, NULL);
+
+		if (b.u != a.u) TEST_FAIL("%s read back as %.9g", buf, (double)b.f);
+	}
+}
+
+TEST(strtof_rounds_from_decimal) {
+	// rounding to double first would land exactly on the halfway point and then on 1.0f
+	ASSERT_TRUE(strtof("1.00000005960464477539062500001", NULL) == 1.00000012f);
+	ASSERT_TRUE(strtof("1.000000059604644775390625", NULL) == 1.0f);
+	ASSERT_TRUE(strtof("7.1e-46", NULL) == FLT_TRUE_MIN);
+}
+
 /* ============================================================= */
 
 TEST_SUITE(strtold)
@@ -1058,6 +1180,37 @@ TEST(qsort_zero_size) {
 	ASSERT_TRUE(1);
 }
 
+static int cmp_bytes3(const void *a, const void *b) {
+	return memcmp(a, b, 3);
+}
+
+static int cmp_key16(const void *a, const void *b) {
+	long long x = *(const long long *)a, y = *(const long long *)b;
+	return (x > y) - (x < y);
+}
+
+TEST(qsort_element_sizes) {
+	static unsigned char odd[3 * 2000 + 1];
+	static long long wide[2 * 2000], words[2001];
+	unsigned seed = 12345;
+
+	for (size_t i = 0; i < sizeof(odd); i++) odd[i] = (unsigned char)((seed = seed * 1103515245u + 12345u) >> 24);
+	for (int i = 0; i < 2000; i++) wide[2 * i] = (seed = seed * 1103515245u + 12345u) % 97, wide[2 * i + 1] = -wide[2 * i];
+	for (int i = 0; i < 2001; i++) words[i] = (long long)i * 7919 % 2001;
+
+	/* 3 byte elements, 16 byte elements and 8 byte elements off their alignment */
+	qsort(odd + 1, 2000, 3, cmp_bytes3);
+	qsort(wide, 2000, 16, cmp_key16);
+	qsort((char *)words + 4, 2000, 8, cmp_bytes3);
+
+	for (int i = 1; i < 2000; i++) {
+		ASSERT_TRUE(memcmp(odd + 1 + 3 * (i - 1), odd + 1 + 3 * i, 3) <= 0);
+		ASSERT_TRUE(wide[2 * (i - 1)] <= wide[2 * i]);
+		ASSERT_TRUE(wide[2 * i + 1] == -wide[2 * i]);
+		ASSERT_TRUE(memcmp((char *)words + 4 + 8 * (i - 1), (char *)words + 4 + 8 * i, 3) <= 0);
+	}
+}
+
 /* ============================================================= */
 
 TEST_SUITE(bsearch)
@@ -1161,6 +1314,39 @@ TEST(bsearch_null_comparator) {
 	ASSERT_NULL(r);
 }
 
+TEST(bsearch_batch_matches_bsearch) {
+	static int arr[3000], keys[700];
+	void *found[700];
+	size_t hits = 0;
+
+	for (int i = 0; i < 3000; i++) arr[i] = 3 * i + (i & 1);
+	for (int i = 0; i < 700; i++) keys[i] = i * i / 50 - 5;
+
+	ASSERT_INT_EQ(0, bsearch_batch(keys, 0, sizeof(int), arr, 3000, sizeof(int), cmp_int_bs, found));
+
+	size_t n = bsearch_batch(keys, 700, sizeof(int), arr, 3000, sizeof(int), cmp_int_bs, found);
+
+	for (int i = 0; i < 700; i++) {
+		ASSERT_PTR_EQ(bsearch(&keys[i], arr, 3000, sizeof(int), cmp_int_bs), found[i]);
+		hits += found[i] != NULL;
+	}
+
+	ASSERT_INT_EQ(hits, n);
+	ASSERT_TRUE(n > 0);
+}
+
+TEST(bsearch_batch_repeated_keys) {
+	int arr[] = {2, 4, 6, 8};
+	int keys[] = {1, 4, 4, 9};
+	void *found[4];
+
+	ASSERT_INT_EQ(2, bsearch_batch(keys, 4, sizeof(int), arr, 4, sizeof(int), cmp_int_bs, found));
+	ASSERT_NULL(found[0]);
+	ASSERT_PTR_EQ(&arr[1], found[1]);
+	ASSERT_PTR_EQ(&arr[1], found[2]);
+	ASSERT_NULL(found[3]);
+}
+
 /* ============================================================= */
 
 TEST_SUITE(rand)
@@ -1778,6 +1964,19 @@ TEST(malloc_arena_prev_size_safe) {
 	free(again);
 }
 
+TEST(malloc_arena_reuse) {
+	void *ptrs[512];
+	int first = 0, second = 0;
+
+	for (int i = 0; i < 512; i++) first += (ptrs[i] = malloc(40)) && (uint8_t *)ptrs[i] < __jacl_static_heap + JACL_HEAP_INIT / 4;
+	for (int i = 0; i < 512; i++) free(ptrs[i]);
+	for (int i = 0; i < 512; i++) second += (ptrs[i] = malloc(40)) && (uint8_t *)ptrs[i] < __jacl_static_heap + JACL_HEAP_INIT / 4;
+	for (int i = 0; i < 512; i++) free(ptrs[i]);
+
+	ASSERT_INT_GT(first, 0);
+	ASSERT_INT_GE(second, first - JACL_RECYCLING);
+}
+
 TEST(malloc_after_fork_reset) {
 	pid_t pid = fork();
 
@@ -2271,6 +2470,37 @@ TEST(free_double_free) {
 	ASSERT_TRUE(1);
 }
 
+TEST(free_across_many_segments) {
+	enum { N = 300, SZ = 900 * 1024 };
+	static char *blocks[N];
+	int reused = 0;
+
+	for (int i = 0; i < N; i++) {
+		blocks[i] = malloc(SZ);
+		ASSERT_NOT_NULL(blocks[i]);
+		blocks[i][0] = (char)i;
+		blocks[i][SZ - 1] = (char)i;
+	}
+
+	for (int i = 0; i < N; i += 2) free(blocks[i]);
+
+	for (int i = 0; i < N; i += 2) {
+		char *p = malloc(SZ);
+
+		ASSERT_NOT_NULL(p);
+
+		for (int j = 0; j < N; j += 2) if (p == blocks[j]) { reused++; break; }
+
+		blocks[i] = p;
+	}
+
+	// a lost free would leak its block and force a fresh segment instead
+	ASSERT_TRUE(reused >= N / 2 - 2);
+
+	for (int i = 1; i < N; i += 2) ASSERT_INT_EQ((char)i, blocks[i][SZ - 1]);
+	for (int i = 0; i < N; i++) free(blocks[i]);
+}
+
 /* ============================================================= */
 
 TEST_SUITE(mkostemp)
@@ -2436,6 +2666,38 @@ TEST(qsort_r_descending) {
 	ASSERT_INT_EQ(arr[4], 1);
 }
 
+static int cmp_r_memcmp24(const void *a, const void *b, void *arg) {
+	(void)arg;
+	return memcmp(a, b, 24);
+}
+
+static int cmp_r_count(const void *a, const void *b, void *arg) {
+	int x = *(const int *)a, y = *(const int *)b;
+	++*(size_t *)arg;
+	return (x > y) - (x < y);
+}
+
+TEST(qsort_r_comparisons_bounded) {
+	static int arr[4096];
+	unsigned seed = 1;
+
+	for (int shape = 0; shape < 6; shape++) {
+		size_t calls = 0;
+
+		for (int i = 0; i < 4096; i++) {
+			seed = seed * 1103515245u + 12345u;
+			arr[i] = shape == 0 ? i : shape == 1 ? 4096 - i : shape == 2 ? (i < 2048 ? i : 4096 - i) : shape == 3 ? i % 16 : shape == 4 ? 7 : (int)(seed >> 8);
+		}
+
+		qsort_r(arr, 4096, sizeof(int), cmp_r_count, &calls);
+
+		for (int i = 1; i < 4096; i++) ASSERT_INT_GE(arr[i], arr[i - 1]);
+
+		/* well inside n log2 n times a small constant, whatever the shape */
+		ASSERT_TRUE(calls < 3 * 4096 * 12);
+	}
+}
+
 TEST(qsort_r_large_array) {
 	int arr[1000];
 	for (int i = 0; i < 1000; i++) arr[i] = 999 - i;
@@ -2492,6 +2754,51 @@ TEST(qsort_r_empty) {
 
 /* ============================================================= */
 
+TEST_SUITE(qsort_mt)
+
+TEST(qsort_mt_every_crew_size) {
+	static int arr[50000];
+	unsigned seed = 7;
+
+	/* odd crews leave the last merge in the scratch copy */
+	for (unsigned threads = 1; threads <= 8; threads++) {
+		long long before = 0, after = 0;
+		int order = 1;
+
+		for (int i = 0; i < 50000; i++) before += arr[i] = (int)((seed = seed * 1103515245u + 12345u) >> 8) % 10007;
+
+		qsort_mt(arr, 50000, sizeof(int), cmp_r, &order, threads, 1000);
+
+		for (int i = 0; i < 50000; i++) after += arr[i];
+		for (int i = 1; i < 50000; i++) ASSERT_INT_GE(arr[i], arr[i - 1]);
+
+		ASSERT_TRUE(before == after);
+	}
+}
+
+TEST(qsort_mt_wide_elements) {
+	static unsigned char recs[24 * 20000];
+	unsigned seed = 99;
+
+	for (size_t i = 0; i < sizeof(recs); i++) recs[i] = (unsigned char)((seed = seed * 1103515245u + 12345u) >> 28);
+
+	qsort_mt(recs, 20000, 24, cmp_r_memcmp24, NULL, 5, 500);
+
+	for (int i = 1; i < 20000; i++) ASSERT_TRUE(memcmp(recs + 24 * (i - 1), recs + 24 * i, 24) <= 0);
+}
+
+TEST(qsort_mt_small_is_serial) {
+	int arr[] = {5, 3, 9, 1, 7};
+	int order = -1;
+
+	qsort_mt(arr, 5, sizeof(int), cmp_r, &order, 0, 0);
+
+	ASSERT_INT_EQ(9, arr[0]);
+	ASSERT_INT_EQ(1, arr[4]);
+}
+
+/* ============================================================= */
+
 TEST_SUITE(a64l)
 
 TEST(a64l_basic) {
@@ -55,6 +55,19 @@ TEST(memcpy_null_pointers) {
 	ASSERT_NULL(memcpy(NULL, NULL, 4));
 }
 
+TEST(memcpy_long_misaligned) {
+	unsigned char src[300], dest[320];
+
+	for (int i = 0; i < 300; i++) src[i] = (unsigned char)(i * 7);
+
+	memset(dest, 0xEE, sizeof(dest));
+	memcpy(dest + 3, src + 1, 257);
+
+	ASSERT_MEM_EQ(dest + 3, src + 1, 257);
+	ASSERT_EQ(0xEE, dest[2]);
+	ASSERT_EQ(0xEE, dest[260]);
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(memmove)
@@ -100,6 +113,22 @@ TEST(memmove_null_pointers) {
 	ASSERT_NULL(memmove(buf, NULL, 4));
 }
 
+TEST(memmove_overlap_long) {
+	unsigned char buf[400];
+
+	for (int i = 0; i < 400; i++) buf[i] = (unsigned char)i;
+
+	memmove(buf + 5, buf, 300);
+
+	for (int i = 0; i < 300; i++) ASSERT_EQ((unsigned char)i, buf[i + 5]);
+
+	for (int i = 0; i < 400; i++) buf[i] = (unsigned char)i;
+
+	memmove(buf, buf + 5, 300);
+
+	for (int i = 0; i < 300; i++) ASSERT_EQ((unsigned char)(i + 5), buf[i]);
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(memset)
@@ -135,6 +164,18 @@ TEST(memset_null_pointer) {
 	ASSERT_NULL(memset(NULL, 'A', 10));
 }
 
+TEST(memset_long_misaligned) {
+	unsigned char buf[200];
+
+	memset(buf, 0, sizeof(buf));
+	memset(buf + 1, 0xA5, 131);
+
+	ASSERT_EQ(0, buf[0]);
+	ASSERT_EQ(0xA5, buf[1]);
+	ASSERT_EQ(0xA5, buf[131]);
+	ASSERT_EQ(0, buf[132]);
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(memcmp)
@@ -186,6 +227,21 @@ TEST(memcmp_null_both) {
 	ASSERT_EQ(0, memcmp(NULL, NULL, 0));
 }
 
+TEST(memcmp_long_late_difference) {
+	unsigned char a[100], b[100];
+
+	memset(a, 'x', sizeof(a));
+	memset(b, 'x', sizeof(b));
+
+	ASSERT_EQ(0, memcmp(a, b, sizeof(a)));
+
+	b[77] = 'y';
+
+	ASSERT_EQ(-1, memcmp(a, b, sizeof(a)));
+	ASSERT_EQ(1, memcmp(b, a, sizeof(a)));
+	ASSERT_EQ(0, memcmp(a, b, 77));
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(memchr)
@@ -226,6 +282,17 @@ TEST(memchr_zero_n) {
 	ASSERT_NULL(memchr("a", 'a', 0));
 }
 
+TEST(memchr_long_bounded) {
+	char buf[100];
+
+	memset(buf, 'a', sizeof(buf));
+
+	buf[70] = 'Z';
+
+	ASSERT_PTR_EQ(buf + 70, memchr(buf + 3, 'Z', 90));
+	ASSERT_NULL(memchr(buf + 3, 'Z', 67));
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(memmem)
@@ -261,6 +328,41 @@ TEST(memmem_null_needle) {
 	ASSERT_NULL(memmem("a", 1, NULL, 1));
 }
 
+TEST(memmem_periodic_needle) {
+	char hay[600], ndl[200];
+
+	memset(hay, 'a', sizeof(hay));
+	memset(ndl, 'a', sizeof(ndl));
+
+	ndl[sizeof(ndl) - 1] = 'b';
+
+	ASSERT_NULL(memmem(hay, sizeof(hay), ndl, sizeof(ndl)));
+
+	hay[sizeof(hay) - 1] = 'b';
+
+	ASSERT_EQ(hay + sizeof(hay) - sizeof(ndl), memmem(hay, sizeof(hay), ndl, sizeof(ndl)));
+}
+
+TEST(memmem_embedded_nul) {
+	const char hay[] = "ab\0cd\0ef\0cd\0gh";
+
+	ASSERT_EQ(hay + 8, memmem(hay, sizeof(hay), "\0cd\0g", 5));
+	ASSERT_EQ(hay + 2, memmem(hay, sizeof(hay), "\0cd", 3));
+}
+
+TEST(memmem_short_needle_all_offsets) {
+	char hay[256];
+	const char *ndl = "needle";
+
+	for (size_t at = 0; at + 6 <= sizeof(hay); at++) {
+		memset(hay, 'n', sizeof(hay));
+		memcpy(hay + at, ndl, 6);
+
+		ASSERT_EQ(hay + at, memmem(hay, sizeof(hay), ndl, 6));
+		ASSERT_NULL(memmem(hay, at + 5, ndl, 6));
+	}
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(strlen)
@@ -281,6 +383,18 @@ TEST(strlen_null) {
 	ASSERT_EQ(0, strlen(NULL));
 }
 
+TEST(strlen_long_misaligned) {
+	char buf[128];
+
+	for (int off = 0; off < 33; off++) {
+		memset(buf, 'x', sizeof(buf));
+
+		buf[off + 70] = '\0';
+
+		ASSERT_EQ(70, strlen(buf + off));
+	}
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(strnlen)
@@ -489,6 +603,24 @@ TEST(strcmp_null_b) {
 	ASSERT_NE(0, strcmp("a", NULL));
 }
 
+TEST(strcmp_long_strings) {
+	char a[100], b[100];
+
+	memset(a, 'q', sizeof(a)); a[90] = '\0';
+	memset(b, 'q', sizeof(b)); b[90] = '\0';
+
+	ASSERT_EQ(0, strcmp(a + 1, b + 1));
+
+	b[60] = 'r';
+
+	ASSERT_TRUE(strcmp(a + 1, b + 1) < 0);
+	ASSERT_TRUE(strcmp(b + 1, a + 1) > 0);
+}
+
+TEST(strcmp_high_bytes_unsigned) {
+	ASSERT_TRUE(strcmp("a\x80", "a\x7f") > 0);
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(strncmp)
@@ -655,6 +787,20 @@ TEST(strchr_null_s) {
 	ASSERT_NULL(strchr(NULL, 'a'));
 }
 
+TEST(strchr_long_stops_at_nul) {
+	char buf[100];
+
+	memset(buf, 'x', sizeof(buf));
+
+	buf[50] = '\0';
+	buf[60] = 'Z';
+	buf[40] = 'Y';
+
+	ASSERT_NULL(strchr(buf + 1, 'Z'));
+	ASSERT_PTR_EQ(buf + 40, strchr(buf + 1, 'Y'));
+	ASSERT_PTR_EQ(buf + 50, strchr(buf + 1, '\0'));
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(strrchr)
@@ -710,6 +856,81 @@ TEST(strstr_null_needle) {
 	ASSERT_NULL(strstr("a", NULL));
 }
 
+TEST(strstr_long_needle) {
+	char hay[2048], ndl[100];
+
+	for (size_t i = 0; i < sizeof(hay) - 1; i++) hay[i] = "abcab"[i % 5];
+	for (size_t i = 0; i < sizeof(ndl) - 1; i++) ndl[i] = "abcab"[(i + 3) % 5];
+
+	hay[sizeof(hay) - 1] = '\0';
+	ndl[sizeof(ndl) - 1] = '\0';
+
+	ASSERT_EQ(hay + 3, strstr(hay, ndl));
+
+	ndl[50] = 'z';
+
+	ASSERT_NULL(strstr(hay, ndl));
+}
+
+TEST(strstr_worst_case) {
+	char hay[4096], ndl[64];
+
+	memset(hay, 'a', sizeof(hay) - 1);
+	memset(ndl, 'a', sizeof(ndl) - 1);
+
+	hay[sizeof(hay) - 1] = '\0';
+	ndl[0] = 'b';
+	ndl[sizeof(ndl) - 1] = '\0';
+
+	ASSERT_NULL(strstr(hay, ndl));
+
+	hay[100] = 'b';
+
+	ASSERT_EQ(hay + 100, strstr(hay, ndl));
+}
+
+TEST(strstr_needle_past_end) {
+	ASSERT_NULL(strstr("abcdefghijklmnopqrstuvwxyz0123456789", "xyz0123456789abcdefghijklmnopqrstuvw"));
+}
+
+/* ============================================================================ */
+
+TEST_SUITE(strcasestr)
+
+TEST(strcasestr_found) {
+	const char *str = "Hello World";
+
+	ASSERT_EQ(str + 6, strcasestr(str, "WORLD"));
+	ASSERT_EQ(str, strcasestr(str, "hello w"));
+}
+
+TEST(strcasestr_not_found) {
+	ASSERT_NULL(strcasestr("Hello World", "worlds"));
+}
+
+TEST(strcasestr_empty_needle) {
+	const char *str = "test";
+
+	ASSERT_EQ(str, strcasestr(str, ""));
+}
+
+TEST(strcasestr_long_needle) {
+	char hay[512], ndl[80];
+
+	for (size_t i = 0; i < sizeof(hay) - 1; i++) hay[i] = (i & 1) ? 'X' : 'y';
+	for (size_t i = 0; i < sizeof(ndl) - 1; i++) ndl[i] = (i & 1) ? 'Y' : 'x';
+
+	hay[sizeof(hay) - 1] = '\0';
+	ndl[sizeof(ndl) - 1] = '\0';
+
+	ASSERT_EQ(hay + 1, strcasestr(hay, ndl));
+}
+
+TEST(strcasestr_non_letters) {
+	ASSERT_NULL(strcasestr("a@b", "A`B"));
+	ASSERT_EQ((const char *)NULL, strcasestr(NULL, "a"));
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(strspn)
@@ -737,6 +958,26 @@ TEST(strspn_all_match) {
 	ASSERT_EQ(5, strspn("hello", "helo"));
 }
 
+TEST(strspn_large_set) {
+	const char *set = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+	ASSERT_EQ(10, strspn("token42xyz-rest", set));
+	ASSERT_EQ(0, strspn("-token", set));
+}
+
+TEST(strspn_long_misaligned) {
+	char buf[300];
+
+	for (size_t off = 0; off < 40; off++) {
+		memset(buf, ' ', sizeof(buf));
+
+		buf[off + 200] = 'x';
+		buf[off + 201] = '\0';
+
+		ASSERT_EQ(200, strspn(buf + off, " \t"));
+	}
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(strcspn)
@@ -764,6 +1005,27 @@ TEST(strcspn_no_match) {
 	ASSERT_EQ(5, strcspn("hello", "xyz"));
 }
 
+TEST(strcspn_high_bytes) {
+	ASSERT_EQ(3, strcspn("abc\xff\x80", "\x80\xff"));
+	ASSERT_EQ(3, strcspn("abc\x7f\x80", "\x80\x7f\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10"));
+}
+
+TEST(strcspn_large_set_long) {
+	char buf[1000];
+	const char *set = ",;:|/\\-_.+=*&^%$#@!~?<>()[]{}";
+
+	memset(buf, 'a', sizeof(buf) - 1);
+
+	buf[sizeof(buf) - 1] = '\0';
+
+	ASSERT_EQ(sizeof(buf) - 1, strcspn(buf, set));
+
+	buf[777] = '}';
+
+	ASSERT_EQ(777, strcspn(buf, set));
+	ASSERT_EQ(buf + 777, strpbrk(buf, set));
+}
+
 /* ============================================================================ */
 
 TEST_SUITE(strpbrk)
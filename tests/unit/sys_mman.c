@@ -355,6 +355,42 @@ TEST(munmap_zero_length) {
 
 #endif /* !JACL_ARCH_WASM */
 
+/* ============================================================================ */
+#if JACL_OS_LINUX
+TEST_SUITE(mremap_tests);
+
+TEST(mremap_grow_keeps_contents) {
+	unsigned char *p = mmap(NULL, 4096, PROT_READ | PROT_WRITE,
+	                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, p);
+	memset(p, 0xA5, 4096);
+
+	unsigned char *q = mremap(p, 4096, 16 * 4096, MREMAP_MAYMOVE);
+	ASSERT_NE(MAP_FAILED, q);
+	ASSERT_EQ(0xA5, q[0]);
+	ASSERT_EQ(0xA5, q[4095]);
+	ASSERT_EQ(0, q[16 * 4096 - 1]);
+	munmap(q, 16 * 4096);
+}
+
+TEST(mremap_shrink_in_place) {
+	void *p = mmap(NULL, 4 * 4096, PROT_READ | PROT_WRITE,
+	               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, p);
+	ASSERT_EQ(p, mremap(p, 4 * 4096, 4096, 0));
+	munmap(p, 4096);
+}
+
+TEST(mremap_unmapped_fails) {
+	void *p = mmap(NULL, 4096, PROT_READ | PROT_WRITE,
+	               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, p);
+	munmap(p, 4096);
+	ASSERT_EQ(MAP_FAILED, mremap(p, 4096, 8192, MREMAP_MAYMOVE));
+	ASSERT_EQ(EFAULT, errno);
+}
+#endif
+
 /* ============================================================================ */
 #if JACL_ARCH_WASM
 TEST_SUITE(wasm_stubs);